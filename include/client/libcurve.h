@@ -25,6 +25,7 @@
 
 #include <unistd.h>
 #include <stdint.h>
+#include <sys/uio.h>
 #include <vector>
 #include <map>
 #include <string>
@@ -268,6 +269,40 @@ int AioWrite(int fd, CurveAioContext* aioctx);
  */
 int AioDiscard(int fd, CurveAioContext* aioctx);
 
+/**
+ * @brief Asynchronous vectored read, data is scattered into iov
+ * @param fd file descriptor
+ * @param aioctx async request context, buf is ignored and length must be
+ *        the total length of iov
+ * @param iov io vectors, it can be released after return
+ * @param iovcnt number of io vectors
+ * @return 0 means success, otherwise it means failure
+ */
+int AioReadv(int fd, CurveAioContext* aioctx,
+             const struct iovec* iov, int iovcnt);
+
+/**
+ * @brief Asynchronous vectored write, data is gathered from iov
+ * @param fd file descriptor
+ * @param aioctx async request context, buf is ignored and length must be
+ *        the total length of iov
+ * @param iov io vectors, it can be released after return
+ * @param iovcnt number of io vectors
+ * @return 0 means success, otherwise it means failure
+ */
+int AioWritev(int fd, CurveAioContext* aioctx,
+              const struct iovec* iov, int iovcnt);
+
+/**
+ * @brief Submit a batch of asynchronous requests at once
+ * @param fd file descriptor
+ * @param aioctxs async request contexts, op of each context decides
+ *        whether it is a read, write or discard
+ * @param count number of contexts
+ * @return 0 means all requests are submitted, otherwise none of them is
+ */
+int AioSubmit(int fd, CurveAioContext* aioctxs[], int count);
+
 /**
  * 重命名文件
  * @param: userinfo是用户信息
@@ -430,7 +465,8 @@ class FileClient;
 
 enum class UserDataType {
     RawBuffer,  // char*
-    IOBuffer   // butil::IOBuf*
+    IOBuffer,   // butil::IOBuf*
+    IOVector    // struct iovec*, used by AioReadv/AioWritev
 };
 
 // 存储用户信息
@@ -537,6 +573,40 @@ class CurveClient {
      */
     virtual int AioDiscard(int fd, CurveAioContext* aioctx);
 
+    /**
+     * @brief Async vectored read
+     * @param fd file descriptor
+     * @param aioctx async request context, buf is ignored
+     * @param iov io vectors to store read data
+     * @param iovcnt number of io vectors
+     * @return return error code, 0(LIBCURVE_ERROR::OK) means success
+     */
+    virtual int AioReadv(int fd, CurveAioContext* aioctx,
+                         const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Async vectored write
+     * @param fd file descriptor
+     * @param aioctx async request context, buf is ignored
+     * @param iov io vectors of write data
+     * @param iovcnt number of io vectors
+     * @return return error code, 0(LIBCURVE_ERROR::OK) means success
+     */
+    virtual int AioWritev(int fd, CurveAioContext* aioctx,
+                          const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Submit a batch of async requests
+     * @param fd file descriptor
+     * @param aioctxs async request contexts
+     * @param count number of contexts
+     * @param dataType type of user buffer of all contexts, IOVector is not
+     *        supported, use AioReadv/AioWritev instead
+     * @return return error code, 0(LIBCURVE_ERROR::OK) means success
+     */
+    virtual int AioSubmit(int fd, CurveAioContext* aioctxs[], int count,
+                          UserDataType dataType);
+
     /**
      * 测试使用，设置fileclient
      * @param client 需要设置的fileclient
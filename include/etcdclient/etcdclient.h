@@ -210,6 +210,14 @@ extern GoUint32 EtcdClientTxn2(int p0, struct Operation p1, struct Operation p2)
 
 extern GoUint32 EtcdClientTxn3(int p0, struct Operation p1, struct Operation p2, struct Operation p3);
 
+/* Return type for EtcdClientTxnN */
+struct EtcdClientTxnN_return {
+	GoUint32 r0;
+	GoInt64 r1;
+};
+
+extern struct EtcdClientTxnN_return EtcdClientTxnN(int p0, struct Operation* p1, int p2);
+
 extern GoUint32 EtcdClientCompareAndSwap(int p0, char* p1, char* p2, char* p3, int p4, int p5, int p6);
 
 /* Return type for EtcdElectionCampaign */
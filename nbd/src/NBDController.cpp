@@ -136,9 +136,10 @@ int IOController::MapOnNbdDeviceByDevPath(int sockfd,
     return 0;
 }
 
-int IOController::SetUp(NBDConfig* config, int sockfd,
+int IOController::SetUp(NBDConfig* config, const std::vector<int>& sockfds,
                         uint64_t size, uint64_t flags) {
     int ret = -1;
+    int sockfd = sockfds.front();
 
     if (config->devpath.empty()) {
         ret = MapOnUnusedNbdDevice(sockfd, &config->devpath);
@@ -240,7 +241,8 @@ void NetLinkController::Uninit() {
     nlId_ = -1;
 }
 
-int NetLinkController::SetUp(NBDConfig* config, int sockfd,
+int NetLinkController::SetUp(NBDConfig* config,
+                             const std::vector<int>& sockfds,
                              uint64_t size, uint64_t flags) {
     int ret = Init();
     if (ret < 0) {
@@ -249,7 +251,7 @@ int NetLinkController::SetUp(NBDConfig* config, int sockfd,
         return ret;
     }
 
-    ret = ConnectInternal(config, sockfd, size, flags);
+    ret = ConnectInternal(config, sockfds, size, flags);
     Uninit();
     if (ret < 0) {
         return ret;
@@ -360,7 +362,8 @@ static int netlink_connect_cb(struct nl_msg *msg, void *arg) {
     return NL_OK;
 }
 
-int NetLinkController::ConnectInternal(NBDConfig* config, int sockfd,
+int NetLinkController::ConnectInternal(NBDConfig* config,
+                                       const std::vector<int>& sockfds,
                                        uint64_t size, uint64_t flags) {
     struct nlattr *sock_attr = nullptr;
     struct nlattr *sock_opt = nullptr;
@@ -403,15 +406,18 @@ int NetLinkController::ConnectInternal(NBDConfig* config, int sockfd,
         goto nla_put_failure;
     }
 
-    sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
-    if (sock_opt == nullptr) {
-        dout << "curve-nbd: Could not init sock in netlink message."
-             << std::endl;
-        goto nla_put_failure;
-    }
+    // 每个连接对应一个NBD_SOCK_ITEM
+    for (int sockfd : sockfds) {
+        sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
+        if (sock_opt == nullptr) {
+            dout << "curve-nbd: Could not init sock in netlink message."
+                 << std::endl;
+            goto nla_put_failure;
+        }
 
-    NLA_PUT_U32(msg, NBD_SOCK_FD, sockfd);
-    nla_nest_end(msg, sock_opt);
+        NLA_PUT_U32(msg, NBD_SOCK_FD, sockfd);
+        nla_nest_end(msg, sock_opt);
+    }
     nla_nest_end(msg, sock_attr);
 
     ret = nl_send_sync(sock_, msg);
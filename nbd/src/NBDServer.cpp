@@ -44,6 +44,8 @@
 #include <inttypes.h>
 #include <netinet/in.h>
 
+#include <chrono>  // NOLINT
+
 #include "nbd/src/util.h"
 
 namespace curve {
@@ -80,6 +82,32 @@ static std::ostream& operator<<(std::ostream& os, const IOContext& ctx) {
     return os;
 }
 
+// 释放已完成请求链表中的所有请求
+static void DestroyRequests(IOContext* ctxs) {
+    while (ctxs != nullptr) {
+        IOContext* next = ctxs->next;
+        delete ctxs;
+        ctxs = next;
+    }
+}
+
+NBDServer::NBDServer(const std::vector<int>& socks, NBDControllerPtr nbdCtrl,
+                     std::shared_ptr<ImageInstance> imageInstance,
+                     std::shared_ptr<SafeIO> safeIO)
+    : started_(false),
+      terminated_(false),
+      nbdCtrl_(nbdCtrl),
+      image_(imageInstance),
+      safeIO_(safeIO),
+      pendingRequestCounts_(0) {
+    for (size_t i = 0; i < socks.size(); ++i) {
+        std::unique_ptr<Connection> conn(new Connection());
+        conn->index = i;
+        conn->sock = socks[i];
+        conns_.push_back(std::move(conn));
+    }
+}
+
 void NBDServer::NBDAioCallback(struct NebdClientAioContext* aioCtx) {
     IOContext* ctx = reinterpret_cast<IOContext*>(
         reinterpret_cast<char*>(aioCtx) - offsetof(IOContext, nebdAioCtx));
@@ -99,8 +127,10 @@ NBDServer::~NBDServer() {
 
         Shutdown();
 
-        writerThread_.join();
-        readerThread_.join();
+        for (auto& conn : conns_) {
+            conn->writerThread.join();
+            conn->readerThread.join();
+        }
 
         WaitClean();
 
@@ -117,8 +147,12 @@ void NBDServer::Start() {
 
     started_ = true;
 
-    readerThread_ = std::thread(&NBDServer::ReaderFunc, this);
-    writerThread_ = std::thread(&NBDServer::WriterFunc, this);
+    for (auto& conn : conns_) {
+        conn->readerThread =
+            std::thread(&NBDServer::ReaderFunc, this, conn.get());
+        conn->writerThread =
+            std::thread(&NBDServer::WriterFunc, this, conn.get());
+    }
 
     return;
 }
@@ -137,22 +171,29 @@ void NBDServer::Shutdown() {
     bool expected = false;
 
     if (terminated_.compare_exchange_strong(expected, true)) {
-        shutdown(sock_, SHUT_RDWR);
+        // 任意一个连接出错都关闭所有连接
+        for (auto& conn : conns_) {
+            shutdown(conn->sock, SHUT_RDWR);
+        }
 
-        std::lock_guard<std::mutex> lk(requestMtx_);
-        requestCond_.notify_all();
+        for (auto& conn : conns_) {
+            std::lock_guard<std::mutex> lk(conn->mtx);
+            conn->cond.notify_all();
+        }
     }
 }
 
-void NBDServer::ReaderFunc() {
+void NBDServer::ReaderFunc(Connection* conn) {
     ssize_t r = 0;
     bool disconnect = false;
 
     while (!terminated_) {
         std::unique_ptr<IOContext> ctx(new IOContext());
         ctx->server = this;
+        ctx->connIndex = conn->index;
 
-        r = safeIO_->ReadExact(sock_, &ctx->request, sizeof(ctx->request));
+        r = safeIO_->ReadExact(conn->sock, &ctx->request,
+                               sizeof(ctx->request));
         if (r < 0) {
             LOG(ERROR) << "Failed to read nbd request header: "
                        << cpp_strerror(r);
@@ -184,7 +225,7 @@ void NBDServer::ReaderFunc() {
                 ctx->data.reset(new char[ctx->request.len]);
 
                 // 写请求，继续读取写入数据
-                r = safeIO_->ReadExact(sock_, ctx->data.get(),
+                r = safeIO_->ReadExact(conn->sock, ctx->data.get(),
                                        ctx->request.len);
                 if (r < 0) {
                     LOG(ERROR) << "Failed to read nbd request data "
@@ -208,6 +249,7 @@ void NBDServer::ReaderFunc() {
 
         if (ret == false) {
             pctx->nebdAioCtx.ret = -1;
+            pctx->reply.error = htonl(EINVAL);
             OnRequestFinish(pctx);
             break;
         }
@@ -221,78 +263,112 @@ void NBDServer::ReaderFunc() {
     Shutdown();
 }
 
-void NBDServer::WriterFunc() {
+void NBDServer::WriterFunc(Connection* conn) {
     signal(SIGPIPE, SIG_IGN);
 
-    ssize_t r = 0;
-
     while (!terminated_) {
-        std::unique_ptr<IOContext> ctx(WaitRequestFinish());
+        IOContext* ctxs = WaitRequestFinish(conn);
 
-        if (ctx == nullptr) {
+        if (ctxs == nullptr) {
             LOG(INFO) << "No more requests, terminating";
             break;
         }
 
-        r = safeIO_->Write(sock_, &ctx->reply, sizeof(struct nbd_reply));
+        ssize_t r = SendReplies(conn, ctxs);
+        DestroyRequests(ctxs);
         if (r < 0) {
-            LOG(ERROR) << *ctx << ": failed to write reply header : "
-                       << cpp_strerror(r);
-            return;
+            break;
         }
+    }
 
+    LOG(INFO) << "WriterFunc terminated!";
+    Shutdown();
+}
+
+ssize_t NBDServer::SendReplies(Connection* conn, IOContext* ctxs) {
+    // 每个请求最多需要返回头部和读取的数据两段
+    std::vector<struct iovec> iov;
+    for (IOContext* ctx = ctxs; ctx != nullptr; ctx = ctx->next) {
+        iov.push_back({&ctx->reply, sizeof(struct nbd_reply)});
         if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-            r = safeIO_->Write(sock_, ctx->data.get(), ctx->request.len);
-            if (r < 0) {
-                LOG(ERROR) << *ctx << ": faield to write reply date : "
-                           << cpp_strerror(r);
-                return;
-            }
+            iov.push_back({ctx->data.get(), ctx->request.len});
         }
     }
 
-    LOG(INFO) << "WriterFunc terminated!";
-    Shutdown();
+    ssize_t r = safeIO_->Writev(conn->sock, iov.data(), iov.size());
+    if (r < 0) {
+        LOG(ERROR) << *ctxs << ": failed to write replies : "
+                   << cpp_strerror(r);
+    }
+
+    return r;
 }
 
-IOContext* NBDServer::WaitRequestFinish() {
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(
-        lk, [this]() { return !finishedRequests_.empty() || terminated_; });
+IOContext* NBDServer::TakeFinishedRequests(Connection* conn) {
+    IOContext* ctx = conn->completed.exchange(nullptr);
 
-    if (finishedRequests_.empty()) {
-        return nullptr;
+    // 链表中后完成的请求在前，反转后按完成顺序返回
+    IOContext* ctxs = nullptr;
+    while (ctx != nullptr) {
+        IOContext* next = ctx->next;
+        ctx->next = ctxs;
+        ctxs = ctx;
+        ctx = next;
     }
 
-    IOContext* ctx = finishedRequests_.front();
-    finishedRequests_.pop_front();
+    return ctxs;
+}
+
+IOContext* NBDServer::WaitRequestFinish(Connection* conn) {
+    IOContext* ctxs = TakeFinishedRequests(conn);
+    if (ctxs != nullptr) {
+        return ctxs;
+    }
+
+    std::unique_lock<std::mutex> lk(conn->mtx);
+    conn->writerWaiting = true;
+    conn->cond.wait(lk, [this, conn]() {
+        return conn->completed.load() != nullptr || terminated_;
+    });
+    conn->writerWaiting = false;
 
-    return ctx;
+    return TakeFinishedRequests(conn);
 }
 
 void NBDServer::OnRequestStart() {
-    std::lock_guard<std::mutex> lk(requestMtx_);
-    ++pendingRequestCounts_;
+    pendingRequestCounts_.fetch_add(1);
 }
 
 void NBDServer::OnRequestFinish(IOContext* ctx) {
-    std::lock_guard<std::mutex> lk(requestMtx_);
-
-    --pendingRequestCounts_;
+    Connection* conn = conns_[ctx->connIndex].get();
+
+    IOContext* head = conn->completed.load();
+    do {
+        ctx->next = head;
+    } while (!conn->completed.compare_exchange_weak(head, ctx));
+
+    // 只有写线程在等待时才需要加锁唤醒，写线程设置标记后会再检查链表，
+    // 两边都是顺序一致的原子操作，不会丢失唤醒
+    if (conn->writerWaiting) {
+        std::lock_guard<std::mutex> lk(conn->mtx);
+        conn->cond.notify_one();
+    }
 
-    finishedRequests_.push_back(ctx);
-    requestCond_.notify_all();
+    // 计数减为0后WaitClean返回，server随即析构，这里必须是最后一次访问server
+    pendingRequestCounts_.fetch_sub(1);
 }
 
 void NBDServer::WaitClean() {
     LOG(INFO) << "WaitClean, current pending requests: "
               << pendingRequestCounts_;
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(lk, [this]() { return pendingRequestCounts_ == 0; });
 
-    while (!finishedRequests_.empty()) {
-        std::unique_ptr<IOContext> ctx(finishedRequests_.front());
-        finishedRequests_.pop_front();
+    // 只在退出时执行，轮询等待即可，不需要在请求返回路径上加锁通知
+    while (pendingRequestCounts_ != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (auto& conn : conns_) {
+        DestroyRequests(TakeFinishedRequests(conn.get()));
     }
 }
 
@@ -43,11 +43,11 @@
 #include <linux/nbd.h>
 #include <atomic>
 #include <condition_variable>  // NOLINT
-#include <deque>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "nbd/src/ImageInstance.h"
 #include "nbd/src/NBDController.h"
@@ -68,6 +68,10 @@ struct IOContext {
     int command = 0;
 
     NBDServer* server = nullptr;
+    // 请求所在连接的下标
+    size_t connIndex = 0;
+    // 已完成请求链表中的下一个请求
+    IOContext* next = nullptr;
     std::unique_ptr<char[]> data;
 
     // NEBD请求上下文信息
@@ -79,18 +83,18 @@ struct IOContext {
 };
 
 // NBDServer负责与nbd内核进行数据通信
+// 每个连接有自己的读线程和写线程，请求完成后放入所在连接的无锁链表，
+// 由该连接的写线程批量取出，通过一次writev返回给内核
 class NBDServer {
  public:
     NBDServer(int sock, NBDControllerPtr nbdCtrl,
               std::shared_ptr<ImageInstance> imageInstance,
               std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>())
-        : started_(false),
-          terminated_(false),
-          sock_(sock),
-          nbdCtrl_(nbdCtrl),
-          image_(imageInstance),
-          pendingRequestCounts_(0),
-          safeIO_(safeIO) {}
+        : NBDServer(std::vector<int>{sock}, nbdCtrl, imageInstance, safeIO) {}
+
+    NBDServer(const std::vector<int>& socks, NBDControllerPtr nbdCtrl,
+              std::shared_ptr<ImageInstance> imageInstance,
+              std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>());
 
     ~NBDServer();
 
@@ -131,15 +135,36 @@ class NBDServer {
      */
     void WaitClean();
 
+    // 与内核之间的一个连接
+    struct Connection {
+        // 连接在conns_中的下标
+        size_t index = 0;
+        // 与内核通信的socket fd
+        int sock = -1;
+        // 读线程
+        std::thread readerThread;
+        // 写线程
+        std::thread writerThread;
+
+        // 已完成请求链表，后完成的在前
+        std::atomic<IOContext*> completed{nullptr};
+        // 写线程是否在等待请求完成
+        std::atomic<bool> writerWaiting{false};
+        std::mutex mtx;
+        std::condition_variable cond;
+    };
+
     /**
      * @brief 读线程执行函数
+     * @param conn 读线程所在的连接
      */
-    void ReaderFunc();
+    void ReaderFunc(Connection* conn);
 
     /**
      * @brief 写线程执行函数
+     * @param conn 写线程所在的连接
      */
-    void WriterFunc();
+    void WriterFunc(Connection* conn);
 
     /**
      * @brief 异步请求开始时执行函数
@@ -153,10 +178,23 @@ class NBDServer {
     void OnRequestFinish(IOContext* ctx);
 
     /**
-     * @brief 等待异步请求返回
-     * @return 异步请求context
+     * @brief 等待连接上的异步请求返回
+     * @param conn 等待的连接
+     * @return 已完成的请求链表，按完成顺序排列，server停止时返回nullptr
+     */
+    IOContext* WaitRequestFinish(Connection* conn);
+
+    /**
+     * @brief 取出连接上全部已完成的请求
+     * @return 已完成的请求链表，按完成顺序排列
      */
-    IOContext* WaitRequestFinish();
+    static IOContext* TakeFinishedRequests(Connection* conn);
+
+    /**
+     * @brief 将一批请求的返回通过writev发送给内核
+     * @return 成功返回0，失败返回负值
+     */
+    ssize_t SendReplies(Connection* conn, IOContext* ctxs);
 
     /**
      * 发起异步请求
@@ -171,26 +209,14 @@ class NBDServer {
     // server是否停止
     std::atomic<bool> terminated_;
 
-    // 与内核通信的socket fd
-    int sock_;
+    // 与内核之间的连接
+    std::vector<std::unique_ptr<Connection>> conns_;
     NBDControllerPtr nbdCtrl_;
     std::shared_ptr<ImageInstance> image_;
     std::shared_ptr<SafeIO> safeIO_;
 
-    // 保护pendingRequestCounts_和finishedRequests_
-    std::mutex requestMtx_;
-    std::condition_variable requestCond_;
-
     // 正在执行过程中的请求数量
-    uint64_t pendingRequestCounts_;
-
-    // 已完成请求上下文队列
-    std::deque<IOContext*> finishedRequests_;
-
-    // 读线程
-    std::thread readerThread_;
-    // 写线程
-    std::thread writerThread_;
+    std::atomic<uint64_t> pendingRequestCounts_;
 
     // 等待断开连接锁/条件变量
     std::mutex disconnectMutex_;
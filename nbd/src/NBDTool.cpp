@@ -59,14 +59,6 @@ NBDControllerPtr NBDTool::GetController(bool tryNetlink) {
 int NBDTool::Connect(NBDConfig *cfg) {
     // loadmodule 到时候放到外面做
 
-    // init socket pair
-    int ret = socketPair_.Init();
-    if (ret < 0) {
-        dout << "init socker pair failed, imgname = " << cfg->imgname
-             << std::endl;
-        return ret;
-    }
-
     // 初始化打开文件
     ImagePtr imageInstance = GenerateImage(cfg->imgname);
     bool openSuccess = imageInstance->Open();
@@ -89,14 +81,39 @@ int NBDTool::Connect(NBDConfig *cfg) {
     }
 
     // load nbd module
-    ret = load_module(cfg);
+    int ret = load_module(cfg);
     if (ret < 0) {
         dout << "load module failed, imgname = " << cfg->imgname << std::endl;
         return ret;
     }
 
-    NBDControllerPtr nbdCtrl = GetController(cfg->try_netlink);
-    nbdServer_ = std::make_shared<NBDServer>(socketPair_.Second(), nbdCtrl,
+    // 多个连接只能通过netlink方式建立
+    NBDControllerPtr nbdCtrl =
+        GetController(cfg->try_netlink || cfg->num_connections > 1);
+    if (cfg->num_connections > 1 && !nbdCtrl->IsNetLink()) {
+        dout << "curve-nbd: netlink interface not supported, "
+             << "use 1 connection instead of " << cfg->num_connections
+             << std::endl;
+        cfg->num_connections = 1;
+    }
+
+    // init socket pair
+    std::vector<int> kernelSocks;
+    std::vector<int> serverSocks;
+    for (int i = 0; i < cfg->num_connections; ++i) {
+        std::unique_ptr<NBDSocketPair> socketPair(new NBDSocketPair());
+        ret = socketPair->Init();
+        if (ret < 0) {
+            dout << "init socker pair failed, imgname = " << cfg->imgname
+                 << std::endl;
+            return ret;
+        }
+        kernelSocks.push_back(socketPair->First());
+        serverSocks.push_back(socketPair->Second());
+        socketPairs_.push_back(std::move(socketPair));
+    }
+
+    nbdServer_ = std::make_shared<NBDServer>(serverSocks, nbdCtrl,
                                              imageInstance);
 
     // setup controller
@@ -105,7 +122,12 @@ int NBDTool::Connect(NBDConfig *cfg) {
     if (cfg->readonly) {
         flags |= NBD_FLAG_READ_ONLY;
     }
-    ret = nbdCtrl->SetUp(cfg, socketPair_.First(), fileSize, flags);
+    // 内核要求多个连接时设置该flag，flush在nebd侧作用于整个卷，
+    // 任意连接上完成的flush对所有连接上已完成的写请求都生效
+    if (cfg->num_connections > 1) {
+        flags |= NBD_FLAG_CAN_MULTI_CONN;
+    }
+    ret = nbdCtrl->SetUp(cfg, kernelSocks, fileSize, flags);
     if (ret < 0) {
         dout << "nbd controller setup failed, imgname = " << cfg->imgname
              << std::endl;
@@ -112,7 +112,8 @@ class NBDTool {
         int fd_[2];
     };
 
-    NBDSocketPair socketPair_;
+    // 每个连接对应一个socketpair
+    std::vector<std::unique_ptr<NBDSocketPair>> socketPairs_;
     NBDServerPtr nbdServer_;
     std::shared_ptr<NBDWatchContext> nbdWatchCtx_;
 };
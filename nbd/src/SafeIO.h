@@ -24,6 +24,7 @@
 #ifndef NBD_SRC_SAFEIO_H_
 #define NBD_SRC_SAFEIO_H_
 
+#include <sys/uio.h>
 #include <cstddef>
 #include <cstdio>
 
@@ -39,6 +40,7 @@ class SafeIO {
     virtual ssize_t ReadExact(int fd, void* buf, size_t count);
     virtual ssize_t Read(int fd, void* buf, size_t count);
     virtual ssize_t Write(int fd, const void* buf, size_t count);
+    virtual ssize_t Writev(int fd, struct iovec* iov, int iovcnt);
 };
 
 }  // namespace nbd
@@ -40,6 +40,7 @@
 #ifndef NBD_SRC_DEFINE_H_
 #define NBD_SRC_DEFINE_H_
 
+#include <linux/nbd.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/types.h>
@@ -56,6 +57,12 @@ namespace nbd {
 #define HELP_INFO 1
 #define VERSION_INFO 2
 #define CURVE_NBD_BLKSIZE 4096UL    // CURVE后端当前支持4096大小对齐的IO
+#define CURVE_NBD_MAX_CONNECTIONS 16  // 每个nbd设备最多的连接数
+
+// 较老的内核头文件中没有定义
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN (1 << 8)
+#endif
 
 #define NBD_MAX_PATH "/sys/module/nbd/parameters/nbds_max"
 #define PROCESS_NAME "curve-nbd"
@@ -78,6 +85,8 @@ struct NBDConfig {
     bool set_max_part = false;
     // 是否以netlink方式控制nbd内核模块
     bool try_netlink = false;
+    // 每个nbd设备与内核之间的连接数，大于1时需要netlink方式
+    int num_connections = 1;
     // 需要映射的后端文件名称
     std::string imgname;
     // 指定需要映射的nbd设备路径
@@ -41,7 +41,9 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <libgen.h>
+#include <limits.h>
 #include <string.h>
+#include <algorithm>
 #include <sstream>
 #include "nbd/src/define.h"
 #include "nbd/src/util.h"
@@ -153,6 +155,18 @@ int parse_args(std::vector<const char*>& args, std::ostream *err_msg,   // NOLIN
             }
         } else if (argparse_flag(args, i, "--try-netlink", (char *)NULL)) { // NOLINT
             cfg->try_netlink = true;
+        } else if (argparse_witharg(args, i, &cfg->num_connections, err,
+                                    "--connections", (char *)NULL)) {   // NOLINT
+            if (!err.str().empty()) {
+                *err_msg << "curve-nbd: " << err.str();
+                return -EINVAL;
+            }
+            if (cfg->num_connections < 1 ||
+                cfg->num_connections > CURVE_NBD_MAX_CONNECTIONS) {
+                *err_msg << "curve-nbd: Invalid argument for connections(1~"
+                         << CURVE_NBD_MAX_CONNECTIONS << ")!";
+                return -EINVAL;
+            }
         }  else if (argparse_flag(args, i, "-f", "--force", (char *)NULL)) {  // NOLINT
             cfg->force_unmap = true;
         } else if (argparse_witharg(args, i, &cfg->retry_times, err, "--retry_times", (char*)(NULL))) {  // NOLINT
@@ -500,5 +514,28 @@ ssize_t safe_write(int fd, const void* buf, size_t count) {
     return 0;
 }
 
+ssize_t safe_writev(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t r = writev(fd, iov, std::min(iovcnt, IOV_MAX));
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        // 跳过已经写完的部分
+        while (iovcnt > 0 && (size_t)r >= iov->iov_len) {
+            r -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + r;  // NOLINT
+            iov->iov_len -= r;
+        }
+    }
+    return 0;
+}
+
 }  // namespace nbd
 }  // namespace curve
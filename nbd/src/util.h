@@ -25,6 +25,7 @@
 #ifndef NBD_SRC_UTIL_H_
 #define NBD_SRC_UTIL_H_
 
+#include <sys/uio.h>
 #include <string>
 #include <vector>
 #include "nbd/src/define.h"
@@ -67,6 +68,8 @@ int check_dev_can_unmap(const NBDConfig *cfg);
 ssize_t safe_read_exact(int fd, void* buf, size_t count);
 ssize_t safe_read(int fd, void* buf, size_t count);
 ssize_t safe_write(int fd, const void* buf, size_t count);
+// 写入iov中的所有数据，iov会被修改
+ssize_t safe_writev(int fd, struct iovec* iov, int iovcnt);
 
 // 网络字节序转换
 inline uint64_t ntohll(uint64_t val) {
@@ -40,6 +40,7 @@ class MockSafeIO : public SafeIO {
     MOCK_METHOD3(ReadExact, ssize_t(int, void*, size_t));
     MOCK_METHOD3(Read, ssize_t(int, void*, size_t));
     MOCK_METHOD3(Write, ssize_t(int, const void*, size_t));
+    MOCK_METHOD3(Writev, ssize_t(int, struct iovec*, int));
 };
 
 }  // namespace nbd
@@ -30,6 +30,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <memory>
+#include <vector>
 #include "nbd/src/NBDServer.h"
 #include "nbd/test/fake_safe_io.h"
 #include "nbd/test/mock_image_instance.h"
@@ -296,5 +297,106 @@ TEST_F(NBDServerTest, ReadWriteDataErrorTest) {
     ASSERT_TRUE(server_->IsTerminated());
 }
 
+TEST_F(NBDServerTest, ReplyInCompletionOrderTest) {
+    ASSERT_NO_THROW(server_->Start());
+
+    const int kRequests = 3;
+    std::vector<NebdClientAioContext*> nebdContexts;
+    EXPECT_CALL(*image_, AioRead(_))
+        .Times(kRequests)
+        .WillRepeatedly(Invoke([&](NebdClientAioContext* ctx) {
+            nebdContexts.push_back(ctx);
+        }));
+
+    for (int i = 0; i < kRequests; ++i) {
+        request_.from = 0;
+        request_.len = htonl(8);
+        request_.type = htonl(NBD_CMD_READ);
+        request_.magic = htonl(NBD_REQUEST_MAGIC);
+        memset(&request_.handle, i, sizeof(request_.handle));
+        ASSERT_EQ(NBDRequestSize, write(fd_[0], &request_, NBDRequestSize));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+    ASSERT_EQ(static_cast<size_t>(kRequests), nebdContexts.size());
+
+    // 逆序完成，返回顺序与完成顺序一致
+    for (int i = kRequests - 1; i >= 0; --i) {
+        memset(nebdContexts[i]->buf, i, nebdContexts[i]->length);
+        nebdContexts[i]->cb(nebdContexts[i]);
+    }
+
+    for (int i = kRequests - 1; i >= 0; --i) {
+        char readbuf[8];
+        char expected[8];
+        memset(expected, i, sizeof(expected));
+        ASSERT_EQ(NBDReplySize, read(fd_[0], &reply_, NBDReplySize));
+        ASSERT_EQ(0, reply_.error);
+        ASSERT_EQ(0, memcmp(reply_.handle, expected, sizeof(reply_.handle)));
+        ASSERT_EQ(sizeof(readbuf), read(fd_[0], readbuf, sizeof(readbuf)));
+        ASSERT_EQ(0, memcmp(readbuf, expected, sizeof(expected)));
+    }
+}
+
+TEST_F(NBDServerTest, MultiConnectionTest) {
+    int fd2[2];
+    ASSERT_NE(-1, socketpair(AF_UNIX, SOCK_STREAM, 0, fd2));
+    server_.reset(new NBDServer(std::vector<int>{fd_[1], fd2[1]}, nullptr,
+                                image_));
+    ASSERT_NO_THROW(server_->Start());
+
+    NebdClientAioContext* readContext;
+    NebdClientAioContext* writeContext;
+    EXPECT_CALL(*image_, AioRead(_))
+        .Times(1)
+        .WillOnce(SaveArg<0>(&readContext));
+    EXPECT_CALL(*image_, AioWrite(_))
+        .Times(1)
+        .WillOnce(SaveArg<0>(&writeContext));
+
+    // 第一个连接上发送读请求
+    request_.from = 0;
+    request_.len = htonl(8);
+    request_.type = htonl(NBD_CMD_READ);
+    request_.magic = htonl(NBD_REQUEST_MAGIC);
+    memset(&request_.handle, 1, sizeof(request_.handle));
+    ASSERT_EQ(NBDRequestSize, write(fd_[0], &request_, NBDRequestSize));
+
+    // 第二个连接上发送写请求
+    request_.type = htonl(NBD_CMD_WRITE);
+    memset(&request_.handle, 2, sizeof(request_.handle));
+    ASSERT_EQ(NBDRequestSize, write(fd2[0], &request_, NBDRequestSize));
+    ASSERT_EQ(8, write(fd2[0], "hello, world", 8));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+
+    // 请求的返回发送到请求所在的连接
+    char expected[8];
+    writeContext->cb(writeContext);
+    ASSERT_EQ(NBDReplySize, read(fd2[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+    memset(expected, 2, sizeof(expected));
+    ASSERT_EQ(0, memcmp(reply_.handle, expected, sizeof(reply_.handle)));
+
+    memcpy(readContext->buf, handle_, sizeof(handle_));
+    readContext->cb(readContext);
+    char readbuf[8];
+    ASSERT_EQ(NBDReplySize, read(fd_[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+    memset(expected, 1, sizeof(expected));
+    ASSERT_EQ(0, memcmp(reply_.handle, expected, sizeof(reply_.handle)));
+    ASSERT_EQ(sizeof(readbuf), read(fd_[0], readbuf, sizeof(readbuf)));
+    ASSERT_EQ(0, memcmp(readbuf, handle_, sizeof(handle_)));
+
+    // 任意一个连接断开，server停止
+    ::shutdown(fd2[0], SHUT_RDWR);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+    ASSERT_TRUE(server_->IsTerminated());
+
+    server_.reset();
+    ::close(fd2[0]);
+    ::close(fd2[1]);
+}
+
 }  // namespace nbd
 }  // namespace curve
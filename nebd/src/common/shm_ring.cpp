@@ -0,0 +1,387 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#include "nebd/src/common/shm_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <string>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+namespace nebd {
+namespace common {
+
+namespace {
+
+const size_t kPageSize = 4096;
+const uint32_t kMaxDepth = 4096;
+const uint32_t kMaxSlotSize = 64 * 1024 * 1024;
+
+size_t AlignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+bool IsPowerOfTwo(uint32_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+size_t SubmitOffset() {
+    return AlignUp(sizeof(ShmRingHeader), 64);
+}
+
+size_t CompleteOffset(uint32_t depth) {
+    return AlignUp(SubmitOffset() + depth * sizeof(ShmSubmitEntry), 64);
+}
+
+size_t SlotOffset(uint32_t depth) {
+    return AlignUp(CompleteOffset(depth) + depth * sizeof(ShmCompleteEntry),
+                   kPageSize);
+}
+
+// 共享内存大小固定后part1不能再修改，否则part2访问时会收到SIGBUS
+const int kShmRequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+}  // namespace
+
+ShmRing::ShmRing()
+    : depth_(0),
+      slotSize_(0),
+      fd_(-1),
+      base_(nullptr),
+      size_(0),
+      header_(nullptr),
+      submits_(nullptr),
+      completes_(nullptr),
+      slots_(nullptr) {}
+
+ShmRing::~ShmRing() {
+    Destroy();
+}
+
+size_t ShmRing::RegionSize(uint32_t depth, uint32_t slotSize) {
+    return SlotOffset(depth) + static_cast<size_t>(depth) * slotSize;
+}
+
+int ShmRing::Create(uint32_t depth, uint32_t slotSize) {
+    if (!IsPowerOfTwo(depth) || depth > kMaxDepth ||
+        slotSize == 0 || slotSize > kMaxSlotSize) {
+        LOG(ERROR) << "Invalid shm ring size, depth = " << depth
+                   << ", slot size = " << slotSize;
+        return -EINVAL;
+    }
+
+    // 共享内存没有名字，只通过fd传递给part2
+    int fd = syscall(SYS_memfd_create, "nebd-shm",
+                     MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        int err = errno;
+        LOG(ERROR) << "Create shm failed, error = " << strerror(err);
+        return -err;
+    }
+
+    size_t size = RegionSize(depth, slotSize);
+    if (ftruncate(fd, size) != 0) {
+        int err = errno;
+        LOG(ERROR) << "Truncate shm failed, size = " << size
+                   << ", error = " << strerror(err);
+        close(fd);
+        return -err;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, kShmRequiredSeals) != 0) {
+        int err = errno;
+        LOG(ERROR) << "Seal shm failed, error = " << strerror(err);
+        close(fd);
+        return -err;
+    }
+
+    int ret = Map(fd, size);
+    if (ret != 0) {
+        close(fd);
+        return ret;
+    }
+
+    InitLayout(depth, slotSize);
+    header_->magic = kShmRingMagic;
+    header_->version = kShmRingVersion;
+    header_->depth = depth;
+    header_->slotSize = slotSize;
+    header_->submitHead = 0;
+    header_->submitTail = 0;
+    header_->completeHead = 0;
+    header_->completeTail = 0;
+    header_->serverWaiting = 0;
+    header_->clientWaiting = 0;
+    return 0;
+}
+
+int ShmRing::Attach(int fd) {
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & kShmRequiredSeals) != kShmRequiredSeals) {
+        LOG(ERROR) << "Shm is not sealed, seals = " << seals;
+        return -EINVAL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -errno;
+    }
+
+    size_t size = st.st_size;
+    if (size < sizeof(ShmRingHeader)) {
+        LOG(ERROR) << "Shm is too small, size = " << size;
+        return -EINVAL;
+    }
+
+    int ret = Map(fd, size);
+    if (ret != 0) {
+        return ret;
+    }
+
+    uint32_t depth = header_->depth;
+    uint32_t slotSize = header_->slotSize;
+    if (header_->magic != kShmRingMagic ||
+        header_->version != kShmRingVersion ||
+        !IsPowerOfTwo(depth) || depth > kMaxDepth ||
+        slotSize == 0 || slotSize > kMaxSlotSize ||
+        RegionSize(depth, slotSize) > size) {
+        LOG(ERROR) << "Invalid shm ring, magic = " << header_->magic
+                   << ", version = " << header_->version
+                   << ", depth = " << depth
+                   << ", slot size = " << slotSize
+                   << ", shm size = " << size;
+        munmap(base_, size_);
+        base_ = nullptr;
+        header_ = nullptr;
+        fd_ = -1;
+        return -EINVAL;
+    }
+
+    InitLayout(depth, slotSize);
+    return 0;
+}
+
+void ShmRing::InitLayout(uint32_t depth, uint32_t slotSize) {
+    depth_ = depth;
+    slotSize_ = slotSize;
+    submits_ = reinterpret_cast<ShmSubmitEntry*>(
+        static_cast<char*>(base_) + SubmitOffset());
+    completes_ = reinterpret_cast<ShmCompleteEntry*>(
+        static_cast<char*>(base_) + CompleteOffset(depth));
+    slots_ = static_cast<char*>(base_) + SlotOffset(depth);
+}
+
+int ShmRing::Map(int fd, size_t size) {
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    if (base == MAP_FAILED) {
+        int err = errno;
+        LOG(ERROR) << "Map shm failed, size = " << size
+                   << ", error = " << strerror(err);
+        return -err;
+    }
+
+    fd_ = fd;
+    base_ = base;
+    size_ = size;
+    header_ = static_cast<ShmRingHeader*>(base);
+    return 0;
+}
+
+void ShmRing::Destroy() {
+    if (base_ != nullptr) {
+        munmap(base_, size_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    header_ = nullptr;
+}
+
+void ShmRing::Submit(const ShmSubmitEntry& entry) {
+    uint32_t head = header_->submitHead.load(std::memory_order_relaxed);
+    submits_[head & (depth_ - 1)] = entry;
+    header_->submitHead.store(head + 1);
+}
+
+bool ShmRing::PopSubmit(ShmSubmitEntry* entry) {
+    uint32_t tail = header_->submitTail.load(std::memory_order_relaxed);
+    if (tail == header_->submitHead.load()) {
+        return false;
+    }
+
+    *entry = submits_[tail & (depth_ - 1)];
+    header_->submitTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::HasSubmit() const {
+    return header_->submitTail.load(std::memory_order_relaxed) !=
+           header_->submitHead.load();
+}
+
+bool ShmRing::PushComplete(const ShmCompleteEntry& entry) {
+    uint32_t head = header_->completeHead.load(std::memory_order_relaxed);
+    if (head - header_->completeTail.load(std::memory_order_acquire) >=
+        depth_) {
+        return false;
+    }
+
+    completes_[head & (depth_ - 1)] = entry;
+    header_->completeHead.store(head + 1);
+    return true;
+}
+
+bool ShmRing::PopComplete(ShmCompleteEntry* entry) {
+    uint32_t tail = header_->completeTail.load(std::memory_order_relaxed);
+    if (tail == header_->completeHead.load()) {
+        return false;
+    }
+
+    *entry = completes_[tail & (depth_ - 1)];
+    header_->completeTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::HasComplete() const {
+    return header_->completeTail.load(std::memory_order_relaxed) !=
+           header_->completeHead.load();
+}
+
+int SendWithFds(int sock, const void* buf, size_t len,
+                const int* fds, int nfds) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+
+    char control[CMSG_SPACE(sizeof(int) * kShmMaxHandshakeFds)];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (nfds > 0) {
+        if (nfds > kShmMaxHandshakeFds) {
+            return -EINVAL;
+        }
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+    }
+
+    ssize_t n = 0;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -errno;
+    }
+    return static_cast<size_t>(n) == len ? 0 : -EPROTO;
+}
+
+int RecvWithFds(int sock, void* buf, size_t len, int* fds, int* nfds) {
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    char control[CMSG_SPACE(sizeof(int) * kShmMaxHandshakeFds)];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = 0;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -errno;
+    } else if (n == 0) {
+        return -ECONNRESET;
+    }
+
+    int capacity = *nfds;
+    *nfds = 0;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+
+        int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int* received = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+        for (int i = 0; i < count; ++i) {
+            // 多余的fd直接关闭，避免泄漏
+            if (*nfds < capacity) {
+                fds[(*nfds)++] = received[i];
+            } else {
+                close(received[i]);
+            }
+        }
+    }
+
+    if (static_cast<size_t>(n) != len || (msg.msg_flags & MSG_CTRUNC)) {
+        for (int i = 0; i < *nfds; ++i) {
+            close(fds[i]);
+        }
+        *nfds = 0;
+        return -EPROTO;
+    }
+
+    return 0;
+}
+
+}  // namespace common
+}  // namespace nebd
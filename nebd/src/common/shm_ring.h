@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#ifndef NEBD_SRC_COMMON_SHM_RING_H_
+#define NEBD_SRC_COMMON_SHM_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "nebd/src/common/uncopyable.h"
+
+namespace nebd {
+namespace common {
+
+// 共享内存由part1和part2两个进程映射，其中的原子变量必须是无锁的
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic int must be lock free");
+
+const uint32_t kShmRingMagic = 0x6e656264;  // "nebd"
+const uint32_t kShmRingVersion = 1;
+// 一次握手最多传递的fd数量
+const int kShmMaxHandshakeFds = 3;
+
+// part1提交给part2的请求
+struct ShmSubmitEntry {
+    // 请求类型，取值与LIBAIO_OP一致
+    uint32_t op;
+    // 请求编号，同时也是请求数据槽位的下标
+    uint32_t tag;
+    uint64_t offset;
+    uint64_t length;
+};
+
+// part2返回给part1的请求结果
+struct ShmCompleteEntry {
+    uint32_t tag;
+    int32_t ret;
+};
+
+// 共享内存头部，生产者和消费者修改的下标放在不同的cache line
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    // 环的长度，也是最多同时下发的请求数，2的幂
+    uint32_t depth;
+    // 每个请求数据槽位的大小
+    uint32_t slotSize;
+
+    // 提交队列，part1生产，part2消费
+    alignas(64) std::atomic<uint32_t> submitHead;
+    alignas(64) std::atomic<uint32_t> submitTail;
+    // 完成队列，part2生产，part1消费
+    alignas(64) std::atomic<uint32_t> completeHead;
+    alignas(64) std::atomic<uint32_t> completeTail;
+
+    // 消费者准备阻塞在eventfd上时设置，生产者只在设置时才写eventfd
+    alignas(64) std::atomic<uint32_t> serverWaiting;
+    alignas(64) std::atomic<uint32_t> clientWaiting;
+};
+
+/**
+ * part1和part2之间的共享内存通道，内存布局为：
+ * | 头部 | 提交队列 | 完成队列 | depth个数据槽位 |
+ * 每个请求占用一个编号，编号对应的数据槽位存放读写的数据，
+ * 同时下发的请求数不超过depth，两个队列都不会溢出。
+ * 两个队列都是单生产者单消费者，多线程生产时由调用方加锁。
+ */
+class ShmRing : public Uncopyable {
+ public:
+    ShmRing();
+    ~ShmRing();
+
+    /**
+     * @brief 计算共享内存的大小
+     */
+    static size_t RegionSize(uint32_t depth, uint32_t slotSize);
+
+    /**
+     * @brief part1创建并初始化共享内存，创建后封住共享内存的大小
+     * @param depth 队列长度，必须是2的幂
+     * @param slotSize 每个请求最大的数据量
+     * @return 成功返回0，失败返回-errno
+     */
+    int Create(uint32_t depth, uint32_t slotSize);
+
+    /**
+     * @brief part2映射part1创建的共享内存，并检查格式，
+     *        共享内存必须已经封住大小，不允许part1再修改
+     * @param fd 共享内存的fd，映射成功后由ShmRing负责关闭
+     * @return 成功返回0，失败返回-errno
+     */
+    int Attach(int fd);
+
+    /**
+     * @brief 解除映射并关闭fd
+     */
+    void Destroy();
+
+    int Fd() const {
+        return fd_;
+    }
+
+    uint32_t Depth() const {
+        return depth_;
+    }
+
+    uint32_t SlotSize() const {
+        return slotSize_;
+    }
+
+    ShmRingHeader* Header() const {
+        return header_;
+    }
+
+    char* SlotData(uint32_t tag) const {
+        return slots_ + static_cast<size_t>(tag) * slotSize_;
+    }
+
+    // 提交队列，part1调用
+    void Submit(const ShmSubmitEntry& entry);
+    // 提交队列，part2调用，队列为空时返回false
+    bool PopSubmit(ShmSubmitEntry* entry);
+    bool HasSubmit() const;
+
+    // 完成队列，part2调用，队列已满时返回false
+    bool PushComplete(const ShmCompleteEntry& entry);
+    // 完成队列，part1调用，队列为空时返回false
+    bool PopComplete(ShmCompleteEntry* entry);
+    bool HasComplete() const;
+
+ private:
+    int Map(int fd, size_t size);
+    void InitLayout(uint32_t depth, uint32_t slotSize);
+
+ private:
+    // 对端可以修改共享内存，队列长度和槽位大小使用校验后的本地副本
+    uint32_t depth_;
+    uint32_t slotSize_;
+    int fd_;
+    void* base_;
+    size_t size_;
+    ShmRingHeader* header_;
+    ShmSubmitEntry* submits_;
+    ShmCompleteEntry* completes_;
+    char* slots_;
+};
+
+// part1连接part2时发送的握手消息，
+// 同时通过SCM_RIGHTS传递共享内存fd、提交通知eventfd和完成通知eventfd
+struct ShmHandshakeRequest {
+    uint32_t magic;
+    // 已经打开的nebd文件fd
+    int32_t fd;
+};
+
+struct ShmHandshakeResponse {
+    // 0表示成功
+    int32_t ret;
+};
+
+/**
+ * @brief 在unix socket上发送消息，同时传递fd
+ * @return 成功返回0，失败返回-errno
+ */
+int SendWithFds(int sock, const void* buf, size_t len,
+                const int* fds, int nfds);
+
+/**
+ * @brief 在unix socket上接收消息和fd
+ * @param[out] fds 接收到的fd
+ * @param[in,out] nfds 输入fds的容量，输出接收到的fd数量
+ * @return 成功返回0，失败返回-errno，对端关闭返回-ECONNRESET
+ */
+int RecvWithFds(int sock, void* buf, size_t len, int* fds, int* nfds);
+
+}  // namespace common
+}  // namespace nebd
+
+#endif  // NEBD_SRC_COMMON_SHM_RING_H_
@@ -121,6 +121,15 @@ void NebdClient::Uninit() {
         heartbeatMgr_->Stop();
     }
 
+    std::unordered_map<int, std::shared_ptr<ShmChannel>> shmChannels;
+    {
+        nebd::common::WriteLockGuard lk(shmChannelsLock_);
+        shmChannels.swap(shmChannels_);
+    }
+    for (auto& channel : shmChannels) {
+        channel.second->Close();
+    }
+
     // stop exec queue
     for (auto& q : rpcTaskQueues_) {
         bthread::execution_queue_stop(q);
@@ -182,10 +191,17 @@ int NebdClient::Open(const char* filename) {
     }
 
     metaCache_->AddFileInfo({fd, filename, fileLock});
+
+    if (option_.shmOption.enable) {
+        OpenShmChannel(fd);
+    }
+
     return fd;
 }
 
 int NebdClient::Close(int fd) {
+    CloseShmChannel(fd);
+
     auto task = [&](brpc::Controller* cntl,
                     brpc::Channel* channel,
                     bool* rpcFailed) -> int64_t {
@@ -307,6 +323,10 @@ int64_t NebdClient::GetFileSize(int fd) {
 }
 
 int NebdClient::Discard(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::DiscardRequest request;
@@ -327,6 +347,10 @@ int NebdClient::Discard(int fd, NebdClientAioContext* aioctx) {
 }
 
 int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::ReadRequest request;
@@ -349,6 +373,10 @@ int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
 static void EmptyDeleter(void* m) {}
 
 int NebdClient::AioWrite(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::WriteRequest request;
@@ -372,6 +400,10 @@ int NebdClient::AioWrite(int fd, NebdClientAioContext* aioctx) {
 }
 
 int NebdClient::Flush(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::FlushRequest request;
@@ -522,6 +554,33 @@ int NebdClient::InitNebdClientOption(Configuration* conf) {
     LOG_IF(ERROR, ret != true) << "Load log.path failed";
     RETURN_IF_FALSE(ret);
 
+    return InitShmOption(conf, &option_.shmOption);
+}
+
+int NebdClient::InitShmOption(Configuration* conf, ShmOption* shmOption) {
+    bool ret = conf->GetBoolValue("shm.enable", &shmOption->enable);
+    LOG_IF(WARNING, ret != true)
+        << "Load shm.enable from config file failed, current value is "
+        << shmOption->enable;
+    if (!shmOption->enable) {
+        return 0;
+    }
+
+    ret = conf->GetStringValue("shm.serverAddress",
+                               &shmOption->serverAddress);
+    LOG_IF(ERROR, ret != true) << "Load shm.serverAddress failed";
+    RETURN_IF_FALSE(ret);
+
+    ret = conf->GetUInt32Value("shm.ioDepth", &shmOption->ioDepth);
+    LOG_IF(ERROR, ret != true)
+        << "Load shm.ioDepth from config file failed, current value is "
+        << shmOption->ioDepth;
+
+    ret = conf->GetUInt32Value("shm.maxIoSize", &shmOption->maxIoSize);
+    LOG_IF(ERROR, ret != true)
+        << "Load shm.maxIoSize from config file failed, current value is "
+        << shmOption->maxIoSize;
+
     return 0;
 }
 
@@ -587,6 +646,76 @@ int64_t NebdClient::ExecuteSyncRpc(RpcTask task) {
     return -1;
 }
 
+void NebdClient::OpenShmChannel(int fd) {
+    // 通道断开后，未完成的请求重新下发，此时通道已经不可用，请求会走rpc
+    auto fallback = [this, fd](NebdClientAioContext* aioctx) {
+        switch (aioctx->op) {
+            case LIBAIO_OP::LIBAIO_OP_READ:
+                AioRead(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_WRITE:
+                AioWrite(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_DISCARD:
+                Discard(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_FLUSH:
+                Flush(fd, aioctx);
+                break;
+            default:
+                LOG(ERROR) << "Unknown aio op " << aioctx->op;
+                aioctx->ret = -1;
+                aioctx->cb(aioctx);
+                break;
+        }
+    };
+
+    std::shared_ptr<ShmChannel> channel = std::make_shared<ShmChannel>(
+        fd, option_.shmOption, fallback);
+    int ret = channel->Init();
+    if (ret != 0) {
+        LOG(WARNING) << "Init shm channel failed, use rpc instead, fd = "
+                     << fd;
+        return;
+    }
+
+    nebd::common::WriteLockGuard lk(shmChannelsLock_);
+    shmChannels_[fd] = channel;
+}
+
+void NebdClient::CloseShmChannel(int fd) {
+    std::shared_ptr<ShmChannel> channel;
+    {
+        nebd::common::WriteLockGuard lk(shmChannelsLock_);
+        auto iter = shmChannels_.find(fd);
+        if (iter == shmChannels_.end()) {
+            return;
+        }
+        channel = iter->second;
+        shmChannels_.erase(iter);
+    }
+
+    // 关闭时可能会重新下发请求，不能持有锁
+    channel->Close();
+}
+
+bool NebdClient::SubmitByShm(int fd, NebdClientAioContext* aioctx) {
+    std::shared_ptr<ShmChannel> channel;
+    {
+        nebd::common::ReadLockGuard lk(shmChannelsLock_);
+        if (shmChannels_.empty()) {
+            return false;
+        }
+        auto iter = shmChannels_.find(fd);
+        if (iter == shmChannels_.end()) {
+            return false;
+        }
+        channel = iter->second;
+    }
+
+    return channel->Submit(aioctx);
+}
+
 std::string NebdClient::ReplaceSlash(const std::string& str) {
     std::string ret(str);
     for (auto& ch : ret) {
@@ -29,14 +29,17 @@
 #include <functional>
 #include <string>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "nebd/src/part1/nebd_common.h"
 #include "nebd/src/common/configuration.h"
+#include "nebd/src/common/rw_lock.h"
 #include "nebd/proto/client.pb.h"
 #include "nebd/src/part1/libnebd.h"
 #include "nebd/src/part1/heartbeat_manager.h"
 #include "nebd/src/part1/nebd_metacache.h"
+#include "nebd/src/part1/shm_channel.h"
 
 #include "include/curve_compiler_specific.h"
 
@@ -154,6 +157,8 @@ class NebdClient {
 
     int InitChannel();
 
+    int InitShmOption(Configuration* conf, ShmOption* shmOption);
+
     void InitLogger(const LogOption& logOption);
 
     /**
@@ -165,6 +170,20 @@ class NebdClient {
     std::string ReplaceSlash(const std::string& str);
 
     int64_t ExecuteSyncRpc(RpcTask task);
+
+    /**
+     * @brief 文件打开后建立共享内存通道，失败时该文件的请求走rpc
+     */
+    void OpenShmChannel(int fd);
+
+    void CloseShmChannel(int fd);
+
+    /**
+     * @brief 通过共享内存通道下发请求
+     * @return 下发成功返回true，否则需要通过rpc下发
+     */
+    bool SubmitByShm(int fd, NebdClientAioContext* aioctx);
+
     // 心跳管理模块
     std::shared_ptr<HeartbeatManager> heartbeatMgr_;
     // 缓存模块
@@ -176,6 +195,10 @@ class NebdClient {
 
     std::atomic<uint64_t> logId_{1};
 
+    // 已建立的共享内存通道，key为文件fd
+    std::unordered_map<int, std::shared_ptr<ShmChannel>> shmChannels_;
+    nebd::common::RWLock shmChannelsLock_;
+
  private:
     using AsyncRpcTask = std::function<void()>;
 
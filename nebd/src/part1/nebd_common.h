@@ -49,6 +49,18 @@ struct LogOption {
     std::string logPath;
 };
 
+// 共享内存通道配置项
+struct ShmOption {
+    // 是否通过共享内存下发读写请求
+    bool enable = false;
+    // part2共享内存通道的socket file address
+    std::string serverAddress;
+    // 每个文件最多同时通过共享内存下发的请求数，必须是2的幂
+    uint32_t ioDepth = 64;
+    // 通过共享内存下发的请求最大的数据量，更大的请求通过rpc下发
+    uint32_t maxIoSize = 256 * 1024;
+};
+
 // nebd client配置项
 struct NebdClientOption {
     // part2 socket file address
@@ -59,6 +71,8 @@ struct NebdClientOption {
     RequestOption requestOption;
     // 日志配置项
     LogOption logOption;
+    // 共享内存通道配置项
+    ShmOption shmOption;
 };
 
 // heartbeat配置项
@@ -0,0 +1,326 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#include "nebd/src/part1/shm_channel.h"
+
+#include <glog/logging.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace nebd {
+namespace client {
+
+using nebd::common::kShmRingMagic;
+using nebd::common::ShmCompleteEntry;
+using nebd::common::ShmHandshakeRequest;
+using nebd::common::ShmHandshakeResponse;
+using nebd::common::ShmRingHeader;
+using nebd::common::ShmSubmitEntry;
+
+// 等待part2握手返回的超时时间
+const int kHandshakeTimeoutS = 3;
+
+ShmChannel::ShmChannel(int fd, const ShmOption& option, ShmFallback fallback)
+    : fd_(fd),
+      option_(option),
+      fallback_(fallback),
+      submitEventFd_(-1),
+      completeEventFd_(-1),
+      sock_(-1),
+      broken_(false),
+      running_(false) {}
+
+ShmChannel::~ShmChannel() {
+    Close();
+}
+
+int ShmChannel::Init() {
+    int ret = ring_.Create(option_.ioDepth, option_.maxIoSize);
+    if (ret != 0) {
+        LOG(ERROR) << "Create shm ring failed, fd = " << fd_;
+        return -1;
+    }
+
+    submitEventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    completeEventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (submitEventFd_ < 0 || completeEventFd_ < 0) {
+        LOG(ERROR) << "Create eventfd failed, fd = " << fd_
+                   << ", error = " << strerror(errno);
+        return -1;
+    }
+
+    ret = Connect();
+    if (ret != 0) {
+        return -1;
+    }
+
+    uint32_t depth = ring_.Depth();
+    freeTags_.reserve(depth);
+    for (uint32_t tag = depth; tag > 0; --tag) {
+        freeTags_.push_back(tag - 1);
+    }
+    inflight_.assign(depth, nullptr);
+
+    running_ = true;
+    completionThread_ = std::thread(&ShmChannel::CompletionFunc, this);
+
+    LOG(INFO) << "Shm channel established, fd = " << fd_
+              << ", io depth = " << depth
+              << ", max io size = " << ring_.SlotSize();
+    return 0;
+}
+
+int ShmChannel::Connect() {
+    sock_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock_ < 0) {
+        LOG(ERROR) << "Create socket failed, error = " << strerror(errno);
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (option_.serverAddress.size() >= sizeof(addr.sun_path)) {
+        LOG(ERROR) << "Shm server address is too long: "
+                   << option_.serverAddress;
+        return -1;
+    }
+    strncpy(addr.sun_path, option_.serverAddress.c_str(),
+            sizeof(addr.sun_path) - 1);
+
+    if (connect(sock_, reinterpret_cast<struct sockaddr*>(&addr),
+                sizeof(addr)) != 0) {
+        LOG(WARNING) << "Connect to shm server failed, address = "
+                     << option_.serverAddress
+                     << ", error = " << strerror(errno);
+        return -1;
+    }
+
+    struct timeval timeout = {kHandshakeTimeoutS, 0};
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    ShmHandshakeRequest request;
+    request.magic = kShmRingMagic;
+    request.fd = fd_;
+    int fds[] = {ring_.Fd(), submitEventFd_, completeEventFd_};
+    int ret = nebd::common::SendWithFds(sock_, &request, sizeof(request),
+                                        fds, 3);
+    if (ret != 0) {
+        LOG(WARNING) << "Send shm handshake failed, fd = " << fd_
+                     << ", error = " << strerror(-ret);
+        return -1;
+    }
+
+    ShmHandshakeResponse response;
+    int nfds = 0;
+    ret = nebd::common::RecvWithFds(sock_, &response, sizeof(response),
+                                    nullptr, &nfds);
+    if (ret != 0 || response.ret != 0) {
+        LOG(WARNING) << "Shm handshake failed, fd = " << fd_
+                     << ", error = " << strerror(-ret)
+                     << ", response = " << (ret == 0 ? response.ret : 0);
+        return -1;
+    }
+
+    return 0;
+}
+
+bool ShmChannel::Submit(NebdClientAioContext* aioctx) {
+    uint64_t length = aioctx->op == LIBAIO_OP::LIBAIO_OP_FLUSH
+                          ? 0 : aioctx->length;
+    if (length > ring_.SlotSize()) {
+        return false;
+    }
+
+    uint32_t tag = 0;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (broken_ || freeTags_.empty()) {
+            return false;
+        }
+        tag = freeTags_.back();
+        freeTags_.pop_back();
+    }
+
+    // 占用编号后槽位只属于当前请求，拷贝数据时不需要加锁
+    if (aioctx->op == LIBAIO_OP::LIBAIO_OP_WRITE) {
+        memcpy(ring_.SlotData(tag), aioctx->buf, length);
+    }
+
+    ShmSubmitEntry entry;
+    entry.op = aioctx->op;
+    entry.tag = tag;
+    entry.offset = aioctx->offset;
+    entry.length = length;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (broken_) {
+            freeTags_.push_back(tag);
+            return false;
+        }
+        inflight_[tag] = aioctx;
+        ring_.Submit(entry);
+    }
+
+    if (ring_.Header()->serverWaiting.load()) {
+        uint64_t one = 1;
+        ssize_t n = write(submitEventFd_, &one, sizeof(one));
+        (void)n;
+    }
+
+    return true;
+}
+
+void ShmChannel::Close() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t n = write(completeEventFd_, &one, sizeof(one));
+        (void)n;
+        completionThread_.join();
+    }
+
+    if (sock_ >= 0) {
+        close(sock_);
+        sock_ = -1;
+    }
+    if (submitEventFd_ >= 0) {
+        close(submitEventFd_);
+        submitEventFd_ = -1;
+    }
+    if (completeEventFd_ >= 0) {
+        close(completeEventFd_);
+        completeEventFd_ = -1;
+    }
+    ring_.Destroy();
+}
+
+void ShmChannel::CompletionFunc() {
+    ShmRingHeader* header = ring_.Header();
+
+    while (running_) {
+        HandleCompletions();
+
+        // 设置等待标记后再检查一次，避免丢失part2的通知
+        header->clientWaiting = 1;
+        if (ring_.HasComplete()) {
+            header->clientWaiting = 0;
+            continue;
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = completeEventFd_;
+        fds[0].events = POLLIN;
+        fds[1].fd = sock_;
+        fds[1].events = POLLIN;
+        int ret = poll(fds, 2, -1);
+        header->clientWaiting = 0;
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "Poll shm channel failed, fd = " << fd_
+                       << ", error = " << strerror(errno);
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t count = 0;
+            ssize_t n = read(completeEventFd_, &count, sizeof(count));
+            (void)n;
+        }
+
+        // part2不会在连接上发送数据，连接可读说明对端已经关闭
+        if (fds[1].revents != 0) {
+            HandleCompletions();
+            LOG(WARNING) << "Shm channel disconnected, fd = " << fd_;
+            break;
+        }
+    }
+
+    FailInflightRequests();
+}
+
+void ShmChannel::HandleCompletions() {
+    ShmCompleteEntry entry;
+    while (ring_.PopComplete(&entry)) {
+        if (entry.tag >= ring_.Depth()) {
+            LOG(ERROR) << "Invalid shm completion tag " << entry.tag
+                       << ", fd = " << fd_;
+            continue;
+        }
+
+        NebdClientAioContext* aioctx = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            std::swap(aioctx, inflight_[entry.tag]);
+        }
+        if (aioctx == nullptr) {
+            LOG(ERROR) << "Shm completion of unknown request, tag = "
+                       << entry.tag << ", fd = " << fd_;
+            continue;
+        }
+
+        if (entry.ret >= 0 && aioctx->op == LIBAIO_OP::LIBAIO_OP_READ) {
+            memcpy(aioctx->buf, ring_.SlotData(entry.tag), aioctx->length);
+        }
+
+        // 数据拷贝完成后才能释放槽位
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            freeTags_.push_back(entry.tag);
+        }
+
+        aioctx->ret = entry.ret < 0 ? -1 : 0;
+        aioctx->cb(aioctx);
+    }
+}
+
+void ShmChannel::FailInflightRequests() {
+    std::vector<NebdClientAioContext*> aioctxs;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        broken_ = true;
+        for (auto& aioctx : inflight_) {
+            if (aioctx != nullptr) {
+                aioctxs.push_back(aioctx);
+                aioctx = nullptr;
+            }
+        }
+    }
+
+    if (!aioctxs.empty()) {
+        LOG(WARNING) << "Shm channel broken, resubmit " << aioctxs.size()
+                     << " requests, fd = " << fd_;
+    }
+
+    for (auto aioctx : aioctxs) {
+        fallback_(aioctx);
+    }
+}
+
+}  // namespace client
+}  // namespace nebd
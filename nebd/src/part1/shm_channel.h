@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#ifndef NEBD_SRC_PART1_SHM_CHANNEL_H_
+#define NEBD_SRC_PART1_SHM_CHANNEL_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part1/libnebd.h"
+#include "nebd/src/part1/nebd_common.h"
+
+namespace nebd {
+namespace client {
+
+using nebd::common::ShmRing;
+
+// 通道断开时，未完成的请求交给调用方重新下发
+using ShmFallback = std::function<void(NebdClientAioContext*)>;
+
+/**
+ * 单个文件与part2之间的共享内存通道
+ * 读写请求的数据通过共享内存中的槽位传递，请求和结果通过共享内存中的队列传递，
+ * 对端阻塞等待时才通过eventfd通知。open/close等控制请求仍然走rpc。
+ * part2退出或者通道出错后，未完成的请求通过fallback重新下发，
+ * 之后的请求都返回false，由调用方通过rpc下发。
+ */
+class ShmChannel {
+ public:
+    ShmChannel(int fd, const ShmOption& option, ShmFallback fallback);
+    ~ShmChannel();
+
+    /**
+     * @brief 创建共享内存并与part2建立连接
+     * @return 成功返回0，失败返回-1
+     */
+    int Init();
+
+    /**
+     * @brief 通过共享内存下发请求
+     * @return 下发成功返回true；请求过大、没有空闲槽位或者通道已断开返回false，
+     *         此时请求需要通过rpc下发
+     */
+    bool Submit(NebdClientAioContext* aioctx);
+
+    /**
+     * @brief 关闭通道
+     */
+    void Close();
+
+    bool IsBroken() const {
+        return broken_;
+    }
+
+ private:
+    int Connect();
+
+    // 完成线程执行函数
+    void CompletionFunc();
+
+    // 处理完成队列中的所有请求
+    void HandleCompletions();
+
+    // 通道断开后重新下发未完成的请求
+    void FailInflightRequests();
+
+ private:
+    // nebd文件fd
+    int fd_;
+    ShmOption option_;
+    ShmFallback fallback_;
+
+    ShmRing ring_;
+    // 通知part2有新请求
+    int submitEventFd_;
+    // part2通知有请求完成
+    int completeEventFd_;
+    // 与part2之间的连接，只用于握手和感知对端退出
+    int sock_;
+
+    // 保护提交队列、freeTags_、inflight_和broken_
+    std::mutex mtx_;
+    // 空闲的请求编号
+    std::vector<uint32_t> freeTags_;
+    // 已下发的请求，下标为请求编号
+    std::vector<NebdClientAioContext*> inflight_;
+    std::atomic<bool> broken_;
+
+    std::atomic<bool> running_;
+    std::thread completionThread_;
+};
+
+}  // namespace client
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART1_SHM_CHANNEL_H_
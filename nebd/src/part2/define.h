@@ -122,6 +122,8 @@ const char HEARTBEATTIMEOUTSEC[] = "heartbeat.timeout.sec";
 const char HEARTBEATCHECKINTERVALMS[] = "heartbeat.check.interval.ms";
 const char CURVECLIENTCONFPATH[] = "curveclient.confPath";
 const char RESPONSERETURNRPCWHENIOERROR[] = "response.returnRpcWhenIoError";
+const char SHMENABLE[] = "shm.enable";
+const char SHMLISTENADDRESS[] = "shm.listen.address";
 
 }  // namespace server
 }  // namespace nebd
@@ -251,13 +251,48 @@ bool NebdServer::StartServer() {
         return false;
     }
 
+    if (false == StartShmServer(returnRpcWhenIoError)) {
+        LOG(ERROR) << "NebdServer start shm server fail";
+        server_.Stop(0);
+        server_.Join();
+        return false;
+    }
+
     isRunning_ = true;
     server_.RunUntilAskedToQuit();
 
+    if (shmServer_ != nullptr) {
+        shmServer_->Stop();
+    }
     isRunning_ = false;
     fileLock.ReleaseFileLock();
     return true;
 }
 
+bool NebdServer::StartShmServer(bool returnRpcWhenIoError) {
+    bool enable = false;
+    bool ret = conf_.GetBoolValue(SHMENABLE, &enable);
+    LOG_IF(WARNING, false == ret) << "get " << SHMENABLE
+                                  << " fail, shm server is disabled";
+    if (!enable) {
+        return true;
+    }
+
+    std::string address;
+    ret = conf_.GetStringValue(SHMLISTENADDRESS, &address);
+    if (false == ret) {
+        LOG(ERROR) << "get " << SHMLISTENADDRESS << " fail";
+        return false;
+    }
+
+    shmServer_.reset(new NebdShmServer(fileManager_, returnRpcWhenIoError));
+    if (0 != shmServer_->Start(address)) {
+        shmServer_.reset();
+        return false;
+    }
+
+    return true;
+}
+
 }  // namespace server
 }  // namespace nebd
@@ -30,6 +30,7 @@
 #include "nebd/src/part2/file_manager.h"
 #include "nebd/src/part2/heartbeat_manager.h"
 #include "nebd/src/part2/request_executor_curve.h"
+#include "nebd/src/part2/shm_service.h"
 
 namespace nebd {
 namespace server {
@@ -95,6 +96,12 @@ class NebdServer {
      */
     bool StartServer();
 
+    /**
+     * @brief 启动共享内存服务，配置中未开启时不启动
+     * @return false-启动失败 true-启动成功或者未开启
+     */
+    bool StartShmServer(bool returnRpcWhenIoError);
+
  private:
     // 配置项
     Configuration conf_;
@@ -111,6 +118,8 @@ class NebdServer {
     std::shared_ptr<HeartbeatManager> heartbeatManager_;
     // curveclient
     std::shared_ptr<CurveClient> curveClient_;
+    // 通过共享内存接受part1的读写请求
+    std::unique_ptr<NebdShmServer> shmServer_;
 };
 
 }  // namespace server
@@ -0,0 +1,495 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#include "nebd/src/part2/shm_service.h"
+
+#include <butil/iobuf.h>
+#include <glog/logging.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+
+#include "nebd/src/part2/util.h"
+
+namespace nebd {
+namespace server {
+
+using nebd::common::kShmMaxHandshakeFds;
+using nebd::common::kShmRingMagic;
+using nebd::common::ShmCompleteEntry;
+using nebd::common::ShmHandshakeRequest;
+using nebd::common::ShmHandshakeResponse;
+using nebd::common::ShmRingHeader;
+
+// 共享内存请求的上下文
+struct NebdShmAioContext : public NebdServerAioContext {
+    NebdShmConnection* connection = nullptr;
+    uint32_t tag = 0;
+    // 读写数据，写请求直接引用共享内存中的数据
+    butil::IOBuf data;
+};
+
+static void EmptyDeleter(void* m) {}
+
+NebdShmConnection::NebdShmConnection(
+    int sock, std::shared_ptr<NebdFileManager> fileManager,
+    bool returnRpcWhenIoError)
+    : sock_(sock),
+      fileManager_(fileManager),
+      returnRpcWhenIoError_(returnRpcWhenIoError),
+      fd_(-1),
+      submitEventFd_(-1),
+      completeEventFd_(-1),
+      stopEventFd_(eventfd(0, EFD_CLOEXEC)),
+      inflight_(0),
+      established_(false),
+      stopping_(false),
+      finished_(false) {
+    if (stopEventFd_ < 0) {
+        LOG(ERROR) << "Create shm stop eventfd failed, error = "
+                   << strerror(errno);
+    }
+}
+
+NebdShmConnection::~NebdShmConnection() {
+    Stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (stopEventFd_ >= 0) {
+        close(stopEventFd_);
+    }
+    close(sock_);
+}
+
+void NebdShmConnection::Start() {
+    thread_ = std::thread(&NebdShmConnection::Run, this);
+}
+
+void NebdShmConnection::Stop() {
+    // 先设置stopping_再检查established_，握手完成后处理线程一定能看到stopping_
+    stopping_ = true;
+    if (!established_) {
+        // 还在握手，没有已下发的请求，直接关闭连接唤醒处理线程
+        shutdown(sock_, SHUT_RDWR);
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t n = write(stopEventFd_, &one, sizeof(one));
+    (void)n;
+}
+
+void NebdShmConnection::Run() {
+    // 无法唤醒处理线程时不建立连接，part1的请求走rpc
+    if (stopEventFd_ < 0) {
+        LOG(WARNING) << "Shm connection without stop eventfd, close it";
+    } else if (Handshake() == 0) {
+        established_ = true;
+        Process();
+    }
+
+    // 不再从提交队列取请求，等已下发的请求把结果放入完成队列后再关闭连接，
+    // part1收完这些结果后只把part2没有处理的请求改走rpc
+    WaitInflightRequests();
+    shutdown(sock_, SHUT_RDWR);
+
+    ring_.Destroy();
+    if (submitEventFd_ >= 0) {
+        close(submitEventFd_);
+        submitEventFd_ = -1;
+    }
+    if (completeEventFd_ >= 0) {
+        close(completeEventFd_);
+        completeEventFd_ = -1;
+    }
+
+    LOG(INFO) << "Shm connection closed, fd = " << fd_;
+    finished_ = true;
+}
+
+int NebdShmConnection::Handshake() {
+    ShmHandshakeRequest request;
+    int fds[kShmMaxHandshakeFds];
+    int nfds = kShmMaxHandshakeFds;
+    int ret = nebd::common::RecvWithFds(sock_, &request, sizeof(request),
+                                        fds, &nfds);
+    if (ret != 0) {
+        LOG(WARNING) << "Receive shm handshake failed, error = "
+                     << strerror(-ret);
+        return -1;
+    }
+
+    ShmHandshakeResponse response;
+    response.ret = 0;
+    if (request.magic != kShmRingMagic || nfds != kShmMaxHandshakeFds) {
+        LOG(ERROR) << "Invalid shm handshake, magic = " << request.magic
+                   << ", fd count = " << nfds;
+        response.ret = -EPROTO;
+    } else if (fileManager_->GetFileEntity(request.fd) == nullptr) {
+        LOG(ERROR) << "Shm handshake with unopened file, fd = " << request.fd;
+        response.ret = -EBADF;
+    } else {
+        response.ret = ring_.Attach(fds[0]);
+    }
+
+    if (response.ret == 0) {
+        fd_ = request.fd;
+        submitEventFd_ = fds[1];
+        completeEventFd_ = fds[2];
+
+        uint32_t depth = ring_.Depth();
+        busyTags_.reset(new std::atomic<bool>[depth]);
+        for (uint32_t i = 0; i < depth; ++i) {
+            busyTags_[i] = false;
+        }
+    } else {
+        for (int i = 0; i < nfds; ++i) {
+            close(fds[i]);
+        }
+    }
+
+    ret = nebd::common::SendWithFds(sock_, &response, sizeof(response),
+                                    nullptr, 0);
+    if (ret != 0) {
+        LOG(WARNING) << "Send shm handshake response failed, error = "
+                     << strerror(-ret);
+        return -1;
+    }
+
+    if (response.ret == 0) {
+        LOG(INFO) << "Shm connection established, fd = " << fd_
+                  << ", io depth = " << ring_.Depth()
+                  << ", max io size = " << ring_.SlotSize();
+    }
+    return response.ret == 0 ? 0 : -1;
+}
+
+void NebdShmConnection::Process() {
+    ShmRingHeader* header = ring_.Header();
+    ShmSubmitEntry entry;
+
+    while (!stopping_) {
+        while (!stopping_ && ring_.PopSubmit(&entry)) {
+            if (!HandleSubmit(entry)) {
+                return;
+            }
+        }
+
+        // 设置等待标记后再检查一次，避免丢失part1的通知
+        header->serverWaiting = 1;
+        if (ring_.HasSubmit()) {
+            header->serverWaiting = 0;
+            continue;
+        }
+
+        struct pollfd fds[3];
+        fds[0].fd = submitEventFd_;
+        fds[0].events = POLLIN;
+        fds[1].fd = sock_;
+        fds[1].events = POLLIN;
+        fds[2].fd = stopEventFd_;
+        fds[2].events = POLLIN;
+        int ret = poll(fds, 3, -1);
+        header->serverWaiting = 0;
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "Poll shm connection failed, fd = " << fd_
+                       << ", error = " << strerror(errno);
+            return;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t count = 0;
+            ssize_t n = read(submitEventFd_, &count, sizeof(count));
+            (void)n;
+        }
+
+        // part1不会在连接上发送数据，连接可读说明对端已经关闭
+        if (fds[1].revents != 0) {
+            LOG(INFO) << "Shm connection disconnected, fd = " << fd_;
+            return;
+        }
+    }
+}
+
+bool NebdShmConnection::HandleSubmit(const ShmSubmitEntry& entry) {
+    // 共享内存中的内容不可信，检查通过后才能使用
+    LIBAIO_OP op = static_cast<LIBAIO_OP>(entry.op);
+    if (entry.tag >= ring_.Depth() || entry.length > ring_.SlotSize() ||
+        entry.op >= static_cast<uint32_t>(LIBAIO_OP::LIBAIO_OP_UNKNOWN)) {
+        LOG(ERROR) << "Invalid shm request, fd = " << fd_
+                   << ", op = " << entry.op << ", tag = " << entry.tag
+                   << ", length = " << entry.length;
+        return false;
+    }
+
+    if (busyTags_[entry.tag].exchange(true)) {
+        LOG(ERROR) << "Shm request tag is still in use, fd = " << fd_
+                   << ", tag = " << entry.tag;
+        return false;
+    }
+
+    NebdShmAioContext* context = new (std::nothrow) NebdShmAioContext();
+    if (context == nullptr) {
+        LOG(ERROR) << "Allocate shm request context failed, fd = " << fd_
+                   << ", tag = " << entry.tag;
+        Complete(entry.tag, -1);
+        return true;
+    }
+    context->connection = this;
+    context->tag = entry.tag;
+    context->offset = entry.offset;
+    context->size = entry.length;
+    context->op = op;
+    context->cb = AioCallback;
+    context->returnRpcWhenIoError = returnRpcWhenIoError_;
+
+    inflight_.fetch_add(1);
+
+    int rc = -1;
+    switch (op) {
+        case LIBAIO_OP::LIBAIO_OP_READ:
+            context->buf = &context->data;
+            rc = fileManager_->AioRead(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_WRITE:
+            if (entry.length > 0) {
+                context->data.append_user_data(ring_.SlotData(entry.tag),
+                                               entry.length, EmptyDeleter);
+            }
+            context->buf = &context->data;
+            rc = fileManager_->AioWrite(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_DISCARD:
+            rc = fileManager_->Discard(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_FLUSH:
+            rc = fileManager_->Flush(fd_, context);
+            break;
+        default:
+            break;
+    }
+
+    // 请求下发失败时不会执行回调，直接返回错误
+    if (rc < 0) {
+        LOG(ERROR) << Op2Str(op) << " file failed. " << *context
+                   << ", return code: " << rc;
+        delete context;
+        Complete(entry.tag, -1);
+        inflight_.fetch_sub(1);
+    }
+
+    return true;
+}
+
+void NebdShmConnection::Complete(uint32_t tag, int ret) {
+    busyTags_[tag] = false;
+
+    ShmCompleteEntry entry;
+    entry.tag = tag;
+    entry.ret = ret;
+
+    bool pushed = false;
+    {
+        std::lock_guard<std::mutex> lk(completeMtx_);
+        pushed = ring_.PushComplete(entry);
+    }
+
+    // 同时下发的请求数不超过队列长度，完成队列满说明part1不遵守协议
+    if (!pushed) {
+        LOG(ERROR) << "Shm complete ring is full, fd = " << fd_;
+        Stop();
+        return;
+    }
+
+    if (ring_.Header()->clientWaiting.load()) {
+        uint64_t one = 1;
+        ssize_t n = write(completeEventFd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+void NebdShmConnection::AioCallback(NebdServerAioContext* context) {
+    CHECK(context != nullptr);
+    std::unique_ptr<NebdShmAioContext> shmContext(
+        static_cast<NebdShmAioContext*>(context));
+    NebdShmConnection* connection = shmContext->connection;
+    uint32_t tag = shmContext->tag;
+
+    if (context->ret < 0 && !context->returnRpcWhenIoError) {
+        // 与rpc一致，不返回io错误，请求一直不返回
+        LOG(ERROR) << *context;
+        LOG(ERROR) << Op2Str(context->op)
+                   << " file failed and drop the shm request.";
+    } else if (context->ret < 0) {
+        LOG(ERROR) << *context;
+        connection->Complete(tag, -1);
+    } else {
+        if (context->op == LIBAIO_OP::LIBAIO_OP_READ) {
+            shmContext->data.copy_to(connection->ring_.SlotData(tag),
+                                     context->size);
+        }
+        connection->Complete(tag, 0);
+    }
+
+    // 计数减为0后连接可能被释放，之后不能再访问connection
+    shmContext.reset();
+    connection->inflight_.fetch_sub(1);
+}
+
+void NebdShmConnection::WaitInflightRequests() {
+    while (inflight_.load() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+NebdShmServer::NebdShmServer(std::shared_ptr<NebdFileManager> fileManager,
+                             bool returnRpcWhenIoError)
+    : fileManager_(fileManager),
+      returnRpcWhenIoError_(returnRpcWhenIoError),
+      listenSock_(-1),
+      wakeupFd_(-1),
+      running_(false) {}
+
+NebdShmServer::~NebdShmServer() {
+    Stop();
+}
+
+int NebdShmServer::Start(const std::string& address) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(addr.sun_path)) {
+        LOG(ERROR) << "Shm listen address is too long: " << address;
+        return -1;
+    }
+    strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenSock_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    wakeupFd_ = eventfd(0, EFD_CLOEXEC);
+    if (listenSock_ < 0 || wakeupFd_ < 0) {
+        LOG(ERROR) << "Create shm listen socket failed, error = "
+                   << strerror(errno);
+        return -1;
+    }
+
+    // 删除上次退出时残留的socket文件
+    unlink(address.c_str());
+    if (bind(listenSock_, reinterpret_cast<struct sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+        listen(listenSock_, SOMAXCONN) != 0) {
+        LOG(ERROR) << "Listen on " << address << " failed, error = "
+                   << strerror(errno);
+        return -1;
+    }
+
+    address_ = address;
+    running_ = true;
+    acceptThread_ = std::thread(&NebdShmServer::AcceptFunc, this);
+
+    LOG(INFO) << "Shm server listen on " << address;
+    return 0;
+}
+
+void NebdShmServer::Stop() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t n = write(wakeupFd_, &one, sizeof(one));
+        (void)n;
+        acceptThread_.join();
+
+        for (auto& connection : connections_) {
+            connection->Stop();
+        }
+        connections_.clear();
+
+        unlink(address_.c_str());
+    }
+
+    if (listenSock_ >= 0) {
+        close(listenSock_);
+        listenSock_ = -1;
+    }
+    if (wakeupFd_ >= 0) {
+        close(wakeupFd_);
+        wakeupFd_ = -1;
+    }
+}
+
+void NebdShmServer::AcceptFunc() {
+    while (running_) {
+        struct pollfd fds[2];
+        fds[0].fd = listenSock_;
+        fds[0].events = POLLIN;
+        fds[1].fd = wakeupFd_;
+        fds[1].events = POLLIN;
+        int ret = poll(fds, 2, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "Poll shm listen socket failed, error = "
+                       << strerror(errno);
+            return;
+        }
+
+        if (fds[1].revents != 0) {
+            return;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int sock = accept4(listenSock_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (sock < 0) {
+                LOG(WARNING) << "Accept shm connection failed, error = "
+                             << strerror(errno);
+                continue;
+            }
+
+            ReapConnections();
+            connections_.emplace_back(new NebdShmConnection(
+                sock, fileManager_, returnRpcWhenIoError_));
+            connections_.back()->Start();
+        }
+    }
+}
+
+void NebdShmServer::ReapConnections() {
+    for (auto iter = connections_.begin(); iter != connections_.end();) {
+        if ((*iter)->Finished()) {
+            iter = connections_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+}  // namespace server
+}  // namespace nebd
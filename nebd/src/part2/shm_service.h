@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#ifndef NEBD_SRC_PART2_SHM_SERVICE_H_
+#define NEBD_SRC_PART2_SHM_SERVICE_H_
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part2/define.h"
+#include "nebd/src/part2/file_manager.h"
+
+namespace nebd {
+namespace server {
+
+using nebd::common::ShmRing;
+using nebd::common::ShmSubmitEntry;
+
+/**
+ * part1一个文件的共享内存连接
+ * 握手时从part1接收共享内存和eventfd，之后从提交队列取出请求交给NebdFileManager，
+ * 请求完成后把结果放入完成队列。Stop后不再取新的请求，等待已下发的请求全部返回
+ * 后再关闭连接并释放共享内存。
+ */
+class NebdShmConnection {
+ public:
+    NebdShmConnection(int sock,
+                      std::shared_ptr<NebdFileManager> fileManager,
+                      bool returnRpcWhenIoError);
+    ~NebdShmConnection();
+
+    void Start();
+
+    void Stop();
+
+    // 连接已经断开，并且已下发的请求都已返回
+    bool Finished() const {
+        return finished_;
+    }
+
+ private:
+    void Run();
+
+    int Handshake();
+
+    void Process();
+
+    /**
+     * @brief 处理提交队列中的一个请求
+     * @return 请求不合法返回false，此时关闭连接
+     */
+    bool HandleSubmit(const ShmSubmitEntry& entry);
+
+    void Complete(uint32_t tag, int ret);
+
+    static void AioCallback(NebdServerAioContext* context);
+
+    void WaitInflightRequests();
+
+ private:
+    friend struct NebdShmAioContext;
+
+    int sock_;
+    std::shared_ptr<NebdFileManager> fileManager_;
+    bool returnRpcWhenIoError_;
+
+    // part1打开文件的fd
+    int fd_;
+    ShmRing ring_;
+    int submitEventFd_;
+    int completeEventFd_;
+    // 用于Stop唤醒处理线程
+    int stopEventFd_;
+
+    // 请求编号是否已下发，防止part1重复使用未完成的编号
+    std::unique_ptr<std::atomic<bool>[]> busyTags_;
+    // 已下发未返回的请求数
+    std::atomic<uint32_t> inflight_;
+    // 完成队列可能由多个线程写入
+    std::mutex completeMtx_;
+
+    // 握手是否成功，之后Stop不再直接关闭连接
+    std::atomic<bool> established_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> finished_;
+    std::thread thread_;
+};
+
+/**
+ * 在unix socket上接受part1的共享内存连接
+ */
+class NebdShmServer {
+ public:
+    NebdShmServer(std::shared_ptr<NebdFileManager> fileManager,
+                  bool returnRpcWhenIoError);
+    ~NebdShmServer();
+
+    /**
+     * @brief 开始监听
+     * @param address unix socket地址
+     * @return 成功返回0，失败返回-1
+     */
+    int Start(const std::string& address);
+
+    void Stop();
+
+ private:
+    void AcceptFunc();
+
+    // 释放已经结束的连接
+    void ReapConnections();
+
+ private:
+    std::shared_ptr<NebdFileManager> fileManager_;
+    bool returnRpcWhenIoError_;
+
+    std::string address_;
+    int listenSock_;
+    // 用于唤醒accept线程
+    int wakeupFd_;
+
+    std::atomic<bool> running_;
+    std::thread acceptThread_;
+    std::list<std::unique_ptr<NebdShmConnection>> connections_;
+};
+
+}  // namespace server
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART2_SHM_SERVICE_H_
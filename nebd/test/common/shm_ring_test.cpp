@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "nebd/src/common/shm_ring.h"
+
+namespace nebd {
+namespace common {
+
+TEST(ShmRingTest, CreateAndAttachTest) {
+    ShmRing ring;
+    ASSERT_EQ(-EINVAL, ring.Create(0, 4096));
+    ASSERT_EQ(-EINVAL, ring.Create(3, 4096));
+    ASSERT_EQ(-EINVAL, ring.Create(4, 0));
+    ASSERT_EQ(0, ring.Create(4, 4096));
+    ASSERT_EQ(4u, ring.Depth());
+    ASSERT_EQ(4096u, ring.SlotSize());
+
+    // 模拟part2通过另一个fd映射同一块共享内存
+    ShmRing peer;
+    ASSERT_EQ(0, peer.Attach(dup(ring.Fd())));
+    ASSERT_EQ(4u, peer.Depth());
+    ASSERT_EQ(4096u, peer.SlotSize());
+
+    memset(ring.SlotData(3), 'a', 4096);
+    ASSERT_EQ(0, memcmp(ring.SlotData(3), peer.SlotData(3), 4096));
+}
+
+TEST(ShmRingTest, AttachInvalidTest) {
+    ShmRing ring;
+    ASSERT_EQ(0, ring.Create(4, 4096));
+
+    ring.Header()->magic = 0;
+    ShmRing peer;
+    int fd = dup(ring.Fd());
+    ASSERT_EQ(-EINVAL, peer.Attach(fd));
+    close(fd);
+
+    // 声明的大小超过共享内存的实际大小
+    ring.Header()->magic = kShmRingMagic;
+    ring.Header()->slotSize = 8192;
+    fd = dup(ring.Fd());
+    ASSERT_EQ(-EINVAL, peer.Attach(fd));
+    close(fd);
+
+    // 没有封住大小的共享内存，part1可以随时缩小
+    ring.Header()->slotSize = 4096;
+    char path[] = "./shm_ring_test_XXXXXX";
+    fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    unlink(path);
+    ssize_t size = ShmRing::RegionSize(4, 4096);
+    ASSERT_EQ(size, pwrite(fd, ring.Header(), size, 0));
+    ASSERT_EQ(-EINVAL, peer.Attach(fd));
+    close(fd);
+
+    // 正常创建的共享内存不能再改变大小
+    ASSERT_NE(0, ftruncate(ring.Fd(), 4096));
+    ASSERT_NE(0, ftruncate(ring.Fd(), size * 2));
+}
+
+TEST(ShmRingTest, SubmitAndCompleteTest) {
+    ShmRing ring;
+    ASSERT_EQ(0, ring.Create(4, 4096));
+    ShmRing peer;
+    ASSERT_EQ(0, peer.Attach(dup(ring.Fd())));
+
+    ShmSubmitEntry submit;
+    ASSERT_FALSE(peer.HasSubmit());
+    ASSERT_FALSE(peer.PopSubmit(&submit));
+
+    // 多次循环，验证下标回绕
+    for (uint32_t round = 0; round < 3; ++round) {
+        for (uint32_t tag = 0; tag < 4; ++tag) {
+            submit.op = round;
+            submit.tag = tag;
+            submit.offset = tag * 4096;
+            submit.length = 4096;
+            ring.Submit(submit);
+        }
+
+        for (uint32_t tag = 0; tag < 4; ++tag) {
+            ASSERT_TRUE(peer.HasSubmit());
+            ASSERT_TRUE(peer.PopSubmit(&submit));
+            ASSERT_EQ(round, submit.op);
+            ASSERT_EQ(tag, submit.tag);
+            ASSERT_EQ(tag * 4096, submit.offset);
+
+            ShmCompleteEntry complete;
+            complete.tag = tag;
+            complete.ret = tag;
+            ASSERT_TRUE(peer.PushComplete(complete));
+        }
+        ASSERT_FALSE(peer.PopSubmit(&submit));
+
+        // 完成队列已满
+        ShmCompleteEntry complete;
+        ASSERT_FALSE(peer.PushComplete(complete));
+
+        for (uint32_t tag = 0; tag < 4; ++tag) {
+            ASSERT_TRUE(ring.HasComplete());
+            ASSERT_TRUE(ring.PopComplete(&complete));
+            ASSERT_EQ(tag, complete.tag);
+            ASSERT_EQ(static_cast<int32_t>(tag), complete.ret);
+        }
+        ASSERT_FALSE(ring.HasComplete());
+        ASSERT_FALSE(ring.PopComplete(&complete));
+    }
+}
+
+TEST(ShmRingTest, SendAndRecvFdsTest) {
+    int socks[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, socks));
+
+    ShmRing ring;
+    ASSERT_EQ(0, ring.Create(4, 4096));
+    ring.SlotData(0)[0] = 'x';
+
+    ShmHandshakeRequest request;
+    request.magic = kShmRingMagic;
+    request.fd = 10;
+    int fds[] = {ring.Fd()};
+    ASSERT_EQ(0, SendWithFds(socks[0], &request, sizeof(request), fds, 1));
+
+    ShmHandshakeRequest received;
+    int receivedFds[kShmMaxHandshakeFds];
+    int nfds = kShmMaxHandshakeFds;
+    ASSERT_EQ(0, RecvWithFds(socks[1], &received, sizeof(received),
+                             receivedFds, &nfds));
+    ASSERT_EQ(kShmRingMagic, received.magic);
+    ASSERT_EQ(10, received.fd);
+    ASSERT_EQ(1, nfds);
+
+    ShmRing peer;
+    ASSERT_EQ(0, peer.Attach(receivedFds[0]));
+    ASSERT_EQ('x', peer.SlotData(0)[0]);
+
+    // 不带fd的消息
+    ShmHandshakeResponse response;
+    response.ret = -EBADF;
+    ASSERT_EQ(0, SendWithFds(socks[1], &response, sizeof(response),
+                             nullptr, 0));
+    nfds = 0;
+    ASSERT_EQ(0, RecvWithFds(socks[0], &response, sizeof(response),
+                             nullptr, &nfds));
+    ASSERT_EQ(-EBADF, response.ret);
+    ASSERT_EQ(0, nfds);
+
+    // 对端关闭
+    close(socks[1]);
+    ASSERT_EQ(-ECONNRESET, RecvWithFds(socks[0], &response, sizeof(response),
+                                       nullptr, &nfds));
+    close(socks[0]);
+}
+
+}  // namespace common
+}  // namespace nebd
@@ -0,0 +1,284 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+// 比较part1和part2之间rpc和共享内存两种方式的IOPS和延迟。
+// part1和part2运行在同一个进程中，part2的请求直接返回，不访问curve，
+// 结果只反映两种传输方式本身的开销。
+//
+// usage: nebd-transport-bench -transport=shm -io_size=4096 -iodepth=32
+
+#include <brpc/server.h>
+#include <butil/fast_rand.h>
+#include <butil/iobuf.h>
+#include <butil/time.h>
+#include <bvar/bvar.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "nebd/src/part1/libnebd.h"
+#include "nebd/src/part1/nebd_client.h"
+#include "nebd/src/part2/file_service.h"
+#include "nebd/src/part2/shm_service.h"
+
+DEFINE_string(transport, "shm", "transport between part1 and part2, "
+              "rpc or shm");
+DEFINE_string(dir, "./nebd_transport_bench",
+              "directory of sockets, lock files and logs");
+DEFINE_uint64(io_size, 4096, "size of each I/O");
+DEFINE_uint32(iodepth, 32, "number of inflight I/Os");
+DEFINE_uint32(read_percent, 50, "percent of read I/Os");
+DEFINE_uint32(seconds, 5, "running time");
+
+namespace nebd {
+namespace server {
+
+const int kBenchFd = 1;
+
+static void EmptyDeleter(void* m) {}
+
+// 请求直接返回，读请求返回全0
+class FakeFileManager : public NebdFileManager {
+ public:
+    explicit FakeFileManager(size_t ioSize)
+        : NebdFileManager(nullptr), zeros_(ioSize, 0) {}
+
+    int Open(const std::string& filename) override {
+        return kBenchFd;
+    }
+
+    int Close(int fd, bool removeRecord) override {
+        return 0;
+    }
+
+    int Discard(int fd, NebdServerAioContext* aioctx) override {
+        return Finish(aioctx);
+    }
+
+    int AioRead(int fd, NebdServerAioContext* aioctx) override {
+        butil::IOBuf* buf = static_cast<butil::IOBuf*>(aioctx->buf);
+        buf->append_user_data(&zeros_[0], aioctx->size, EmptyDeleter);
+        return Finish(aioctx);
+    }
+
+    int AioWrite(int fd, NebdServerAioContext* aioctx) override {
+        return Finish(aioctx);
+    }
+
+    int Flush(int fd, NebdServerAioContext* aioctx) override {
+        return Finish(aioctx);
+    }
+
+    NebdFileEntityPtr GetFileEntity(int fd) override {
+        return fd == kBenchFd ? entity_ : nullptr;
+    }
+
+ private:
+    int Finish(NebdServerAioContext* aioctx) {
+        aioctx->ret = 0;
+        aioctx->cb(aioctx);
+        return 0;
+    }
+
+ private:
+    std::vector<char> zeros_;
+    NebdFileEntityPtr entity_ = std::make_shared<NebdFileEntity>();
+};
+
+}  // namespace server
+}  // namespace nebd
+
+namespace {
+
+using nebd::client::nebdClient;
+
+struct BenchContext : public NebdClientAioContext {
+    char* data;
+    uint64_t startUs;
+};
+
+std::mutex gMtx;
+std::condition_variable gCond;
+// 已经返回的请求，可以再次下发
+std::vector<BenchContext*> gFreeCtxs;
+std::atomic<uint64_t> gCompleted(0);
+std::atomic<uint64_t> gFailed(0);
+std::atomic<uint64_t> gTotalLatencyUs(0);
+bvar::LatencyRecorder gLatency;
+
+void BenchCallback(NebdClientAioContext* aioctx) {
+    BenchContext* ctx = static_cast<BenchContext*>(aioctx);
+    uint64_t latencyUs = butil::gettimeofday_us() - ctx->startUs;
+    gLatency << latencyUs;
+    gTotalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    if (aioctx->ret < 0) {
+        gFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    gCompleted.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lk(gMtx);
+    gFreeCtxs.push_back(ctx);
+    gCond.notify_one();
+}
+
+// 持续下发随机读写，保持iodepth个请求未返回
+void RunBench(int fd) {
+    const uint64_t blocks = 1024;
+    const uint64_t deadline =
+        butil::gettimeofday_us() + FLAGS_seconds * 1000000ul;
+    while (butil::gettimeofday_us() < deadline) {
+        BenchContext* ctx = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(gMtx);
+            gCond.wait(lk, []() { return !gFreeCtxs.empty(); });
+            ctx = gFreeCtxs.back();
+            gFreeCtxs.pop_back();
+        }
+
+        ctx->offset = butil::fast_rand_less_than(blocks) * FLAGS_io_size;
+        ctx->length = FLAGS_io_size;
+        ctx->buf = ctx->data;
+        ctx->cb = BenchCallback;
+        ctx->retryCount = 0;
+        ctx->startUs = butil::gettimeofday_us();
+        if (butil::fast_rand_less_than(100) < FLAGS_read_percent) {
+            ctx->op = LIBAIO_OP::LIBAIO_OP_READ;
+            nebdClient.AioRead(fd, ctx);
+        } else {
+            ctx->op = LIBAIO_OP::LIBAIO_OP_WRITE;
+            nebdClient.AioWrite(fd, ctx);
+        }
+    }
+
+    std::unique_lock<std::mutex> lk(gMtx);
+    gCond.wait(lk, []() { return gFreeCtxs.size() == FLAGS_iodepth; });
+}
+
+bool WriteClientConf(const std::string& path, bool enableShm) {
+    std::ofstream conf(path);
+    conf << "nebdserver.serverAddress=" << FLAGS_dir << "/nebd.sock\n"
+         << "metacache.fileLockPath=" << FLAGS_dir << "/lock\n"
+         << "request.syncRpcMaxRetryTimes=50\n"
+         << "request.rpcRetryIntervalUs=100000\n"
+         << "request.rpcRetryMaxIntervalUs=64000000\n"
+         << "request.rpcHostDownRetryIntervalUs=10000\n"
+         << "request.rpcHealthCheckIntervalS=1\n"
+         << "request.rpcMaxDelayHealthCheckIntervalMs=100\n"
+         << "request.rpcSendExecQueueNum=2\n"
+         << "shm.enable=" << (enableShm ? "true" : "false") << "\n"
+         << "shm.serverAddress=" << FLAGS_dir << "/nebd.shm.sock\n"
+         << "shm.ioDepth=" << FLAGS_iodepth << "\n"
+         << "shm.maxIoSize=" << FLAGS_io_size << "\n"
+         << "heartbeat.intervalS=5\n"
+         << "heartbeat.rpcTimeoutMs=500\n"
+         << "log.path=" << FLAGS_dir << "/log\n";
+    return conf.good();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    bool enableShm = FLAGS_transport == "shm";
+    if (!enableShm && FLAGS_transport != "rpc") {
+        LOG(FATAL) << "Unknown transport " << FLAGS_transport;
+    }
+    // 共享内存队列长度必须是2的幂
+    if (enableShm && (FLAGS_iodepth & (FLAGS_iodepth - 1)) != 0) {
+        LOG(FATAL) << "iodepth must be power of 2 with shm transport";
+    }
+
+    mkdir(FLAGS_dir.c_str(), 0755);
+    mkdir((FLAGS_dir + "/lock").c_str(), 0755);
+    mkdir((FLAGS_dir + "/log").c_str(), 0755);
+
+    auto fileManager =
+        std::make_shared<nebd::server::FakeFileManager>(FLAGS_io_size);
+    nebd::server::NebdFileServiceImpl fileService(fileManager, true);
+    brpc::Server server;
+    server.AddService(&fileService, brpc::SERVER_DOESNT_OWN_SERVICE);
+    brpc::ServerOptions options;
+    options.idle_timeout_sec = -1;
+    std::string sockPath = FLAGS_dir + "/nebd.sock";
+    if (server.StartAtSockFile(sockPath.c_str(), &options) != 0) {
+        LOG(FATAL) << "Start brpc server failed";
+    }
+
+    nebd::server::NebdShmServer shmServer(fileManager, true);
+    if (enableShm && shmServer.Start(FLAGS_dir + "/nebd.shm.sock") != 0) {
+        LOG(FATAL) << "Start shm server failed";
+    }
+
+    std::string confPath = FLAGS_dir + "/client.conf";
+    if (!WriteClientConf(confPath, enableShm)) {
+        LOG(FATAL) << "Write client conf failed";
+    }
+    if (nebdClient.Init(confPath.c_str()) != 0) {
+        LOG(FATAL) << "Init nebd client failed";
+    }
+    int fd = nebdClient.Open("test:/nebd_transport_bench");
+    if (fd < 0) {
+        LOG(FATAL) << "Open file failed";
+    }
+
+    std::vector<BenchContext> ctxs(FLAGS_iodepth);
+    for (auto& ctx : ctxs) {
+        ctx.data = new char[FLAGS_io_size];
+        memset(ctx.data, 'a', FLAGS_io_size);
+        gFreeCtxs.push_back(&ctx);
+    }
+
+    RunBench(fd);
+
+    uint64_t completed = gCompleted.load();
+    std::cout << "transport: " << FLAGS_transport
+              << ", io size: " << FLAGS_io_size
+              << ", iodepth: " << FLAGS_iodepth << std::endl
+              << "iops: " << completed / FLAGS_seconds
+              << ", avg latency: "
+              << (completed == 0 ? 0 : gTotalLatencyUs.load() / completed)
+              << " us, p99 latency: " << gLatency.latency_percentile(0.99)
+              << " us, failed: " << gFailed.load() << std::endl;
+
+    nebdClient.Close(fd);
+    nebdClient.Uninit();
+    shmServer.Stop();
+    server.Stop(0);
+    server.Join();
+
+    for (auto& ctx : ctxs) {
+        delete[] ctx.data;
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2021-01-08
+ * Author: wuhanqing
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <butil/iobuf.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "nebd/src/part1/shm_channel.h"
+#include "nebd/src/part2/shm_service.h"
+#include "nebd/test/part2/mock_file_entity.h"
+#include "nebd/test/part2/mock_file_manager.h"
+
+namespace nebd {
+namespace server {
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using nebd::client::ShmChannel;
+
+const char kShmAddress[] = "./nebd_shm_service_test.sock";
+const int kFd = 1;
+
+// part1请求的上下文，记录请求是否返回
+struct TestAioContext : public NebdClientAioContext {
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool done = false;
+
+    TestAioContext(::LIBAIO_OP type, off_t off, size_t len, void* data) {
+        op = type;
+        offset = off;
+        length = len;
+        buf = data;
+        ret = -1;
+        cb = Callback;
+        retryCount = 0;
+    }
+
+    static void Callback(NebdClientAioContext* context) {
+        TestAioContext* ctx = static_cast<TestAioContext*>(context);
+        std::lock_guard<std::mutex> lk(ctx->mtx);
+        ctx->done = true;
+        ctx->cond.notify_all();
+    }
+
+    bool Wait() {
+        std::unique_lock<std::mutex> lk(mtx);
+        return cond.wait_for(lk, std::chrono::seconds(10),
+                             [this]() { return done; });
+    }
+};
+
+class ShmServiceTest : public ::testing::Test {
+ public:
+    void SetUp() override {
+        fileManager_ = std::make_shared<MockFileManager>();
+        data_.assign(64 * 1024, '\0');
+
+        option_.enable = true;
+        option_.serverAddress = kShmAddress;
+        option_.ioDepth = 4;
+        option_.maxIoSize = 16 * 1024;
+    }
+
+    void TearDown() override {
+        unlink(kShmAddress);
+    }
+
+    void StartServer(bool returnRpcWhenIoError) {
+        server_.reset(new NebdShmServer(fileManager_, returnRpcWhenIoError));
+        ASSERT_EQ(0, server_->Start(kShmAddress));
+    }
+
+    // 用内存模拟文件读写，请求在part2处理线程中直接返回
+    void ExpectMemoryFile() {
+        EXPECT_CALL(*fileManager_, GetFileEntity(kFd))
+            .WillRepeatedly(Return(std::make_shared<MockFileEntity>()));
+        EXPECT_CALL(*fileManager_, AioWrite(kFd, _))
+            .WillRepeatedly(Invoke([this](int fd, NebdServerAioContext* ctx) {
+                butil::IOBuf* buf = static_cast<butil::IOBuf*>(ctx->buf);
+                buf->copy_to(&data_[ctx->offset], ctx->size);
+                ctx->ret = 0;
+                ctx->cb(ctx);
+                return 0;
+            }));
+        EXPECT_CALL(*fileManager_, AioRead(kFd, _))
+            .WillRepeatedly(Invoke([this](int fd, NebdServerAioContext* ctx) {
+                butil::IOBuf* buf = static_cast<butil::IOBuf*>(ctx->buf);
+                buf->append(&data_[ctx->offset], ctx->size);
+                ctx->ret = 0;
+                ctx->cb(ctx);
+                return 0;
+            }));
+    }
+
+ protected:
+    std::shared_ptr<MockFileManager> fileManager_;
+    std::unique_ptr<NebdShmServer> server_;
+    ShmOption option_;
+    std::string data_;
+};
+
+TEST_F(ShmServiceTest, ReadWriteTest) {
+    StartServer(false);
+    ExpectMemoryFile();
+    EXPECT_CALL(*fileManager_, Flush(kFd, _))
+        .WillOnce(Invoke([](int fd, NebdServerAioContext* ctx) {
+            ctx->ret = 0;
+            ctx->cb(ctx);
+            return 0;
+        }));
+
+    int fallbackCount = 0;
+    ShmChannel channel(kFd, option_, [&](NebdClientAioContext* ctx) {
+        ++fallbackCount;
+    });
+    ASSERT_EQ(0, channel.Init());
+
+    std::string writeData(8192, 'a');
+    TestAioContext write(::LIBAIO_OP_WRITE, 4096, writeData.size(),
+                         &writeData[0]);
+    ASSERT_TRUE(channel.Submit(&write));
+    ASSERT_TRUE(write.Wait());
+    ASSERT_EQ(0, write.ret);
+    ASSERT_EQ(writeData, data_.substr(4096, 8192));
+
+    std::string readData(8192, '\0');
+    TestAioContext read(::LIBAIO_OP_READ, 4096, readData.size(),
+                        &readData[0]);
+    ASSERT_TRUE(channel.Submit(&read));
+    ASSERT_TRUE(read.Wait());
+    ASSERT_EQ(0, read.ret);
+    ASSERT_EQ(writeData, readData);
+
+    TestAioContext flush(::LIBAIO_OP_FLUSH, 0, 0, nullptr);
+    ASSERT_TRUE(channel.Submit(&flush));
+    ASSERT_TRUE(flush.Wait());
+    ASSERT_EQ(0, flush.ret);
+
+    // 超过最大请求大小的请求需要走rpc
+    std::string largeData(option_.maxIoSize + 1, 'b');
+    TestAioContext large(::LIBAIO_OP_WRITE, 0, largeData.size(),
+                         &largeData[0]);
+    ASSERT_FALSE(channel.Submit(&large));
+
+    channel.Close();
+    ASSERT_EQ(0, fallbackCount);
+    server_->Stop();
+}
+
+TEST_F(ShmServiceTest, ConcurrentRequestTest) {
+    StartServer(false);
+    ExpectMemoryFile();
+
+    ShmChannel channel(kFd, option_, [](NebdClientAioContext* ctx) {});
+    ASSERT_EQ(0, channel.Init());
+
+    const int kThreads = 4;
+    const int kRequests = 200;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            std::string buf(4096, 'a' + i);
+            for (int j = 0; j < kRequests; ++j) {
+                TestAioContext write(::LIBAIO_OP_WRITE, i * 4096, buf.size(),
+                                     &buf[0]);
+                // 没有空闲槽位时重试
+                while (!channel.Submit(&write)) {
+                    std::this_thread::yield();
+                }
+                ASSERT_TRUE(write.Wait());
+                ASSERT_EQ(0, write.ret);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < kThreads; ++i) {
+        ASSERT_EQ(std::string(4096, 'a' + i), data_.substr(i * 4096, 4096));
+    }
+
+    channel.Close();
+    server_->Stop();
+}
+
+TEST_F(ShmServiceTest, HandshakeFailTest) {
+    // part2未启动
+    ShmChannel noServer(kFd, option_, [](NebdClientAioContext* ctx) {});
+    ASSERT_EQ(-1, noServer.Init());
+
+    // 文件未打开
+    StartServer(false);
+    EXPECT_CALL(*fileManager_, GetFileEntity(kFd))
+        .WillOnce(Return(nullptr));
+    ShmChannel channel(kFd, option_, [](NebdClientAioContext* ctx) {});
+    ASSERT_EQ(-1, channel.Init());
+
+    // 队列长度不是2的幂
+    option_.ioDepth = 3;
+    ShmChannel invalid(kFd, option_, [](NebdClientAioContext* ctx) {});
+    ASSERT_EQ(-1, invalid.Init());
+
+    server_->Stop();
+}
+
+TEST_F(ShmServiceTest, IoErrorTest) {
+    StartServer(true);
+    EXPECT_CALL(*fileManager_, GetFileEntity(kFd))
+        .WillOnce(Return(std::make_shared<MockFileEntity>()));
+    EXPECT_CALL(*fileManager_, AioRead(kFd, _))
+        .WillOnce(Invoke([](int fd, NebdServerAioContext* ctx) {
+            ctx->ret = -1;
+            ctx->cb(ctx);
+            return 0;
+        }));
+    EXPECT_CALL(*fileManager_, Discard(kFd, _))
+        .WillOnce(Return(-1));
+
+    ShmChannel channel(kFd, option_, [](NebdClientAioContext* ctx) {});
+    ASSERT_EQ(0, channel.Init());
+
+    char buf[4096];
+    TestAioContext read(::LIBAIO_OP_READ, 0, sizeof(buf), buf);
+    ASSERT_TRUE(channel.Submit(&read));
+    ASSERT_TRUE(read.Wait());
+    ASSERT_EQ(-1, read.ret);
+
+    // 请求下发失败
+    TestAioContext discard(::LIBAIO_OP_DISCARD, 0, 4096, nullptr);
+    ASSERT_TRUE(channel.Submit(&discard));
+    ASSERT_TRUE(discard.Wait());
+    ASSERT_EQ(-1, discard.ret);
+
+    channel.Close();
+    server_->Stop();
+}
+
+TEST_F(ShmServiceTest, ServerStopTest) {
+    StartServer(false);
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    NebdServerAioContext* pending = nullptr;
+    EXPECT_CALL(*fileManager_, GetFileEntity(kFd))
+        .WillOnce(Return(std::make_shared<MockFileEntity>()));
+    EXPECT_CALL(*fileManager_, AioRead(kFd, _))
+        .WillOnce(Invoke([&](int fd, NebdServerAioContext* ctx) {
+            std::lock_guard<std::mutex> lk(mtx);
+            pending = ctx;
+            cond.notify_all();
+            return 0;
+        }));
+
+    std::vector<NebdClientAioContext*> resubmitted;
+    ShmChannel channel(kFd, option_, [&](NebdClientAioContext* ctx) {
+        resubmitted.push_back(ctx);
+        ctx->ret = 0;
+        ctx->cb(ctx);
+    });
+    ASSERT_EQ(0, channel.Init());
+
+    char buf[4096];
+    TestAioContext read(::LIBAIO_OP_READ, 0, sizeof(buf), buf);
+    ASSERT_TRUE(channel.Submit(&read));
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        cond.wait(lk, [&]() { return pending != nullptr; });
+    }
+
+    // part2退出，不再处理新的请求，等待已下发的请求返回
+    std::thread stopThread([this]() { server_->Stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(channel.IsBroken());
+
+    char buf2[4096];
+    TestAioContext read2(::LIBAIO_OP_READ, 4096, sizeof(buf2), buf2);
+    ASSERT_TRUE(channel.Submit(&read2));
+
+    // 已下发的请求通过共享内存返回，未处理的请求交给fallback
+    pending->ret = 0;
+    pending->cb(pending);
+    ASSERT_TRUE(read.Wait());
+    ASSERT_EQ(0, read.ret);
+    ASSERT_TRUE(read2.Wait());
+    ASSERT_EQ(0, read2.ret);
+    stopThread.join();
+
+    ASSERT_EQ(1, resubmitted.size());
+    ASSERT_EQ(&read2, resubmitted[0]);
+    ASSERT_TRUE(channel.IsBroken());
+    ASSERT_FALSE(channel.Submit(&read));
+
+    channel.Close();
+}
+
+}  // namespace server
+}  // namespace nebd
@@ -126,6 +126,10 @@ int ChunkServer::Run(int argc, char** argv) {
     LocalFileSystemOption lfsOption;
     LOG_IF(FATAL, !conf.GetBoolValue(
         "fs.enable_renameat2", &lfsOption.enableRenameat2));
+    LOG_IF(FATAL, !conf.GetBoolValue(
+        "fs.enable_io_uring", &lfsOption.enableIoUring));
+    LOG_IF(FATAL, !conf.GetUInt32Value(
+        "fs.io_uring_queue_depth", &lfsOption.ioUringQueueDepth));
     LOG_IF(FATAL, 0 != fs->Init(lfsOption))
         << "Failed to initialize local filesystem module!";
 
@@ -220,6 +224,8 @@ int ChunkServer::Run(int argc, char** argv) {
     copysetNodeOptions.chunkFilePool = chunkfilePool;
     copysetNodeOptions.walFilePool = walFilePool;
     copysetNodeOptions.localFileSystem = fs;
+    // io_uring可用时apply线程提交写请求后即可处理下一个请求
+    copysetNodeOptions.enableAsyncWrite = fs->AsyncIOEnabled();
     copysetNodeOptions.trash = trash_;
     if (nullptr != walFilePool) {
         FilePoolOptions poolOpt = walFilePool->GetFilePoolOpt();
@@ -478,6 +484,9 @@ void ChunkServer::InitChunkFilePoolOptions(
             &chunkFilePoolOptions->bytesPerWrite));
         LOG_IF(FATAL, !conf->GetUInt32Value("chunkfilepool.clean.throttle_iops",
             &chunkFilePoolOptions->iops4clean));
+        // 快照通过reflink共享数据块时，回收的chunk需先解除共享再放回池中
+        LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_reflink_snapshot",
+            &chunkFilePoolOptions->unshareOnRecycle));
 
         if (0 == chunkFilePoolOptions->bytesPerWrite
             || chunkFilePoolOptions->bytesPerWrite > 1 * 1024 * 1024
@@ -567,6 +576,12 @@ void ChunkServer::InitCopysetNodeOptions(
         &copysetNodeOptions->finishLoadMargin));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.check_loadmargin_interval_ms",
         &copysetNodeOptions->checkLoadMarginIntervalMs));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_chunk_hash_index",
+        &copysetNodeOptions->enableChunkHashIndex));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_reflink_snapshot",
+        &copysetNodeOptions->enableReflinkSnapshot));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.clone_meta_sync_pages",
+        &copysetNodeOptions->cloneMetaSyncPages));
 }
 
 void ChunkServer::InitCopyerOptions(
@@ -621,6 +636,10 @@ void ChunkServer::InitScanOptions(
         &scanOptions->retry));
     LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_rpc_retry_interval_us",
         &scanOptions->retryIntervalUs));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_chunk_hash_index",
+        &scanOptions->digestScan));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.scan_verify_percent",
+        &scanOptions->verifyPercent));
 }
 
 void ChunkServer::InitHeartbeatOptions(
@@ -213,6 +213,12 @@ void CSCopysetMetric::MonitorDataStore(CSDataStore* datastore) {
         snapshotCountPrefix, GetDatastoreSnapshotCountFunc, datastore);
     cloneChunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         cloneChunkCountPrefix, GetDatastoreCloneChunkCountFunc, datastore);
+    std::string hashIndexHitPrefix = Prefix() + "_hashindex_hit";
+    std::string hashIndexMismatchPrefix = Prefix() + "_hashindex_mismatch";
+    hashIndexHit_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
+        hashIndexHitPrefix, GetDatastoreHashIndexHitFunc, datastore);
+    hashIndexMismatch_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
+        hashIndexMismatchPrefix, GetDatastoreHashIndexMismatchFunc, datastore);
 }
 
 void CSCopysetMetric::MonitorCurveSegmentLogStorage(
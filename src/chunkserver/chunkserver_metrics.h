@@ -186,7 +186,9 @@ class CSCopysetMetric {
         , chunkCount_(nullptr)
         , snapshotCount_(nullptr)
         , cloneChunkCount_(nullptr)
-        , walSegmentCount_(nullptr) {}
+        , walSegmentCount_(nullptr)
+        , hashIndexHit_(nullptr)
+        , hashIndexMismatch_(nullptr) {}
 
     ~CSCopysetMetric() {}
 
@@ -291,6 +293,10 @@ class CSCopysetMetric {
     PassiveStatusPtr<uint32_t> snapshotCount_;
     // copyset上的 clone chunk 的数量
     PassiveStatusPtr<uint32_t> cloneChunkCount_;
+    // scan直接从chunk hash index得到摘要的次数
+    PassiveStatusPtr<uint32_t> hashIndexHit_;
+    // scan校验数据时发现chunk hash index与数据不一致的page数量
+    PassiveStatusPtr<uint32_t> hashIndexMismatch_;
     // copyset上的IO类型的metric统计
     CSIOMetric ioMetrics_;
 };
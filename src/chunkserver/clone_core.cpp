@@ -20,6 +20,7 @@
  * Author: yangyaokai
  */
 
+#include <stdlib.h>
 #include <vector>
 #include <string>
 
@@ -41,6 +42,21 @@ static void ReadBufferDeleter(void* ptr) {
     delete[] static_cast<char*>(ptr);
 }
 
+// 下载的数据按页对齐存放，paste请求的数据以对齐的block写入WAL时可以不用拷贝
+static const size_t kDownloadBufferAlignment = 4096;
+
+static char* NewDownloadBuffer(size_t size) {
+    void* buf = nullptr;
+    if (posix_memalign(&buf, kDownloadBufferAlignment, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<char*>(buf);
+}
+
+static void DownloadBufferDeleter(void* ptr) {
+    free(ptr);
+}
+
 DownloadClosure::DownloadClosure(std::shared_ptr<ReadChunkRequest> readRequest,
                                  std::shared_ptr<CloneCore> cloneCore,
                                  AsyncDownloadContext* downloadCtx,
@@ -67,7 +83,7 @@ void DownloadClosure::Run() {
     brpc::ClosureGuard doneGuard(done_);
     butil::IOBuf copyData;
     copyData.append_user_data(
-        downloadCtx_->buf, downloadCtx_->size, ReadBufferDeleter);
+        downloadCtx_->buf, downloadCtx_->size, DownloadBufferDeleter);
 
     CHECK(readRequest_ != nullptr) << "read request is nullptr.";
     // 记录结束metric
@@ -174,7 +190,7 @@ int CloneCore::CloneReadByLocalInfo(
         downloadCtx->location = chunkInfo.location;
         downloadCtx->offset = offset;
         downloadCtx->size = length;
-        downloadCtx->buf = new (std::nothrow) char[length];
+        downloadCtx->buf = NewDownloadBuffer(length);
         DownloadClosure* downloadClosure =
             new (std::nothrow) DownloadClosure(readRequest,
                                                shared_from_this(),
@@ -209,7 +225,7 @@ void CloneCore::CloneReadByRequestInfo(std::shared_ptr<ReadChunkRequest>
     downloadCtx->location = location;
     downloadCtx->offset = chunkRequest->offset();
     downloadCtx->size = chunkRequest->size();
-    downloadCtx->buf = new (std::nothrow) char[chunkRequest->size()];
+    downloadCtx->buf = NewDownloadBuffer(chunkRequest->size());
     DownloadClosure* downloadClosure =
     new (std::nothrow) DownloadClosure(readRequest,
                                     shared_from_this(),
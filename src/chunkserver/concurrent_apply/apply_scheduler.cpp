@@ -0,0 +1,246 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-16
+ * Author: lixiaocui
+ */
+
+#include <glog/logging.h>
+
+#include <chrono>   // NOLINT
+#include <utility>
+
+#include "src/chunkserver/concurrent_apply/apply_scheduler.h"
+#include "src/common/timeutility.h"
+
+using curve::common::CountDownEvent;
+using curve::common::LockGuard;
+using curve::common::UniqueLock;
+using curve::common::TimeUtility;
+
+namespace curve {
+namespace chunkserver {
+namespace concurrent {
+
+const int ApplyScheduler::kGroupsPerThread;
+const int ApplyScheduler::kMaxTasksPerRun;
+
+// max time a parked thread waits before rechecking the queues
+const int kIdleWaitMs = 10;
+
+ApplyScheduler::Worker::Worker(ApplyScheduler* scheduler, int index,
+                               size_t capacity, const std::string& prefix)
+    : scheduler(scheduler),
+      index(index),
+      ready(capacity),
+      queueDepth(prefix, "queue_depth",
+                 &ApplyScheduler::GetQueueDepth, this),
+      waitLatency(prefix, "wait"),
+      stealCount(prefix, "steal_count") {}
+
+ApplyScheduler::ApplyScheduler() : running_(false), idle_(0) {}
+
+ApplyScheduler::~ApplyScheduler() {
+    Stop();
+}
+
+void ApplyScheduler::Start(int concurrent, int depth, const std::string& name,
+                           CountDownEvent* started) {
+    uint32_t groupNum = concurrent * kGroupsPerThread;
+    for (uint32_t i = 0; i < groupNum; i++) {
+        groups_.emplace_back(new TaskGroup(depth));
+    }
+    // every group is queued at most once, so the ready queue is never full
+    for (int i = 0; i < concurrent; i++) {
+        workers_.emplace_back(new Worker(
+            this, i, groupNum, name + "_worker_" + std::to_string(i)));
+    }
+
+    running_.store(true);
+    for (int i = 0; i < concurrent; i++) {
+        workers_[i]->th = std::thread(&ApplyScheduler::Run, this, i, started);
+    }
+}
+
+void ApplyScheduler::Push(uint64_t key, Task task) {
+    QueuedTask queued;
+    queued.task = std::move(task);
+    queued.enqueueUs = TimeUtility::GetTimeofDayUs();
+    PushToGroup(key % groups_.size(), &queued);
+}
+
+void ApplyScheduler::PushToGroup(uint32_t gid, QueuedTask* task) {
+    TaskGroup* group = groups_[gid].get();
+    // count the task before it is visible in the queue, so that a group is
+    // owned by exactly one scheduled or running thread while pending > 0
+    int64_t prev = group->pending.fetch_add(1, std::memory_order_acq_rel);
+    if (!group->tasks.TryPush(task)) {
+        // the queue is full, wait for the running thread to take tasks
+        UniqueLock lk(group->fullMtx);
+        group->fullWaiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!group->tasks.TryPush(task)) {
+            group->notFull.wait_for(lk,
+                                    std::chrono::milliseconds(kIdleWaitMs));
+        }
+        group->fullWaiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (prev == 0) {
+        // keep the hash of the old per-thread queues as the home thread
+        Schedule(gid, gid % workers_.size());
+    }
+}
+
+void ApplyScheduler::Schedule(uint32_t gid, int index) {
+    CHECK(workers_[index]->ready.TryPush(gid))
+        << "ready queue of apply thread " << index << " is full";
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle_.load(std::memory_order_relaxed) > 0) {
+        LockGuard lk(idleMtx_);
+        idleCond_.notify_one();
+    }
+}
+
+bool ApplyScheduler::PopGroup(int index, uint32_t* gid) {
+    if (workers_[index]->ready.TryPop(gid)) {
+        return true;
+    }
+
+    int concurrent = workers_.size();
+    for (int i = 1; i < concurrent; i++) {
+        if (workers_[(index + i) % concurrent]->ready.TryPop(gid)) {
+            workers_[index]->stealCount << 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ApplyScheduler::HasReadyGroup() const {
+    for (auto& worker : workers_) {
+        if (worker->ready.SizeApprox() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ApplyScheduler::RunGroup(int index, uint32_t gid) {
+    TaskGroup* group = groups_[gid].get();
+    Worker* worker = workers_[index].get();
+
+    int64_t run = 0;
+    QueuedTask queued;
+    while (run < kMaxTasksPerRun && group->tasks.TryPop(&queued)) {
+        worker->waitLatency <<
+            TimeUtility::GetTimeofDayUs() - queued.enqueueUs;
+        queued.task();
+        queued.task = nullptr;
+        run++;
+    }
+
+    // wake the pushers waiting for room in the task queue
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (run > 0 &&
+        group->fullWaiters.load(std::memory_order_relaxed) > 0) {
+        LockGuard lk(group->fullMtx);
+        group->notFull.notify_all();
+    }
+
+    // tasks left or still being pushed, requeue the group on this thread
+    int64_t prev = group->pending.fetch_sub(run, std::memory_order_acq_rel);
+    if (prev > run) {
+        Schedule(gid, index);
+    }
+}
+
+void ApplyScheduler::Run(int index, CountDownEvent* started) {
+    started->Signal();
+    uint32_t gid;
+    while (running_.load(std::memory_order_acquire)) {
+        if (PopGroup(index, &gid)) {
+            RunGroup(index, gid);
+            continue;
+        }
+
+        UniqueLock lk(idleMtx_);
+        idle_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!HasReadyGroup() && running_.load(std::memory_order_acquire)) {
+            idleCond_.wait_for(lk, std::chrono::milliseconds(kIdleWaitMs));
+        }
+        idle_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void ApplyScheduler::Flush() {
+    // a group with no pending task has finished all the tasks pushed to it
+    std::vector<uint32_t> busy;
+    for (uint32_t i = 0; i < groups_.size(); i++) {
+        if (groups_[i]->pending.load(std::memory_order_acquire) > 0) {
+            busy.push_back(i);
+        }
+    }
+    if (busy.empty()) {
+        return;
+    }
+
+    CountDownEvent event(busy.size());
+    for (uint32_t gid : busy) {
+        QueuedTask flushtask;
+        flushtask.task = [&event]() {
+            event.Signal();
+        };
+        flushtask.enqueueUs = TimeUtility::GetTimeofDayUs();
+        PushToGroup(gid, &flushtask);
+    }
+    event.Wait();
+}
+
+void ApplyScheduler::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    {
+        LockGuard lk(idleMtx_);
+        idleCond_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        worker->th.join();
+    }
+    workers_.clear();
+    groups_.clear();
+}
+
+uint64_t ApplyScheduler::GetQueueDepth(void* arg) {
+    Worker* worker = static_cast<Worker*>(arg);
+    const auto& groups = worker->scheduler->groups_;
+    uint32_t concurrent = groups.size() / kGroupsPerThread;
+    uint64_t depth = 0;
+    for (uint32_t gid = worker->index; gid < groups.size();
+         gid += concurrent) {
+        depth += groups[gid]->tasks.SizeApprox();
+    }
+    return depth;
+}
+
+}   // namespace concurrent
+}   // namespace chunkserver
+}   // namespace curve
@@ -0,0 +1,157 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-16
+ * Author: lixiaocui
+ */
+
+#ifndef SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_SCHEDULER_H_
+#define SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_SCHEDULER_H_
+
+#include <bvar/bvar.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>    // NOLINT
+#include <vector>
+
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/mpmc_queue.h"
+
+namespace curve {
+namespace chunkserver {
+namespace concurrent {
+
+using curve::common::MPMCQueue;
+
+/**
+ * ApplyScheduler: work-stealing scheduler for apply tasks
+ * Tasks with the same key belong to the same task group and are executed
+ * serially in push order. A ready task group is queued on its home thread,
+ * and an idle thread steals whole task groups from the other threads, so a
+ * group only runs on one thread at a time: requests on the same chunk keep
+ * their order while busy threads no longer starve idle ones. Both the task
+ * queues and the ready queues are bounded lock-free queues.
+ */
+class ApplyScheduler {
+ public:
+    using Task = std::function<void()>;
+
+    // num of task groups per thread
+    static const int kGroupsPerThread = 32;
+    // max tasks a group runs before it is requeued, so that the other
+    // groups on the same thread get their turn
+    static const int kMaxTasksPerRun = 32;
+
+    ApplyScheduler();
+    ~ApplyScheduler();
+
+    /**
+     * Start: start the worker threads
+     * @param[in] concurrent: num of threads
+     * @param[in] depth: depth of task queue in every task group
+     * @param[in] name: prefix of metrics
+     * @param[in] started: signaled once by every thread after it starts
+     */
+    void Start(int concurrent, int depth, const std::string& name,
+               curve::common::CountDownEvent* started);
+
+    /**
+     * Push: push task to the group of key, wait if the group is full
+     */
+    void Push(uint64_t key, Task task);
+
+    /**
+     * Flush: wait until all tasks pushed before are finished
+     */
+    void Flush();
+
+    /**
+     * Stop: stop all threads, tasks not executed yet are dropped
+     */
+    void Stop();
+
+ private:
+    struct QueuedTask {
+        Task task;
+        // used to record the time waiting in queue
+        uint64_t enqueueUs;
+        QueuedTask() : enqueueUs(0) {}
+    };
+
+    struct TaskGroup {
+        explicit TaskGroup(size_t depth)
+            : tasks(depth), pending(0), fullWaiters(0) {}
+        MPMCQueue<QueuedTask> tasks;
+        // num of tasks pushed but not finished, the pusher who changes
+        // it from 0 to 1 schedules the group
+        std::atomic<int64_t> pending;
+        // pushers park here when the task queue is full, the running
+        // thread only notifies when some pusher is waiting
+        std::atomic<int> fullWaiters;
+        curve::common::Mutex fullMtx;
+        curve::common::ConditionVariable notFull;
+    };
+
+    struct Worker {
+        Worker(ApplyScheduler* scheduler, int index, size_t capacity,
+               const std::string& prefix);
+        ApplyScheduler* scheduler;
+        int index;
+        std::thread th;
+        // ready task groups
+        MPMCQueue<uint32_t> ready;
+        // num of tasks queued in the groups whose home is this thread
+        bvar::PassiveStatus<uint64_t> queueDepth;
+        bvar::LatencyRecorder waitLatency;
+        bvar::Adder<uint64_t> stealCount;
+    };
+
+    void Run(int index, curve::common::CountDownEvent* started);
+
+    void PushToGroup(uint32_t gid, QueuedTask* task);
+
+    void Schedule(uint32_t gid, int index);
+
+    bool PopGroup(int index, uint32_t* gid);
+
+    void RunGroup(int index, uint32_t gid);
+
+    bool HasReadyGroup() const;
+
+    static uint64_t GetQueueDepth(void* arg);
+
+ private:
+    std::atomic<bool> running_;
+    std::vector<std::unique_ptr<TaskGroup>> groups_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // threads park here when no group is ready, pushers only notify
+    // when some thread is idle
+    std::atomic<int> idle_;
+    curve::common::Mutex idleMtx_;
+    curve::common::ConditionVariable idleCond_;
+};
+
+}   // namespace concurrent
+}   // namespace chunkserver
+}   // namespace curve
+
+#endif  // SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_SCHEDULER_H_
@@ -44,8 +44,10 @@ bool ConcurrentApplyModule::Init(const ConcurrentApplyOption &opt) {
 
     start_ = true;
     cond_.Reset(opt.rconcurrentsize + opt.wconcurrentsize);
-    InitThreadPool(ThreadPoolType::READ, rconcurrentsize_, rqueuedepth_);
-    InitThreadPool(ThreadPoolType::WRITE, wconcurrentsize_, wqueuedepth_);
+    rscheduler_.Start(rconcurrentsize_, rqueuedepth_,
+                      "concurrent_apply_read", &cond_);
+    wscheduler_.Start(wconcurrentsize_, wqueuedepth_,
+                      "concurrent_apply_write", &cond_);
 
     if (!cond_.WaitFor(5000)) {
         LOG(ERROR) << "init concurrent module's threads fail";
@@ -77,85 +79,16 @@ bool ConcurrentApplyModule::checkOptAndInit(
 }
 
 
-void ConcurrentApplyModule::InitThreadPool(
-    ThreadPoolType type, int concorrent, int depth) {
-    for (int i = 0; i < concorrent; i++) {
-        auto asyncth = new (std::nothrow) taskthread(depth);
-        CHECK(asyncth != nullptr) << "allocate failed!";
-
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
-        }
-    }
-
-    for (int i = 0; i < concorrent; i++) {
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_[i]->th = std::move(
-                std::thread(&ConcurrentApplyModule::Run, this, type, i));
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_[i]->th =
-                std::thread(&ConcurrentApplyModule::Run, this, type, i);
-            break;
-        }
-    }
-}
-
-void ConcurrentApplyModule::Run(ThreadPoolType type, int index) {
-    cond_.Signal();
-    while (start_) {
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_[index]->tq.Pop()();
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_[index]->tq.Pop()();
-            break;
-        }
-    }
-}
-
 void ConcurrentApplyModule::Stop() {
     LOG(INFO) << "stop ConcurrentApplyModule...";
     start_ = false;
-    auto wakeup = []() {};
-    for (auto iter : rapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
-    }
-    rapplyMap_.clear();
-
-    for (auto iter : wapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
-    }
-    wapplyMap_.clear();
-
+    rscheduler_.Stop();
+    wscheduler_.Stop();
     LOG(INFO) << "stop ConcurrentApplyModule ok.";
 }
 
 void ConcurrentApplyModule::Flush() {
-    CountDownEvent event(wconcurrentsize_);
-    auto flushtask = [&event]() {
-        event.Signal();
-    };
-
-    for (int i = 0; i < wconcurrentsize_; i++) {
-        wapplyMap_[i]->tq.Push(flushtask);
-    }
-
-    event.Wait();
+    wscheduler_.Flush();
 }
 
 ThreadPoolType ConcurrentApplyModule::Schedule(CHUNK_OP_TYPE optype) {
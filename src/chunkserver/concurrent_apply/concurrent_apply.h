@@ -25,19 +25,14 @@
 
 #include <glog/logging.h>
 #include <unistd.h>
-#include <atomic>
-#include <mutex>    // NOLINT
-#include <thread>    // NOLINT
-#include <unordered_map>
+#include <functional>
 #include <utility>
-#include <condition_variable>    // NOLINT
 
-#include "src/common/concurrent/task_queue.h"
+#include "src/chunkserver/concurrent_apply/apply_scheduler.h"
 #include "src/common/concurrent/count_down_event.h"
 #include "proto/chunk.pb.h"
 #include "include/curve_compiler_specific.h"
 
-using curve::common::TaskQueue;
 using curve::common::CountDownEvent;
 using curve::chunkserver::CHUNK_OP_TYPE;
 
@@ -67,28 +62,30 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
     /**
      * Init: initialize ConcurrentApplyModule
      * @param[in] wconcurrentsize: num of write threads
-     * @param[in] wqueuedepth: depth of write queue in ervery thread
+     * @param[in] wqueuedepth: depth of write queue in every task group
      * @param[in] rconcurrentsizee: num of read threads
-     * @param[in] wqueuedephth: depth of read queue in every thread
+     * @param[in] wqueuedephth: depth of read queue in every task group
      */
     bool Init(const ConcurrentApplyOption &opt);
 
     /**
      * Push: apply task will be push to ConcurrentApplyModule
-     * @param[in] key: used to hash task to specified queue
+     * @param[in] key: tasks with the same key are executed in push order,
+     *                 and may be stolen by any thread as a whole
      * @param[in] optype: operation type defined in proto
      * @param[in] f: task
      * @param[in] args: param to excute task
      */
     template<class F, class... Args>
     bool Push(uint64_t key, CHUNK_OP_TYPE optype, F&& f, Args&&... args) {
-        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        ApplyScheduler::Task task =
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...);
         switch (Schedule(optype)) {
             case ThreadPoolType::READ:
-                rapplyMap_[Hash(key, rconcurrentsize_)]->tq.Push(task);
+                rscheduler_.Push(key, std::move(task));
                 break;
             case ThreadPoolType::WRITE:
-                wapplyMap_[Hash(key, wconcurrentsize_)]->tq.Push(task);
+                wscheduler_.Push(key, std::move(task));
                 break;
         }
 
@@ -105,33 +102,17 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
  private:
     bool checkOptAndInit(const ConcurrentApplyOption &option);
 
-    void Run(ThreadPoolType type, int index);
-
     ThreadPoolType Schedule(CHUNK_OP_TYPE optype);
 
-    void InitThreadPool(ThreadPoolType type, int concorrent, int depth);
-
-    int Hash(uint64_t key, int concurrent) {
-        return key % concurrent;
-    }
-
  private:
-    typedef uint8_t threadIndex;
-    typedef struct taskthread {
-        std::thread th;
-        TaskQueue tq;
-        taskthread(size_t capacity):tq(capacity) {}
-        ~taskthread() = default;
-    } taskthread_t;
-
     bool start_;
     int rconcurrentsize_;
     int rqueuedepth_;
     int wconcurrentsize_;
     int wqueuedepth_;
     CountDownEvent cond_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<threadIndex, taskthread_t*> wapplyMap_; // NOLINT
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<threadIndex, taskthread_t*> rapplyMap_;   // NOLINT
+    CURVE_CACHELINE_ALIGNMENT ApplyScheduler wscheduler_;
+    CURVE_CACHELINE_ALIGNMENT ApplyScheduler rscheduler_;
 };
 }   // namespace concurrent
 }   // namespace chunkserver
@@ -101,6 +101,15 @@ struct CopysetNodeOptions {
     std::shared_ptr<FilePool> walFilePool;
     // 文件系统适配层
     std::shared_ptr<LocalFileSystem> localFileSystem;
+    // 是否异步apply写请求，开启后apply线程把写请求提交给文件系统后
+    // 不等待IO完成，由IO完成回调返回给client
+    bool enableAsyncWrite = false;
+    // 是否在写路径上维护chunk的page crc，供scan比较摘要而无需读取全部数据
+    bool enableChunkHashIndex = false;
+    // 快照写时复制是否通过reflink共享数据块，文件系统不支持时回退为拷贝
+    bool enableReflinkSnapshot = false;
+    // clone chunk最多积累多少个新写入的page才更新metapage，0表示每次写都更新
+    uint32_t cloneMetaSyncPages = 0;
     // 回收站, 心跳模块判断该chunkserver不在copyset配置组时，
     // 通知copysetManager将copyset目录移动至回收站
     // 一段时间后实际回收物理空间
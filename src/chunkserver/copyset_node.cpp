@@ -64,6 +64,7 @@ CopysetNode::CopysetNode(const LogicPoolID &logicPoolId,
     chunkDataApath_(),
     chunkDataRpath_(),
     appliedIndex_(0),
+    lastApplyingIndex_(0),
     leaderTerm_(-1),
     scaning_(false),
     lastScanSec_(0),
@@ -114,6 +115,13 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     dsOptions.chunkSize = options.maxChunkSize;
     dsOptions.pageSize = options.pageSize;
     dsOptions.locationLimit = options.locationLimit;
+    dsOptions.enableAsyncWrite = options.enableAsyncWrite;
+    dsOptions.enableReflinkSnapshot = options.enableReflinkSnapshot;
+    dsOptions.cloneMetaSyncPages = options.cloneMetaSyncPages;
+    if (options.enableChunkHashIndex) {
+        dsOptions.hashIndexDir =
+            copysetDirPath_ + "/" + CHUNK_HASH_INDEX_DIR;
+    }
     dataStore_ = std::make_shared<CSDataStore>(options.localFileSystem,
                                                options.chunkFilePool,
                                                dsOptions);
@@ -197,6 +205,10 @@ void CopysetNode::Fini() {
         // 迁移copyset时，copyset移除后再去执行WriteChunk操作可能出错
         concurrentapply_->Flush();
     }
+    if (nullptr != dataStore_) {
+        // 等待已经提交的异步写完成
+        dataStore_->WaitAsyncWrites();
+    }
 }
 
 void CopysetNode::InitRaftNodeOptions(const CopysetNodeOptions &options) {
@@ -273,12 +285,16 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             auto opReq = ChunkOpRequest::Decode(log, &request, &data,
                                                 iter.index(), GetLeaderId());
             auto chunkId = request.chunkid();
-            auto task = std::bind(&ChunkOpRequest::OnApplyFromLog,
+            auto optype = request.optype();
+            auto index = iter.index();
+            OnApplyFromLogStart(index);
+            auto task = std::bind(&CopysetNode::ApplyFromLog,
+                                  this,
                                   opReq,
-                                  dataStore_,
                                   std::move(request),
-                                  data);
-            concurrentapply_->Push(chunkId, request.optype(), task);
+                                  data,
+                                  index);
+            concurrentapply_->Push(chunkId, optype, task);
         }
     }
 }
@@ -292,9 +308,18 @@ void CopysetNode::on_snapshot_save(::braft::SnapshotWriter *writer,
     brpc::ClosureGuard doneGuard(done);
 
     /**
-     * 1.flush I/O to disk，确保数据都落盘
+     * 1.flush I/O to disk，确保数据都落盘，包括已经提交的异步写
      */
     concurrentapply_->Flush();
+    dataStore_->WaitAsyncWrites();
+    // 快照之前的日志会被删除不再回放，clone chunk只在内存中更新的
+    // bitmap需要先落盘
+    if (CSErrorCode::Success != dataStore_->SyncMetaPages()) {
+        done->status().set_error(EIO, "Sync chunk metapages failed");
+        LOG(ERROR) << "Sync chunk metapages failed. "
+                   << "Copyset: " << GroupIdString();
+        return;
+    }
 
     /**
      * 2.保存配置版本: conf.epoch，注意conf.epoch是存放在data目录下
@@ -440,6 +465,8 @@ int CopysetNode::on_snapshot_load(::braft::SnapshotReader *reader) {
         }
     }
     lastSnapshotIndex_ = meta.last_included_index();
+    // snapshot中的数据都已经apply
+    UpdateAppliedIndex(lastSnapshotIndex_);
     return 0;
 }
 
@@ -758,6 +785,31 @@ uint64_t CopysetNode::GetAppliedIndex() const {
     return appliedIndex_.load(std::memory_order_acquire);
 }
 
+void CopysetNode::ApplyFromLog(std::shared_ptr<ChunkOpRequest> opReq,
+                               const ChunkRequest &request,
+                               const butil::IOBuf &data,
+                               uint64_t index) {
+    opReq->OnApplyFromLog(dataStore_, request, data);
+    OnApplyFromLogDone(index);
+}
+
+void CopysetNode::OnApplyFromLogStart(uint64_t index) {
+    std::lock_guard<std::mutex> lk(applyingMtx_);
+    applyingIndexes_.insert(index);
+    lastApplyingIndex_ = index;
+}
+
+void CopysetNode::OnApplyFromLogDone(uint64_t index) {
+    std::lock_guard<std::mutex> lk(applyingMtx_);
+    applyingIndexes_.erase(index);
+    // 日志是按序开始apply的，比还没完成的最小index小的日志都已经apply完成
+    if (applyingIndexes_.empty()) {
+        UpdateAppliedIndex(lastApplyingIndex_);
+    } else {
+        UpdateAppliedIndex(*applyingIndexes_.begin() - 1);
+    }
+}
+
 std::shared_ptr<CSDataStore> CopysetNode::GetDataStore() const {
     return dataStore_;
 }
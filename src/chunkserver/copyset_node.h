@@ -29,6 +29,8 @@
 #include <vector>
 #include <climits>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
@@ -54,6 +56,7 @@ using ::curve::mds::heartbeat::ConfigChangeType;
 using ::curve::common::Peer;
 
 class CopysetNodeManager;
+class ChunkOpRequest;
 
 extern const char *kCurveConfEpochFilename;
 
@@ -225,6 +228,13 @@ class CopysetNode : public braft::StateMachine,
      */
     virtual uint64_t GetAppliedIndex() const;
 
+    /**
+     * 从日志apply的op开始执行和执行完成时调用，用于更新follower的applied index
+     * @param index: op对应的log index
+     */
+    void OnApplyFromLogStart(uint64_t index);
+    void OnApplyFromLogDone(uint64_t index);
+
     /**
      * @brief: 查询配置变更的状态
      * @param type[out]: 配置变更类型
@@ -403,6 +413,14 @@ class CopysetNode : public braft::StateMachine,
     int SaveConfEpoch(const std::string &filePath);
 
  private:
+    /**
+     * follower apply日志中的op，完成后更新applied index
+     */
+    void ApplyFromLog(std::shared_ptr<ChunkOpRequest> opReq,
+                      const ChunkRequest &request,
+                      const butil::IOBuf &data,
+                      uint64_t index);
+
     inline std::string GroupId() {
         return ToGroupId(logicPoolId_, copysetId_);
     }
@@ -446,6 +464,12 @@ class CopysetNode : public braft::StateMachine,
     std::unique_ptr<ConfEpochFile> epochFile_;
     // 复制组的apply index
     std::atomic<uint64_t> appliedIndex_;
+    // 从日志apply的op是并发执行的，记录还没有apply完成的log index，
+    // 只有比它们都小的index才能更新到appliedIndex_，这样follower上
+    // appliedIndex_之前的日志都已经apply，可以提供follower read
+    std::mutex applyingMtx_;
+    std::set<uint64_t> applyingIndexes_;
+    uint64_t lastApplyingIndex_;
     // 复制组当前任期，如果<=0表明不是leader
     std::atomic<int64_t> leaderTerm_;
     // 复制组数据回收站目录
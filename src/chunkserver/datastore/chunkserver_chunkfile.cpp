@@ -26,21 +26,21 @@
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/chunkserver/datastore/chunkserver_chunkfile.h"
 #include "src/common/crc32.h"
+#include "src/common/aligned_buffer_pool.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::AlignedBuffer;
+using curve::common::AlignedBufferPool;
+
 ChunkFileMetaPage::ChunkFileMetaPage(const ChunkFileMetaPage& metaPage) {
     version = metaPage.version;
     sn = metaPage.sn;
     correctedSn = metaPage.correctedSn;
     location = metaPage.location;
-    if (metaPage.bitmap != nullptr) {
-        bitmap = std::make_shared<Bitmap>(metaPage.bitmap->Size(),
-                                          metaPage.bitmap->GetBitmap());
-    } else {
-        bitmap = nullptr;
-    }
+    // The bitmap is immutable, so it is shared instead of copied
+    bitmap = metaPage.bitmap;
 }
 
 ChunkFileMetaPage& ChunkFileMetaPage::operator =(
@@ -51,12 +51,8 @@ ChunkFileMetaPage& ChunkFileMetaPage::operator =(
     sn = metaPage.sn;
     correctedSn = metaPage.correctedSn;
     location = metaPage.location;
-    if (metaPage.bitmap != nullptr) {
-        bitmap = std::make_shared<Bitmap>(metaPage.bitmap->Size(),
-                                          metaPage.bitmap->GetBitmap());
-    } else {
-        bitmap = nullptr;
-    }
+    // The bitmap is immutable, so it is shared instead of copied
+    bitmap = metaPage.bitmap;
     return *this;
 }
 
@@ -79,7 +75,7 @@ void ChunkFileMetaPage::encode(char* buf) {
         memcpy(buf + len, &bits, sizeof(bits));
         len += sizeof(bits);
         size_t bitmapBytes = (bits + 8 - 1) >> 3;
-        memcpy(buf + len, bitmap->GetBitmap(), bitmapBytes);
+        bitmap->Encode(buf + len);
         len += bitmapBytes;
     }
     uint32_t crc = ::curve::common::CRC32(buf, len);
@@ -103,7 +99,7 @@ CSErrorCode ChunkFileMetaPage::decode(const char* buf) {
         uint32_t bits = 0;
         memcpy(&bits, buf + len, sizeof(bits));
         len += sizeof(bits);
-        bitmap = std::make_shared<Bitmap>(bits, buf + len);
+        bitmap = std::make_shared<CompactBitmap>(bits, buf + len);
         size_t bitmapBytes = (bitmap->Size() + 8 - 1) >> 3;
         len += bitmapBytes;
     }
@@ -128,6 +124,47 @@ CSErrorCode ChunkFileMetaPage::decode(const char* buf) {
     return CSErrorCode::Success;
 }
 
+void InflightIOTracker::Add(off_t offset, size_t length) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    ranges_.insert(std::make_pair(offset, length));
+}
+
+void InflightIOTracker::Remove(off_t offset, size_t length) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = ranges_.find(std::make_pair(offset, length));
+    if (iter != ranges_.end()) {
+        ranges_.erase(iter);
+    }
+    cond_.notify_all();
+}
+
+void InflightIOTracker::WaitOverlap(off_t offset, size_t length) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (hasOverlap(offset, length)) {
+        cond_.wait(lk);
+    }
+}
+
+void InflightIOTracker::WaitAll() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (!ranges_.empty()) {
+        cond_.wait(lk);
+    }
+}
+
+bool InflightIOTracker::hasOverlap(off_t offset, size_t length) {
+    // ranges_ is ordered by offset, only ranges beginning before the end of
+    // the requested range can overlap with it
+    off_t end = offset + length;
+    for (auto iter = ranges_.begin();
+         iter != ranges_.end() && iter->first < end; ++iter) {
+        if (iter->first + static_cast<off_t>(iter->second) > offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
 CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
                          std::shared_ptr<FilePool> chunkFilePool,
                          const ChunkOptions& options)
@@ -140,7 +177,13 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
       snapshot_(nullptr),
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
-      metric_(options.metric) {
+      metric_(options.metric),
+      inflightIO_(std::make_shared<InflightIOTracker>()),
+      hashIndexDir_(options.hashIndexDir),
+      hashIndex_(nullptr),
+      enableReflinkSnapshot_(options.enableReflinkSnapshot),
+      cloneMetaSyncPages_(options.cloneMetaSyncPages),
+      unsyncedPages_(0) {
     CHECK(!baseDir_.empty()) << "Create chunk file failed";
     CHECK(lfs_ != nullptr) << "Create chunk file failed";
     metaPage_.sn = options.sn;
@@ -150,7 +193,7 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
     //     and Bitmap needs to be initialized
     if (!metaPage_.location.empty()) {
         uint32_t bits = size_ / pageSize_;
-        metaPage_.bitmap = std::make_shared<Bitmap>(bits);
+        metaPage_.bitmap = std::make_shared<CompactBitmap>(bits);
     }
     if (metric_ != nullptr) {
         metric_->chunkFileCount << 1;
@@ -158,11 +201,23 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
 }
 
 CSChunkFile::~CSChunkFile() {
+    // The fd must stay open until the submitted writes are completed
+    inflightIO_->WaitAll();
+
     if (snapshot_ != nullptr) {
         delete snapshot_;
         snapshot_ = nullptr;
     }
 
+    // Stamp the index with the chunk file after the last write, so that it
+    // can be trusted when the chunk is opened next time
+    if (hashIndex_ != nullptr && fd_ >= 0) {
+        struct stat fileInfo;
+        if (lfs_->Fstat(fd_, &fileInfo) == 0) {
+            hashIndex_->Close(fileInfo);
+        }
+    }
+
     if (fd_ >= 0) {
         lfs_->Close(fd_);
     }
@@ -234,9 +289,28 @@ CSErrorCode CSChunkFile::Open(bool createFile) {
         }
         isCloneChunk_ = true;
     }
+    if (errCode == CSErrorCode::Success
+        && !hashIndexDir_.empty()
+        && hashIndex_ == nullptr) {
+        openHashIndex(fileInfo);
+    }
     return errCode;
 }
 
+void CSChunkFile::openHashIndex(const struct stat& chunkStat) {
+    auto hashIndex = std::make_shared<ChunkHashIndex>(lfs_,
+                                                      hashIndexPath(),
+                                                      pageSize_,
+                                                      size_ / pageSize_);
+    CSErrorCode errorCode = hashIndex->Open(chunkStat);
+    if (errorCode != CSErrorCode::Success) {
+        LOG(WARNING) << "Open chunk hash index failed, scan will read data."
+                     << "ChunkID: " << chunkId_;
+        return;
+    }
+    hashIndex_ = hashIndex;
+}
+
 CSErrorCode CSChunkFile::LoadSnapshot(SequenceNum sn) {
     WriteLockGuard writeGuard(rwLock_);
     if (snapshot_ != nullptr) {
@@ -285,6 +359,7 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
                    << ", chunk size: " << size_;
         return CSErrorCode::InvalidArgError;
     }
+    inflightIO_->WaitOverlap(offset, length);
     // Curve will ensure that all previous requests arrive or time out
     // before issuing new requests after user initiate a snapshot request.
     // Therefore, this is only a log recovery request, and it must have been
@@ -388,6 +463,69 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
     return CSErrorCode::Success;
 }
 
+void CSChunkFile::WriteAsync(SequenceNum sn,
+                             const butil::IOBuf& buf,
+                             off_t offset,
+                             size_t length,
+                             uint32_t* cost,
+                             CSAsyncCallback cb) {
+    {
+        WriteLockGuard writeGuard(rwLock_);
+        // Only a plain overwrite of a normal chunk can be submitted
+        // asynchronously, it changes nothing but the data of the chunk.
+        bool plainWrite = CheckOffsetAndLength(offset, length)
+                          && !isCloneChunk_
+                          && sn == metaPage_.sn
+                          && sn >= metaPage_.correctedSn
+                          && !needCow(sn);
+        if (plainWrite) {
+            // Overlapping writes must reach the disk in the apply order
+            inflightIO_->WaitOverlap(offset, length);
+            inflightIO_->Add(offset, length);
+            std::shared_ptr<InflightIOTracker> tracker = inflightIO_;
+            std::shared_ptr<ChunkHashIndex> hashIndex = hashIndex_;
+            if (hashIndex != nullptr) {
+                hashIndex->MarkDirty();
+            }
+            ChunkID chunkId = chunkId_;
+            auto done = [tracker, hashIndex, buf, chunkId,
+                         offset, length, cb](int rc) {
+                // the index must be updated before the range is released,
+                // the scan waits for inflight ranges
+                if (rc >= 0 && hashIndex != nullptr) {
+                    hashIndex->Update(buf, offset, length);
+                }
+                tracker->Remove(offset, length);
+                if (rc < 0) {
+                    LOG(ERROR) << "Write data to chunk file failed."
+                               << "ChunkID: " << chunkId
+                               << ", offset: " << offset
+                               << ", length: " << length
+                               << ", error: " << rc;
+                    cb(CSErrorCode::InternalError);
+                    return;
+                }
+                cb(CSErrorCode::Success);
+            };
+            int rc = lfs_->WriteAsync(fd_, buf, offset + pageSize_,
+                                      length, done);
+            if (rc < 0) {
+                inflightIO_->Remove(offset, length);
+                LOG(ERROR) << "Submit write to chunk file failed."
+                           << "ChunkID: " << chunkId_
+                           << ",request sn: " << sn
+                           << ",chunk sn: " << metaPage_.sn;
+                cb(CSErrorCode::InternalError);
+            }
+            return;
+        }
+    }
+    // Write goes through all the checks again under the lock. Operations on
+    // the same chunk are applied in order by the same thread, so nothing can
+    // sneak in between.
+    cb(Write(sn, buf, offset, length, cost));
+}
+
 CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
     WriteLockGuard writeGuard(rwLock_);
     if (!CheckOffsetAndLength(offset, length)) {
@@ -403,6 +541,7 @@ CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
     if (!isCloneChunk_) {
         return CSErrorCode::Success;
     }
+    inflightIO_->WaitOverlap(offset, length);
 
     // The request above must be pagesize aligned
     // the starting page index number of the paste area
@@ -455,6 +594,7 @@ CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
                    << ", chunk size: " << size_;
         return CSErrorCode::InvalidArgError;
     }
+    inflightIO_->WaitOverlap(offset, length);
 
     // If it is clonechunk, ensure that the read area has been written,
     // otherwise an error is returned
@@ -510,6 +650,7 @@ CSErrorCode CSChunkFile::ReadSpecifiedChunk(SequenceNum sn,
                    << ", chunk size: " << size_;
         return CSErrorCode::InvalidArgError;
     }
+    inflightIO_->WaitOverlap(offset, length);
     // If the sequence equals the sequence of the current chunk,
     // read the current chunk file
     if (sn == metaPage_.sn) {
@@ -583,6 +724,7 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
                      << ", chunk sn: " << metaPage_.sn;
         return CSErrorCode::BackwardRequestError;
     }
+    inflightIO_->WaitAll();
 
     // If there is a snapshot, delete the snapshot first,
     // normally there will be no such situation
@@ -602,6 +744,16 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
         snapshot_ = nullptr;
     }
 
+    // Delete the index before the chunk, a chunk without index is fine,
+    // but an index must never outlive its chunk
+    if (hashIndex_ != nullptr) {
+        CSErrorCode errorCode = hashIndex_->Delete();
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        hashIndex_ = nullptr;
+    }
+
     if (fd_ >= 0) {
         lfs_->Close(fd_);
         fd_ = -1;
@@ -708,21 +860,26 @@ void CSChunkFile::GetInfo(CSChunkInfo* info)  {
                         : snapshot_->GetSn());
     info->isClone = isCloneChunk_;
     info->location = metaPage_.location;
-    // There will be a memcpy, otherwise you need to lock the bitmap operation.
-    // This step exists on the critical path of ReadChunk, which has certain
-    // requirements for performance.
-    // TODO(yyk) needs to evaluate which method performs better.
-    if (metaPage_.bitmap != nullptr)
-        info->bitmap = std::make_shared<Bitmap>(metaPage_.bitmap->Size(),
-                                                metaPage_.bitmap->GetBitmap());
-    else
-        info->bitmap = nullptr;
+    // This step exists on the critical path of ReadChunk. The bitmap is
+    // never modified in place, flush publishes a new one, so the caller
+    // can hold a reference to it after the lock is released.
+    info->bitmap = metaPage_.bitmap;
+}
+
+CSErrorCode CSChunkFile::SyncMetaPage() {
+    WriteLockGuard writeGuard(rwLock_);
+    if (unsyncedPages_ == 0) {
+        return CSErrorCode::Success;
+    }
+    ChunkFileMetaPage tempMeta = metaPage_;
+    return updateMetaPage(&tempMeta);
 }
 
 CSErrorCode CSChunkFile::GetHash(off_t offset,
                                  size_t length,
                                  std::string* hash)  {
     ReadLockGuard readGuard(rwLock_);
+    inflightIO_->WaitAll();
     uint32_t crc32c = 0;
 
     char *buf = new(std::nothrow) char[length];
@@ -747,6 +904,73 @@ CSErrorCode CSChunkFile::GetHash(off_t offset,
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSChunkFile::GetDigest(off_t offset,
+                                   size_t length,
+                                   bool verify,
+                                   uint32_t* digest) {
+    ReadLockGuard readGuard(rwLock_);
+    if (!CheckOffsetAndLength(offset, length)) {
+        LOG(ERROR) << "Get chunk digest failed, invalid offset or length."
+                   << "ChunkID: " << chunkId_
+                   << ", offset: " << offset
+                   << ", length: " << length
+                   << ", page size: " << pageSize_
+                   << ", chunk size: " << size_;
+        return CSErrorCode::InvalidArgError;
+    }
+    inflightIO_->WaitOverlap(offset, length);
+
+    // Pages of a clone chunk may be not written yet, always read the data
+    // to keep the same result as reading the chunk
+    bool useIndex = hashIndex_ != nullptr && !isCloneChunk_;
+    if (useIndex && !verify && hashIndex_->GetDigest(offset, length, digest)) {
+        if (metric_ != nullptr) {
+            metric_->hashIndexHit << 1;
+        }
+        return CSErrorCode::Success;
+    }
+
+    if (isCloneChunk_) {
+        uint32_t beginIndex = offset / pageSize_;
+        uint32_t endIndex = (offset + length - 1) / pageSize_;
+        if (metaPage_.bitmap->NextClearBit(beginIndex, endIndex)
+            != Bitmap::NO_POS) {
+            LOG(ERROR) << "Get chunk digest failed, has page never written."
+                       << "ChunkID: " << chunkId_
+                       << ", offset: " << offset
+                       << ", length: " << length;
+            return CSErrorCode::PageNerverWrittenError;
+        }
+    }
+
+    AlignedBuffer buf = AlignedBufferPool::GetInstance()->Get(length);
+    int rc = readData(buf.data(), offset, length);
+    if (rc < 0) {
+        LOG(ERROR) << "Read chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ",chunk sn: " << metaPage_.sn;
+        return CSErrorCode::InternalError;
+    }
+    std::vector<uint32_t> crcs;
+    ChunkHashIndex::PageCrcs(buf.data(), length, pageSize_, &crcs);
+    *digest = ChunkHashIndex::Digest(crcs);
+
+    if (useIndex) {
+        uint32_t mismatch = hashIndex_->Verify(offset, crcs);
+        if (mismatch > 0) {
+            LOG(ERROR) << "Chunk hash index mismatch with data."
+                       << "ChunkID: " << chunkId_
+                       << ", offset: " << offset
+                       << ", length: " << length
+                       << ", mismatch pages: " << mismatch;
+            if (metric_ != nullptr) {
+                metric_->hashIndexMismatch << mismatch;
+            }
+        }
+    }
+    return CSErrorCode::Success;
+}
+
 bool CSChunkFile::needCreateSnapshot(SequenceNum sn) {
     // The maximum value of correctSn_ and sn_ can represent
     // the true sequence number of the chunk file
@@ -831,6 +1055,9 @@ CSErrorCode CSChunkFile::updateMetaPage(ChunkFileMetaPage* metaPage) {
                    << ",chunk sn: " << metaPage_.sn;
         return CSErrorCode::InternalError;
     }
+    // The metapage to write always contains all the pages published in
+    // memory, so nothing is pending after it is persisted
+    unsyncedPages_ = 0;
     return CSErrorCode::Success;
 }
 
@@ -865,9 +1092,15 @@ CSErrorCode CSChunkFile::copy2Snapshot(off_t offset, size_t length) {
     for (auto& range : uncopiedRange) {
         copyOff = range.beginIndex * pageSize_;
         copySize = (range.endIndex - range.beginIndex + 1) * pageSize_;
-        std::shared_ptr<char> buf(new char[copySize],
-                                  std::default_delete<char[]>());
-        int rc = readData(buf.get(),
+        // Share the extents if the filesystem supports reflink, the later
+        // writes of the chunk are copied on write by the filesystem
+        if (enableReflinkSnapshot_
+            && snapshot_->Clone(fd_, copyOff, copySize) ==
+               CSErrorCode::Success) {
+            continue;
+        }
+        AlignedBuffer buf = AlignedBufferPool::GetInstance()->Get(copySize);
+        int rc = readData(buf.data(),
                           copyOff,
                           copySize);
         if (rc < 0) {
@@ -876,7 +1109,7 @@ CSErrorCode CSChunkFile::copy2Snapshot(off_t offset, size_t length) {
                        << ",chunk sn: " << metaPage_.sn;
             return CSErrorCode::InternalError;
         }
-        errorCode = snapshot_->Write(buf.get(), copyOff, copySize);
+        errorCode = snapshot_->Write(buf.data(), copyOff, copySize);
         if (errorCode != CSErrorCode::Success) {
             LOG(ERROR) << "Write to snapshot failed."
                        << "ChunkID: " << chunkId_
@@ -904,8 +1137,8 @@ CSErrorCode CSChunkFile::flush() {
     ChunkFileMetaPage tempMeta = metaPage_;
     bool needUpdateMeta = dirtyPages_.size() > 0;
     bool clearClone = false;
-    for (auto pageIndex : dirtyPages_) {
-        tempMeta.bitmap->Set(pageIndex);
+    if (needUpdateMeta && tempMeta.bitmap != nullptr) {
+        tempMeta.bitmap = tempMeta.bitmap->Set(dirtyPages_);
     }
     if (isCloneChunk_) {
         // If all pages have been written, mark the Chunk as a non-clone chunk
@@ -916,6 +1149,17 @@ CSErrorCode CSChunkFile::flush() {
             clearClone = true;
         }
     }
+    // Only publish the new pages in memory if few enough are pending.
+    // If they are lost in a crash, the writes are replayed from the raft
+    // log, since the pending pages are always persisted before the raft
+    // snapshot.
+    if (needUpdateMeta && !clearClone
+        && unsyncedPages_ + dirtyPages_.size() < cloneMetaSyncPages_) {
+        metaPage_.bitmap = tempMeta.bitmap;
+        unsyncedPages_ += dirtyPages_.size();
+        dirtyPages_.clear();
+        return CSErrorCode::Success;
+    }
     if (needUpdateMeta) {
         CSErrorCode errorCode = updateMetaPage(&tempMeta);
         if (errorCode != CSErrorCode::Success) {
@@ -30,6 +30,9 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <utility>
 
 #include "include/curve_compiler_specific.h"
 #include "include/chunkserver/chunkserver_common.h"
@@ -38,6 +41,7 @@
 #include "src/fs/local_filesystem.h"
 #include "src/chunkserver/datastore/filename_operator.h"
 #include "src/chunkserver/datastore/chunkserver_snapshot.h"
+#include "src/chunkserver/datastore/chunkserver_hashindex.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/file_pool.h"
 
@@ -74,7 +78,7 @@ struct ChunkFileMetaPage {
     string location;
     // Indicates the state of the page in the current Chunk,
     // if it is not CloneChunk, it is nullptr
-    std::shared_ptr<Bitmap> bitmap;
+    CompactBitmapPtr bitmap;
 
     ChunkFileMetaPage() : version(FORMAT_VERSION)
                         , sn(0)
@@ -88,6 +92,36 @@ struct ChunkFileMetaPage {
     CSErrorCode decode(const char* buf);
 };
 
+/**
+ * Callback of an asynchronous chunk operation, called exactly once with
+ * the result of the operation
+ */
+using CSAsyncCallback = std::function<void(CSErrorCode)>;
+
+/**
+ * Records the data ranges of asynchronous writes that have been submitted
+ * to the local file system but not completed yet.
+ * Operations that touch the same range of the chunk wait on it, so that
+ * they always observe the data of the writes applied before them.
+ */
+class InflightIOTracker {
+ public:
+    void Add(off_t offset, size_t length);
+    void Remove(off_t offset, size_t length);
+    // Wait until no inflight write overlaps [offset, offset + length)
+    void WaitOverlap(off_t offset, size_t length);
+    // Wait until all inflight writes are completed
+    void WaitAll();
+
+ private:
+    bool hasOverlap(off_t offset, size_t length);
+
+ private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::multiset<std::pair<off_t, size_t>> ranges_;
+};
+
 struct ChunkOptions {
     // The id of the chunk, used as the file name of the chunk
     ChunkID         id;
@@ -107,6 +141,16 @@ struct ChunkOptions {
     PageSizeType    pageSize;
     // datastore internal statistical metric
     std::shared_ptr<DataStoreMetric> metric;
+    // The directory of the chunk hash index, empty means the index
+    // is not maintained
+    std::string     hashIndexDir;
+    // Whether the copy on write of snapshots shares the extents of the
+    // chunk file by reflink instead of copying the data
+    bool            enableReflinkSnapshot;
+    // The number of newly written pages of a clone chunk that are only
+    // published in memory before the metapage is updated, 0 means the
+    // metapage is updated by every write
+    uint32_t        cloneMetaSyncPages;
 
     ChunkOptions() : id(0)
                    , sn(0)
@@ -115,7 +159,10 @@ struct ChunkOptions {
                    , location("")
                    , chunkSize(0)
                    , pageSize(0)
-                   , metric(nullptr) {}
+                   , metric(nullptr)
+                   , hashIndexDir("")
+                   , enableReflinkSnapshot(false)
+                   , cloneMetaSyncPages(0) {}
 };
 
 class CSChunkFile {
@@ -164,6 +211,26 @@ class CSChunkFile {
                       off_t offset,
                       size_t length,
                       uint32_t* cost);
+    /**
+     * Write chunk files asynchronously
+     * Plain overwrites of a normal chunk are submitted to the local file
+     * system and the function returns before the data reaches the disk.
+     * Writes that need to create a snapshot, do cow, update the metapage
+     * or change the bitmap of a clone chunk go through Write synchronously.
+     * Later operations on overlapping ranges wait for the submitted writes.
+     * @param sn: The file sequence number of the current write request
+     * @param buf: data requested to be written
+     * @param offset: The offset position of the request to write
+     * @param length: The length of the data requested to be written
+     * @param cost: The actual number of IOs generated by this request
+     * @param cb: called with the result once the data is written
+     */
+    void WriteAsync(SequenceNum sn,
+                    const butil::IOBuf& buf,
+                    off_t offset,
+                    size_t length,
+                    uint32_t* cost,
+                    CSAsyncCallback cb);
     /**
      * Write the copied data into Chunk
      * Only write areas that have not been written, and will not overwrite
@@ -234,6 +301,14 @@ class CSChunkFile {
      * @param[out]: the chunk info getted
      */
     void GetInfo(CSChunkInfo* info);
+    /**
+     * Persist the bitmap pages of the clone chunk that are only
+     * published in memory
+     * Called before the raft snapshot, the writes after it can be
+     * recovered by replaying the log.
+     * @return: return error code
+     */
+    CSErrorCode SyncMetaPage();
     /**
      * Get the hash value of the chunk, this interface is used for test
      * @param[out]: chunk hash value
@@ -242,6 +317,23 @@ class CSChunkFile {
     CSErrorCode GetHash(off_t offset,
                         size_t length,
                         std::string *hash);
+    /**
+     * Get the digest of the chunk data, used by the consistency scan.
+     * The digest is the CRC32C of the page crcs in the range, it comes from
+     * the chunk hash index if all the page crcs are known, otherwise the
+     * data is read and the index is rebuilt.
+     * There may be concurrency, add read lock
+     * @param offset: the starting offset of the range
+     * @param length: the length of the range
+     * @param verify: read the data even if the index is complete, and
+     *                check the index against it
+     * @param[out] digest: the digest of the range
+     * @return: return error code
+     */
+    CSErrorCode GetDigest(off_t offset,
+                          size_t length,
+                          bool verify,
+                          uint32_t* digest);
     /**
      * Get chunkFileMetaPage
      * @return: metapage
@@ -282,7 +374,8 @@ class CSChunkFile {
     CSErrorCode loadMetaPage();
     /**
      * Copy the uncopied data in the specified area from the chunk file
-     * to the snapshot file
+     * to the snapshot file, the data is shared by reflink if enabled and
+     * copied if the reflink fails
      * @param offset: the starting offset of the write data area
      * @param length: the length of the write data area
      * @return: return error code
@@ -292,6 +385,8 @@ class CSChunkFile {
      * Update the bitmap of the clone chunk
      * If all pages have been written, the clone chunk will be converted
      * to a normal chunk
+     * The metapage update is deferred until cloneMetaSyncPages_ pages are
+     * pending, the conversion to a normal chunk is never deferred
      */
     CSErrorCode flush();
 
@@ -300,6 +395,17 @@ class CSChunkFile {
                     FileNameOperator::GenerateChunkFileName(chunkId_);
     }
 
+    inline string hashIndexPath() {
+        return hashIndexDir_ + "/" +
+                    FileNameOperator::GenerateHashIndexName(chunkId_);
+    }
+
+    /**
+     * Open the hash index of the chunk, the chunk works without the index
+     * if it fails
+     */
+    void openHashIndex(const struct stat& chunkStat);
+
     inline uint32_t fileSize() {
         return pageSize_ + size_;
     }
@@ -317,10 +423,16 @@ class CSChunkFile {
     }
 
     inline int writeData(const char* buf, off_t offset, size_t length) {
+        if (hashIndex_ != nullptr) {
+            hashIndex_->MarkDirty();
+        }
         int rc = lfs_->Write(fd_, buf, offset + pageSize_, length);
         if (rc < 0) {
             return rc;
         }
+        if (hashIndex_ != nullptr) {
+            hashIndex_->Update(buf, offset, length);
+        }
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
@@ -337,10 +449,16 @@ class CSChunkFile {
     }
 
     inline int writeData(const butil::IOBuf& buf, off_t offset, size_t length) {
+        if (hashIndex_ != nullptr) {
+            hashIndex_->MarkDirty();
+        }
         int rc = lfs_->Write(fd_, buf, offset + pageSize_, length);
         if (rc < 0) {
             return rc;
         }
+        if (hashIndex_ != nullptr) {
+            hashIndex_->Update(buf, offset, length);
+        }
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
@@ -403,6 +521,21 @@ class CSChunkFile {
     std::shared_ptr<LocalFileSystem> lfs_;
     // datastore internal statistical indicators
     std::shared_ptr<DataStoreMetric> metric_;
+    // Asynchronous writes not completed yet, shared with their callbacks
+    // so that the callbacks stay valid after the chunk file is destroyed
+    std::shared_ptr<InflightIOTracker> inflightIO_;
+    // The directory of the chunk hash index, empty if disabled
+    std::string hashIndexDir_;
+    // Page crcs of the chunk, shared with the callbacks of asynchronous
+    // writes, nullptr if not maintained
+    std::shared_ptr<ChunkHashIndex> hashIndex_;
+    // Share the extents with the snapshot by reflink on copy on write
+    bool enableReflinkSnapshot_;
+    // The number of written pages allowed to be missing from the bitmap
+    // on disk, 0 means the metapage is updated by every write
+    uint32_t cloneMetaSyncPages_;
+    // The number of pages set in metaPage_.bitmap but not yet persisted
+    uint32_t unsyncedPages_;
 };
 }  // namespace chunkserver
 }  // namespace curve
@@ -40,15 +40,21 @@ CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
     : chunkSize_(options.chunkSize),
       pageSize_(options.pageSize),
       baseDir_(options.baseDir),
+      hashIndexDir_(options.hashIndexDir),
       locationLimit_(options.locationLimit),
       chunkFilePool_(chunkFilePool),
-      lfs_(lfs) {
+      lfs_(lfs),
+      enableAsyncWrite_(options.enableAsyncWrite),
+      enableReflinkSnapshot_(options.enableReflinkSnapshot),
+      cloneMetaSyncPages_(options.cloneMetaSyncPages),
+      asyncWrites_(0) {
     CHECK(!baseDir_.empty()) << "Create datastore failed";
     CHECK(lfs_ != nullptr) << "Create datastore failed";
     CHECK(chunkFilePool_ != nullptr) << "Create datastore failed";
 }
 
 CSDataStore::~CSDataStore() {
+    WaitAsyncWrites();
 }
 
 bool CSDataStore::Initialize() {
@@ -61,6 +67,21 @@ bool CSDataStore::Initialize() {
         }
     }
 
+    if (!hashIndexDir_.empty() && !lfs_->DirExists(hashIndexDir_.c_str())) {
+        int rc = lfs_->Mkdir(hashIndexDir_.c_str());
+        if (rc < 0) {
+            LOG(ERROR) << "Create " << hashIndexDir_ << " failed.";
+            return false;
+        }
+    }
+
+    if (enableReflinkSnapshot_ && !reflinkSupported()) {
+        LOG(WARNING) << "Filesystem of " << baseDir_
+                     << " does not support reflink,"
+                     << " snapshot falls back to copying data.";
+        enableReflinkSnapshot_ = false;
+    }
+
     vector<string> files;
     int rc = lfs_->List(baseDir_, &files);
     if (rc < 0) {
@@ -108,10 +129,53 @@ bool CSDataStore::Initialize() {
             LOG(WARNING) << "Unknown file: " << files[i];
         }
     }
+    removeStaleHashIndex();
     LOG(INFO) << "Initialize data store success.";
     return true;
 }
 
+void CSDataStore::removeStaleHashIndex() {
+    if (hashIndexDir_.empty()) {
+        return;
+    }
+    vector<string> files;
+    if (lfs_->List(hashIndexDir_, &files) < 0) {
+        LOG(WARNING) << "List " << hashIndexDir_ << " failed.";
+        return;
+    }
+    // Index of chunks deleted while the copyset is installing a raft
+    // snapshot, or left by a crash during chunk deletion
+    for (auto& file : files) {
+        vector<string> elements;
+        ::curve::common::SplitString(file, "_", &elements);
+        ChunkID id;
+        if (elements.size() == 3
+            && ::curve::common::StringToUll(elements[1], &id)
+            && file == FileNameOperator::GenerateHashIndexName(id)
+            && metaCache_.Get(id) != nullptr) {
+            continue;
+        }
+        LOG(INFO) << "Remove stale chunk hash index: " << file;
+        lfs_->Delete(hashIndexDir_ + "/" + file);
+    }
+}
+
+bool CSDataStore::reflinkSupported() {
+    // Clone the first page of an unnamed probe file to its second page,
+    // the probe file is released on close and never left in baseDir
+    int fd = lfs_->Open(baseDir_, O_RDWR|O_TMPFILE);
+    if (fd < 0) {
+        LOG(WARNING) << "Open tmpfile in " << baseDir_ << " failed.";
+        return false;
+    }
+    char buf[pageSize_];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    bool supported = lfs_->Write(fd, buf, 0, pageSize_) >= 0
+                     && lfs_->CloneRange(fd, 0, fd, pageSize_, pageSize_) == 0;
+    lfs_->Close(fd);
+    return supported;
+}
+
 CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
     auto chunkFile = metaCache_.Get(id);
     if (chunkFile != nullptr) {
@@ -245,6 +309,9 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
         options.id = id;
         options.sn = sn;
         options.baseDir = baseDir_;
+        options.hashIndexDir = hashIndexDir_;
+        options.enableReflinkSnapshot = enableReflinkSnapshot_;
+        options.cloneMetaSyncPages = cloneMetaSyncPages_;
         options.chunkSize = chunkSize_;
         options.location = cloneSourceLocation;
         options.pageSize = pageSize_;
@@ -268,6 +335,78 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
     return CSErrorCode::Success;
 }
 
+void CSDataStore::WriteChunkAsync(ChunkID id,
+                                  SequenceNum sn,
+                                  const butil::IOBuf& buf,
+                                  off_t offset,
+                                  size_t length,
+                                  uint32_t* cost,
+                                  CSAsyncCallback cb,
+                                  const std::string & cloneSourceLocation) {
+    if (sn == kInvalidSeq) {
+        LOG(ERROR) << "Sequence num should not be zero."
+                   << "ChunkID = " << id;
+        cb(CSErrorCode::InvalidArgError);
+        return;
+    }
+    auto chunkFile = metaCache_.Get(id);
+    // If the chunk file does not exist, create the chunk file first
+    if (chunkFile == nullptr) {
+        ChunkOptions options;
+        options.id = id;
+        options.sn = sn;
+        options.baseDir = baseDir_;
+        options.hashIndexDir = hashIndexDir_;
+        options.enableReflinkSnapshot = enableReflinkSnapshot_;
+        options.cloneMetaSyncPages = cloneMetaSyncPages_;
+        options.chunkSize = chunkSize_;
+        options.location = cloneSourceLocation;
+        options.pageSize = pageSize_;
+        options.metric = metric_;
+        CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
+        if (errorCode != CSErrorCode::Success) {
+            cb(errorCode);
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(asyncWritesMtx_);
+        ++asyncWrites_;
+    }
+    auto done = [this, id, cb](CSErrorCode errorCode) {
+        if (errorCode != CSErrorCode::Success) {
+            LOG(WARNING) << "Write chunk file failed."
+                         << "ChunkID = " << id;
+        }
+        cb(errorCode);
+        std::lock_guard<std::mutex> lk(asyncWritesMtx_);
+        --asyncWrites_;
+        asyncWritesCond_.notify_all();
+    };
+    chunkFile->WriteAsync(sn, buf, offset, length, cost, done);
+}
+
+void CSDataStore::WaitAsyncWrites() {
+    std::unique_lock<std::mutex> lk(asyncWritesMtx_);
+    while (asyncWrites_ > 0) {
+        asyncWritesCond_.wait(lk);
+    }
+}
+
+CSErrorCode CSDataStore::SyncMetaPages() {
+    ChunkMapSnapshot chunkMap = metaCache_.GetSnapshot();
+    for (const auto& item : chunkMap) {
+        CSErrorCode errorCode = item.second->SyncMetaPage();
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Sync metapage failed."
+                       << "ChunkID = " << item.first;
+            return errorCode;
+        }
+    }
+    return CSErrorCode::Success;
+}
+
 CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
                                           SequenceNum sn,
                                           SequenceNum correctedSn,
@@ -294,6 +433,9 @@ CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
         options.correctedSn = correctedSn;
         options.location = location;
         options.baseDir = baseDir_;
+        options.hashIndexDir = hashIndexDir_;
+        options.enableReflinkSnapshot = enableReflinkSnapshot_;
+        options.cloneMetaSyncPages = cloneMetaSyncPages_;
         options.chunkSize = chunkSize_;
         options.pageSize = pageSize_;
         options.metric = metric_;
@@ -371,11 +513,33 @@ CSErrorCode CSDataStore::GetChunkHash(ChunkID id,
     return chunkFile->GetHash(offset, length, hash);
 }
 
+CSErrorCode CSDataStore::GetChunkDigest(ChunkID id,
+                                        off_t offset,
+                                        size_t length,
+                                        bool verify,
+                                        uint32_t* digest) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        return CSErrorCode::ChunkNotExistError;
+    }
+
+    CSErrorCode errorCode =
+        chunkFile->GetDigest(offset, length, verify, digest);
+    if (errorCode != CSErrorCode::Success) {
+        LOG(WARNING) << "Get chunk digest failed."
+                     << "ChunkID = " << id;
+        return errorCode;
+    }
+    return CSErrorCode::Success;
+}
+
 DataStoreStatus CSDataStore::GetStatus() {
     DataStoreStatus status;
     status.chunkFileCount = metric_->chunkFileCount.get_value();
     status.cloneChunkCount = metric_->cloneChunkCount.get_value();
     status.snapshotCount = metric_->snapshotCount.get_value();
+    status.hashIndexHit = metric_->hashIndexHit.get_value();
+    status.hashIndexMismatch = metric_->hashIndexMismatch.get_value();
     return status;
 }
 
@@ -386,6 +550,9 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
         options.id = id;
         options.sn = 0;
         options.baseDir = baseDir_;
+        options.hashIndexDir = hashIndexDir_;
+        options.enableReflinkSnapshot = enableReflinkSnapshot_;
+        options.cloneMetaSyncPages = cloneMetaSyncPages_;
         options.chunkSize = chunkSize_;
         options.pageSize = pageSize_;
         options.metric = metric_;
@@ -401,8 +568,8 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
     return CSErrorCode::Success;
 }
 
-ChunkMap CSDataStore::GetChunkMap() {
-    return metaCache_.GetMap();
+ChunkMapSnapshot CSDataStore::GetChunkMap() {
+    return metaCache_.GetSnapshot();
 }
 
 }  // namespace chunkserver
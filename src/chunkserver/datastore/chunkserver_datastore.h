@@ -30,6 +30,8 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <condition_variable>  // NOLINT
 
 #include "include/curve_compiler_specific.h"
 #include "include/chunkserver/chunkserver_common.h"
@@ -37,6 +39,7 @@
 #include "src/common/concurrent/concurrent.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/chunkserver_chunkfile.h"
+#include "src/chunkserver/datastore/chunkserver_metacache.h"
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/fs/local_filesystem.h"
 
@@ -44,7 +47,6 @@ namespace curve {
 namespace chunkserver {
 using curve::fs::LocalFileSystem;
 using ::curve::common::Atomic;
-using CSChunkFilePtr = std::shared_ptr<CSChunkFile>;
 
 inline void TrivialDeleter(void* ptr) {}
 
@@ -53,12 +55,26 @@ inline void TrivialDeleter(void* ptr) {}
  * baseDir: Directory path managed by DataStore
  * chunkSize: The size of the chunk file or snapshot file in the DataStore
  * pageSize: the size of the smallest read-write unit
+ * enableAsyncWrite: whether the apply threads submit writes asynchronously
+ * enableReflinkSnapshot: whether the copy on write of snapshots shares the
+ *                        extents of the chunk file instead of copying data
+ * cloneMetaSyncPages: the number of newly written pages of a clone chunk
+ *                     that are only kept in memory before the metapage is
+ *                     updated, 0 means the metapage is updated by every
+ *                     write. Pages not persisted are recovered by raft log
+ *                     replay, SyncMetaPages must be called before the raft
+ *                     snapshot.
  */
 struct DataStoreOptions {
     std::string                         baseDir;
+    // The directory of the chunk hash index, empty means disabled
+    std::string                         hashIndexDir;
     ChunkSizeType                       chunkSize;
     PageSizeType                        pageSize;
     uint32_t                            locationLimit;
+    bool                                enableAsyncWrite = false;
+    bool                                enableReflinkSnapshot = false;
+    uint32_t                            cloneMetaSyncPages = 0;
 };
 
 /**
@@ -66,14 +82,21 @@ struct DataStoreOptions {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * hashIndexHit: the number of scan digests got from the chunk hash index
+ * hashIndexMismatch: the number of pages whose stored crc is different
+ *                    from the data
  */
 struct DataStoreStatus {
     uint32_t chunkFileCount;
     uint32_t snapshotCount;
     uint32_t cloneChunkCount;
+    uint32_t hashIndexHit;
+    uint32_t hashIndexMismatch;
     DataStoreStatus() : chunkFileCount(0)
                     , snapshotCount(0)
-                    , cloneChunkCount(0) {}
+                    , cloneChunkCount(0)
+                    , hashIndexHit(0)
+                    , hashIndexMismatch(0) {}
 };
 
 /**
@@ -81,66 +104,26 @@ struct DataStoreStatus {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * hashIndexHit: the number of scan digests got from the chunk hash index
+ * hashIndexMismatch: the number of pages whose stored crc is different
+ *                    from the data
  */
 struct DataStoreMetric {
     bvar::Adder<uint32_t> chunkFileCount;
     bvar::Adder<uint32_t> snapshotCount;
     bvar::Adder<uint32_t> cloneChunkCount;
+    bvar::Adder<uint32_t> hashIndexHit;
+    bvar::Adder<uint32_t> hashIndexMismatch;
 };
 using DataStoreMetricPtr = std::shared_ptr<DataStoreMetric>;
 
-using ChunkMap = std::unordered_map<ChunkID, CSChunkFilePtr>;
-// For the mapping from chunkid to chunkfile,
-// use read-write lock to protect the map operation
-class CSMetaCache {
- public:
-    CSMetaCache() {}
-    virtual ~CSMetaCache() {}
-
-    ChunkMap GetMap() {
-        ReadLockGuard readGuard(rwLock_);
-        return chunkMap_;
-    }
-
-    CSChunkFilePtr Get(ChunkID id) {
-        ReadLockGuard readGuard(rwLock_);
-        if (chunkMap_.find(id) == chunkMap_.end()) {
-            return nullptr;
-        }
-        return chunkMap_[id];
-    }
-
-    CSChunkFilePtr Set(ChunkID id, CSChunkFilePtr chunkFile) {
-        WriteLockGuard writeGuard(rwLock_);
-       // When two write requests are concurrently created to create a chunk
-       // file, return the first set chunkFile
-        if (chunkMap_.find(id) == chunkMap_.end()) {
-            chunkMap_[id] = chunkFile;
-        }
-        return chunkMap_[id];
-    }
-
-    void Remove(ChunkID id) {
-        WriteLockGuard writeGuard(rwLock_);
-        if (chunkMap_.find(id) != chunkMap_.end()) {
-            chunkMap_.erase(id);
-        }
-    }
-
-    void Clear() {
-        WriteLockGuard writeGuard(rwLock_);
-        chunkMap_.clear();
-    }
-
- private:
-    RWLock      rwLock_;
-    ChunkMap    chunkMap_;
-};
-
 class CSDataStore {
  public:
     // for ut mock
-    CSDataStore() {}
+    CSDataStore() : enableAsyncWrite_(false),
+                    enableReflinkSnapshot_(false),
+                    cloneMetaSyncPages_(0),
+                    asyncWrites_(0) {}
 
     CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
                 std::shared_ptr<FilePool> chunkFilePool,
@@ -248,6 +231,49 @@ class CSDataStore {
                           cloneSourceLocation);
     }
 
+    /**
+     * Write data asynchronously, see CSChunkFile::WriteAsync
+     * The callback is called exactly once, either in the calling thread or
+     * in the completion thread of the local file system
+     * @param id: the chunk id to be written
+     * @param sn: The sequence number of the user file when the current
+     *            write request is issued
+     * @param buf: the content of the data to be written
+     * @param offset: the offset address requested to write
+     * @param length: the length of the data requested to be written
+     * @param cost: the actual number of IOs generated, used for QOS control
+     * @param cb: called with the result of the write
+     * @param cloneSource: indicates the address of the clone from curvefs
+     */
+    virtual void WriteChunkAsync(ChunkID id,
+                                 SequenceNum sn,
+                                 const butil::IOBuf& buf,
+                                 off_t offset,
+                                 size_t length,
+                                 uint32_t* cost,
+                                 CSAsyncCallback cb,
+                                 const std::string & cloneSourceLocation = "");
+
+    /**
+     * Wait until all the asynchronous writes submitted through this
+     * datastore are completed
+     */
+    virtual void WaitAsyncWrites();
+
+    /**
+     * Persist the bitmap pages of all clone chunks that are only kept in
+     * memory, the writes before it don't need to be replayed any more
+     * @return: return error code
+     */
+    virtual CSErrorCode SyncMetaPages();
+
+    /**
+     * Whether the upper layer should use WriteChunkAsync to apply writes
+     */
+    virtual bool AsyncWriteEnabled() const {
+        return enableAsyncWrite_;
+    }
+
     /**
      * Create a cloned Chunk, record the data source location information
      * in the chunk
@@ -298,18 +324,41 @@ class CSDataStore {
                                      off_t offset,
                                      size_t length,
                                      std::string* hash);
+    /**
+     * Get the digest of the chunk data for the consistency scan, it is
+     * got from the chunk hash index if possible, see CSChunkFile::GetDigest
+     * @param id[in]: chunk id
+     * @param offset[in]: the starting offset of the range
+     * @param length[in]: the length of the range
+     * @param verify[in]: read the data and check the index against it
+     * @param digest[out]: the digest of the range
+     * @return: return error code
+     */
+    virtual CSErrorCode GetChunkDigest(ChunkID id,
+                                       off_t offset,
+                                       size_t length,
+                                       bool verify,
+                                       uint32_t* digest);
     /**
      * Get internal statistics of DataStore
      * @return: internal statistics of datastore
      */
     virtual DataStoreStatus GetStatus();
 
-    virtual ChunkMap GetChunkMap();
+    /**
+     * Get a snapshot of all chunks in the datastore, the snapshot shares
+     * the underlying maps with metacache instead of copying them
+     */
+    virtual ChunkMapSnapshot GetChunkMap();
 
  private:
     CSErrorCode loadChunkFile(ChunkID id);
     CSErrorCode CreateChunkFile(const ChunkOptions & ops,
                                 CSChunkFilePtr* chunkFile);
+    // remove the index files whose chunk is not loaded
+    void removeStaleHashIndex();
+    // probe whether the filesystem of baseDir supports reflink
+    bool reflinkSupported();
 
  private:
     // The size of each chunk
@@ -320,6 +369,8 @@ class CSDataStore {
     uint32_t locationLimit_;
     // datastore management directory
     std::string baseDir_;
+    // chunk hash index directory, empty if the index is disabled
+    std::string hashIndexDir_;
     // the mapping of chunkid->chunkfile
     CSMetaCache metaCache_;
     // chunkfile pool, rely on this pool to create and recycle chunk files
@@ -329,6 +380,16 @@ class CSDataStore {
     std::shared_ptr<LocalFileSystem> lfs_;
     // internal statistics of datastore
     DataStoreMetricPtr metric_;
+    // whether the apply threads submit writes asynchronously
+    bool enableAsyncWrite_;
+    // whether the copy on write of snapshots shares extents by reflink
+    bool enableReflinkSnapshot_;
+    // the number of clone chunk pages allowed to be missing from metapage
+    uint32_t cloneMetaSyncPages_;
+    // the number of asynchronous writes not completed yet
+    uint64_t asyncWrites_;
+    std::mutex asyncWritesMtx_;
+    std::condition_variable asyncWritesCond_;
 };
 
 }  // namespace chunkserver
@@ -0,0 +1,457 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-21
+ * Author: yangyaokai
+ */
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include "src/chunkserver/datastore/chunkserver_hashindex.h"
+#include "src/common/crc32.h"
+
+namespace curve {
+namespace chunkserver {
+
+const uint32_t ChunkHashIndex::kHeaderSize;
+
+namespace {
+const uint32_t kHashIndexMagic = 0x58494843;  // "CHIX"
+const uint8_t kHashIndexVersion = 1;
+const uint8_t kHashIndexClean = 1;
+const uint8_t kHashIndexDirty = 2;
+}  // namespace
+
+ChunkHashIndexHeader::ChunkHashIndexHeader()
+    : version(kHashIndexVersion),
+      state(kHashIndexDirty),
+      pageSize(0),
+      pageNum(0),
+      ino(0),
+      size(0),
+      mtimeSec(0),
+      mtimeNsec(0),
+      ctimeSec(0),
+      ctimeNsec(0),
+      known(nullptr) {}
+
+void ChunkHashIndexHeader::SetStamp(const struct stat& chunkStat) {
+    ino = chunkStat.st_ino;
+    size = chunkStat.st_size;
+    mtimeSec = chunkStat.st_mtim.tv_sec;
+    mtimeNsec = chunkStat.st_mtim.tv_nsec;
+    ctimeSec = chunkStat.st_ctim.tv_sec;
+    ctimeNsec = chunkStat.st_ctim.tv_nsec;
+}
+
+bool ChunkHashIndexHeader::StampMatch(const struct stat& chunkStat) const {
+    return ino == static_cast<uint64_t>(chunkStat.st_ino)
+           && size == static_cast<uint64_t>(chunkStat.st_size)
+           && mtimeSec == static_cast<uint64_t>(chunkStat.st_mtim.tv_sec)
+           && mtimeNsec == static_cast<uint64_t>(chunkStat.st_mtim.tv_nsec)
+           && ctimeSec == static_cast<uint64_t>(chunkStat.st_ctim.tv_sec)
+           && ctimeNsec == static_cast<uint64_t>(chunkStat.st_ctim.tv_nsec);
+}
+
+bool ChunkHashIndexHeader::encode(char* buf) const {
+    size_t len = 0;
+    memcpy(buf, &kHashIndexMagic, sizeof(kHashIndexMagic));
+    len += sizeof(kHashIndexMagic);
+    memcpy(buf + len, &version, sizeof(version));
+    len += sizeof(version);
+    memcpy(buf + len, &state, sizeof(state));
+    len += sizeof(state);
+    memcpy(buf + len, &pageSize, sizeof(pageSize));
+    len += sizeof(pageSize);
+    memcpy(buf + len, &pageNum, sizeof(pageNum));
+    len += sizeof(pageNum);
+    const uint64_t stamp[] = {ino, size, mtimeSec, mtimeNsec,
+                              ctimeSec, ctimeNsec};
+    memcpy(buf + len, stamp, sizeof(stamp));
+    len += sizeof(stamp);
+    uint32_t bits = (known == nullptr ? 0 : known->Size());
+    size_t bitmapBytes = (bits + 8 - 1) >> 3;
+    if (len + sizeof(bits) + bitmapBytes + sizeof(uint32_t)
+        > ChunkHashIndex::kHeaderSize) {
+        return false;
+    }
+    memcpy(buf + len, &bits, sizeof(bits));
+    len += sizeof(bits);
+    if (bits > 0) {
+        memcpy(buf + len, known->GetBitmap(), bitmapBytes);
+        len += bitmapBytes;
+    }
+    uint32_t crc = ::curve::common::CRC32(buf, len);
+    memcpy(buf + len, &crc, sizeof(crc));
+    return true;
+}
+
+CSErrorCode ChunkHashIndexHeader::decode(const char* buf) {
+    size_t len = 0;
+    uint32_t magic;
+    memcpy(&magic, buf, sizeof(magic));
+    len += sizeof(magic);
+    if (magic != kHashIndexMagic) {
+        return CSErrorCode::FileFormatError;
+    }
+    memcpy(&version, buf + len, sizeof(version));
+    len += sizeof(version);
+    memcpy(&state, buf + len, sizeof(state));
+    len += sizeof(state);
+    memcpy(&pageSize, buf + len, sizeof(pageSize));
+    len += sizeof(pageSize);
+    memcpy(&pageNum, buf + len, sizeof(pageNum));
+    len += sizeof(pageNum);
+    uint64_t stamp[6];
+    memcpy(stamp, buf + len, sizeof(stamp));
+    len += sizeof(stamp);
+    ino = stamp[0];
+    size = stamp[1];
+    mtimeSec = stamp[2];
+    mtimeNsec = stamp[3];
+    ctimeSec = stamp[4];
+    ctimeNsec = stamp[5];
+    uint32_t bits;
+    memcpy(&bits, buf + len, sizeof(bits));
+    len += sizeof(bits);
+    size_t bitmapBytes = (bits + 8 - 1) >> 3;
+    if (len + bitmapBytes + sizeof(uint32_t) > ChunkHashIndex::kHeaderSize) {
+        return CSErrorCode::FileFormatError;
+    }
+    known = nullptr;
+    if (bits > 0) {
+        known = std::make_shared<Bitmap>(bits, buf + len);
+        len += bitmapBytes;
+    }
+    uint32_t crc = ::curve::common::CRC32(buf, len);
+    uint32_t recordCrc;
+    memcpy(&recordCrc, buf + len, sizeof(recordCrc));
+    if (crc != recordCrc) {
+        return CSErrorCode::CrcCheckError;
+    }
+    if (version != kHashIndexVersion) {
+        return CSErrorCode::IncompatibleError;
+    }
+    return CSErrorCode::Success;
+}
+
+ChunkHashIndex::ChunkHashIndex(std::shared_ptr<LocalFileSystem> lfs,
+                               const std::string& path,
+                               PageSizeType pageSize,
+                               uint32_t pageNum)
+    : lfs_(lfs),
+      path_(path),
+      pageSize_(pageSize),
+      pageNum_(pageNum),
+      fd_(-1),
+      dirty_(false),
+      broken_(false),
+      known_(nullptr) {}
+
+ChunkHashIndex::~ChunkHashIndex() {
+    if (fd_ >= 0) {
+        lfs_->Close(fd_);
+        fd_ = -1;
+    }
+}
+
+CSErrorCode ChunkHashIndex::Open(const struct stat& chunkStat) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    bool exist = lfs_->FileExists(path_);
+    int rc = lfs_->Open(path_, O_RDWR|O_CREAT|O_NOATIME);
+    if (rc < 0) {
+        LOG(ERROR) << "Open chunk hash index failed, path: " << path_;
+        return CSErrorCode::InternalError;
+    }
+    fd_ = rc;
+
+    if (exist) {
+        char buf[kHeaderSize];  // NOLINT
+        memset(buf, 0, sizeof(buf));
+        ChunkHashIndexHeader header;
+        rc = lfs_->Read(fd_, buf, 0, kHeaderSize);
+        if (rc >= 0
+            && header.decode(buf) == CSErrorCode::Success
+            && header.state == kHashIndexClean
+            && header.pageSize == pageSize_
+            && header.pageNum == pageNum_
+            && header.StampMatch(chunkStat)) {
+            dirty_ = false;
+            known_ = header.known;
+            return CSErrorCode::Success;
+        }
+        LOG(INFO) << "Chunk hash index is out of date, will be rebuilt by"
+                  << " scan, path: " << path_;
+    }
+
+    // the stored crcs can not be trusted, all pages are unknown
+    rc = lfs_->Fallocate(fd_, 0, 0, fileSize());
+    if (rc < 0) {
+        LOG(ERROR) << "Allocate chunk hash index failed, path: " << path_;
+        return CSErrorCode::InternalError;
+    }
+    ChunkHashIndexHeader header;
+    header.state = kHashIndexDirty;
+    header.pageSize = pageSize_;
+    header.pageNum = pageNum_;
+    rc = writeHeader(header);
+    if (rc < 0) {
+        LOG(ERROR) << "Write chunk hash index header failed, path: " << path_;
+        return CSErrorCode::InternalError;
+    }
+    dirty_ = true;
+    known_ = std::make_shared<Bitmap>(pageNum_);
+    return CSErrorCode::Success;
+}
+
+void ChunkHashIndex::MarkDirty() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    markDirty();
+}
+
+void ChunkHashIndex::markDirty() {
+    if (dirty_ || broken_) {
+        return;
+    }
+    ChunkHashIndexHeader header;
+    header.state = kHashIndexDirty;
+    header.pageSize = pageSize_;
+    header.pageNum = pageNum_;
+    int rc = writeHeader(header);
+    if (rc >= 0) {
+        rc = lfs_->Fsync(fd_);
+    }
+    if (rc < 0) {
+        LOG(ERROR) << "Mark chunk hash index dirty failed, path: " << path_;
+        invalidate();
+        return;
+    }
+    dirty_ = true;
+}
+
+void ChunkHashIndex::Update(const char* buf, off_t offset, size_t length) {
+    std::vector<uint32_t> crcs;
+    PageCrcs(buf, length, pageSize_, &crcs);
+    std::lock_guard<std::mutex> lk(mtx_);
+    store(offset / pageSize_, crcs);
+}
+
+void ChunkHashIndex::Update(const butil::IOBuf& buf,
+                            off_t offset,
+                            size_t length) {
+    std::vector<uint32_t> crcs;
+    PageCrcs(buf, length, pageSize_, &crcs);
+    std::lock_guard<std::mutex> lk(mtx_);
+    store(offset / pageSize_, crcs);
+}
+
+bool ChunkHashIndex::GetDigest(off_t offset, size_t length, uint32_t* digest) {
+    uint32_t beginIndex = offset / pageSize_;
+    uint32_t endIndex = (offset + length - 1) / pageSize_;
+    std::vector<uint32_t> crcs(endIndex - beginIndex + 1);
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (broken_ || endIndex >= pageNum_) {
+            return false;
+        }
+        if (known_ != nullptr
+            && known_->NextClearBit(beginIndex, endIndex) != Bitmap::NO_POS) {
+            return false;
+        }
+        int rc = lfs_->Read(fd_, reinterpret_cast<char*>(crcs.data()),
+                            crcOffset(beginIndex),
+                            crcs.size() * sizeof(uint32_t));
+        if (rc < 0) {
+            LOG(ERROR) << "Read chunk hash index failed, path: " << path_;
+            return false;
+        }
+    }
+    *digest = Digest(crcs);
+    return true;
+}
+
+uint32_t ChunkHashIndex::Verify(off_t offset,
+                                const std::vector<uint32_t>& crcs) {
+    uint32_t beginIndex = offset / pageSize_;
+    std::vector<uint32_t> stored(crcs.size());
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (broken_ || beginIndex + crcs.size() > pageNum_) {
+        return 0;
+    }
+    int rc = lfs_->Read(fd_, reinterpret_cast<char*>(stored.data()),
+                        crcOffset(beginIndex),
+                        stored.size() * sizeof(uint32_t));
+    if (rc < 0) {
+        LOG(ERROR) << "Read chunk hash index failed, path: " << path_;
+        return 0;
+    }
+
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < crcs.size(); ++i) {
+        bool known = (known_ == nullptr || known_->Test(beginIndex + i));
+        if (known && stored[i] != crcs[i]) {
+            LOG(ERROR) << "Chunk hash index mismatch with data, path: "
+                       << path_ << ", page: " << beginIndex + i
+                       << ", stored crc: " << stored[i]
+                       << ", data crc: " << crcs[i];
+            ++mismatch;
+        }
+    }
+    // the known pages change, they are persisted at close
+    markDirty();
+    store(beginIndex, crcs);
+    return mismatch;
+}
+
+void ChunkHashIndex::Close(const struct stat& chunkStat) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (fd_ < 0) {
+        return;
+    }
+    if (dirty_ && !broken_) {
+        ChunkHashIndexHeader header;
+        header.state = kHashIndexClean;
+        header.pageSize = pageSize_;
+        header.pageNum = pageNum_;
+        header.known = known_;
+        header.SetStamp(chunkStat);
+        // crcs must be on disk before the header says they can be trusted
+        int rc = lfs_->Fsync(fd_);
+        if (rc >= 0) {
+            rc = writeHeader(header);
+        }
+        if (rc >= 0) {
+            rc = lfs_->Fsync(fd_);
+        }
+        if (rc < 0) {
+            LOG(WARNING) << "Close chunk hash index failed, path: " << path_;
+        }
+    }
+    lfs_->Close(fd_);
+    fd_ = -1;
+}
+
+CSErrorCode ChunkHashIndex::Delete() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (fd_ >= 0) {
+        lfs_->Close(fd_);
+        fd_ = -1;
+    }
+    broken_ = true;
+    int rc = lfs_->Delete(path_);
+    if (rc < 0 && rc != -ENOENT) {
+        LOG(ERROR) << "Delete chunk hash index failed, path: " << path_;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+void ChunkHashIndex::PageCrcs(const char* buf,
+                              size_t length,
+                              PageSizeType pageSize,
+                              std::vector<uint32_t>* crcs) {
+    crcs->resize(length / pageSize);
+    for (size_t i = 0; i < crcs->size(); ++i) {
+        (*crcs)[i] = ::curve::common::CRC32(buf + i * pageSize, pageSize);
+    }
+}
+
+void ChunkHashIndex::PageCrcs(const butil::IOBuf& buf,
+                              size_t length,
+                              PageSizeType pageSize,
+                              std::vector<uint32_t>* crcs) {
+    crcs->assign(length / pageSize, 0);
+    // pages may span the blocks of the iobuf
+    size_t page = 0;
+    size_t filled = 0;
+    for (size_t i = 0; i < buf.backing_block_num() && page < crcs->size();
+         ++i) {
+        butil::StringPiece block = buf.backing_block(i);
+        const char* data = block.data();
+        size_t remain = block.size();
+        while (remain > 0 && page < crcs->size()) {
+            size_t n = std::min<size_t>(remain, pageSize - filled);
+            (*crcs)[page] = ::curve::common::CRC32((*crcs)[page], data, n);
+            data += n;
+            remain -= n;
+            filled += n;
+            if (filled == pageSize) {
+                ++page;
+                filled = 0;
+            }
+        }
+    }
+}
+
+uint32_t ChunkHashIndex::Digest(const std::vector<uint32_t>& crcs) {
+    return ::curve::common::CRC32(reinterpret_cast<const char*>(crcs.data()),
+                                  crcs.size() * sizeof(uint32_t));
+}
+
+void ChunkHashIndex::store(uint32_t beginIndex,
+                           const std::vector<uint32_t>& crcs) {
+    if (broken_ || crcs.empty()) {
+        return;
+    }
+    int rc = lfs_->Write(fd_, reinterpret_cast<const char*>(crcs.data()),
+                         crcOffset(beginIndex),
+                         crcs.size() * sizeof(uint32_t));
+    if (rc < 0) {
+        LOG(ERROR) << "Write chunk hash index failed, path: " << path_;
+        invalidate();
+        return;
+    }
+    if (known_ != nullptr) {
+        known_->Set(beginIndex, beginIndex + crcs.size() - 1);
+        if (known_->NextClearBit(0) == Bitmap::NO_POS) {
+            known_ = nullptr;
+        }
+    }
+}
+
+int ChunkHashIndex::writeHeader(const ChunkHashIndexHeader& header) {
+    char buf[kHeaderSize];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    ChunkHashIndexHeader toWrite = header;
+    // the bitmap is too large for the header, only an index with all pages
+    // known can be closed CLEAN then
+    if (!toWrite.encode(buf)) {
+        toWrite.state = kHashIndexDirty;
+        toWrite.known = nullptr;
+        toWrite.encode(buf);
+    }
+    return lfs_->Write(fd_, buf, 0, kHeaderSize);
+}
+
+void ChunkHashIndex::invalidate() {
+    broken_ = true;
+    // never leave a CLEAN header behind the stale crcs
+    if (fd_ >= 0) {
+        lfs_->Close(fd_);
+        fd_ = -1;
+    }
+    lfs_->Delete(path_);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-21
+ * Author: yangyaokai
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_HASHINDEX_H_
+#define SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_HASHINDEX_H_
+
+#include <sys/stat.h>
+#include <butil/iobuf.h>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "src/common/bitmap.h"
+#include "src/fs/local_filesystem.h"
+#include "src/chunkserver/datastore/define.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::fs::LocalFileSystem;
+using curve::common::Bitmap;
+
+/**
+ * Chunk hash index file format
+ * header: 4096 bytes
+ *   magic: 4 bytes
+ *   version: 1 byte
+ *   state: 1 byte, CLEAN or DIRTY
+ *   pageSize: 4 bytes
+ *   pageNum: 4 bytes
+ *   stamp of the chunk file (ino, size, mtime, ctime): 48 bytes
+ *   knownBits: 4 bytes, 0 means all pages are known
+ *   known bitmap: (knownBits + 7) / 8 bytes
+ *   crc: 4 bytes
+ * page crcs: 4 bytes per page, the CRC32C of each data page of the chunk
+ *
+ * The index is only trusted after a restart if it was closed CLEAN and the
+ * chunk file is still the one it was closed with, otherwise all pages are
+ * unknown and will be rebuilt from the data by the next scan.
+ */
+struct ChunkHashIndexHeader {
+    uint8_t version;
+    uint8_t state;
+    uint32_t pageSize;
+    uint32_t pageNum;
+    uint64_t ino;
+    uint64_t size;
+    uint64_t mtimeSec;
+    uint64_t mtimeNsec;
+    uint64_t ctimeSec;
+    uint64_t ctimeNsec;
+    // pages whose crc is known, nullptr means all pages are known
+    std::shared_ptr<Bitmap> known;
+
+    ChunkHashIndexHeader();
+    void SetStamp(const struct stat& chunkStat);
+    bool StampMatch(const struct stat& chunkStat) const;
+
+    // return false if the bitmap can not be held in the header
+    bool encode(char* buf) const;
+    CSErrorCode decode(const char* buf);
+};
+
+/**
+ * Per page CRC32C of a chunk file, maintained on the write path and kept in
+ * a side file, so that the scan can compare the digest of the stored crcs
+ * instead of reading the whole chunk.
+ * The side file is written through the page cache, the header is marked
+ * DIRTY before the first write after open and CLEAN again at close.
+ */
+class ChunkHashIndex {
+ public:
+    static const uint32_t kHeaderSize = 4096;
+
+    ChunkHashIndex(std::shared_ptr<LocalFileSystem> lfs,
+                   const std::string& path,
+                   PageSizeType pageSize,
+                   uint32_t pageNum);
+    virtual ~ChunkHashIndex();
+
+    /**
+     * Open the index file, create it if not exist
+     * @param chunkStat: stat of the chunk file, used to check whether the
+     *                   stored crcs still belong to the chunk
+     * @return: return error code
+     */
+    CSErrorCode Open(const struct stat& chunkStat);
+    /**
+     * Must be called before the chunk data is written, so that a crash
+     * before Close() never leaves a CLEAN index with stale crcs
+     */
+    void MarkDirty();
+    /**
+     * Record the crcs of the pages written, offset and length are page
+     * aligned
+     */
+    void Update(const char* buf, off_t offset, size_t length);
+    void Update(const butil::IOBuf& buf, off_t offset, size_t length);
+    /**
+     * Get the digest of [offset, offset + length) from the stored crcs
+     * @return: false if the crc of some page is unknown
+     */
+    bool GetDigest(off_t offset, size_t length, uint32_t* digest);
+    /**
+     * Compare the crcs computed from the data with the stored ones, and
+     * store the computed crcs
+     * @param crcs: crcs of the pages beginning at offset
+     * @return: the number of known pages whose stored crc is different
+     */
+    uint32_t Verify(off_t offset, const std::vector<uint32_t>& crcs);
+    /**
+     * Persist the index and mark it CLEAN
+     * @param chunkStat: stat of the chunk file after the last write
+     */
+    void Close(const struct stat& chunkStat);
+    /**
+     * Delete the index file, called when the chunk is deleted
+     */
+    CSErrorCode Delete();
+
+    /**
+     * Compute the crc of each page of buf
+     */
+    static void PageCrcs(const char* buf,
+                         size_t length,
+                         PageSizeType pageSize,
+                         std::vector<uint32_t>* crcs);
+    static void PageCrcs(const butil::IOBuf& buf,
+                         size_t length,
+                         PageSizeType pageSize,
+                         std::vector<uint32_t>* crcs);
+    /**
+     * The digest of a range is the CRC32C of its page crcs, it is the same
+     * whether it comes from the index or from the data
+     */
+    static uint32_t Digest(const std::vector<uint32_t>& crcs);
+
+ private:
+    // the following functions must be called with mtx_ held
+    void markDirty();
+    void store(uint32_t beginIndex, const std::vector<uint32_t>& crcs);
+    int writeHeader(const ChunkHashIndexHeader& header);
+    // stop maintaining the index after an io error
+    void invalidate();
+
+    inline uint64_t fileSize() const {
+        return kHeaderSize + static_cast<uint64_t>(pageNum_) * sizeof(uint32_t);
+    }
+
+    inline uint64_t crcOffset(uint32_t pageIndex) const {
+        return kHeaderSize +
+               static_cast<uint64_t>(pageIndex) * sizeof(uint32_t);
+    }
+
+ private:
+    std::shared_ptr<LocalFileSystem> lfs_;
+    std::string path_;
+    PageSizeType pageSize_;
+    uint32_t pageNum_;
+    int fd_;
+    // the header on disk is DIRTY
+    bool dirty_;
+    // the index is no longer maintained because of an io error
+    bool broken_;
+    // pages whose crc is known, nullptr means all pages are known
+    std::shared_ptr<Bitmap> known_;
+    std::mutex mtx_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_HASHINDEX_H_
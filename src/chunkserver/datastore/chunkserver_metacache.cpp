@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-18
+ * Author: yangyaokai
+ */
+
+#include <thread>  // NOLINT
+
+#include "src/chunkserver/datastore/chunkserver_metacache.h"
+
+namespace curve {
+namespace chunkserver {
+
+const int CSMetaCache::kShardNum;
+
+CSMetaCache::CSMetaCache() {
+    ChunkMapPtr empty = std::make_shared<const ChunkMap>();
+    for (int i = 0; i < kShardNum; ++i) {
+        Shard* shard = &shards_[i];
+        shard->readers[0].store(0);
+        shard->readers[1].store(0);
+        shard->epoch.store(0);
+        shard->current = empty;
+        shard->published.store(empty.get());
+    }
+}
+
+CSMetaCache::~CSMetaCache() {}
+
+ChunkMapSnapshot CSMetaCache::GetSnapshot() {
+    std::vector<ChunkMapPtr> maps;
+    maps.reserve(kShardNum);
+    for (int i = 0; i < kShardNum; ++i) {
+        std::lock_guard<std::mutex> lk(shards_[i].mtx);
+        maps.push_back(shards_[i].current);
+    }
+    return ChunkMapSnapshot(std::move(maps));
+}
+
+CSChunkFilePtr CSMetaCache::Set(ChunkID id, CSChunkFilePtr chunkFile) {
+    Shard* shard = GetShard(id);
+    std::lock_guard<std::mutex> lk(shard->mtx);
+    auto iter = shard->current->find(id);
+    if (iter != shard->current->end()) {
+        return iter->second;
+    }
+    std::shared_ptr<ChunkMap> map =
+        std::make_shared<ChunkMap>(*shard->current);
+    map->emplace(id, chunkFile);
+    Publish(shard, map);
+    return chunkFile;
+}
+
+void CSMetaCache::Remove(ChunkID id) {
+    Shard* shard = GetShard(id);
+    std::lock_guard<std::mutex> lk(shard->mtx);
+    if (shard->current->find(id) == shard->current->end()) {
+        return;
+    }
+    std::shared_ptr<ChunkMap> map =
+        std::make_shared<ChunkMap>(*shard->current);
+    map->erase(id);
+    Publish(shard, map);
+}
+
+void CSMetaCache::Clear() {
+    for (int i = 0; i < kShardNum; ++i) {
+        Shard* shard = &shards_[i];
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        if (!shard->current->empty()) {
+            Publish(shard, std::make_shared<const ChunkMap>());
+        }
+    }
+}
+
+void CSMetaCache::Publish(Shard* shard, ChunkMapPtr map) {
+    shard->published.store(map.get());
+    Synchronize(shard);
+    // no reader is using the old map now, release it unless some snapshot
+    // still holds it
+    shard->current = std::move(map);
+}
+
+void CSMetaCache::Synchronize(Shard* shard) {
+    // A reader enters by incrementing readers[epoch & 1] and then loads the
+    // published map. Flip the epoch and drain the old counter twice, so that
+    // every reader that entered before the new map was published, whichever
+    // counter it picked, has left when we return. Readers entering after
+    // the flip load the new map, so the drain always finishes.
+    for (int i = 0; i < 2; ++i) {
+        uint32_t epoch = shard->epoch.fetch_add(1);
+        while (shard->readers[epoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
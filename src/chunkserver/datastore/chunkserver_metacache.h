@@ -0,0 +1,218 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-18
+ * Author: yangyaokai
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METACACHE_H_
+#define SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METACACHE_H_
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "include/curve_compiler_specific.h"
+#include "include/chunkserver/chunkserver_common.h"
+#include "src/chunkserver/datastore/chunkserver_chunkfile.h"
+
+namespace curve {
+namespace chunkserver {
+
+using CSChunkFilePtr = std::shared_ptr<CSChunkFile>;
+using ChunkMap = std::unordered_map<ChunkID, CSChunkFilePtr>;
+using ChunkMapPtr = std::shared_ptr<const ChunkMap>;
+
+/**
+ * A point-in-time view of all chunks in the metacache
+ * It only holds references to the immutable shard maps, so taking a
+ * snapshot does not copy any entry, and later modifications of the cache
+ * are not visible through it. Iterated as a single map.
+ */
+class ChunkMapSnapshot {
+ public:
+    class const_iterator
+        : public std::iterator<std::forward_iterator_tag,
+                               const ChunkMap::value_type> {
+     public:
+        const_iterator() : shards_(nullptr), shard_(0) {}
+
+        const ChunkMap::value_type& operator*() const {
+            return *iter_;
+        }
+        const ChunkMap::value_type* operator->() const {
+            return &(*iter_);
+        }
+
+        const_iterator& operator++() {
+            ++iter_;
+            SkipEmpty();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return shard_ == other.shard_ &&
+                   (shard_ == shards_->size() || iter_ == other.iter_);
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+     private:
+        friend class ChunkMapSnapshot;
+        const_iterator(const std::vector<ChunkMapPtr>* shards, size_t shard)
+            : shards_(shards), shard_(shard) {
+            if (shard_ < shards_->size()) {
+                iter_ = (*shards_)[shard_]->begin();
+                SkipEmpty();
+            }
+        }
+
+        // move to the next non empty shard if current one is exhausted
+        void SkipEmpty() {
+            while (iter_ == (*shards_)[shard_]->end()) {
+                if (++shard_ == shards_->size()) {
+                    return;
+                }
+                iter_ = (*shards_)[shard_]->begin();
+            }
+        }
+
+        const std::vector<ChunkMapPtr>* shards_;
+        size_t shard_;
+        ChunkMap::const_iterator iter_;
+    };
+
+    ChunkMapSnapshot() {}
+    explicit ChunkMapSnapshot(std::vector<ChunkMapPtr> shards)
+        : shards_(std::move(shards)) {}
+    // wrap a plain map, e.g. the map built in ut
+    ChunkMapSnapshot(ChunkMap map)  // NOLINT
+        : shards_(1, std::make_shared<const ChunkMap>(std::move(map))) {}
+
+    const_iterator begin() const {
+        return const_iterator(&shards_, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(&shards_, shards_.size());
+    }
+
+    bool empty() const {
+        return begin() == end();
+    }
+
+    size_t size() const {
+        size_t size = 0;
+        for (auto& shard : shards_) {
+            size += shard->size();
+        }
+        return size;
+    }
+
+ private:
+    std::vector<ChunkMapPtr> shards_;
+};
+
+/**
+ * For the mapping from chunkid to chunkfile
+ * The map is split into shards by chunk id, each shard publishes an
+ * immutable map. Get() only reads the published map and never takes a
+ * lock; writers (create/delete chunk, which are rare compared to reads)
+ * copy the shard, publish the new map and wait until the readers of the
+ * old one leave, like a simple userspace RCU.
+ */
+class CSMetaCache {
+ public:
+    static const int kShardNum = 64;
+
+    CSMetaCache();
+    virtual ~CSMetaCache();
+
+    CSMetaCache(const CSMetaCache&) = delete;
+    CSMetaCache& operator=(const CSMetaCache&) = delete;
+
+    /**
+     * Get a copy-free snapshot of all chunks, used to iterate the map
+     */
+    ChunkMapSnapshot GetSnapshot();
+
+    CSChunkFilePtr Get(ChunkID id) {
+        Shard* shard = GetShard(id);
+        // enter the read side, see Synchronize() for the writer side
+        int index = shard->epoch.load() & 1;
+        shard->readers[index].fetch_add(1);
+        const ChunkMap* map = shard->published.load();
+        CSChunkFilePtr chunkFile;
+        auto iter = map->find(id);
+        if (iter != map->end()) {
+            chunkFile = iter->second;
+        }
+        shard->readers[index].fetch_sub(1);
+        return chunkFile;
+    }
+
+    /**
+     * When two write requests are concurrently created to create a chunk
+     * file, return the first set chunkFile
+     */
+    CSChunkFilePtr Set(ChunkID id, CSChunkFilePtr chunkFile);
+
+    void Remove(ChunkID id);
+
+    void Clear();
+
+ private:
+    struct Shard {
+        char pad0[CURVE_CACHELINE_SIZE];
+        // readers of the published map, indexed by epoch
+        std::atomic<int64_t> readers[2];
+        std::atomic<uint32_t> epoch;
+        std::atomic<const ChunkMap*> published;
+        char pad1[CURVE_CACHELINE_SIZE];
+        // serialize writers, and own the published map
+        std::mutex mtx;
+        ChunkMapPtr current;
+    };
+
+    Shard* GetShard(ChunkID id) {
+        return &shards_[id % kShardNum];
+    }
+
+    // publish the new map of shard, must be called with shard->mtx held
+    void Publish(Shard* shard, ChunkMapPtr map);
+
+    // wait until all readers entered before now leave
+    void Synchronize(Shard* shard);
+
+ private:
+    Shard shards_[kShardNum];
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METACACHE_H_
@@ -113,6 +113,7 @@ CSSnapshot::CSSnapshot(std::shared_ptr<LocalFileSystem> lfs,
       size_(options.chunkSize),
       pageSize_(options.pageSize),
       baseDir_(options.baseDir),
+      needSync_(false),
       lfs_(lfs),
       chunkFilePool_(chunkFilePool),
       metric_(options.metric) {
@@ -217,15 +218,48 @@ CSErrorCode CSSnapshot::Write(const char * buf, off_t offset, size_t length) {
                    << ",snapshot sn: " << metaPage_.sn;
         return CSErrorCode::InternalError;
     }
+    addDirtyPages(offset, length);
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSSnapshot::Clone(int chunkFd, off_t offset, size_t length) {
+    int rc = lfs_->CloneRange(chunkFd, offset + pageSize_,
+                              fd_, offset + pageSize_, length);
+    if (rc < 0) {
+        LOG(WARNING) << "Clone to snapshot failed."
+                     << "ChunkID: " << chunkId_
+                     << ",snapshot sn: " << metaPage_.sn
+                     << ",offset: " << offset
+                     << ",length: " << length
+                     << ",error: " << rc;
+        return CSErrorCode::InternalError;
+    }
+    needSync_ = true;
+    addDirtyPages(offset, length);
+    return CSErrorCode::Success;
+}
+
+void CSSnapshot::addDirtyPages(off_t offset, size_t length) {
     uint32_t pageBeginIndex = offset / pageSize_;
     uint32_t pageEndIndex = (offset + length - 1) / pageSize_;
     for (uint32_t i = pageBeginIndex; i <= pageEndIndex; ++i) {
         dirtyPages_.insert(i);
     }
-    return CSErrorCode::Success;
 }
 
 CSErrorCode CSSnapshot::Flush() {
+    // The shared extents must be persisted before the bitmap says the
+    // pages are in the snapshot
+    if (needSync_) {
+        int rc = lfs_->Fsync(fd_);
+        if (rc < 0) {
+            LOG(ERROR) << "Sync snapshot failed."
+                       << "ChunkID: " << chunkId_
+                       << ",snapshot sn: " << metaPage_.sn;
+            return CSErrorCode::InternalError;
+        }
+        needSync_ = false;
+    }
     SnapshotMetaPage tempMeta = metaPage_;
     for (auto pageIndex : dirtyPages_) {
         tempMeta.bitmap->Set(pageIndex);
@@ -100,6 +100,16 @@ class CSSnapshot {
      * @return: return error code
      */
     CSErrorCode Write(const char * buf, off_t offset, size_t length);
+    /**
+     * Share the data of the chunk file with the snapshot file by reflink
+     * instead of copying it, the data of the chunk file also begins after
+     * one page of metapage. Like Write, the bitmap is updated by Flush
+     * @param chunkFd: file descriptor of the chunk file
+     * @param offset: The offset of the area to be shared
+     * @param length: The length of the area to be shared
+     * @return: return error code
+     */
+    CSErrorCode Clone(int chunkFd, off_t offset, size_t length);
     /**
      * Read the snapshot data, according to the bitmap to determine whether to read the data from the chunk file
      * @param buf: Snapshot data read
@@ -144,6 +154,11 @@ class CSSnapshot {
      * Load metapage into memory
      */
     CSErrorCode loadMetaPage();
+    /**
+     * Record the pages written to the snapshot file, they are set in the
+     * bitmap by Flush
+     */
+    void addDirtyPages(off_t offset, size_t length);
 
     inline string path() {
         return baseDir_ + "/" +
@@ -187,6 +202,9 @@ class CSSnapshot {
     // page index has been written but has not yet been updated to the in
     // the metapage
     std::set<uint32_t> dirtyPages_;
+    // Extents are shared since the last Flush, the file opened with
+    // O_DSYNC does not persist them until fsync
+    bool needSync_;
     // Rely on the local file system to manipulate files
     std::shared_ptr<LocalFileSystem> lfs_;
     // Rely on FilePool to create and delete files
@@ -28,11 +28,14 @@
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/bitmap.h"
+#include "src/common/compact_bitmap.h"
 
 namespace curve {
 namespace chunkserver {
 
 using curve::common::Bitmap;
+using curve::common::CompactBitmap;
+using curve::common::CompactBitmapPtr;
 
 // In zeroed chunk file, the version is 2,
 // otherwise, the version is 1
@@ -96,8 +99,9 @@ struct CSChunkInfo {
     // otherwise it is empty
     std::string location;
     // If it is CloneChunk, it means the state of the current Chunk page,
-    // otherwise it is nullptr
-    std::shared_ptr<Bitmap> bitmap;
+    // otherwise it is nullptr. The bitmap is immutable and shared with the
+    // chunk file, a new one is published when the page state changes
+    CompactBitmapPtr bitmap;
     CSChunkInfo() : chunkId(0)
                   , pageSize(4096)
                   , chunkSize(16 * 4096 * 4096)
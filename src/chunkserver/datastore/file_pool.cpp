@@ -34,13 +34,20 @@
 #include <memory>
 #include <vector>
 
+#include "src/common/aligned_buffer_pool.h"
 #include "src/common/string_util.h"
 #include "src/common/throttle.h"
 #include "src/common/configuration.h"
 #include "src/common/crc32.h"
 #include "src/common/curve_define.h"
 
+#ifndef FALLOC_FL_UNSHARE_RANGE
+#define FALLOC_FL_UNSHARE_RANGE 0x40
+#endif
+
 using curve::common::kFilePoolMaigic;
+using curve::common::AlignedBuffer;
+using curve::common::AlignedBufferPool;
 
 namespace curve {
 namespace chunkserver {
@@ -207,9 +214,6 @@ FilePool::FilePool(std::shared_ptr<LocalFileSystem> fsptr)
     cleanAlived_ = false;
     dirtyChunks_.clear();
     cleanChunks_.clear();
-    char* buffer = new (std::nothrow) (char[poolOpt_.bytesPerWrite]);
-    memset(buffer, 0, poolOpt_.bytesPerWrite);
-    writeBuffer_ = std::unique_ptr<char[]>(buffer);
 }
 
 bool FilePool::Initialize(const FilePoolOptions& cfopt) {
@@ -278,7 +282,10 @@ bool FilePool::CleanChunk(uint64_t chunkid, bool onlyMarked) {
         uint64_t nwrite = 0;
         uint64_t ntotal = chunklen;
         uint32_t bytesPerWrite = poolOpt_.bytesPerWrite;
-        char* buffer = writeBuffer_.get();
+        AlignedBuffer writeBuffer =
+            AlignedBufferPool::GetInstance()->Get(bytesPerWrite);
+        char* buffer = writeBuffer.data();
+        memset(buffer, 0, bytesPerWrite);
 
         while (nwrite < ntotal) {
             nbytes = fsptr_->Write(fd, buffer, nwrite,
@@ -585,6 +592,19 @@ int FilePool::RecycleFile(const std::string& chunkpath) {
             return fsptr_->Delete(chunkpath.c_str());
         }
 
+        // A file with shared extents never goes back to the pool, or the
+        // next user of it pays for the copy on write and may hit ENOSPC
+        if (poolOpt_.unshareOnRecycle) {
+            ret = fsptr_->Fallocate(fd, FALLOC_FL_UNSHARE_RANGE, 0, chunklen);
+            if (ret != 0) {
+                LOG(ERROR) << "Unshare file " << chunkpath.c_str()
+                           << " failed, ret = " << ret
+                           << ", delete file dirctly";
+                fsptr_->Close(fd);
+                return fsptr_->Delete(chunkpath.c_str());
+            }
+        }
+
         fsptr_->Close(fd);
 
         uint64_t newfilenum = 0;
@@ -63,6 +63,10 @@ struct FilePoolOptions {
     uint32_t    metaFileSize;
     // retry times for get file
     uint16_t    retryTimes;
+    // Unshare the extents of a file before recycling it, the files may
+    // share extents with others by reflink, a shared extent is copied on
+    // the next write and loses the preallocation of the pool
+    bool        unshareOnRecycle;
 
     FilePoolOptions() {
         getFileFromPool = true;
@@ -73,6 +77,7 @@ struct FilePoolOptions {
         fileSize = 0;
         metaPageSize = 0;
         retryTimes = 5;
+        unshareOnRecycle = false;
         ::memset(metaPath, 0, 256);
         ::memset(filePoolDir, 0, 256);
     }
@@ -86,6 +91,7 @@ struct FilePoolOptions {
         fileSize = other.fileSize;
         retryTimes = other.retryTimes;
         metaPageSize = other.metaPageSize;
+        unshareOnRecycle = other.unshareOnRecycle;
         ::memcpy(metaPath, other.metaPath, 256);
         ::memcpy(filePoolDir, other.filePoolDir, 256);
         return *this;
@@ -100,6 +106,7 @@ struct FilePoolOptions {
         fileSize = other.fileSize;
         retryTimes = other.retryTimes;
         metaPageSize = other.metaPageSize;
+        unshareOnRecycle = other.unshareOnRecycle;
         ::memcpy(metaPath, other.metaPath, 256);
         ::memcpy(filePoolDir, other.filePoolDir, 256);
     }
@@ -328,9 +335,6 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
 
     // Sleeper for cleaning chunk thread
     InterruptibleSleeper cleanSleeper_;
-
-    // The buffer for write chunk file
-    std::unique_ptr<char[]> writeBuffer_;
 };
 }   // namespace chunkserver
 }   // namespace curve
@@ -61,6 +61,12 @@ class FileNameOperator {
                 + "_snap_" + std::to_string(sn);
     }
 
+    // The format of the hash index file name is chunk_id_hash, it is parsed
+    // as UNKNOWN, so it is never taken as a chunk file
+    static inline string GenerateHashIndexName(ChunkID id) {
+        return GenerateChunkFileName(id) + "_hash";
+    }
+
     static inline FileInfo ParseFileName(const string& fileName) {
         vector<string> elements;
         ::curve::common::SplitString(fileName, "_", &elements);
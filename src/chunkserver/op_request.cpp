@@ -242,7 +242,24 @@ void ReadChunkRequest::Process() {
     brpc::ClosureGuard doneGuard(done_);
 
     if (!node_->IsLeaderTerm()) {
-        RedirectChunkRequest();
+        /**
+         * follower read：follower上的applied index不小于client携带的
+         * applied index时，client之前写入的数据在follower上都已经apply，
+         * 可以直接读，否则还是重定向到leader
+         */
+        if (!IsFollowerReadable()) {
+            RedirectChunkRequest();
+            return;
+        }
+
+        auto thisPtr
+            = std::dynamic_pointer_cast<ReadChunkRequest>(shared_from_this());
+        auto task = std::bind(&ReadChunkRequest::OnApply,
+                              thisPtr,
+                              node_->GetAppliedIndex(),
+                              doneGuard.release());
+        concurrentApplyModule_->Push(
+            request_->chunkid(), request_->optype(), task);
         return;
     }
 
@@ -327,6 +344,12 @@ void ReadChunkRequest::OnApply(uint64_t index,
         }
         // 如果需要从源端拷贝数据，需要将请求转发给clone manager处理
         if ( needLazyClone || NeedClone(chunkInfo) ) {
+            // 拷贝的数据需要通过leader写入，follower read直接重定向到leader
+            if (!node_->IsLeaderTerm()) {
+                response_->set_status(
+                    CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED);
+                break;
+            }
             applyIndex = index;
             std::shared_ptr<CloneTask> cloneTask =
             cloneMgr_->GenerateCloneTask(
@@ -373,6 +396,14 @@ void ReadChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
     // read什么都不用做
 }
 
+bool ReadChunkRequest::IsFollowerReadable() const {
+    return request_->followerread()
+        && request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_READ
+        && request_->has_appliedindex()
+        && request_->appliedindex() > 0
+        && node_->GetAppliedIndex() >= request_->appliedindex();
+}
+
 bool ReadChunkRequest::NeedClone(const CSChunkInfo& chunkInfo) {
     // 如果不是 clone chunk，就不需要拷贝
     if (chunkInfo.isClone) {
@@ -448,6 +479,30 @@ void WriteChunkRequest::OnApply(uint64_t index,
                             request_->clonefileoffset());
     }
 
+    if (datastore_->AsyncWriteEnabled()) {
+        /**
+         * 异步apply：提交写IO后apply线程即可处理下一个op，
+         * 由IO完成回调设置response并返回给client，
+         * 同一个chunk上后续的op会等待与其重叠的写完成，不影响一致性
+         */
+        auto thisPtr =
+            std::dynamic_pointer_cast<WriteChunkRequest>(shared_from_this());
+        ::google::protobuf::Closure *asyncDone = doneGuard.release();
+        auto cb = [thisPtr, index, asyncDone](CSErrorCode ret) {
+            brpc::ClosureGuard doneGuard(asyncDone);
+            thisPtr->HandleWriteResult(index, ret);
+        };
+        datastore_->WriteChunkAsync(request_->chunkid(),
+                                    request_->sn(),
+                                    cntl_->request_attachment(),
+                                    request_->offset(),
+                                    request_->size(),
+                                    nullptr,
+                                    cb,
+                                    cloneSourceLocation);
+        return;
+    }
+
     auto ret = datastore_->WriteChunk(request_->chunkid(),
                                       request_->sn(),
                                       cntl_->request_attachment(),
@@ -455,7 +510,10 @@ void WriteChunkRequest::OnApply(uint64_t index,
                                       request_->size(),
                                       &cost,
                                       cloneSourceLocation);
+    HandleWriteResult(index, ret);
+}
 
+void WriteChunkRequest::HandleWriteResult(uint64_t index, CSErrorCode ret) {
     if (CSErrorCode::Success == ret) {
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
         node_->UpdateAppliedIndex(index);
@@ -511,6 +569,23 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                             request.clonefileoffset());
     }
 
+    if (datastore->AsyncWriteEnabled()) {
+        // request在apply线程返回后就会释放，回调中需要持有一份拷贝
+        std::shared_ptr<ChunkRequest> req =
+            std::make_shared<ChunkRequest>(request);
+        auto cb = [req](CSErrorCode ret) {
+            HandleWriteResultFromLog(*req, ret);
+        };
+        datastore->WriteChunkAsync(request.chunkid(),
+                                   request.sn(),
+                                   data,
+                                   request.offset(),
+                                   request.size(),
+                                   nullptr,
+                                   cb,
+                                   cloneSourceLocation);
+        return;
+    }
 
     auto ret = datastore->WriteChunk(request.chunkid(),
                                      request.sn(),
@@ -519,6 +594,11 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                                      request.size(),
                                      &cost,
                                      cloneSourceLocation);
+    HandleWriteResultFromLog(request, ret);
+}
+
+void WriteChunkRequest::HandleWriteResultFromLog(const ChunkRequest &request,
+                                                 CSErrorCode ret) {
      if (CSErrorCode::Success == ret) {
          return;
      } else if (CSErrorCode::BackwardRequestError == ret) {
@@ -866,32 +946,53 @@ void PasteChunkInternalRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> data
     }
 }
 
-void ScanChunkRequest::OnApply(uint64_t index,
-                               ::google::protobuf::Closure *done) {
-    brpc::ClosureGuard doneGuard(done);
+CSErrorCode ScanChunkRequest::ScanChunk(
+    std::shared_ptr<CSDataStore> datastore,
+    const ChunkRequest &request,
+    uint32_t *crc) {
+    bool readMetaPage = request.has_readmetapage() && request.readmetapage();
+    if (!readMetaPage && request.has_digestscan() && request.digestscan()) {
+        bool verify = request.has_verifydata() && request.verifydata();
+        return datastore->GetChunkDigest(request.chunkid(),
+                                         request.offset(),
+                                         request.size(),
+                                         verify,
+                                         crc);
+    }
 
-    // read and calculate crc, build scanmap
-    uint32_t crc = 0;
-    size_t size = request_->size();
+    size_t size = request.size();
     std::unique_ptr<char[]> readBuffer(new(std::nothrow)char[size]);
     CHECK(nullptr != readBuffer)
         << "new readBuffer failed " << strerror(errno);
     // scan chunk metapage or user data
-    auto ret = 0;
-    if (request_->has_readmetapage() && request_->readmetapage()) {
-        ret = datastore_->ReadChunkMetaPage(request_->chunkid(),
-                                            request_->sn(),
-                                            readBuffer.get());
+    CSErrorCode ret;
+    if (readMetaPage) {
+        ret = datastore->ReadChunkMetaPage(request.chunkid(),
+                                           request.sn(),
+                                           readBuffer.get());
     } else {
-        ret = datastore_->ReadChunk(request_->chunkid(),
-                                    request_->sn(),
-                                    readBuffer.get(),
-                                    request_->offset(),
-                                    size);
+        ret = datastore->ReadChunk(request.chunkid(),
+                                   request.sn(),
+                                   readBuffer.get(),
+                                   request.offset(),
+                                   size);
     }
+    if (CSErrorCode::Success == ret) {
+        *crc = ::curve::common::CRC32(readBuffer.get(), size);
+    }
+    return ret;
+}
+
+void ScanChunkRequest::OnApply(uint64_t index,
+                               ::google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    // read and calculate crc, build scanmap
+    uint32_t crc = 0;
+    size_t size = request_->size();
+    auto ret = ScanChunk(datastore_, *request_, &crc);
 
     if (CSErrorCode::Success == ret) {
-        crc = ::curve::common::CRC32(readBuffer.get(), size);
         // build scanmap
         ScanMap scanMap;
         scanMap.set_logicalpoolid(request_->logicpoolid());
@@ -928,26 +1029,9 @@ void ScanChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,  /
                                                const butil::IOBuf &data) {
     uint32_t crc = 0;
     size_t size = request.size();
-    std::unique_ptr<char[]> readBuffer(new(std::nothrow)char[size]);
-    CHECK(nullptr != readBuffer)
-        << "new readBuffer failed " << strerror(errno);
-
-    // scan chunk metapage or user data
-    auto ret = 0;
-    if (request.has_readmetapage() && request.readmetapage()) {
-        ret = datastore->ReadChunkMetaPage(request.chunkid(),
-                                            request.sn(),
-                                            readBuffer.get());
-    } else {
-        ret = datastore->ReadChunk(request.chunkid(),
-                                    request.sn(),
-                                    readBuffer.get(),
-                                    request.offset(),
-                                    size);
-    }
+    auto ret = ScanChunk(datastore, request, &crc);
 
     if (CSErrorCode::Success == ret) {
-        crc = ::curve::common::CRC32(readBuffer.get(), size);
         BuildAndSendScanMap(request, index_, crc);
     } else if (CSErrorCode::ChunkNotExistError == ret) {
         LOG(ERROR) << "scan failed: chunk not exist, "
@@ -232,6 +232,8 @@ class ReadChunkRequest : public ChunkOpRequest {
  private:
     // 根据chunk信息判断是否需要拷贝数据
     bool NeedClone(const CSChunkInfo& chunkInfo);
+    // 非leader时判断是否可以直接在本节点读
+    bool IsFollowerReadable() const;
     // 从chunk文件中读数据
     void ReadChunk();
 
@@ -263,6 +265,17 @@ class WriteChunkRequest : public ChunkOpRequest {
     void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                         const ChunkRequest &request,
                         const butil::IOBuf &data) override;
+
+ private:
+    /**
+     * 根据datastore的返回值设置response
+     * @param index: 此op对应的log index
+     * @param ret: datastore写入的返回值
+     */
+    void HandleWriteResult(uint64_t index, CSErrorCode ret);
+
+    static void HandleWriteResultFromLog(const ChunkRequest &request,
+                                         CSErrorCode ret);
 };
 
 class ReadSnapshotRequest : public ChunkOpRequest {
@@ -386,6 +399,13 @@ class ScanChunkRequest : public ChunkOpRequest {
  private:
     void BuildAndSendScanMap(const ChunkRequest &request, uint64_t index,
                              uint32_t crc);
+    /**
+     * 计算scan范围的crc，metapage和旧请求使用数据的crc，
+     * digestScan请求使用chunk hash index中page crc的摘要
+     */
+    CSErrorCode ScanChunk(std::shared_ptr<CSDataStore> datastore,
+                          const ChunkRequest &request,
+                          uint32_t *crc);
     ScanManager* scanManager_;
     uint64_t index_;
     PeerId peer_;
@@ -88,6 +88,26 @@ uint32_t GetDatastoreCloneChunkCountFunc(void* arg) {
     return cloneChunkCount;
 }
 
+uint32_t GetDatastoreHashIndexHitFunc(void* arg) {
+    CSDataStore* dataStore = reinterpret_cast<CSDataStore*>(arg);
+    uint32_t hashIndexHit = 0;
+    if (dataStore != nullptr) {
+        DataStoreStatus status = dataStore->GetStatus();
+        hashIndexHit = status.hashIndexHit;
+    }
+    return hashIndexHit;
+}
+
+uint32_t GetDatastoreHashIndexMismatchFunc(void* arg) {
+    CSDataStore* dataStore = reinterpret_cast<CSDataStore*>(arg);
+    uint32_t hashIndexMismatch = 0;
+    if (dataStore != nullptr) {
+        DataStoreStatus status = dataStore->GetStatus();
+        hashIndexMismatch = status.hashIndexMismatch;
+    }
+    return hashIndexMismatch;
+}
+
 uint32_t GetChunkTrashedFunc(void* arg) {
     Trash* trash = reinterpret_cast<Trash*>(arg);
     uint32_t chunkTrashed = 0;
@@ -51,6 +51,16 @@ namespace chunkserver {
      * @param arg: datastore的对象指针
      */
     uint32_t GetDatastoreCloneChunkCountFunc(void* arg);
+    /**
+     * 获取datastore中scan从chunk hash index得到摘要的次数
+     * @param arg: datastore的对象指针
+     */
+    uint32_t GetDatastoreHashIndexHitFunc(void* arg);
+    /**
+     * 获取datastore中chunk hash index与数据不一致的page数量
+     * @param arg: datastore的对象指针
+     */
+    uint32_t GetDatastoreHashIndexMismatchFunc(void* arg);
     /**
      * 获取chunkserver上chunk文件的数量
      * @param arg: nullptr
@@ -39,12 +39,16 @@
 //          Xiong,Kai(xiongkai@baidu.com)
 
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <bvar/bvar.h>
 #include <butil/fd_utility.h>
 #include <butil/raw_pack.h>
 #include <braft/local_storage.pb.h>
 #include <braft/fsync.h>
 #include "src/chunkserver/raftlog/curve_segment.h"
 #include "src/chunkserver/raftlog/define.h"
+#include "src/common/aligned_buffer_pool.h"
 
 namespace curve {
 namespace chunkserver {
@@ -52,6 +56,36 @@ namespace chunkserver {
 DEFINE_bool(raftSyncSegments, true, "call fsync when a segment is closed");
 DEFINE_bool(enableWalDirectWrite, true, "enable wal direct write or not");
 DEFINE_uint32(walAlignSize, 4096, "wal align size to write");
+DEFINE_bool(walZeroCopyAppend, false, "write the page aligned blocks of "
+            "entry data to wal directly without copying them, segments "
+            "written with it can't be loaded by older versions");
+
+// entries whose aligned data blocks are written without copy and
+// the bytes of them, and the bytes copied into the write buffer
+static bvar::Adder<uint64_t> g_wal_zero_copy_entries(
+    "curve_wal_zero_copy_entries");
+static bvar::Adder<uint64_t> g_wal_zero_copy_bytes(
+    "curve_wal_zero_copy_bytes");
+static bvar::Adder<uint64_t> g_wal_copy_bytes("curve_wal_copy_bytes");
+
+// Length of the data before its tail of page aligned blocks, the blocks
+// in [*first_block, backing_block_num()) are aligned in both address and
+// length, returns data.length() if the last block is not aligned
+static size_t aligned_tail_pos(const butil::IOBuf& data, size_t align,
+                               size_t* first_block) {
+    size_t pos = data.length();
+    size_t i = data.backing_block_num();
+    for (; i > 0; --i) {
+        butil::StringPiece block = data.backing_block(i - 1);
+        if (reinterpret_cast<uintptr_t>(block.data()) % align != 0
+            || block.size() % align != 0) {
+            break;
+        }
+        pos -= block.size();
+    }
+    *first_block = i;
+    return pos;
+}
 
 int CurveSegment::create() {
     if (!_is_open) {
@@ -101,6 +135,7 @@ struct CurveSegment::EntryHeader {
     int64_t term;
     int type;
     int checksum_type;
+    uint32_t data_gap;
     uint32_t data_len;
     uint32_t data_real_len;
     uint32_t data_checksum;
@@ -110,6 +145,7 @@ std::ostream& operator<<(std::ostream& os,
                          const CurveSegment::EntryHeader& h) {
     os << "{term=" << h.term << ", type=" << h.type << ", data_len="
        << h.data_len << ", data_real_len=" << h.data_real_len
+       << ", data_gap=" << h.data_gap
        << ", checksum_type=" << h.checksum_type << ", data_checksum="
        << h.data_checksum << '}';
     return os;
@@ -330,6 +366,7 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
     tmp.term = term;
     tmp.type = meta_field >> 24;
     tmp.checksum_type = (meta_field << 8) >> 24;
+    tmp.data_gap = meta_field & kMaxEntryDataGap;
     tmp.data_len = data_len;
     tmp.data_real_len = data_real_len;
     tmp.data_checksum = data_checksum;
@@ -343,22 +380,22 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
         *head = tmp;
     }
     if (data != NULL) {
-        if (buf.length() < kEntryHeaderSize + data_real_len) {
-            const size_t to_read = kEntryHeaderSize + data_real_len
-                                                    - buf.length();
+        const size_t data_off = kEntryHeaderSize + tmp.data_gap;
+        if (buf.length() < data_off + data_real_len) {
+            const size_t to_read = data_off + data_real_len - buf.length();
             const ssize_t n = braft::file_pread(&buf, _fd,
                                     offset + buf.length(), to_read);
             if (n != (ssize_t)to_read) {
                 return n < 0 ? -1 : 1;
             }
-        } else if (buf.length() > kEntryHeaderSize + data_real_len) {
-            buf.pop_back(buf.length() - kEntryHeaderSize - data_real_len);
+        } else if (buf.length() > data_off + data_real_len) {
+            buf.pop_back(buf.length() - data_off - data_real_len);
         }
-        CHECK_EQ(buf.length(), kEntryHeaderSize + data_real_len);
-        buf.pop_front(kEntryHeaderSize);
+        CHECK_EQ(buf.length(), data_off + data_real_len);
+        buf.pop_front(data_off);
         if (!verify_checksum(tmp.checksum_type, buf, tmp.data_checksum)) {
             LOG(ERROR) << "Found corrupted data at offset="
-                       << offset + kEntryHeaderSize
+                       << offset + data_off
                        << " header=" << tmp
                        << " path: " << _path;
             return -1;
@@ -368,26 +405,17 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
     return 0;
 }
 
-int CurveSegment::append(const braft::LogEntry* entry) {
-    if (BAIDU_UNLIKELY(!entry || !_is_open)) {
-        return EINVAL;
-    } else if (entry->id.index !=
-                    _last_index.load(butil::memory_order_consume) + 1) {
-        CHECK(false) << "entry->index=" << entry->id.index
-                  << " _last_index=" << _last_index
-                  << " _first_index=" << _first_index;
-        return ERANGE;
-    }
-    butil::IOBuf data;
+int CurveSegment::_serialize_entry(const braft::LogEntry* entry,
+                                   butil::IOBuf* data) {
     switch (entry->type) {
     case braft::ENTRY_TYPE_DATA:
-        data.append(entry->data);
+        data->append(entry->data);
         break;
     case braft::ENTRY_TYPE_NO_OP:
         break;
     case braft::ENTRY_TYPE_CONFIGURATION:
         {
-            butil::Status status = serialize_configuration_meta(entry, data);
+            butil::Status status = serialize_configuration_meta(entry, *data);
             if (!status.ok()) {
                 LOG(ERROR) << "Fail to serialize ConfigurationPBMeta, path: "
                            << _path;
@@ -400,80 +428,217 @@ int CurveSegment::append(const braft::LogEntry* entry) {
                    << ", path: " << _path;
         return -1;
     }
-    uint32_t data_check_sum = get_checksum(_checksum_type, data);
-    uint32_t real_length = data.length();
-    size_t to_write = kEntryHeaderSize + data.length();
-    uint32_t zero_bytes_num = 0;
-    // 4KB alignment
-    if (to_write % FLAGS_walAlignSize != 0) {
-        zero_bytes_num = (to_write / FLAGS_walAlignSize + 1) *
-                                        FLAGS_walAlignSize - to_write;
-    }
-    data.resize(data.length() + zero_bytes_num);
-    to_write = kEntryHeaderSize + data.length();
-    CHECK_LE(data.length(), 1ul << 56ul);
-    char* write_buf = nullptr;
-    if (FLAGS_enableWalDirectWrite) {
-        int ret = posix_memalign(reinterpret_cast<void **>(&write_buf),
-                                 FLAGS_walAlignSize, to_write);
-        LOG_IF(FATAL, ret < 0 || write_buf == nullptr)
-        << "posix_memalign WAL write buffer failed " << strerror(ret);
-    } else {
-        write_buf = new char[kEntryHeaderSize];
-    }
+    return 0;
+}
 
-    const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16);
-    butil::RawPacker packer(write_buf);
+void CurveSegment::_pack_header(const braft::LogEntry* entry,
+                                uint32_t data_len, uint32_t real_length,
+                                uint32_t data_checksum, uint32_t data_gap,
+                                char* buf) {
+    CHECK_LE(data_gap, kMaxEntryDataGap);
+    const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16)
+                              | data_gap;
+    butil::RawPacker packer(buf);
     packer.pack64(entry->id.term)
           .pack32(meta_field)
-          .pack32((uint32_t)data.length())
+          .pack32(data_len)
           .pack32(real_length)
-          .pack32(data_check_sum);
-    packer.pack32(get_checksum(
-                  _checksum_type, write_buf, kEntryHeaderSize - 4));
-    if (FLAGS_enableWalDirectWrite) {
-        data.copy_to(write_buf + kEntryHeaderSize, real_length);
-        int ret = ::pwrite(_direct_fd, write_buf, to_write, _meta.bytes);
-        free(write_buf);
-        if (ret != to_write) {
-            LOG(ERROR) << "Fail to write directly to fd=" << _direct_fd;
+          .pack32(data_checksum);
+    packer.pack32(get_checksum(_checksum_type, buf, kEntryHeaderSize - 4));
+}
+
+int CurveSegment::append(const braft::LogEntry* entry) {
+    if (BAIDU_UNLIKELY(!entry)) {
+        return EINVAL;
+    }
+    return append_batch(&entry, 1);
+}
+
+int CurveSegment::append_batch(const braft::LogEntry* const* entries,
+                               size_t count) {
+    if (BAIDU_UNLIKELY(!entries || count == 0 || !_is_open)) {
+        return EINVAL;
+    }
+    const int64_t last_index = _last_index.load(butil::memory_order_consume);
+    for (size_t i = 0; i < count; ++i) {
+        if (BAIDU_UNLIKELY(!entries[i])) {
+            return EINVAL;
+        } else if (entries[i]->id.index != last_index + 1 + (int64_t)i) {
+            CHECK(false) << "entry->index=" << entries[i]->id.index
+                      << " _last_index=" << _last_index
+                      << " _first_index=" << _first_index;
+            return ERANGE;
+        }
+    }
+
+    // Zero copy append: when the data of an entry ends with page aligned
+    // blocks, e.g. the data of a chunk request received into aligned
+    // memory, zero bytes are put between the header and the data so that
+    // these blocks land at aligned offsets and are written by pwritev
+    // directly, only the header and the data before them are copied
+    const bool zero_copy = FLAGS_enableWalDirectWrite
+                        && FLAGS_walZeroCopyAppend
+                        && FLAGS_walAlignSize <= kMaxEntryDataGap + 1;
+    std::vector<butil::IOBuf> datas(count);
+    // length of data copied to the write buffer, and the first aligned
+    // block written without copy, tail_pos[i] == length means no such block
+    std::vector<size_t> tail_pos(count);
+    std::vector<size_t> tail_block(count);
+    std::vector<uint32_t> gaps(count, 0);
+    size_t to_write = 0;
+    size_t zero_copy_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (_serialize_entry(entries[i], &datas[i]) != 0) {
             return -1;
         }
+        CHECK_LE(datas[i].length(), 1ul << 56ul);
+        tail_pos[i] = datas[i].length();
+        if (zero_copy) {
+            tail_pos[i] = aligned_tail_pos(datas[i], FLAGS_walAlignSize,
+                                           &tail_block[i]);
+            const uint64_t tail_off = _meta.bytes + to_write
+                                    + kEntryHeaderSize + tail_pos[i];
+            if (tail_pos[i] < datas[i].length()
+                && tail_off % FLAGS_walAlignSize != 0) {
+                gaps[i] = FLAGS_walAlignSize
+                        - tail_off % FLAGS_walAlignSize;
+            }
+            zero_copy_bytes += datas[i].length() - tail_pos[i];
+        }
+        to_write += kEntryHeaderSize + gaps[i] + datas[i].length();
+    }
+    // 4KB alignment, the padding of the whole batch is appended to the
+    // last entry and counted in its data_len, so load() can still skip
+    // from one entry to the next by header size plus data_len
+    uint32_t zero_bytes_num = 0;
+    const uint64_t end = _meta.bytes + to_write;
+    if (end % FLAGS_walAlignSize != 0) {
+        zero_bytes_num = (end / FLAGS_walAlignSize + 1) *
+                                        FLAGS_walAlignSize - end;
+    }
+
+    std::vector<off_t> offsets(count);
+    off_t offset = _meta.bytes;
+    if (FLAGS_enableWalDirectWrite) {
+        // the segment may end in the middle of a batch after truncate,
+        // read back the partial block to start the write at aligned offset
+        const size_t head_len = _meta.bytes % FLAGS_walAlignSize;
+        const off_t write_offset = _meta.bytes - head_len;
+        const size_t buf_len = head_len + to_write + zero_bytes_num;
+        // the aligned blocks are not copied, they split the buffer into
+        // pieces which all start and end at aligned offsets
+        curve::common::AlignedBuffer buffer =
+            curve::common::AlignedBufferPool::GetInstance()->Get(
+                buf_len - zero_copy_bytes, FLAGS_walAlignSize);
+        char* write_buf = buffer.data();
+        if (head_len > 0) {
+            ssize_t n = ::pread(_direct_fd, write_buf,
+                                FLAGS_walAlignSize, write_offset);
+            if (n < (ssize_t)head_len) {
+                LOG(ERROR) << "Fail to read partial block from fd="
+                           << _direct_fd << ", path: " << _path << berror();
+                return -1;
+            }
+        }
+        std::vector<struct iovec> iov;
+        char* piece = write_buf;
+        char* pos = write_buf + head_len;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t real_length = datas[i].length();
+            uint32_t data_len = gaps[i] + real_length +
+                                (i == count - 1 ? zero_bytes_num : 0);
+            _pack_header(entries[i], data_len, real_length,
+                         get_checksum(_checksum_type, datas[i]), gaps[i],
+                         pos);
+            pos += kEntryHeaderSize;
+            memset(pos, 0, gaps[i]);
+            pos += gaps[i];
+            datas[i].copy_to(pos, tail_pos[i]);
+            pos += tail_pos[i];
+            if (tail_pos[i] < real_length) {
+                iov.push_back({piece, static_cast<size_t>(pos - piece)});
+                for (size_t j = tail_block[i];
+                     j < datas[i].backing_block_num(); ++j) {
+                    butil::StringPiece block = datas[i].backing_block(j);
+                    iov.push_back({const_cast<char*>(block.data()),
+                                   block.size()});
+                }
+                piece = pos;
+                g_wal_zero_copy_entries << 1;
+                g_wal_zero_copy_bytes << real_length - tail_pos[i];
+            }
+            g_wal_copy_bytes << tail_pos[i];
+            offsets[i] = offset;
+            offset += kEntryHeaderSize + data_len;
+        }
+        memset(pos, 0, zero_bytes_num);
+        pos += zero_bytes_num;
+        if (pos > piece) {
+            iov.push_back({piece, static_cast<size_t>(pos - piece)});
+        }
+        to_write += zero_bytes_num;
+        off_t iov_offset = write_offset;
+        for (size_t i = 0; i < iov.size(); i += IOV_MAX) {
+            const int iov_count = std::min(iov.size() - i, (size_t)IOV_MAX);
+            size_t len = 0;
+            for (int j = 0; j < iov_count; ++j) {
+                len += iov[i + j].iov_len;
+            }
+            ssize_t n = ::pwritev(_direct_fd, &iov[i], iov_count,
+                                  iov_offset);
+            if (n != (ssize_t)len) {
+                LOG(ERROR) << "Fail to write directly to fd=" << _direct_fd
+                           << ", path: " << _path << berror();
+                return -1;
+            }
+            iov_offset += len;
+        }
     } else {
-        butil::IOBuf header;
-        header.append(write_buf, kEntryHeaderSize);
-        delete write_buf;
-        butil::IOBuf* pieces[2] = { &header, &data };
-        size_t start = 0;
+        butil::IOBuf batch;
+        char header_buf[kEntryHeaderSize];
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t real_length = datas[i].length();
+            uint32_t data_len = real_length +
+                                (i == count - 1 ? zero_bytes_num : 0);
+            _pack_header(entries[i], data_len, real_length,
+                         get_checksum(_checksum_type, datas[i]), 0,
+                         header_buf);
+            batch.append(header_buf, kEntryHeaderSize);
+            batch.append(datas[i]);
+            offsets[i] = offset;
+            offset += kEntryHeaderSize + data_len;
+        }
+        batch.resize(batch.length() + zero_bytes_num);
+        to_write += zero_bytes_num;
         ssize_t written = 0;
         while (written < (ssize_t)to_write) {
-            const ssize_t n = butil::IOBuf::cut_multiple_into_file_descriptor(
-                    _fd, pieces + start, ARRAY_SIZE(pieces) - start);
+            const ssize_t n = batch.cut_into_file_descriptor(_fd);
             if (n < 0) {
                 LOG(ERROR) << "Fail to write to fd=" << _fd
                            << ", path: " << _path << berror();
                 return -1;
             }
             written += n;
-            for (; start < ARRAY_SIZE(pieces) && pieces[start]->empty();
-                    ++start) {}
         }
     }
     {
         BAIDU_SCOPED_LOCK(_mutex);
-        _offset_and_term.push_back(std::make_pair(_meta.bytes, entry->id.term));
-        _last_index.fetch_add(1, butil::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            _offset_and_term.push_back(
+                std::make_pair(offsets[i], entries[i]->id.term));
+        }
+        _last_index.fetch_add(count, butil::memory_order_relaxed);
         _meta.bytes += to_write;
     }
     return _update_meta_page();
 }
 
 int CurveSegment::_update_meta_page() {
-    char* metaPage = nullptr;
-    int ret = posix_memalign(reinterpret_cast<void **>(&metaPage),
-                            FLAGS_walAlignSize, _meta_page_size);
-    LOG_IF(FATAL, ret < 0 || metaPage == nullptr)
-        << "posix_memalign WAL meta page failed " << strerror(ret);
+    curve::common::AlignedBuffer buffer =
+        curve::common::AlignedBufferPool::GetInstance()->Get(
+            _meta_page_size, FLAGS_walAlignSize);
+    char* metaPage = buffer.data();
+    int ret;
     memset(metaPage, 0, _meta_page_size);
     memcpy(metaPage, &_meta.bytes, sizeof(_meta.bytes));
     if (FLAGS_enableWalDirectWrite) {
@@ -481,7 +646,6 @@ int CurveSegment::_update_meta_page() {
     } else {
         ret = ::pwrite(_fd, metaPage, _meta_page_size, 0);
     }
-    free(metaPage);
     if (ret != _meta_page_size) {
         LOG(ERROR) << "Fail to write meta page into fd="
                    << (FLAGS_enableWalDirectWrite ? _direct_fd : _fd)
@@ -60,6 +60,8 @@ namespace curve {
 namespace chunkserver {
 
 DECLARE_bool(enableWalDirectWrite);
+DECLARE_uint32(walAlignSize);
+DECLARE_bool(walZeroCopyAppend);
 
 struct CurveSegmentMeta {
     CurveSegmentMeta() : bytes(0) {}
@@ -111,6 +113,12 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     // serialize entry, and append to open segment
     int append(const braft::LogEntry* entry) override;
 
+    // serialize entries and append them to open segment with one write,
+    // padding is applied to the whole batch rather than every entry, the
+    // batch is either fully appended or not appended at all
+    int append_batch(const braft::LogEntry* const* entries,
+                     size_t count) override;
+
     // get entry by index
     braft::LogEntry* get(const int64_t index) const override;
 
@@ -160,6 +168,12 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
 
     int _load_meta();
 
+    int _serialize_entry(const braft::LogEntry* entry, butil::IOBuf* data);
+
+    void _pack_header(const braft::LogEntry* entry, uint32_t data_len,
+                      uint32_t real_length, uint32_t data_checksum,
+                      uint32_t data_gap, char* buf);
+
     int _update_meta_page();
 
     std::string _path;
@@ -47,6 +47,25 @@
 namespace curve {
 namespace chunkserver {
 
+DEFINE_uint64(walBatchMaxBytes, 1048576,
+              "max bytes of entries packed into one wal write, "
+              "0 means every entry is written and padded alone");
+
+static inline uint64_t align_to_wal(uint64_t size) {
+    return (size + FLAGS_walAlignSize - 1) / FLAGS_walAlignSize
+            * FLAGS_walAlignSize;
+}
+
+// max bytes an entry takes in the segment before padding, zero copy append
+// may put less than one aligned block between the header and the data
+static inline uint64_t entry_size(const braft::LogEntry* entry) {
+    uint64_t size = entry->data.size() + kEntryHeaderSize;
+    if (FLAGS_enableWalDirectWrite && FLAGS_walZeroCopyAppend) {
+        size += FLAGS_walAlignSize - 1;
+    }
+    return size;
+}
+
 LogStorageOptions StoreOptForCurveSegmentLogStorage(
     LogStorageOptions options) {
     static LogStorageOptions options_;
@@ -405,7 +424,7 @@ int64_t CurveSegmentLogStorage::get_term(const int64_t index) {
 
 int CurveSegmentLogStorage::append_entry(const braft::LogEntry* entry) {
     scoped_refptr<Segment> segment =
-                open_segment(entry->data.size() + kEntryHeaderSize);
+                open_segment(entry_size(entry));
     if (NULL == segment) {
         return EIO;
     }
@@ -432,24 +451,47 @@ int CurveSegmentLogStorage::append_entries(
                    << " _last_log_index path: " << _path;
         return -1;
     }
+    const uint64_t maxTotalFileSize =
+                            _walFilePool->GetFilePoolOpt().fileSize
+                          + _walFilePool->GetFilePoolOpt().metaPageSize;
     scoped_refptr<Segment> last_segment = NULL;
-    for (size_t i = 0; i < entries.size(); i++) {
-        braft::LogEntry* entry = entries[i];
-
-        scoped_refptr<Segment> segment =
-                    open_segment(entry->data.size() + kEntryHeaderSize);
+    size_t appended = 0;
+    while (appended < entries.size()) {
+        size_t batch_size = entry_size(entries[appended]);
+        scoped_refptr<Segment> segment = open_segment(batch_size);
         if (NULL == segment) {
-            return i;
+            break;
+        }
+        // pack as many entries as the open segment and walBatchMaxBytes
+        // allow into one write, so that the entries share one padding
+        const uint64_t start = segment->bytes();
+        const uint64_t limit = std::min(start + FLAGS_walBatchMaxBytes,
+                                        maxTotalFileSize);
+        size_t end = appended + 1;
+        while (end < entries.size()) {
+            size_t next = batch_size + entry_size(entries[end]);
+            if (align_to_wal(start + next) > limit) {
+                break;
+            }
+            batch_size = next;
+            ++end;
+        }
+        int ret = segment->append_batch(&entries[appended], end - appended);
+        int64_t count = segment->last_index()
+                      - entries[appended]->id.index + 1;
+        if (count > 0) {
+            _last_log_index.fetch_add(count, butil::memory_order_release);
+            appended += count;
+            last_segment = segment;
         }
-        int ret = segment->append(entry);
         if (0 != ret) {
-            return i;
+            break;
         }
-        _last_log_index.fetch_add(1, butil::memory_order_release);
-        last_segment = segment;
     }
-    last_segment->sync(_enable_sync);
-    return entries.size();
+    if (last_segment) {
+        last_segment->sync(_enable_sync);
+    }
+    return appended;
 }
 
 int CurveSegmentLogStorage::truncate_prefix(const int64_t first_index_kept) {
@@ -705,7 +747,10 @@ scoped_refptr<Segment> CurveSegmentLogStorage::open_segment(
         }
         uint32_t maxTotalFileSize = _walFilePool->GetFilePoolOpt().fileSize
                                   + _walFilePool->GetFilePoolOpt().metaPageSize;
-        if (_open_segment->bytes() + to_write > maxTotalFileSize) {
+        // the write is padded to the alignment from the current offset,
+        // which is not aligned after truncating inside a batch
+        if (align_to_wal(_open_segment->bytes() + to_write)
+                > maxTotalFileSize) {
             _segments[_open_segment->first_index()] = _open_segment;
             prev_open_segment.swap(_open_segment);
         }
@@ -60,6 +60,8 @@
 namespace curve {
 namespace chunkserver {
 
+DECLARE_uint64(walBatchMaxBytes);
+
 class CurveSegmentLogStorage;
 
 struct LogStorageOptions {
@@ -51,12 +51,18 @@ namespace chunkserver {
 
 // Format of Header, all fields are in network order
 // | -------------------- term (64bits) -------------------------  |
-// | entry-type (8bits) | checksum_type (8bits) | reserved(16bits) |
+// | entry-type (8bits) | checksum_type (8bits) | data gap (16bits) |
 // | ------------------ data len (32bits) -----------------------  |
 // | --------------- data real len (32bits) ---------------------  |
 // | data_checksum (32bits) | header checksum (32bits)             |
+//
+// data gap is the number of zero bytes between the header and the data,
+// which is written by the zero copy append to put the page aligned tail
+// of the data at an aligned offset, old entries always have it 0.
+// data len covers the gap, the data and the padding
 
 const size_t kEntryHeaderSize = 28;
+const uint32_t kMaxEntryDataGap = 0xFFFF;
 
 enum CheckSumType {
     CHECKSUM_MURMURHASH32 = 0,
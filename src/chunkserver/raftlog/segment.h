@@ -44,6 +44,20 @@ class Segment : public butil::RefCountedThreadSafe<Segment> {
     // serialize entry, and append to open segment
     virtual int append(const braft::LogEntry* entry) = 0;
 
+    // append a batch of continuous entries to open segment, the caller
+    // can find out how many entries are appended by last_index() when
+    // it fails. Segments which can not write in batch append one by one.
+    virtual int append_batch(const braft::LogEntry* const* entries,
+                             size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            int ret = append(entries[i]);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return 0;
+    }
+
     // get entry by index
     virtual braft::LogEntry* get(const int64_t index) const = 0;
 
@@ -20,6 +20,8 @@
  * Author: huyao
  */
 
+#include <butil/fast_rand.h>
+
 #include "src/chunkserver/scan_manager.h"
 #include "src/chunkserver/op_request.h"
 
@@ -35,6 +37,8 @@ int ScanManager::Init(const ScanManagerOptions &options) {
     timeoutMs_ = options.timeoutMs;
     retry_ = options.retry;
     retryIntervalUs_ = options.retryIntervalUs;
+    digestScan_ = options.digestScan;
+    verifyPercent_ = options.verifyPercent;
     jobWaitInterval_.Init(options.intervalSec * 1000);
     // reuse timeout 1000ms as send scan task interval
     scanTaskWaitInterval_.Init(options.timeoutMs);
@@ -268,6 +272,12 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
                     request->set_size(chunkMetaPageSize_);
                 } else {
                     request->set_size(scanSize_);
+                    if (digestScan_) {
+                        // only a sampled subset of ranges reads the data
+                        request->set_digestscan(true);
+                        request->set_verifydata(
+                            butil::fast_rand_less_than(100) < verifyPercent_);
+                    }
                 }
                 ScanChunkClosure *done = new ScanChunkClosure(request,
                                                               response);
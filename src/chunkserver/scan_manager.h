@@ -62,6 +62,12 @@ struct ScanManagerOptions {
     uint64_t timeoutMs;
     uint32_t retry;
     uint64_t retryIntervalUs;
+    // compare the digest of page crcs kept by the chunk hash index instead
+    // of reading all the data
+    bool digestScan = false;
+    // percent of the ranges whose data is still read and verified against
+    // the chunk hash index when digestScan is enabled
+    uint32_t verifyPercent = 0;
     CopysetNodeManager* copysetNodeManager;
 };
 
@@ -94,7 +100,7 @@ struct ScanJob {
     RWLock taskLock;
     ChunkID currentChunkId;
     uint64_t currentOffset;
-    ChunkMap chunkMap;
+    ChunkMapSnapshot chunkMap;
     std::shared_ptr<CSDataStore> dataStore;
     ScanJob() : type(ScanType::Init) {}
 };
@@ -251,6 +257,8 @@ class ScanManager {
     uint64_t timeoutMs_;
     uint32_t retry_;
     uint64_t retryIntervalUs_;
+    bool digestScan_;
+    uint32_t verifyPercent_;
 };
 }  // namespace chunkserver
 }  // namespace curve
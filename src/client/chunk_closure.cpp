@@ -162,6 +162,8 @@ void ClientClosure::Run() {
     std::unique_ptr<brpc::Controller> cntlGuard(cntl_);
     brpc::ClosureGuard doneGuard(done_);
 
+    ReleaseInflightLimiter();
+
     metaCache_ = client_->GetMetaCache();
     reqDone_ = static_cast<RequestClosure*>(done_);
     fileMetric_ = reqDone_->GetMetric();
@@ -255,6 +257,28 @@ void ClientClosure::Run() {
     }
 }
 
+void ClientClosure::ReleaseInflightLimiter() {
+    if (limiter_ == nullptr) {
+        return;
+    }
+
+    const int cntlstatus = cntl_->ErrorCode();
+    if (cntl_->Failed()) {
+        // 只有超时说明chunkserver处理不过来，其他错误不作为延时样本
+        if (cntlstatus == brpc::ERPCTIMEDOUT || cntlstatus == ETIMEDOUT) {
+            limiter_->OnResponse(cntl_->latency_us(), true);
+        } else {
+            limiter_->Release();
+        }
+    } else {
+        limiter_->OnResponse(
+            cntl_->latency_us(),
+            GetResponseStatus() == CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
+    }
+
+    limiter_.reset();
+}
+
 void ClientClosure::OnRpcFailed() {
     client_->ResetSenderIfNotHealth(chunkserverID_);
 
@@ -485,6 +509,22 @@ void WriteChunkClosure::OnSuccess() {
         response_->appliedindex());
 }
 
+void ReadChunkClosure::Run() {
+    if (hedgedCtx_ != nullptr) {
+        hedgedCtx_->tracker->Record(chunkserverID_, cntl_->latency_us());
+
+        // 发给follower的hedged read已经完成了当前请求，done_已经失效
+        if (!hedgedCtx_->Claim()) {
+            ReleaseInflightLimiter();
+            delete cntl_;
+            delete this;
+            return;
+        }
+    }
+
+    ClientClosure::Run();
+}
+
 void ReadChunkClosure::SendRetryRequest() {
     client_->ReadChunk(reqCtx_->idinfo_, reqCtx_->seq_,
                        reqCtx_->offset_,
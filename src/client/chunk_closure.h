@@ -33,6 +33,8 @@
 #include "src/client/client_config.h"
 #include "src/client/client_common.h"
 #include "src/client/client_metric.h"
+#include "src/client/hedged_read.h"
+#include "src/client/inflight_limiter.h"
 #include "src/client/request_closure.h"
 #include "src/common/math_util.h"
 
@@ -79,6 +81,10 @@ class ClientClosure : public Closure {
         chunkserverEndPoint_ = endPoint;
     }
 
+    void SetInflightLimiter(std::shared_ptr<AdaptiveInflightLimiter> limiter) {
+        limiter_ = std::move(limiter);
+    }
+
     EndPoint GetChunkServerEndPoint() const {
         return chunkserverEndPoint_;
     }
@@ -204,6 +210,12 @@ class ClientClosure : public Closure {
 
     void RefreshLeader();
 
+    /**
+     * rpc返回后释放inflight limiter的窗口，并将rpc延时和是否overload
+     * 反馈给limiter用于调整窗口大小
+     */
+    void ReleaseInflightLimiter();
+
     static FailureRequestOption         failReqOpt_;
 
     brpc::Controller*                   cntl_;
@@ -225,6 +237,9 @@ class ClientClosure : public Closure {
     // 发送重试请求前是否睡眠
     bool retryDirectly_ = false;
 
+    // 发送rpc时获取的chunkserver inflight窗口，未开启时为nullptr
+    std::shared_ptr<AdaptiveInflightLimiter> limiter_;
+
     // response 状态码
     int                                 status_;
 
@@ -246,9 +261,19 @@ class ReadChunkClosure : public ClientClosure {
     ReadChunkClosure(CopysetClient* client, Closure* done)
         : ClientClosure(client, done) {}
 
+    void Run() override;
+
     void OnSuccess() override;
     void OnChunkNotExist() override;
     void SendRetryRequest() override;
+
+    void SetHedgedReadContext(std::shared_ptr<HedgedReadContext> ctx) {
+        hedgedCtx_ = std::move(ctx);
+    }
+
+ private:
+    // 开启hedged read时有效，用于和发给follower的读请求竞争完成当前请求
+    std::shared_ptr<HedgedReadContext> hedgedCtx_;
 };
 
 class ReadChunkSnapClosure : public ClientClosure {
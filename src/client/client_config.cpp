@@ -64,6 +64,12 @@ int ClientConfig::Init(const char* configpath) {
     LOG_IF(ERROR, ret == false) << "config no global.fileIOSplitMaxSizeKB info";           // NOLINT
     RETURN_IF_FALSE(ret);
 
+    ret = conf_.GetUInt32Value("global.segmentPrefetchNum",
+          &fileServiceOption_.ioOpt.ioSplitOpt.segmentPrefetchNum);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.segmentPrefetchNum info, using default value "
+        << fileServiceOption_.ioOpt.ioSplitOpt.segmentPrefetchNum;
+
     ret = conf_.GetBoolValue("chunkserver.enableAppliedIndexRead",
           &fileServiceOption_.ioOpt.ioSenderOpt.chunkserverEnableAppliedIndexRead);        // NOLINT
     LOG_IF(ERROR, ret == false) << "config no chunkserver.enableAppliedIndexRead info";     // NOLINT
@@ -153,6 +159,30 @@ int ClientConfig::Init(const char* configpath) {
     LOG_IF(ERROR, ret == false) << "config no schedule.threadpoolSize info";
     RETURN_IF_FALSE(ret);
 
+    ret = conf_.GetBoolValue("schedule.enableWriteMerge",
+        &fileServiceOption_.ioOpt.reqSchdulerOpt.enableWriteMerge);
+    LOG_IF(WARNING, ret == false)
+        << "config no schedule.enableWriteMerge info, using default value "
+        << fileServiceOption_.ioOpt.reqSchdulerOpt.enableWriteMerge;
+
+    ret = conf_.GetUInt32Value("schedule.writeMergeWindowUs",
+        &fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeWindowUs);
+    LOG_IF(WARNING, ret == false)
+        << "config no schedule.writeMergeWindowUs info, using default value "
+        << fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeWindowUs;
+
+    ret = conf_.GetUInt32Value("schedule.writeMergeMaxBytes",
+        &fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeMaxBytes);
+    LOG_IF(WARNING, ret == false)
+        << "config no schedule.writeMergeMaxBytes info, using default value "
+        << fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeMaxBytes;
+
+    ret = conf_.GetUInt32Value("schedule.writeMergeMaxRequests",
+        &fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeMaxRequests);
+    LOG_IF(WARNING, ret == false)
+        << "config no schedule.writeMergeMaxRequests info, using default value "
+        << fileServiceOption_.ioOpt.reqSchdulerOpt.writeMergeMaxRequests;
+
     ret = conf_.GetUInt32Value("mds.refreshTimesPerLease",
         &fileServiceOption_.leaseOpt.mdsRefreshTimesPerLease);
     LOG_IF(ERROR, ret == false) << "config no mds.refreshTimesPerLease info";
@@ -271,6 +301,166 @@ int ClientConfig::Init(const char* configpath) {
     LOG_IF(ERROR, ret == false) << "config no discard.taskDelayMs info";
     RETURN_IF_FALSE(ret);
 
+    ret = conf_.GetBoolValue("readCache.enable",
+                             &fileServiceOption_.ioOpt.readCacheOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.enable info, using default value "
+        << fileServiceOption_.ioOpt.readCacheOpt.enable;
+
+    ret = conf_.GetUInt64Value(
+        "readCache.capacityMB",
+        &fileServiceOption_.ioOpt.readCacheOpt.capacityMB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.capacityMB info, using default value "
+        << fileServiceOption_.ioOpt.readCacheOpt.capacityMB;
+
+    ret = conf_.GetUInt32Value(
+        "readCache.blockSize",
+        &fileServiceOption_.ioOpt.readCacheOpt.blockSize);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.blockSize info, using default value "
+        << fileServiceOption_.ioOpt.readCacheOpt.blockSize;
+
+    ret = conf_.GetUInt32Value(
+        "readCache.protectedPercent",
+        &fileServiceOption_.ioOpt.readCacheOpt.protectedPercent);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.protectedPercent info, using default value "
+        << fileServiceOption_.ioOpt.readCacheOpt.protectedPercent;
+
+    ret = conf_.GetBoolValue("readahead.enable",
+                             &fileServiceOption_.ioOpt.readaheadOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.enable info, using default value "
+        << fileServiceOption_.ioOpt.readaheadOpt.enable;
+
+    ret = conf_.GetUInt32Value(
+        "readahead.triggerCount",
+        &fileServiceOption_.ioOpt.readaheadOpt.triggerCount);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.triggerCount info, using default value "
+        << fileServiceOption_.ioOpt.readaheadOpt.triggerCount;
+
+    ret = conf_.GetUInt32Value(
+        "readahead.windowMinKB",
+        &fileServiceOption_.ioOpt.readaheadOpt.windowMinKB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.windowMinKB info, using default value "
+        << fileServiceOption_.ioOpt.readaheadOpt.windowMinKB;
+
+    ret = conf_.GetUInt32Value(
+        "readahead.windowMaxKB",
+        &fileServiceOption_.ioOpt.readaheadOpt.windowMaxKB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.windowMaxKB info, using default value "
+        << fileServiceOption_.ioOpt.readaheadOpt.windowMaxKB;
+
+    ret = conf_.GetUInt32Value(
+        "readahead.maxInflightMB",
+        &fileServiceOption_.ioOpt.readaheadOpt.maxInflightMB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.maxInflightMB info, using default value "
+        << fileServiceOption_.ioOpt.readaheadOpt.maxInflightMB;
+
+    ret = conf_.GetBoolValue(
+        "chunkserver.hedgedRead.enable",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.enable info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.enable;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.hedgedRead.latencyPercentile",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.latencyPercentile);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.latencyPercentile info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.latencyPercentile;
+
+    ret = conf_.GetUInt64Value(
+        "chunkserver.hedgedRead.minDelayUS",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minDelayUS);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.minDelayUS info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minDelayUS;
+
+    ret = conf_.GetUInt64Value(
+        "chunkserver.hedgedRead.maxDelayUS",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.maxDelayUS);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.maxDelayUS info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.maxDelayUS;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.hedgedRead.minSamples",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minSamples);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.minSamples info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minSamples;
+
+    ret = conf_.GetBoolValue(
+        "chunkserver.inflightLimiter.enable",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.enable info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.enable;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.initWindow",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.initWindow);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.initWindow info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.initWindow;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.minWindow",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.minWindow);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.minWindow info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.minWindow;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.maxWindow",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.maxWindow);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.maxWindow info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.maxWindow;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.latencyTolerancePercent",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.latencyTolerancePercent);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.latencyTolerancePercent info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.latencyTolerancePercent;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.latencyDecreasePercent",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.latencyDecreasePercent);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.latencyDecreasePercent info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.latencyDecreasePercent;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.overloadDecreasePercent",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.overloadDecreasePercent);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.overloadDecreasePercent info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.overloadDecreasePercent;
+
+    ret = conf_.GetUInt32Value(
+        "chunkserver.inflightLimiter.minRttPeriodS",
+        &fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.minRttPeriodS);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.inflightLimiter.minRttPeriodS info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.inflightLimiterOpt.minRttPeriodS;
+
     return 0;
 }
 
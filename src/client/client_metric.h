@@ -102,6 +102,45 @@ struct DiscardMetric {
     bvar::Adder<int64_t> pending;
 };
 
+struct ReadCacheMetric {
+    explicit ReadCacheMetric(const std::string& prefix)
+        : hit(prefix, "read_cache_hit"),
+          miss(prefix, "read_cache_miss"),
+          eviction(prefix, "read_cache_eviction"),
+          bytes(prefix, "read_cache_bytes") {}
+
+    bvar::Adder<int64_t> hit;
+    bvar::Adder<int64_t> miss;
+    bvar::Adder<int64_t> eviction;
+    bvar::Adder<int64_t> bytes;
+};
+
+struct ReadaheadMetric {
+    explicit ReadaheadMetric(const std::string& prefix)
+        : issued(prefix, "readahead_issued"),
+          issuedBytes(prefix, "readahead_issued_bytes"),
+          inflightBytes(prefix, "readahead_inflight_bytes"),
+          throttled(prefix, "readahead_throttled") {}
+
+    // readahead requests sent
+    bvar::Adder<int64_t> issued;
+    bvar::Adder<int64_t> issuedBytes;
+    bvar::Adder<int64_t> inflightBytes;
+    // readahead skipped because too much data is inflight
+    bvar::Adder<int64_t> throttled;
+};
+
+struct HedgedReadMetric {
+    explicit HedgedReadMetric(const std::string& prefix)
+        : issued(prefix, "hedged_read_issued"),
+          won(prefix, "hedged_read_won") {}
+
+    // hedged reads sent to followers
+    bvar::Adder<int64_t> issued;
+    // hedged reads completed before the read sent to leader
+    bvar::Adder<int64_t> won;
+};
+
 // 文件级别metric信息统计
 struct FileMetric {
     const std::string prefix = "curve_client";
@@ -134,8 +173,17 @@ struct FileMetric {
     // 当前文件上的悬挂IO数量
     IOSuspendMetric suspendRPCMetric;
 
+    // 合并到其他写请求中发送的写请求qps
+    PerSecondMetric mergedWriteQPS;
+
     DiscardMetric discardMetric;
 
+    ReadCacheMetric readCacheMetric;
+
+    ReadaheadMetric readaheadMetric;
+
+    HedgedReadMetric hedgedReadMetric;
+
     explicit FileMetric(const std::string& name)
         : filename(name),
           inflightRPCNum(prefix, filename + "_inflight_rpc_num"),
@@ -149,7 +197,11 @@ struct FileMetric {
           userDiscard(prefix, filename + "_discard"),
           getLeaderRetryQPS(prefix, filename + "_get_leader_retry_rpc"),
           suspendRPCMetric(prefix, filename + "_suspend_io_num"),
-          discardMetric(prefix + filename) {}
+          mergedWriteQPS(prefix, filename + "_merged_write"),
+          discardMetric(prefix + filename),
+          readCacheMetric(prefix + filename),
+          readaheadMetric(prefix + filename),
+          hedgedReadMetric(prefix + filename) {}
 };
 
 // 用于全局mds接口统计信息调用信息统计
@@ -250,6 +302,17 @@ class MetricHelper {
         }
     }
 
+    /**
+     * 统计合并到其他写请求中发送的写请求个数
+     * @param: fm为当前文件的metric指针
+     * @param: count为被合并的请求个数
+     */
+    static void IncremMergedWriteCount(FileMetric* fm, uint64_t count) {
+        if (fm != nullptr) {
+            fm->mergedWriteQPS.count << count;
+        }
+    }
+
     /**
      * 统计用户当前读写请求次数，用于qps计算
      * @param: fm为当前文件的metric指针
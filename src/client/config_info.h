@@ -151,16 +151,61 @@ struct FailureRequestOption {
     uint64_t chunkserverMaxRetryTimesBeforeConsiderSuspend = 20;
 };
 
+/**
+ * hedged read配置，读请求发给leader之后，如果超过一定时间还没有返回，
+ * 再向一个follower发送同样的读请求，先返回的结果作为读请求的结果
+ * @enable: 是否开启hedged read，需要同时开启appliedindex read
+ * @latencyPercentile: leader的rpc延时超过其该百分位时发送hedged read
+ * @minDelayUS: 发送hedged read前的最短等待时间
+ * @maxDelayUS: 发送hedged read前的最长等待时间
+ * @minSamples: 一个chunkserver的延时样本数量达到该值后才会用于计算等待时间
+ */
+struct HedgedReadOption {
+    bool enable = false;
+    uint32_t latencyPercentile = 95;
+    uint64_t minDelayUS = 2000;
+    uint64_t maxDelayUS = 100000;
+    uint32_t minSamples = 64;
+};
+
+/**
+ * 每个chunkserver的inflight rpc数量的自适应限制，窗口大小根据rpc延时和
+ * overload返回调整，一个进程内的所有文件共享
+ * @enable: 是否开启
+ * @initWindow: 初始窗口大小
+ * @minWindow: 最小窗口大小
+ * @maxWindow: 最大窗口大小
+ * @latencyTolerancePercent: rpc延时超过最近最小延时的该百分比时，认为请求
+ *                           在chunkserver上排队，缩小窗口
+ * @latencyDecreasePercent: 延时升高时窗口缩小的百分比
+ * @overloadDecreasePercent: chunkserver返回overload或者rpc超时时窗口缩小的百分比
+ * @minRttPeriodS: 最小延时的统计周期
+ */
+struct InflightLimiterOption {
+    bool enable = false;
+    uint32_t initWindow = 32;
+    uint32_t minWindow = 4;
+    uint32_t maxWindow = 256;
+    uint32_t latencyTolerancePercent = 300;
+    uint32_t latencyDecreasePercent = 10;
+    uint32_t overloadDecreasePercent = 50;
+    uint32_t minRttPeriodS = 10;
+};
+
 /**
  * 发送rpc给chunkserver的配置
  * @chunkserverEnableAppliedIndexRead: 是否开启使用appliedindex read
  * @inflightOpt: 一个文件向chunkserver发送请求时的inflight 请求控制配置
  * @failRequestOpt: rpc发送失败之后，需要进行rpc重试的相关配置
+ * @hedgedReadOpt: hedged read相关配置
+ * @inflightLimiterOpt: 每个chunkserver的inflight rpc自适应限制配置
  */
 struct IOSenderOption {
     bool chunkserverEnableAppliedIndexRead;
     InFlightIOCntlInfo inflightOpt;
     FailureRequestOption failRequestOpt;
+    HedgedReadOption hedgedReadOpt;
+    InflightLimiterOption inflightLimiterOpt;
 };
 
 /**
@@ -168,10 +213,19 @@ struct IOSenderOption {
  * 线程池，线程池中的线程各自配置一个队列
  * @scheduleQueueCapacity: schedule模块配置的队列深度
  * @scheduleThreadpoolSize: schedule模块线程池大小
+ * @enableWriteMerge: 是否将队列中同一chunk上相邻或重叠的写请求合并为一个rpc发送
+ * @writeMergeWindowUs: 队列为空时等待后续可合并写请求的最长时间，为0时只合并
+ *                      已经在队列中的请求
+ * @writeMergeMaxBytes: 合并后写请求的最大长度
+ * @writeMergeMaxRequests: 一个rpc最多合并的写请求个数
  */
 struct RequestScheduleOption {
     uint32_t scheduleQueueCapacity = 1024;
     uint32_t scheduleThreadpoolSize = 2;
+    bool enableWriteMerge = false;
+    uint32_t writeMergeWindowUs = 0;
+    uint32_t writeMergeMaxBytes = 64 * 1024;
+    uint32_t writeMergeMaxRequests = 32;
     IOSenderOption ioSenderOpt;
 };
 
@@ -207,9 +261,12 @@ struct MetaCacheOption {
  * IO 拆分模块配置信息
  * @fileIOSplitMaxSizeKB: 用户下发IO大小client没有限制，但是client会将用户的IO进行拆分，
  *                        发向同一个chunkserver的请求锁携带的数据大小不能超过该值。
+ * @segmentPrefetchNum: 顺序写到未分配的segment时，一次向mds申请分配的
+ *                      segment数量，包括当前segment，小于等于1时不预分配
  */
 struct IOSplitOption {
     uint64_t fileIOSplitMaxSizeKB = 64;
+    uint32_t segmentPrefetchNum = 0;
 };
 
 /**
@@ -244,6 +301,38 @@ struct ThrottleOption {
     bool enable = false;
 };
 
+/**
+ * read cache config
+ * @enable: cache the data read and written by the writer of a file
+ * @capacityMB: max size of cached data of each file
+ * @blockSize: data is cached in blocks of this size
+ * @protectedPercent: percent of capacity for the blocks hit more than once
+ */
+struct ReadCacheOption {
+    bool enable = false;
+    uint64_t capacityMB = 64;
+    uint32_t blockSize = 4096;
+    uint32_t protectedPercent = 80;
+};
+
+/**
+ * readahead config
+ * @enable: prefetch data of sequential reads into read cache, it only works
+ *          when read cache is enabled
+ * @triggerCount: number of sequential reads before readahead starts
+ * @windowMinKB: initial readahead window size
+ * @windowMaxKB: max readahead window size, the window doubles every time
+ *               the reader catches up
+ * @maxInflightMB: max size of inflight readahead data of each file
+ */
+struct ReadaheadOption {
+    bool enable = false;
+    uint32_t triggerCount = 2;
+    uint32_t windowMinKB = 512;
+    uint32_t windowMaxKB = 16384;
+    uint32_t maxInflightMB = 64;
+};
+
 /**
  * IOOption存储了当前io 操作所需要的所有配置信息
  */
@@ -256,6 +345,8 @@ struct IOOption {
     CloseFdThreadOption closeFdThreadOption;
     ThrottleOption throttleOption;
     DiscardOption discardOption;
+    ReadCacheOption readCacheOpt;
+    ReadaheadOption readaheadOpt;
 };
 
 /**
@@ -22,8 +22,13 @@
 
 #include "src/client/copyset_client.h"
 
+#include <bthread/bthread.h>
+#include <bthread/unstable.h>
+#include <butil/time.h>
 #include <glog/logging.h>
 #include <unistd.h>
+
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -53,6 +58,14 @@ int CopysetClient::Init(MetaCache *metaCache,
     }
     iosenderopt_ = ioSenderOpt;
 
+    // hedged read依赖appliedindex read，follower根据appliedindex判断能否读
+    if (iosenderopt_.hedgedReadOpt.enable &&
+        iosenderopt_.chunkserverEnableAppliedIndexRead) {
+        latencyTracker_ = std::make_shared<ChunkServerLatencyTracker>(
+            iosenderopt_.hedgedReadOpt.latencyPercentile,
+            iosenderopt_.hedgedReadOpt.minSamples);
+    }
+
     LOG(INFO) << "CopysetClient init success, conf info: "
                  "chunkserverOPRetryIntervalUS = "
               << iosenderopt_.failRequestOpt.chunkserverOPRetryIntervalUS
@@ -124,13 +137,128 @@ int CopysetClient::ReadChunk(const ChunkIDInfo& idinfo, uint64_t sn,
 
     auto task = [&](Closure* done, std::shared_ptr<RequestSender> senderPtr) {
         ReadChunkClosure *readDone = new ReadChunkClosure(this, done);
+
+        std::shared_ptr<HedgedReadContext> hedgedCtx;
+        if (latencyTracker_ != nullptr) {
+            hedgedCtx = std::make_shared<HedgedReadContext>(
+                this, static_cast<RequestClosure*>(done), latencyTracker_);
+            hedgedCtx->idinfo = idinfo;
+            hedgedCtx->sn = sn;
+            hedgedCtx->offset = offset;
+            hedgedCtx->length = length;
+            hedgedCtx->appliedindex = appliedindex;
+            hedgedCtx->leaderId = senderPtr->GetChunkServerID();
+            readDone->SetHedgedReadContext(hedgedCtx);
+        }
+
         senderPtr->ReadChunk(idinfo, sn, offset, length,
                              appliedindex, sourceInfo, readDone);
+
+        // 只有知道之前写入的appliedindex时follower才能保证读到最新数据，
+        // 需要从克隆源拷贝数据的请求只能由leader处理
+        if (hedgedCtx != nullptr && appliedindex > 0 &&
+            !sourceInfo.IsValid()) {
+            ScheduleHedgedRead(hedgedCtx);
+        }
     };
 
     return DoRPCTask(idinfo, task, doneGuard.release());
 }
 
+void CopysetClient::ScheduleHedgedRead(
+    const std::shared_ptr<HedgedReadContext>& ctx) {
+    const auto& opt = iosenderopt_.hedgedReadOpt;
+    uint64_t delayUs = latencyTracker_->GetLatency(ctx->leaderId);
+    if (delayUs == 0) {
+        // leader的读延时样本还不够
+        delayUs = opt.maxDelayUS;
+    }
+    delayUs = std::min(std::max(delayUs, opt.minDelayUS), opt.maxDelayUS);
+
+    auto* arg = new std::shared_ptr<HedgedReadContext>(ctx);
+    bthread_timer_t timer;
+    int ret = bthread_timer_add(&timer, butil::microseconds_from_now(delayUs),
+                                OnHedgedReadTimer, arg);
+    if (ret != 0) {
+        LOG(WARNING) << "add hedged read timer failed, ret = " << ret;
+        delete arg;
+    }
+}
+
+void CopysetClient::OnHedgedReadTimer(void* arg) {
+    auto* ctx = static_cast<std::shared_ptr<HedgedReadContext>*>(arg);
+    if ((*ctx)->IsClaimed()) {
+        delete ctx;
+        return;
+    }
+
+    // 定时器线程中不能执行耗时的操作，在bthread中发送hedged read
+    bthread_t tid;
+    if (bthread_start_background(&tid, nullptr, RunHedgedRead, arg) != 0) {
+        RunHedgedRead(arg);
+    }
+}
+
+void* CopysetClient::RunHedgedRead(void* arg) {
+    std::unique_ptr<std::shared_ptr<HedgedReadContext>> ctx(
+        static_cast<std::shared_ptr<HedgedReadContext>*>(arg));
+    (*ctx)->client->SendHedgedRead(*ctx);
+    return nullptr;
+}
+
+void CopysetClient::SendHedgedRead(
+    const std::shared_ptr<HedgedReadContext>& ctx) {
+    // 持有锁期间请求不会完成，当前copyset client不会被释放
+    std::lock_guard<bthread::Mutex> lk(ctx->mtx);
+    if (ctx->claimed) {
+        return;
+    }
+
+    CopysetInfo cpinfo =
+        metaCache_->GetCopysetinfo(ctx->idinfo.lpid_, ctx->idinfo.cpid_);
+
+    // 选择读延时最低的follower
+    const CopysetPeerInfo* target = nullptr;
+    uint64_t targetLatency = 0;
+    for (const auto& peer : cpinfo.csinfos_) {
+        if (peer.chunkserverID == ctx->leaderId) {
+            continue;
+        }
+        uint64_t latency = latencyTracker_->GetLatency(peer.chunkserverID);
+        if (target == nullptr || latency < targetLatency) {
+            target = &peer;
+            targetLatency = latency;
+        }
+    }
+
+    if (target == nullptr) {
+        return;
+    }
+
+    auto senderPtr = senderManager_->GetOrCreateSender(
+        target->chunkserverID, target->externalAddr.addr_, iosenderopt_);
+    if (senderPtr == nullptr) {
+        return;
+    }
+
+    // hedged read不等待follower的inflight窗口，follower繁忙时不发送
+    auto limiter = senderPtr->GetInflightLimiter();
+    if (limiter != nullptr && !limiter->TryAcquire()) {
+        return;
+    }
+
+    if (fileMetric_ != nullptr) {
+        fileMetric_->hedgedReadMetric.issued << 1;
+    }
+
+    HedgedReadClosure* done =
+        new HedgedReadClosure(ctx, target->chunkserverID, limiter);
+    senderPtr->ReadChunkFromFollower(ctx->idinfo, ctx->sn, ctx->offset,
+                                     ctx->length, ctx->appliedindex,
+                                     done->GetCntl(), done->GetResponse(),
+                                     done);
+}
+
 int CopysetClient::WriteChunk(const ChunkIDInfo& idinfo, uint64_t sn,
                               const butil::IOBuf& data,
                               off_t offset, size_t length,
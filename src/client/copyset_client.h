@@ -33,6 +33,7 @@
 #include "src/client/client_common.h"
 #include "src/client/client_metric.h"
 #include "src/client/config_info.h"
+#include "src/client/hedged_read.h"
 #include "src/client/request_context.h"
 #include "src/client/request_sender_manager.h"
 #include "src/common/concurrent/concurrent.h"
@@ -215,6 +216,23 @@ class CopysetClient {
     friend class WriteChunkClosure;
     friend class ReadChunkClosure;
 
+    /**
+     * 读请求发给leader后，等待一段时间再向follower发送hedged read
+     * 等待时间为leader读延时的百分位值，限制在[minDelayUS, maxDelayUS]之间
+     * @param[in]: ctx为hedged read的上下文
+     */
+    void ScheduleHedgedRead(const std::shared_ptr<HedgedReadContext>& ctx);
+
+    /**
+     * 如果读请求还没有完成，向读延时最低的follower发送hedged read
+     * @param[in]: ctx为hedged read的上下文
+     */
+    void SendHedgedRead(const std::shared_ptr<HedgedReadContext>& ctx);
+
+    static void OnHedgedReadTimer(void* arg);
+
+    static void* RunHedgedRead(void* arg);
+
     // 拉取新的leader信息
     bool FetchLeader(LogicPoolID lpid,
                      CopysetID cpid,
@@ -253,6 +271,9 @@ class CopysetClient {
 
     // 是否在停止状态中，如果是在关闭过程中且session失效，需要将rpc直接返回不下发
     bool exitFlag_;
+
+    // 各个chunkserver的读延时，开启hedged read时有效
+    std::shared_ptr<ChunkServerLatencyTracker> latencyTracker_;
 };
 
 }   // namespace client
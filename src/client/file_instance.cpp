@@ -52,6 +52,10 @@ bool FileInstance::Initialize(const std::string& filename,
                               bool readonly) {
     readonly_ = readonly;
     fileopt_ = fileservicopt;
+    // 只读打开的文件可能被其他client写，不能使用读缓存
+    if (readonly_) {
+        fileopt_.ioOpt.readCacheOpt.enable = false;
+    }
     bool ret = false;
     do {
         if (!userinfo.Valid()) {
@@ -144,6 +148,34 @@ int FileInstance::AioDiscard(CurveAioContext* aioctx) {
     return -1;
 }
 
+int FileInstance::AioReadv(CurveAioContext* aioctx, const struct iovec* iov,
+                           int iovcnt) {
+    return iomanager4file_.AioReadv(aioctx, iov, iovcnt, mdsclient_.get());
+}
+
+int FileInstance::AioWritev(CurveAioContext* aioctx, const struct iovec* iov,
+                            int iovcnt) {
+    if (readonly_) {
+        DVLOG(9) << "open with read only, do not support write!";
+        return -1;
+    }
+    return iomanager4file_.AioWritev(aioctx, iov, iovcnt, mdsclient_.get());
+}
+
+int FileInstance::AioSubmit(CurveAioContext* aioctxs[], int count,
+                            UserDataType dataType) {
+    if (readonly_) {
+        for (int i = 0; i < count; ++i) {
+            if (aioctxs[i]->op != LIBCURVE_OP_READ) {
+                LOG(ERROR) << "Open with read only, only support read";
+                return -1;
+            }
+        }
+    }
+    return iomanager4file_.AioSubmit(aioctxs, count, mdsclient_.get(),
+                                     dataType);
+}
+
 // 两种场景会造成在Open的时候返回LIBCURVE_ERROR::FILE_OCCUPIED
 // 1. 强制重启qemu不会调用close逻辑，然后启动的时候原来的文件sessio还没过期.
 //    导致再次去发起open的时候，返回被占用，这种情况可以通过load sessionmap
@@ -124,6 +124,35 @@ class CURVE_CACHELINE_ALIGNMENT FileInstance {
      */
     int AioDiscard(CurveAioContext* aioctx);
 
+    /**
+     * @brief Asynchronous vectored read
+     * @param aioctx async request context
+     * @param iov io vectors to store read data
+     * @param iovcnt number of io vectors
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioReadv(CurveAioContext* aioctx, const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Asynchronous vectored write
+     * @param aioctx async request context
+     * @param iov io vectors of write data
+     * @param iovcnt number of io vectors
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioWritev(CurveAioContext* aioctx, const struct iovec* iov,
+                  int iovcnt);
+
+    /**
+     * @brief Submit a batch of asynchronous requests
+     * @param aioctxs async request contexts
+     * @param count number of contexts
+     * @param dataType type of user buffer
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioSubmit(CurveAioContext* aioctxs[], int count,
+                  UserDataType dataType);
+
     int Close();
 
     void UnInitialize();
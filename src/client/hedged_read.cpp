@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Jan  4 11:02:45 CST 2021
+ * Author: wuhanqing
+ */
+
+#include "src/client/hedged_read.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "src/client/client_metric.h"
+#include "src/client/request_closure.h"
+#include "src/client/request_context.h"
+
+namespace curve {
+namespace client {
+
+using curve::chunkserver::CHUNK_OP_STATUS;
+using curve::common::ReadLockGuard;
+using curve::common::WriteLockGuard;
+
+namespace {
+
+// recompute the percentile every so many samples
+const uint64_t kUpdateInterval = 16;
+
+}  // namespace
+
+const uint32_t ChunkServerLatencyTracker::kMaxSamples;
+
+ChunkServerLatencyTracker::ChunkServerLatencyTracker(uint32_t percentile,
+                                                     uint32_t minSamples)
+    : percentile_(std::min<uint32_t>(std::max<uint32_t>(percentile, 1), 100)),
+      minSamples_(std::min(std::max<uint32_t>(minSamples, 1), kMaxSamples)) {}
+
+ChunkServerLatencyTracker::Stat* ChunkServerLatencyTracker::GetOrCreateStat(
+    ChunkServerID id) {
+    {
+        ReadLockGuard lk(rwlock_);
+        auto it = stats_.find(id);
+        if (it != stats_.end()) {
+            return it->second.get();
+        }
+    }
+
+    WriteLockGuard lk(rwlock_);
+    auto& stat = stats_[id];
+    if (stat == nullptr) {
+        stat.reset(new Stat());
+        stat->samples.reserve(kMaxSamples);
+    }
+    return stat.get();
+}
+
+void ChunkServerLatencyTracker::Record(ChunkServerID id, uint64_t latencyUs) {
+    Stat* stat = GetOrCreateStat(id);
+
+    std::lock_guard<std::mutex> lk(stat->mtx);
+    if (stat->samples.size() < kMaxSamples) {
+        stat->samples.push_back(latencyUs);
+    } else {
+        stat->samples[stat->count % kMaxSamples] = latencyUs;
+    }
+    ++stat->count;
+
+    if (stat->count < minSamples_ ||
+        (stat->count != minSamples_ && stat->count % kUpdateInterval != 0)) {
+        return;
+    }
+
+    std::vector<uint64_t> sorted(stat->samples);
+    size_t pos = (sorted.size() * percentile_ + 99) / 100;
+    pos = pos == 0 ? 0 : pos - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + pos, sorted.end());
+    stat->latency.store(sorted[pos], std::memory_order_relaxed);
+}
+
+uint64_t ChunkServerLatencyTracker::GetLatency(ChunkServerID id) const {
+    ReadLockGuard lk(rwlock_);
+    auto it = stats_.find(id);
+    if (it == stats_.end()) {
+        return 0;
+    }
+    return it->second->latency.load(std::memory_order_relaxed);
+}
+
+void HedgedReadClosure::Run() {
+    std::unique_ptr<HedgedReadClosure> selfGuard(this);
+
+    ctx_->tracker->Record(chunkserverId_, cntl_.latency_us());
+
+    if (limiter_ != nullptr) {
+        if (cntl_.Failed()) {
+            limiter_->Release();
+        } else {
+            limiter_->OnResponse(cntl_.latency_us(),
+                                 response_.status() ==
+                                     CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
+        }
+    }
+
+    if (cntl_.Failed() ||
+        response_.status() != CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS) {
+        // the read sent to leader will complete the request, just drop it
+        LOG_EVERY_SECOND(WARNING)
+            << "hedged read failed, logicpool id = " << ctx_->idinfo.lpid_
+            << ", copyset id = " << ctx_->idinfo.cpid_
+            << ", chunk id = " << ctx_->idinfo.cid_
+            << ", chunkserver id = " << chunkserverId_
+            << ", error = " << cntl_.ErrorText()
+            << ", status = " << response_.status();
+        return;
+    }
+
+    if (!ctx_->Claim()) {
+        return;
+    }
+
+    RequestClosure* done = ctx_->done;
+    done->GetReqCtx()->readData_ = cntl_.response_attachment();
+    done->SetFailed(0);
+    if (done->GetMetric() != nullptr) {
+        done->GetMetric()->hedgedReadMetric.won << 1;
+    }
+    done->Run();
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Jan  4 11:02:45 CST 2021
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_CLIENT_HEDGED_READ_H_
+#define SRC_CLIENT_HEDGED_READ_H_
+
+#include <brpc/controller.h>
+#include <bthread/mutex.h>
+#include <google/protobuf/stubs/callback.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "proto/chunk.pb.h"
+#include "src/client/client_common.h"
+#include "src/client/inflight_limiter.h"
+#include "src/common/concurrent/rw_lock.h"
+
+namespace curve {
+namespace client {
+
+using curve::chunkserver::ChunkResponse;
+
+class CopysetClient;
+class RequestClosure;
+
+/**
+ * Read latency of each chunkserver.
+ *
+ * Only the most recent samples are kept, and the percentile is recomputed
+ * every few samples so that looking it up on the read path is cheap.
+ */
+class ChunkServerLatencyTracker {
+ public:
+    /**
+     * @param percentile which percentile is tracked, in (0, 100]
+     * @param minSamples percentile is unknown until so many samples
+     *        are recorded
+     */
+    ChunkServerLatencyTracker(uint32_t percentile, uint32_t minSamples);
+
+    ChunkServerLatencyTracker(const ChunkServerLatencyTracker&) = delete;
+    ChunkServerLatencyTracker& operator=(const ChunkServerLatencyTracker&) =
+        delete;
+
+    void Record(ChunkServerID id, uint64_t latencyUs);
+
+    /**
+     * @brief Get tracked percentile latency of a chunkserver
+     * @return latency in microseconds, 0 if not enough samples
+     */
+    uint64_t GetLatency(ChunkServerID id) const;
+
+    static const uint32_t kMaxSamples = 256;
+
+ private:
+    struct Stat {
+        std::mutex mtx;
+        std::vector<uint64_t> samples;
+        uint64_t count = 0;
+        std::atomic<uint64_t> latency{0};
+    };
+
+    Stat* GetOrCreateStat(ChunkServerID id);
+
+ private:
+    const uint32_t percentile_;
+    const uint32_t minSamples_;
+
+    mutable curve::common::RWLock rwlock_;
+    std::unordered_map<ChunkServerID, std::unique_ptr<Stat>> stats_;
+};
+
+/**
+ * Shared by the read rpc sent to the leader and the hedged one sent to a
+ * follower, whichever completes first finishes the request.
+ *
+ * The leader's rpc claims the request as soon as it returns, even if it
+ * will be retried, because a retry is sent by the same closure. The hedged
+ * rpc only claims the request if it succeeds, a failed one is dropped.
+ * Once claimed, the other rpc must not touch the request any more.
+ */
+struct HedgedReadContext {
+    HedgedReadContext(CopysetClient* client, RequestClosure* done,
+                      std::shared_ptr<ChunkServerLatencyTracker> tracker)
+        : client(client), done(done), tracker(std::move(tracker)) {}
+
+    bool Claim() {
+        std::lock_guard<bthread::Mutex> lk(mtx);
+        if (claimed) {
+            return false;
+        }
+        claimed = true;
+        return true;
+    }
+
+    bool IsClaimed() {
+        std::lock_guard<bthread::Mutex> lk(mtx);
+        return claimed;
+    }
+
+    // protects claimed, the hedged rpc is sent while holding it, so that
+    // client is valid until the request is claimed
+    bthread::Mutex mtx;
+    bool claimed = false;
+
+    CopysetClient* client;
+    RequestClosure* done;
+    std::shared_ptr<ChunkServerLatencyTracker> tracker;
+
+    ChunkIDInfo idinfo;
+    uint64_t sn = 0;
+    off_t offset = 0;
+    size_t length = 0;
+    uint64_t appliedindex = 0;
+    ChunkServerID leaderId = 0;
+};
+
+/**
+ * Closure of the hedged read rpc sent to a follower
+ */
+class HedgedReadClosure : public google::protobuf::Closure {
+ public:
+    HedgedReadClosure(std::shared_ptr<HedgedReadContext> ctx,
+                      ChunkServerID chunkserverId,
+                      std::shared_ptr<AdaptiveInflightLimiter> limiter)
+        : ctx_(std::move(ctx)),
+          chunkserverId_(chunkserverId),
+          limiter_(std::move(limiter)) {}
+
+    void Run() override;
+
+    brpc::Controller* GetCntl() {
+        return &cntl_;
+    }
+
+    ChunkResponse* GetResponse() {
+        return &response_;
+    }
+
+ private:
+    std::shared_ptr<HedgedReadContext> ctx_;
+    ChunkServerID chunkserverId_;
+    // inflight window acquired from the follower, nullptr if not enabled
+    std::shared_ptr<AdaptiveInflightLimiter> limiter_;
+    brpc::Controller cntl_;
+    ChunkResponse response_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_HEDGED_READ_H_
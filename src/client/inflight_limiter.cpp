@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Tue Jan  5 10:17:26 CST 2021
+ * Author: wuhanqing
+ */
+
+#include "src/client/inflight_limiter.h"
+
+#include <algorithm>
+
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace client {
+
+using curve::common::TimeUtility;
+
+AdaptiveInflightLimiter::AdaptiveInflightLimiter(
+    const std::string& prefix, const InflightLimiterOption& option)
+    : option_(option),
+      window_(std::min(std::max(option.initWindow, option.minWindow),
+                       option.maxWindow)),
+      inflight_(0),
+      minRttUs_(0),
+      minRttExpireUs_(0),
+      lastDecreaseUs_(0),
+      windowMetric_(prefix, "inflight_window", static_cast<int64_t>(window_)),
+      inflightMetric_(prefix, "inflight_rpc", 0),
+      congestedMetric_(prefix, "inflight_congested") {}
+
+void AdaptiveInflightLimiter::Acquire() {
+    std::unique_lock<bthread::Mutex> lk(mtx_);
+    while (inflight_ >= static_cast<uint32_t>(window_)) {
+        cond_.wait(lk);
+    }
+    ++inflight_;
+    inflightMetric_.set_value(inflight_);
+}
+
+bool AdaptiveInflightLimiter::TryAcquire() {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    if (inflight_ >= static_cast<uint32_t>(window_)) {
+        return false;
+    }
+    ++inflight_;
+    inflightMetric_.set_value(inflight_);
+    return true;
+}
+
+void AdaptiveInflightLimiter::Release() {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    ReleaseLocked();
+}
+
+void AdaptiveInflightLimiter::ReleaseLocked() {
+    --inflight_;
+    inflightMetric_.set_value(inflight_);
+    cond_.notify_one();
+}
+
+void AdaptiveInflightLimiter::OnResponse(uint64_t latencyUs, bool congested) {
+    const uint64_t nowUs = TimeUtility::GetTimeofDayUs();
+
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    const uint32_t oldWindow = static_cast<uint32_t>(window_);
+
+    if (congested) {
+        congestedMetric_ << 1;
+        DecreaseLocked(option_.overloadDecreasePercent, nowUs, latencyUs);
+    } else {
+        if (minRttUs_ == 0 || latencyUs < minRttUs_ ||
+            nowUs >= minRttExpireUs_) {
+            // the baseline is reset periodically, so that it follows the
+            // chunkserver when its load changes
+            if (nowUs >= minRttExpireUs_) {
+                minRttExpireUs_ =
+                    nowUs + option_.minRttPeriodS * 1000ull * 1000;
+            }
+            minRttUs_ = latencyUs;
+        }
+
+        if (latencyUs * 100 >
+            minRttUs_ * option_.latencyTolerancePercent) {
+            DecreaseLocked(option_.latencyDecreasePercent, nowUs, latencyUs);
+        } else if (inflight_ * 2 >= oldWindow) {
+            // only grow when the window is actually used
+            window_ = std::min<double>(window_ + 1.0 / window_,
+                                       option_.maxWindow);
+        }
+    }
+
+    const uint32_t newWindow = static_cast<uint32_t>(window_);
+    if (newWindow != oldWindow) {
+        windowMetric_.set_value(newWindow);
+    }
+
+    ReleaseLocked();
+    if (newWindow > oldWindow) {
+        cond_.notify_all();
+    }
+}
+
+void AdaptiveInflightLimiter::DecreaseLocked(uint32_t percent, uint64_t nowUs,
+                                             uint64_t latencyUs) {
+    // responses of rpcs sent before the last decrease carry the same signal
+    if (nowUs < lastDecreaseUs_ + latencyUs) {
+        return;
+    }
+
+    lastDecreaseUs_ = nowUs;
+    window_ = std::max<double>(window_ * (100 - percent) / 100,
+                               option_.minWindow);
+}
+
+uint32_t AdaptiveInflightLimiter::Window() const {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    return static_cast<uint32_t>(window_);
+}
+
+uint32_t AdaptiveInflightLimiter::Inflight() const {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    return inflight_;
+}
+
+std::shared_ptr<AdaptiveInflightLimiter>
+InflightLimiterManager::GetOrCreateLimiter(ChunkServerID id,
+                                           const InflightLimiterOption& option) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto& limiter = limiters_[id];
+    if (limiter == nullptr) {
+        limiter = std::make_shared<AdaptiveInflightLimiter>(
+            "curve_client_chunkserver_" + std::to_string(id), option);
+    }
+    return limiter;
+}
+
+}  // namespace client
+}  // namespace curve
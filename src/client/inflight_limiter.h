@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Tue Jan  5 10:17:26 CST 2021
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_CLIENT_INFLIGHT_LIMITER_H_
+#define SRC_CLIENT_INFLIGHT_LIMITER_H_
+
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+#include <bvar/bvar.h>
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+
+#include "src/client/client_common.h"
+#include "src/client/config_info.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * Adaptive limit of inflight rpcs sent to one chunkserver.
+ *
+ * The window grows by one every window of responses (additive increase)
+ * as long as the rtt stays within latencyTolerancePercent of the minimum
+ * rtt seen recently. A higher rtt means requests are queueing up on the
+ * chunkserver, and the window shrinks by latencyDecreasePercent. An
+ * overload response or rpc timeout shrinks it by overloadDecreasePercent
+ * (multiplicative decrease). The window shrinks at most once per rtt,
+ * because the responses of the same window carry the same signal.
+ *
+ * Acquire blocks until the number of inflight rpcs is below the window,
+ * it can be called in both pthread and bthread.
+ */
+class AdaptiveInflightLimiter {
+ public:
+    AdaptiveInflightLimiter(const std::string& prefix,
+                            const InflightLimiterOption& option);
+
+    AdaptiveInflightLimiter(const AdaptiveInflightLimiter&) = delete;
+    AdaptiveInflightLimiter& operator=(const AdaptiveInflightLimiter&) =
+        delete;
+
+    void Acquire();
+
+    /**
+     * @brief Acquire without blocking
+     * @return false if the window is full
+     */
+    bool TryAcquire();
+
+    /**
+     * @brief An rpc acquired before returned
+     * @param latencyUs rtt of the rpc
+     * @param congested whether the chunkserver is overloaded or the rpc
+     *        timed out
+     */
+    void OnResponse(uint64_t latencyUs, bool congested);
+
+    /**
+     * @brief Release an acquired rpc without taking it as a sample,
+     *        e.g. it failed for reasons other than congestion
+     */
+    void Release();
+
+    uint32_t Window() const;
+
+    uint32_t Inflight() const;
+
+ private:
+    void ReleaseLocked();
+
+    void DecreaseLocked(uint32_t percent, uint64_t nowUs, uint64_t latencyUs);
+
+ private:
+    const InflightLimiterOption option_;
+
+    mutable bthread::Mutex mtx_;
+    bthread::ConditionVariable cond_;
+
+    double window_;
+    uint32_t inflight_;
+
+    // minimum rtt seen in current period, the baseline of rtt
+    uint64_t minRttUs_;
+    uint64_t minRttExpireUs_;
+
+    uint64_t lastDecreaseUs_;
+
+    bvar::Status<int64_t> windowMetric_;
+    bvar::Status<int64_t> inflightMetric_;
+    bvar::Adder<int64_t> congestedMetric_;
+};
+
+/**
+ * Limiters are shared by all files opened by the process, because all of
+ * their rpcs to the same chunkserver queue up on it.
+ */
+class InflightLimiterManager {
+ public:
+    static InflightLimiterManager& GetInstance() {
+        static InflightLimiterManager manager;
+        return manager;
+    }
+
+    std::shared_ptr<AdaptiveInflightLimiter> GetOrCreateLimiter(
+        ChunkServerID id, const InflightLimiterOption& option);
+
+ private:
+    InflightLimiterManager() = default;
+
+    std::mutex mtx_;
+    std::unordered_map<ChunkServerID,
+                       std::shared_ptr<AdaptiveInflightLimiter>> limiters_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_INFLIGHT_LIMITER_H_
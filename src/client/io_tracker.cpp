@@ -35,6 +35,7 @@
 #include "src/client/source_reader.h"
 #include "src/client/metacache_struct.h"
 #include "src/client/discard_task.h"
+#include "src/common/object_pool.h"
 
 namespace curve {
 namespace client {
@@ -44,6 +45,18 @@ using curve::chunkserver::CHUNK_OP_STATUS;
 std::atomic<uint64_t> IOTracker::tracekerID_(1);
 DiscardOption IOTracker::discardOption_;
 
+namespace {
+
+// 暴露异步IO的IOTracker对象池统计信息
+struct IOTrackerPoolMetricExposer {
+    IOTrackerPoolMetricExposer() {
+        curve::common::ObjectPool<IOTracker>::GetInstance()->Expose(
+            "curve_client_io_tracker_pool");
+    }
+} ioTrackerPoolMetricExposer;
+
+}  // namespace
+
 IOTracker::IOTracker(IOManager* iomanager,
                      MetaCache* mc,
                      RequestScheduler* scheduler,
@@ -53,7 +66,11 @@ IOTracker::IOTracker(IOManager* iomanager,
       iomanager_(iomanager),
       scheduler_(scheduler),
       fileMetric_(clientMetric),
-      disableStripe_(disableStripe) {
+      disableStripe_(disableStripe),
+      readCache_(nullptr),
+      cacheBegun_(false),
+      cacheEpoch_(0),
+      readahead_(false) {
     id_         = tracekerID_.fetch_add(1, std::memory_order_relaxed);
     scc_        = nullptr;
     aioctx_     = nullptr;
@@ -102,6 +119,19 @@ void IOTracker::StartAioRead(CurveAioContext* ctx, MDSClient* mdsclient,
 
 void IOTracker::DoRead(MDSClient* mdsclient, const FInfo_t* fileInfo,
                        Throttle* throttle) {
+    if (readCache_ != nullptr) {
+        butil::IOBuf data;
+        if (readCache_->Read(mc_->GetLatestFileSn(), offset_, length_, &data,
+                             &cacheEpoch_)) {
+            PrepareReadIOBuffers(1);
+            SetReadData(0, data);
+            errcode_ = LIBCURVE_ERROR::OK;
+            Done();
+            return;
+        }
+        cacheBegun_ = true;
+    }
+
     if (throttle) {
         throttle->Add(true, length_);
     }
@@ -189,7 +219,7 @@ void IOTracker::StartAioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
 
 void IOTracker::DoWrite(MDSClient* mdsclient, const FInfo_t* fileInfo,
                         Throttle* throttle) {
-    if (nullptr == data_) {
+    if (nullptr == data_ && userDataType_ != UserDataType::IOVector) {
         ReturnOnFail();
         return;
     }
@@ -202,6 +232,20 @@ void IOTracker::DoWrite(MDSClient* mdsclient, const FInfo_t* fileInfo,
         case UserDataType::IOBuffer:
             writeData_ = *reinterpret_cast<const butil::IOBuf*>(data_);
             break;
+        case UserDataType::IOVector:
+            for (const auto& iov : iov_) {
+                writeData_.append_user_data(iov.iov_base, iov.iov_len,
+                                            TrivialDeleter);
+            }
+            break;
+    }
+
+    if (readCache_ != nullptr) {
+        cacheEpoch_ = readCache_->BeginWrite(mc_->GetLatestFileSn(), offset_,
+                                             length_);
+        cacheBegun_ = true;
+        // writeData_ will be cut into requests, only the blocks are shared
+        cacheData_ = writeData_;
     }
 
     if (throttle) {
@@ -254,6 +298,12 @@ void IOTracker::StartAioDiscard(CurveAioContext* ctx, MDSClient* mdsclient,
 
 void IOTracker::DoDiscard(MDSClient* mdsClient, const FInfo* fileInfo,
                           DiscardTaskManager* taskManager) {
+    if (readCache_ != nullptr) {
+        uint64_t epoch = readCache_->BeginWrite(mc_->GetLatestFileSn(),
+                                                offset_, length_);
+        readCache_->EndWrite(epoch, offset_, length_, nullptr);
+    }
+
     int ret = Splitor::IO2ChunkRequests(this, mc_, &reqlist_, nullptr, offset_,
                                         length_, mdsClient, fileInfo);
 
@@ -464,10 +514,19 @@ void IOTracker::Done() {
         ReleaseAllSegmentLocks();
     }
 
+    if (cacheBegun_ && type_ == OpType::WRITE) {
+        readCache_->EndWrite(
+            cacheEpoch_, offset_, length_,
+            errcode_ == LIBCURVE_ERROR::OK ? &cacheData_ : nullptr);
+    }
+
     if (errcode_ == LIBCURVE_ERROR::OK) {
-        uint64_t duration = TimeUtility::GetTimeofDayUs() - opStartTimePoint_;
-        MetricHelper::UserLatencyRecord(fileMetric_, duration, type_);
-        MetricHelper::IncremUserQPSCount(fileMetric_, length_, type_);
+        if (!readahead_) {
+            uint64_t duration =
+                TimeUtility::GetTimeofDayUs() - opStartTimePoint_;
+            MetricHelper::UserLatencyRecord(fileMetric_, duration, type_);
+            MetricHelper::IncremUserQPSCount(fileMetric_, length_, type_);
+        }
 
         // copy read data to user buffer
         if (OpType::READ == type_ || OpType::READ_SNAP == type_) {
@@ -476,6 +535,10 @@ void IOTracker::Done() {
                 readData.append(buf);
             }
 
+            if (cacheBegun_ && readData.size() == length_) {
+                readCache_->EndRead(cacheEpoch_, offset_, readData);
+            }
+
             switch (userDataType_) {
                 case UserDataType::RawBuffer: {
                     size_t nc = readData.copy_to(data_, readData.size());
@@ -493,6 +556,17 @@ void IOTracker::Done() {
                     }
                     break;
                 }
+                case UserDataType::IOVector: {
+                    size_t pos = 0;
+                    for (const auto& iov : iov_) {
+                        pos += readData.copy_to(iov.iov_base, iov.iov_len,
+                                                pos);
+                    }
+                    if (pos != length_) {
+                        errcode_ = LIBCURVE_ERROR::FAILED;
+                    }
+                    break;
+                }
             }
 
             if (errcode_ != LIBCURVE_ERROR::OK) {
@@ -503,7 +577,9 @@ void IOTracker::Done() {
             }
         }
     } else {
-        MetricHelper::IncremUserEPSCount(fileMetric_, type_);
+        if (!readahead_) {
+            MetricHelper::IncremUserEPSCount(fileMetric_, type_);
+        }
         if (type_ == OpType::READ || type_ == OpType::WRITE) {
             LOG(ERROR) << "file [" << fileMetric_->filename << "]"
                     << ", IO Error, OpType = " << OpTypeToString(type_)
@@ -543,8 +619,7 @@ void IOTracker::Done() {
 
 void IOTracker::DestoryRequestList() {
     for (auto iter : reqlist_) {
-        iter->UnInit();
-        delete iter;
+        RequestContext::DeleteInitedRequestContext(iter);
     }
 }
 
@@ -36,6 +36,7 @@
 #include "src/client/request_scheduler.h"
 #include "include/curve_compiler_specific.h"
 #include "src/client/io_condition_varaiable.h"
+#include "src/client/read_cache.h"
 #include "src/common/throttle.h"
 
 #include "proto/chunk.pb.h"
@@ -207,6 +208,12 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         userDataType_ = dataType;
     }
 
+    // set user io vectors, the io vectors are copied
+    void SetUserIOVector(const struct iovec* iov, int iovcnt) {
+        userDataType_ = UserDataType::IOVector;
+        iov_.assign(iov, iov + iovcnt);
+    }
+
     /**
      * @brief prepare space to store read data
      * @param subIoCount #space to store read data
@@ -223,6 +230,22 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         return disableStripe_;
     }
 
+    /**
+     * @brief set the read cache of the file, read/write/discard will
+     *        lookup or update it
+     */
+    void SetReadCache(ReadCache* readCache) {
+        readCache_ = readCache;
+    }
+
+    /**
+     * @brief mark the tracker as a readahead issued by the client itself,
+     *        it is not counted in user io metrics
+     */
+    void SetReadahead() {
+        readahead_ = true;
+    }
+
     static void InitDiscardOption(const DiscardOption& opt);
 
  private:
@@ -305,6 +328,9 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     // user data type
     UserDataType userDataType_;
 
+    // user io vectors if userDataType_ is IOVector
+    std::vector<struct iovec> iov_;
+
     // save write data
     butil::IOBuf writeData_;
 
@@ -357,6 +383,18 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
 
     bool disableStripe_;
 
+    // read cache of the file, nullptr if disabled
+    ReadCache* readCache_;
+    // whether a read missed the cache or a write has begun on it,
+    // and the epoch to update the cache when io is done
+    bool cacheBegun_;
+    uint64_t cacheEpoch_;
+    // data of write to fill the cache
+    butil::IOBuf cacheData_;
+
+    // whether it is a readahead
+    bool readahead_;
+
     // read/write operations will hold segment's read lock,
     // so store corresponding segment lock and release after operations finished
     std::vector<FileSegment*> segmentLocks_;
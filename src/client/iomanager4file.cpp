@@ -23,15 +23,36 @@
 #include <glog/logging.h>
 
 #include <chrono>   // NOLINT
+#include <utility>
+#include <vector>
 
 #include "src/client/metacache.h"
 #include "src/client/iomanager4file.h"
 #include "src/client/file_instance.h"
 #include "src/client/io_tracker.h"
 #include "src/client/splitor.h"
+#include "src/common/object_pool.h"
 
 namespace curve {
 namespace client {
+
+using curve::common::ObjectPool;
+
+namespace {
+
+struct ReadaheadContext : public CurveAioContext {
+    butil::IOBuf data;
+    Readahead* readahead;
+};
+
+void ReadaheadCallback(CurveAioContext* aioctx) {
+    ReadaheadContext* ctx = static_cast<ReadaheadContext*>(aioctx);
+    ctx->readahead->OnPrefetchDone(ctx->length);
+    delete ctx;
+}
+
+}  // namespace
+
 Atomic<uint64_t> IOManager::idRecorder_(1);
 IOManager4File::IOManager4File() : scheduler_(nullptr), exit_(false) {}
 
@@ -87,6 +108,21 @@ bool IOManager4File::Initialize(const std::string& filename,
     discardTaskManager_.reset(
         new DiscardTaskManager(&(fileMetric_->discardMetric)));
 
+    if (ioopt_.readCacheOpt.enable) {
+        readCache_.reset(new ReadCache(ioopt_.readCacheOpt,
+                                       &fileMetric_->readCacheMetric));
+    }
+
+    if (ioopt_.readaheadOpt.enable) {
+        if (readCache_) {
+            readahead_.reset(new Readahead(ioopt_.readaheadOpt,
+                                           &fileMetric_->readaheadMetric));
+        } else {
+            LOG(WARNING) << "readahead is disabled because read cache of "
+                         << filename << " is disabled";
+        }
+    }
+
     LOG(INFO) << "iomanager init success, conf info: "
               << "isolationTaskThreadPoolSize = "
               << ioopt_.taskThreadOpt.isolationTaskThreadPoolSize
@@ -134,6 +170,8 @@ void IOManager4File::UnInitialize() {
         exit_ = true;
 
         delete scheduler_;
+        readahead_.reset();
+        readCache_.reset();
         delete fileMetric_;
         scheduler_ = nullptr;
         fileMetric_ = nullptr;
@@ -149,9 +187,18 @@ int IOManager4File::Read(char* buf, off_t offset,
 
     IOTracker temp(this, &mc_, scheduler_, fileMetric_, disableStripe_);
     temp.SetUserDataType(UserDataType::IOBuffer);
+    temp.SetReadCache(readCache_.get());
     temp.StartRead(&data, offset, length, mdsclient, this->GetFileInfo(),
                    throttle_.get());
 
+    std::vector<ReadaheadRange> ranges;
+    GetReadaheadRanges(offset, length, &ranges);
+    if (!ranges.empty()) {
+        taskPool_.Enqueue([this, ranges, mdsclient]() {
+            StartReadahead(ranges, mdsclient);
+        });
+    }
+
     int rc = temp.Wait();
 
     if (rc < 0) {
@@ -174,6 +221,7 @@ int IOManager4File::Write(const char* buf,
 
     IOTracker temp(this, &mc_, scheduler_, fileMetric_, disableStripe_);
     temp.SetUserDataType(UserDataType::IOBuffer);
+    temp.SetReadCache(readCache_.get());
     temp.StartWrite(&data, offset, length, mdsclient, this->GetFileInfo(),
                     throttle_.get());
 
@@ -185,20 +233,17 @@ int IOManager4File::AioRead(CurveAioContext* ctx, MDSClient* mdsclient,
                             UserDataType dataType) {
     MetricHelper::IncremUserRPSCount(fileMetric_, OpType::READ);
 
-    IOTracker* temp = new (std::nothrow)
-        IOTracker(this, &mc_, scheduler_, fileMetric_, disableStripe_);
+    IOTracker* temp = NewAioTracker(ctx, dataType);
     if (temp == nullptr) {
-        ctx->ret = -LIBCURVE_ERROR::FAILED;
-        ctx->cb(ctx);
-        LOG(ERROR) << "allocate tracker failed!";
         return LIBCURVE_ERROR::OK;
     }
 
-    temp->SetUserDataType(dataType);
-    inflightCntl_.IncremInflightNum();
-    auto task = [this, ctx, mdsclient, temp]() {
+    std::vector<ReadaheadRange> ranges;
+    GetReadaheadRanges(ctx->offset, ctx->length, &ranges);
+    auto task = [this, ctx, mdsclient, temp, ranges]() {
         temp->StartAioRead(ctx, mdsclient, this->GetFileInfo(),
                            throttle_.get());
+        StartReadahead(ranges, mdsclient);
     };
 
     taskPool_.Enqueue(task);
@@ -209,17 +254,11 @@ int IOManager4File::AioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
                              UserDataType dataType) {
     MetricHelper::IncremUserRPSCount(fileMetric_, OpType::WRITE);
 
-    IOTracker* temp = new (std::nothrow)
-        IOTracker(this, &mc_, scheduler_, fileMetric_, disableStripe_);
+    IOTracker* temp = NewAioTracker(ctx, dataType);
     if (temp == nullptr) {
-        ctx->ret = -LIBCURVE_ERROR::FAILED;
-        ctx->cb(ctx);
-        LOG(ERROR) << "allocate tracker failed!";
         return LIBCURVE_ERROR::OK;
     }
 
-    temp->SetUserDataType(dataType);
-    inflightCntl_.IncremInflightNum();
     auto task = [this, ctx, mdsclient, temp]() {
         temp->StartAioWrite(ctx, mdsclient, this->GetFileInfo(),
                             throttle_.get());
@@ -239,6 +278,7 @@ int IOManager4File::Discard(off_t offset, size_t length, MDSClient* mdsclient) {
     FlightIOGuard guard(this);
 
     IOTracker tracker(this, &mc_, scheduler_, fileMetric_);
+    tracker.SetReadCache(readCache_.get());
     tracker.StartDiscard(offset, length, mdsclient, GetFileInfo(),
                          discardTaskManager_.get());
     return tracker.Wait();
@@ -253,8 +293,8 @@ int IOManager4File::AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient) {
         return LIBCURVE_ERROR::OK;
     }
 
-    IOTracker* ioTracker =
-        new (std::nothrow) IOTracker(this, &mc_, scheduler_, fileMetric_);
+    IOTracker* ioTracker = ObjectPool<IOTracker>::GetInstance()->New(
+        this, &mc_, scheduler_, fileMetric_);
 
     if (ioTracker == nullptr) {
         aioctx->ret = -LIBCURVE_ERROR::FAILED;
@@ -263,6 +303,7 @@ int IOManager4File::AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient) {
         return LIBCURVE_ERROR::OK;
     }
 
+    ioTracker->SetReadCache(readCache_.get());
     inflightCntl_.IncremInflightNum();
     auto task = [this, aioctx, mdsclient, ioTracker]() {
         ioTracker->StartAioDiscard(aioctx, mdsclient, this->GetFileInfo(),
@@ -273,6 +314,183 @@ int IOManager4File::AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient) {
     return LIBCURVE_ERROR::OK;
 }
 
+int IOManager4File::AioReadv(CurveAioContext* ctx, const struct iovec* iov,
+                             int iovcnt, MDSClient* mdsclient) {
+    MetricHelper::IncremUserRPSCount(fileMetric_, OpType::READ);
+
+    IOTracker* temp = NewAioTracker(ctx, UserDataType::IOVector);
+    if (temp == nullptr) {
+        return LIBCURVE_ERROR::OK;
+    }
+
+    temp->SetUserIOVector(iov, iovcnt);
+    std::vector<ReadaheadRange> ranges;
+    GetReadaheadRanges(ctx->offset, ctx->length, &ranges);
+    auto task = [this, ctx, mdsclient, temp, ranges]() {
+        temp->StartAioRead(ctx, mdsclient, this->GetFileInfo(),
+                           throttle_.get());
+        StartReadahead(ranges, mdsclient);
+    };
+
+    taskPool_.Enqueue(task);
+    return LIBCURVE_ERROR::OK;
+}
+
+int IOManager4File::AioWritev(CurveAioContext* ctx, const struct iovec* iov,
+                              int iovcnt, MDSClient* mdsclient) {
+    MetricHelper::IncremUserRPSCount(fileMetric_, OpType::WRITE);
+
+    IOTracker* temp = NewAioTracker(ctx, UserDataType::IOVector);
+    if (temp == nullptr) {
+        return LIBCURVE_ERROR::OK;
+    }
+
+    temp->SetUserIOVector(iov, iovcnt);
+    auto task = [this, ctx, mdsclient, temp]() {
+        temp->StartAioWrite(ctx, mdsclient, this->GetFileInfo(),
+                            throttle_.get());
+    };
+
+    taskPool_.Enqueue(task);
+    return LIBCURVE_ERROR::OK;
+}
+
+int IOManager4File::AioSubmit(CurveAioContext* ctxs[], int count,
+                              MDSClient* mdsclient, UserDataType dataType) {
+    std::vector<std::pair<CurveAioContext*, IOTracker*>> trackers;
+    trackers.reserve(count);
+    std::vector<ReadaheadRange> ranges;
+    for (int i = 0; i < count; ++i) {
+        CurveAioContext* ctx = ctxs[i];
+        switch (ctx->op) {
+            case LIBCURVE_OP_READ: {
+                MetricHelper::IncremUserRPSCount(fileMetric_, OpType::READ);
+                std::vector<ReadaheadRange> readRanges;
+                GetReadaheadRanges(ctx->offset, ctx->length, &readRanges);
+                ranges.insert(ranges.end(), readRanges.begin(),
+                              readRanges.end());
+                break;
+            }
+            case LIBCURVE_OP_WRITE:
+                MetricHelper::IncremUserRPSCount(fileMetric_, OpType::WRITE);
+                break;
+            default:
+                MetricHelper::IncremUserRPSCount(fileMetric_,
+                                                 OpType::DISCARD);
+                break;
+        }
+
+        if (ctx->op == LIBCURVE_OP_DISCARD && !IsNeedDiscard(ctx->length)) {
+            ctx->ret = 0;
+            ctx->cb(ctx);
+            continue;
+        }
+
+        IOTracker* tracker = NewAioTracker(ctx, dataType);
+        if (tracker != nullptr) {
+            trackers.emplace_back(ctx, tracker);
+        }
+    }
+
+    if (trackers.empty()) {
+        return LIBCURVE_ERROR::OK;
+    }
+
+    // start all requests in one task, so the task thread is woken up once
+    auto task = [this, mdsclient, trackers, ranges]() {
+        for (const auto& tracker : trackers) {
+            StartAioTracker(tracker.second, tracker.first, mdsclient);
+        }
+        StartReadahead(ranges, mdsclient);
+    };
+
+    taskPool_.Enqueue(task);
+    return LIBCURVE_ERROR::OK;
+}
+
+IOTracker* IOManager4File::NewAioTracker(CurveAioContext* ctx,
+                                         UserDataType dataType) {
+    IOTracker* tracker = nullptr;
+    if (ctx->op == LIBCURVE_OP_DISCARD) {
+        tracker = ObjectPool<IOTracker>::GetInstance()->New(
+            this, &mc_, scheduler_, fileMetric_);
+    } else {
+        tracker = ObjectPool<IOTracker>::GetInstance()->New(
+            this, &mc_, scheduler_, fileMetric_, disableStripe_);
+    }
+
+    if (tracker == nullptr) {
+        ctx->ret = -LIBCURVE_ERROR::FAILED;
+        ctx->cb(ctx);
+        LOG(ERROR) << "allocate tracker failed!";
+        return nullptr;
+    }
+
+    tracker->SetUserDataType(dataType);
+    tracker->SetReadCache(readCache_.get());
+    inflightCntl_.IncremInflightNum();
+    return tracker;
+}
+
+void IOManager4File::StartAioTracker(IOTracker* tracker, CurveAioContext* ctx,
+                                     MDSClient* mdsclient) {
+    switch (ctx->op) {
+        case LIBCURVE_OP_READ:
+            tracker->StartAioRead(ctx, mdsclient, GetFileInfo(),
+                                  throttle_.get());
+            break;
+        case LIBCURVE_OP_WRITE:
+            tracker->StartAioWrite(ctx, mdsclient, GetFileInfo(),
+                                   throttle_.get());
+            break;
+        default:
+            tracker->StartAioDiscard(ctx, mdsclient, GetFileInfo(),
+                                     discardTaskManager_.get());
+            break;
+    }
+}
+
+void IOManager4File::GetReadaheadRanges(off_t offset, size_t length,
+                                        std::vector<ReadaheadRange>* ranges) {
+    if (readahead_ == nullptr) {
+        return;
+    }
+
+    const FInfo* fileInfo = GetFileInfo();
+    readahead_->OnRead(offset, length, fileInfo->length, fileInfo->chunksize,
+                       ioopt_.readCacheOpt.blockSize, ranges);
+}
+
+void IOManager4File::StartReadahead(const std::vector<ReadaheadRange>& ranges,
+                                    MDSClient* mdsclient) {
+    for (const auto& range : ranges) {
+        ReadaheadContext* ctx = new (std::nothrow) ReadaheadContext();
+        IOTracker* tracker = ObjectPool<IOTracker>::GetInstance()->New(
+            this, &mc_, scheduler_, fileMetric_, disableStripe_);
+        if (ctx == nullptr || tracker == nullptr) {
+            LOG(ERROR) << "allocate readahead tracker failed!";
+            readahead_->OnPrefetchDone(range.length);
+            delete ctx;
+            ObjectPool<IOTracker>::GetInstance()->Delete(tracker);
+            continue;
+        }
+
+        ctx->offset = range.offset;
+        ctx->length = range.length;
+        ctx->ret = 0;
+        ctx->op = LIBCURVE_OP_READ;
+        ctx->cb = ReadaheadCallback;
+        ctx->buf = &ctx->data;
+        ctx->readahead = readahead_.get();
+
+        tracker->SetUserDataType(UserDataType::IOBuffer);
+        tracker->SetReadCache(readCache_.get());
+        tracker->SetReadahead();
+        inflightCntl_.IncremInflightNum();
+        tracker->StartAioRead(ctx, mdsclient, GetFileInfo(), throttle_.get());
+    }
+}
+
 void IOManager4File::UpdateFileInfo(const FInfo_t& fi) {
     mc_.UpdateFileInfo(fi);
 }
@@ -290,7 +508,7 @@ void IOManager4File::SetDisableStripe() {
 
 void IOManager4File::HandleAsyncIOResponse(IOTracker* iotracker) {
     inflightCntl_.DecremInflightNum();
-    delete iotracker;
+    ObjectPool<IOTracker>::GetInstance()->Delete(iotracker);
 }
 
 bool IOManager4File::IsNeedDiscard(size_t len) const {
@@ -306,6 +524,10 @@ void IOManager4File::LeaseTimeoutBlockIO() {
     std::unique_lock<std::mutex> lk(exitMtx_);
     if (exit_ == false) {
         scheduler_->LeaseTimeoutBlockIO();
+        // other client may write the file after the lease is lost
+        if (readCache_) {
+            readCache_->Clear();
+        }
     } else {
         LOG(WARNING) << "io manager already exit, no need block io!";
     }
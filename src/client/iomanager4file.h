@@ -31,6 +31,7 @@
 #include <mutex>               // NOLINT
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "include/curve_compiler_specific.h"
 #include "src/client/client_common.h"
@@ -43,6 +44,8 @@
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/throttle.h"
 #include "src/client/discard_task.h"
+#include "src/client/read_cache.h"
+#include "src/client/readahead.h"
 
 namespace curve {
 namespace client {
@@ -127,6 +130,40 @@ class IOManager4File : public IOManager {
      */
     int AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient);
 
+    /**
+     * @brief Asynchronous vectored read
+     * @param aioctx async request context
+     * @param iov io vectors to store read data
+     * @param iovcnt number of io vectors
+     * @param mdsclient for communicate with MDS
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioReadv(CurveAioContext* aioctx, const struct iovec* iov, int iovcnt,
+                 MDSClient* mdsclient);
+
+    /**
+     * @brief Asynchronous vectored write
+     * @param aioctx async request context
+     * @param iov io vectors of write data
+     * @param iovcnt number of io vectors
+     * @param mdsclient for communicate with MDS
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioWritev(CurveAioContext* aioctx, const struct iovec* iov, int iovcnt,
+                  MDSClient* mdsclient);
+
+    /**
+     * @brief Submit a batch of asynchronous requests, all of them are started
+     *        by one task of the task thread pool
+     * @param aioctxs async request contexts
+     * @param count number of contexts
+     * @param mdsclient for communicate with MDS
+     * @param dataType type of aioctx->buf
+     * @return 0 means success, otherwise it means failure
+     */
+    int AioSubmit(CurveAioContext* aioctxs[], int count, MDSClient* mdsclient,
+                  UserDataType dataType);
+
     /**
      * @brief 获取rpc发送令牌
      */
@@ -252,6 +289,30 @@ class IOManager4File : public IOManager {
 
     bool IsNeedDiscard(size_t len) const;
 
+    /**
+     * @brief Create tracker for an asynchronous request
+     * @return the tracker, or nullptr if failed and the request is completed
+     */
+    IOTracker* NewAioTracker(CurveAioContext* aioctx, UserDataType dataType);
+
+    /**
+     * @brief Start an asynchronous request according to its op
+     */
+    void StartAioTracker(IOTracker* tracker, CurveAioContext* aioctx,
+                         MDSClient* mdsclient);
+
+    /**
+     * @brief Record a user read and get the ranges to prefetch
+     */
+    void GetReadaheadRanges(off_t offset, size_t length,
+                            std::vector<ReadaheadRange>* ranges);
+
+    /**
+     * @brief Prefetch ranges into read cache asynchronously
+     */
+    void StartReadahead(const std::vector<ReadaheadRange>& ranges,
+                        MDSClient* mdsclient);
+
  private:
     // 每个IOManager都有其IO配置，保存在iooption里
     IOOption ioopt_;
@@ -298,6 +359,12 @@ class IOManager4File : public IOManager {
     bool disableStripe_;
 
     std::unique_ptr<DiscardTaskManager> discardTaskManager_;
+
+    // read cache of the file, nullptr if disabled
+    std::unique_ptr<ReadCache> readCache_;
+
+    // sequential read detector, nullptr if readahead is disabled
+    std::unique_ptr<Readahead> readahead_;
 };
 
 }  // namespace client
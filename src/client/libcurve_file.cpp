@@ -30,6 +30,7 @@
 #include <mutex>   // NOLINT
 #include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "include/client/libcurve.h"
 #include "include/curve_compiler_specific.h"
@@ -401,6 +402,132 @@ int FileClient::AioDiscard(int fd, CurveAioContext* aioctx) {
     }
 }
 
+int FileClient::AioReadv(int fd, CurveAioContext* aioctx,
+                         const struct iovec* iov, int iovcnt) {
+    if (CheckIOVector(aioctx, iov, iovcnt) == false) {
+        LOG(ERROR) << "AioReadv request invalid, length = " << aioctx->length
+                   << ", offset = " << aioctx->offset
+                   << ", iovcnt = " << iovcnt << ", fd = " << fd;
+        return -LIBCURVE_ERROR::PARAM_ERROR;
+    }
+
+    if (aioctx->length == 0) {
+        return -LIBCURVE_ERROR::OK;
+    }
+
+    if (CheckAligned(aioctx->offset, aioctx->length) == false) {
+        LOG(ERROR) << "AioReadv request not aligned, length = "
+                   << aioctx->length << ", offset = " << aioctx->offset
+                   << ", fd = " << fd;
+        return -LIBCURVE_ERROR::NOT_ALIGNED;
+    }
+
+    ReadLockGuard lk(rwlock_);
+    auto iter = fileserviceMap_.find(fd);
+    if (CURVE_UNLIKELY(iter == fileserviceMap_.end())) {
+        LOG(ERROR) << "invalid fd!";
+        return -LIBCURVE_ERROR::BAD_FD;
+    }
+
+    return iter->second->AioReadv(aioctx, iov, iovcnt);
+}
+
+int FileClient::AioWritev(int fd, CurveAioContext* aioctx,
+                          const struct iovec* iov, int iovcnt) {
+    if (CheckIOVector(aioctx, iov, iovcnt) == false) {
+        LOG(ERROR) << "AioWritev request invalid, length = "
+                   << aioctx->length << ", offset = " << aioctx->offset
+                   << ", iovcnt = " << iovcnt << ", fd = " << fd;
+        return -LIBCURVE_ERROR::PARAM_ERROR;
+    }
+
+    if (aioctx->length == 0) {
+        return -LIBCURVE_ERROR::OK;
+    }
+
+    if (CheckAligned(aioctx->offset, aioctx->length) == false) {
+        LOG(ERROR) << "AioWritev request not aligned, length = "
+                   << aioctx->length << ", offset = " << aioctx->offset
+                   << ", fd = " << fd;
+        return -LIBCURVE_ERROR::NOT_ALIGNED;
+    }
+
+    ReadLockGuard lk(rwlock_);
+    auto iter = fileserviceMap_.find(fd);
+    if (CURVE_UNLIKELY(iter == fileserviceMap_.end())) {
+        LOG(ERROR) << "invalid fd!";
+        return -LIBCURVE_ERROR::BAD_FD;
+    }
+
+    return iter->second->AioWritev(aioctx, iov, iovcnt);
+}
+
+int FileClient::AioSubmit(int fd, CurveAioContext* aioctxs[], int count,
+                          UserDataType dataType) {
+    if (count < 0 || (count > 0 && aioctxs == nullptr)) {
+        LOG(ERROR) << "AioSubmit invalid contexts, count = " << count;
+        return -LIBCURVE_ERROR::PARAM_ERROR;
+    }
+
+    // contexts have no field to carry iovecs, use AioReadv/AioWritev instead
+    if (dataType == UserDataType::IOVector) {
+        LOG(ERROR) << "AioSubmit doesn't support io vector, fd = " << fd;
+        return -LIBCURVE_ERROR::PARAM_ERROR;
+    }
+
+    std::vector<CurveAioContext*> submits;
+    std::vector<CurveAioContext*> empties;
+    submits.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        CurveAioContext* ctx = aioctxs[i];
+        if (ctx->op >= LIBCURVE_OP_MAX) {
+            LOG(ERROR) << "AioSubmit invalid op " << ctx->op << ", fd = " << fd;
+            return -LIBCURVE_ERROR::PARAM_ERROR;
+        }
+
+        if (ctx->op == LIBCURVE_OP_DISCARD) {
+            submits.push_back(ctx);
+            continue;
+        }
+
+        if (ctx->length == 0) {
+            empties.push_back(ctx);
+            continue;
+        }
+
+        if (CheckAligned(ctx->offset, ctx->length) == false) {
+            LOG(ERROR) << "AioSubmit request not aligned, length = "
+                       << ctx->length << ", offset = " << ctx->offset
+                       << ", fd = " << fd;
+            return -LIBCURVE_ERROR::NOT_ALIGNED;
+        }
+        submits.push_back(ctx);
+    }
+
+    int ret = LIBCURVE_ERROR::OK;
+    if (!submits.empty()) {
+        ReadLockGuard lk(rwlock_);
+        auto iter = fileserviceMap_.find(fd);
+        if (CURVE_UNLIKELY(iter == fileserviceMap_.end())) {
+            LOG(ERROR) << "invalid fd!";
+            return -LIBCURVE_ERROR::BAD_FD;
+        }
+
+        ret = iter->second->AioSubmit(submits.data(), submits.size(),
+                                      dataType);
+        if (ret != LIBCURVE_ERROR::OK) {
+            return ret;
+        }
+    }
+
+    for (auto ctx : empties) {
+        ctx->ret = 0;
+        ctx->cb(ctx);
+    }
+
+    return ret;
+}
+
 int FileClient::Rename(const UserInfo_t& userinfo,
     const std::string& oldpath, const std::string& newpath) {
     LIBCURVE_ERROR ret;
@@ -803,6 +930,35 @@ int AioDiscard(int fd, CurveAioContext* aioctx) {
     return globalclient->AioDiscard(fd, aioctx);
 }
 
+int AioReadv(int fd, CurveAioContext* aioctx,
+             const struct iovec* iov, int iovcnt) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "Not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioReadv(fd, aioctx, iov, iovcnt);
+}
+
+int AioWritev(int fd, CurveAioContext* aioctx,
+              const struct iovec* iov, int iovcnt) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "Not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioWritev(fd, aioctx, iov, iovcnt);
+}
+
+int AioSubmit(int fd, CurveAioContext* aioctxs[], int count) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "Not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioSubmit(fd, aioctxs, count);
+}
+
 int Create(const char* filename, const C_UserInfo_t* userinfo, size_t size) {
     if (globalclient == nullptr) {
         LOG(ERROR) << "not inited!";
@@ -187,6 +187,43 @@ class FileClient {
      */
     virtual int AioDiscard(int fd, CurveAioContext* aioctx);
 
+    /**
+     * @brief Asynchronous vectored read
+     * @param fd file descriptor
+     * @param aioctx async request context, buf is ignored and length must be
+     *        the total length of iov
+     * @param iov io vectors to store read data
+     * @param iovcnt number of io vectors
+     * @return 0 means success, otherwise it means failure
+     */
+    virtual int AioReadv(int fd, CurveAioContext* aioctx,
+                         const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Asynchronous vectored write
+     * @param fd file descriptor
+     * @param aioctx async request context, buf is ignored and length must be
+     *        the total length of iov
+     * @param iov io vectors of write data
+     * @param iovcnt number of io vectors
+     * @return 0 means success, otherwise it means failure
+     */
+    virtual int AioWritev(int fd, CurveAioContext* aioctx,
+                          const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Submit a batch of asynchronous requests, read and write requests
+     *        of length 0 are completed immediately
+     * @param fd file descriptor
+     * @param aioctxs async request contexts
+     * @param count number of contexts
+     * @param dataType type of aioctx->buf, default is `UserDataType::RawBuffer`,
+     *        `UserDataType::IOVector` is rejected with PARAM_ERROR
+     * @return 0 means all requests are submitted, otherwise none of them is
+     */
+    virtual int AioSubmit(int fd, CurveAioContext* aioctxs[], int count,
+                          UserDataType dataType = UserDataType::RawBuffer);
+
     /**
      * 重命名文件
      * @param: userinfo是用户信息
@@ -323,6 +360,19 @@ class FileClient {
                (length % IO_ALIGNED_BLOCK_SIZE == 0);
     }
 
+    // length of aioctx must be the total length of iov
+    bool CheckIOVector(const CurveAioContext* aioctx, const struct iovec* iov,
+                       int iovcnt) const {
+        if (iovcnt < 0 || (iovcnt > 0 && iov == nullptr)) {
+            return false;
+        }
+        size_t length = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            length += iov[i].iov_len;
+        }
+        return length == aioctx->length;
+    }
+
  private:
     BthreadRWLock rwlock_;
 
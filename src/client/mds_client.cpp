@@ -886,15 +886,43 @@ LIBCURVE_ERROR MDSClient::SetCloneFileStatus(const std::string& filename,
     return rpcExcutor.DoRPCTask(task, metaServerOpt_.mdsMaxRetryMS);
 }
 
+static void PageFileSegment2SegmentInfo(const PageFileSegment& pfs,
+                                        SegmentInfo* segInfo) {
+    segInfo->chunksize = pfs.chunksize();
+    segInfo->segmentsize = pfs.segmentsize();
+    segInfo->startoffset = pfs.startoffset();
+    LogicPoolID logicpoolid = pfs.logicalpoolid();
+    segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
+
+    for (int i = 0; i < pfs.chunks_size(); i++) {
+        ChunkID chunkid = pfs.chunks(i).chunkid();
+        CopysetID copysetid = pfs.chunks(i).copysetid();
+        segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
+        segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
+    }
+}
+
 LIBCURVE_ERROR MDSClient::GetOrAllocateSegment(bool allocate,
                                                uint64_t offset,
                                                const FInfo_t* fi,
                                                SegmentInfo* segInfo) {
+    std::vector<SegmentInfo> segInfos;
+    LIBCURVE_ERROR ret =
+        GetOrAllocateSegments(allocate, offset, fi, 1, &segInfos);
+    if (ret == LIBCURVE_ERROR::OK) {
+        *segInfo = std::move(segInfos[0]);
+    }
+    return ret;
+}
+
+LIBCURVE_ERROR MDSClient::GetOrAllocateSegments(
+    bool allocate, uint64_t offset, const FInfo_t* fi, uint32_t segmentNum,
+    std::vector<SegmentInfo>* segInfos) {
     auto task = RPCTaskDefine {
         GetOrAllocateSegmentResponse response;
         mdsClientMetric_.getOrAllocateSegment.qps.count << 1;
         LatencyGuard lg(&mdsClientMetric_.getOrAllocateSegment.latency);
-        MDSClientBase::GetOrAllocateSegment(allocate, offset, fi,
+        MDSClientBase::GetOrAllocateSegment(allocate, offset, fi, segmentNum,
                                             &response, cntl, channel);
         if (cntl->Failed()) {
             mdsClientMetric_.getOrAllocateSegment.eps.count << 1;
@@ -923,25 +951,19 @@ LIBCURVE_ERROR MDSClient::GetOrAllocateSegment(bool allocate,
             default: break;
         }
 
-        PageFileSegment pfs = response.pagefilesegment();
-        segInfo->chunksize = pfs.chunksize();
-        segInfo->segmentsize = pfs.segmentsize();
-        segInfo->startoffset = pfs.startoffset();
-        LogicPoolID logicpoolid = pfs.logicalpoolid();
-        segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
-
-        int chunksNum = pfs.chunks_size();
-        if (allocate && chunksNum <= 0) {
+        const PageFileSegment& pfs = response.pagefilesegment();
+        if (allocate && pfs.chunks_size() <= 0) {
             LOG(WARNING) << "MDS allocate segment, but no chunkinfo!";
             // Now, we will retry until allocate segment success
             return -LIBCURVE_ERROR::RETRY_UNTIL_SUCCESS;
         }
 
-        for (int i = 0; i < chunksNum; i++) {
-            ChunkID chunkid = pfs.chunks(i).chunkid();
-            CopysetID copysetid = pfs.chunks(i).copysetid();
-            segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
-            segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
+        segInfos->clear();
+        segInfos->resize(1 + response.extrasegments_size());
+        PageFileSegment2SegmentInfo(pfs, &(*segInfos)[0]);
+        for (int i = 0; i < response.extrasegments_size(); i++) {
+            PageFileSegment2SegmentInfo(response.extrasegments(i),
+                                        &(*segInfos)[i + 1]);
         }
         return LIBCURVE_ERROR::OK;
     };
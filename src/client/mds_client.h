@@ -124,6 +124,23 @@ class MDSClient : public MDSClientBase,
                                         const FInfo_t* fi,
                                         SegmentInfo* segInfo);
 
+    /**
+     * 获取从offset开始的segmentNum个segment的chunk信息，mds在一个事务中分配
+     * 不存在的segment
+     * @param: allocate为true的时候mds端发现不存在就分配，为false的时候不分配
+     * @param: offset为文件整体偏移
+     * @param: fi是当前文件的基本信息
+     * @param: segmentNum为获取的segment数量，mds会按文件长度截断
+     * @param[out]: segInfos按offset排序，第一个为offset所在的segment，
+     *              之后未分配的segment不返回
+     * @return: 同GetOrAllocateSegment
+     */
+    LIBCURVE_ERROR GetOrAllocateSegments(bool allocate,
+                                         uint64_t offset,
+                                         const FInfo_t* fi,
+                                         uint32_t segmentNum,
+                                         std::vector<SegmentInfo>* segInfos);
+
     /**
      * @brief Send DeAllocateSegment request to current working MDS
      * @param fileInfo current file info
@@ -349,6 +349,7 @@ void MDSClientBase::SetCloneFileStatus(const std::string& filename,
 void MDSClientBase::GetOrAllocateSegment(bool allocate,
                                          uint64_t offset,
                                          const FInfo_t* fi,
+                                         uint32_t segmentNum,
                                          GetOrAllocateSegmentResponse* response,
                                          brpc::Controller* cntl,
                                          brpc::Channel* channel) {
@@ -361,11 +362,15 @@ void MDSClientBase::GetOrAllocateSegment(bool allocate,
     request.set_filename(fi->fullPathName);
     request.set_offset(seg_offset);
     request.set_allocateifnotexist(allocate);
+    if (segmentNum > 1) {
+        request.set_segmentnum(segmentNum);
+    }
     FillUserInfo(&request, fi->userinfo);
 
     LOG(INFO) << "GetOrAllocateSegment: filename = " << fi->fullPathName
               << ", allocate = " << allocate << ", owner = " << fi->owner
               << ", offset = " << offset << ", segment offset = " << seg_offset
+              << ", segment num = " << segmentNum
               << ", log id = " << cntl->log_id();
 
     curve::mds::CurveFSService_Stub stub(channel);
@@ -316,6 +316,8 @@ class MDSClientBase {
      * @param: allocate为true的时候mds端发现不存在就分配，为false的时候不分配
      * @param: offset为文件整体偏移
      * @param: fi是当前文件的基本信息
+     * @param: segmentNum为从offset开始获取的segment数量，
+     *         大于1时mds在一个事务中分配
      * @param[out]: response为该rpc的response，提供给外部处理
      * @param[in|out]: cntl既是入参，也是出参，返回RPC状态
      * @param[in]:channel是当前与mds建立的通道
@@ -323,6 +325,7 @@ class MDSClientBase {
     void GetOrAllocateSegment(bool allocate,
                               uint64_t offset,
                               const FInfo_t* fi,
+                              uint32_t segmentNum,
                               GetOrAllocateSegmentResponse* response,
                               brpc::Controller* cntl,
                               brpc::Channel* channel);
@@ -55,12 +55,22 @@ void MetaCache::Init(const MetaCacheOption& metaCacheOpt,
     unstableHelper_.Init(metacacheopt_.chunkserverUnstableOption);
 }
 
+void MetaCache::UpdateFileInfo(const FInfo& fileInfo) {
+    fileInfo_ = fileInfo;
+
+    if (fileInfo.chunksize != 0) {
+        chunkIndexTable_.Reserve(fileInfo.length / fileInfo.chunksize);
+    }
+
+    if (fileInfo.segmentsize != 0) {
+        std::lock_guard<std::mutex> lk(segmentMtx_);
+        segments_.Reserve(fileInfo.length / fileInfo.segmentsize);
+    }
+}
+
 MetaCacheErrorType MetaCache::GetChunkInfoByIndex(ChunkIndex chunkidx,
                                                   ChunkIDInfo* chunxinfo) {
-    ReadLockGuard rdlk(rwlock4ChunkInfo_);
-    auto iter = chunkindex2idMap_.find(chunkidx);
-    if (iter != chunkindex2idMap_.end()) {
-        *chunxinfo = iter->second;
+    if (chunkIndexTable_.Get(chunkidx, chunxinfo)) {
         return MetaCacheErrorType::OK;
     }
     return MetaCacheErrorType::CHUNKINFO_NOT_FOUND;
@@ -68,23 +78,19 @@ MetaCacheErrorType MetaCache::GetChunkInfoByIndex(ChunkIndex chunkidx,
 
 void MetaCache::UpdateChunkInfoByIndex(ChunkIndex cindex,
                                        const ChunkIDInfo& cinfo) {
-    WriteLockGuard wrlk(rwlock4ChunkInfo_);
-    chunkindex2idMap_[cindex] = cinfo;
+    chunkIndexTable_.Update(cindex, cinfo);
 }
 
 bool MetaCache::IsLeaderMayChange(LogicPoolID logicPoolId,
                                   CopysetID copysetId) {
-    rwlock4ChunkInfo_.RDLock();
+    ReadLockGuard rdlk(rwlock4CopysetInfo_);
     auto iter = lpcsid2CopsetInfoMap_.find(
         CalcLogicPoolCopysetID(logicPoolId, copysetId));
     if (iter == lpcsid2CopsetInfoMap_.end()) {
-        rwlock4ChunkInfo_.Unlock();
         return false;
     }
 
-    bool flag = iter->second.LeaderMayChange();
-    rwlock4ChunkInfo_.Unlock();
-    return flag;
+    return iter->second.LeaderMayChange();
 }
 
 int MetaCache::GetLeader(LogicPoolID logicPoolId,
@@ -95,6 +101,11 @@ int MetaCache::GetLeader(LogicPoolID logicPoolId,
                          FileMetric* fm) {
     const auto key = CalcLogicPoolCopysetID(logicPoolId, copysetId);
 
+    // 缓存中的leader都是确定且不需要刷新的，命中时直接返回
+    if (!refresh && leaderCache_.Get(key, serverId, serverAddr)) {
+        return 0;
+    }
+
     CopysetInfo targetInfo;
     rwlock4CopysetInfo_.RDLock();
     auto iter = lpcsid2CopsetInfoMap_.find(key);
@@ -105,6 +116,9 @@ int MetaCache::GetLeader(LogicPoolID logicPoolId,
         return -1;
     }
     targetInfo = iter->second;
+    if (!refresh && !targetInfo.LeaderMayChange()) {
+        PublishLeader(key, &iter->second);
+    }
     rwlock4CopysetInfo_.Unlock();
 
     int ret = 0;
@@ -264,14 +278,38 @@ int MetaCache::UpdateLeader(LogicPoolID logicPoolId,
     }
 
     ChunkServerAddr csAddr(leaderAddr);
-    return iter->second.UpdateLeaderInfo(csAddr);
+    std::lock_guard<std::mutex> lk(leaderCache_.GetMutex());
+    int ret = iter->second.UpdateLeaderInfo(csAddr);
+    if (ret == 0) {
+        PublishLeaderLocked(key, &iter->second);
+    }
+    return ret;
 }
 
 void MetaCache::UpdateCopysetInfo(LogicPoolID logicPoolid, CopysetID copysetid,
                                   const CopysetInfo& csinfo) {
     const auto key = CalcLogicPoolCopysetID(logicPoolid, copysetid);
     WriteLockGuard wrlk(rwlock4CopysetInfo_);
-    lpcsid2CopsetInfoMap_[key] = csinfo;
+    CopysetInfo& cpinfo = lpcsid2CopsetInfoMap_[key];
+    cpinfo = csinfo;
+    PublishLeader(key, &cpinfo);
+}
+
+void MetaCache::PublishLeader(LogicPoolCopysetID key, CopysetInfo* cpinfo) {
+    std::lock_guard<std::mutex> lk(leaderCache_.GetMutex());
+    PublishLeaderLocked(key, cpinfo);
+}
+
+void MetaCache::PublishLeaderLocked(LogicPoolCopysetID key,
+                                    CopysetInfo* cpinfo) {
+    ChunkServerID leaderId = 0;
+    EndPoint leaderAddr;
+    if (!cpinfo->LeaderMayChange() &&
+        cpinfo->GetLeaderInfo(&leaderId, &leaderAddr) == 0) {
+        leaderCache_.PutLocked(key, leaderId, leaderAddr);
+    } else {
+        leaderCache_.InvalidateLocked(key);
+    }
 }
 
 void MetaCache::UpdateAppliedIndex(LogicPoolID logicPoolId,
@@ -336,8 +374,10 @@ void MetaCache::SetChunkserverUnstable(ChunkServerID csid) {
     }
 
     ReadLockGuard rdlk(rwlock4CopysetInfo_);
+    std::lock_guard<std::mutex> lk(leaderCache_.GetMutex());
     for (auto it : copysetIDSet) {
         const auto key = CalcLogicPoolCopysetID(it.lpid, it.cpid);
+        leaderCache_.InvalidateLocked(key);
         auto cpinfo = lpcsid2CopsetInfoMap_.find(key);
         if (cpinfo != lpcsid2CopsetInfoMap_.end()) {
             ChunkServerID leaderid;
@@ -415,37 +455,30 @@ CopysetInfo MetaCache::GetCopysetinfo(LogicPoolID lpid, CopysetID csid) {
 }
 
 FileSegment* MetaCache::GetFileSegment(SegmentIndex segmentIndex) {
-    {
-        ReadLockGuard lk(rwlock4Segments_);
-        auto iter = segments_.find(segmentIndex);
-        if (iter != segments_.end()) {
-            return &iter->second;
-        }
+    FileSegment* segment = segments_.Get(segmentIndex);
+    if (segment != nullptr) {
+        return segment;
     }
 
-    WriteLockGuard lk(rwlock4Segments_);
-    auto ret = segments_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(segmentIndex),
-        std::forward_as_tuple(segmentIndex,
-                              fileInfo_.segmentsize,
-                              metacacheopt_.discardGranularity));
+    std::lock_guard<std::mutex> lk(segmentMtx_);
+    segment = segments_.Get(segmentIndex);
+    if (segment != nullptr) {
+        return segment;
+    }
 
-    return &(ret.first->second);
+    return segments_.Set(segmentIndex,
+                         new FileSegment(segmentIndex,
+                                         fileInfo_.segmentsize,
+                                         metacacheopt_.discardGranularity));
 }
 
 void MetaCache::CleanChunksInSegment(SegmentIndex segmentIndex) {
-    WriteLockGuard lk(rwlock4chunkInfoMap_);
     ChunkIndex beginChunkIndex = static_cast<uint64_t>(segmentIndex) *
                                  fileInfo_.segmentsize / fileInfo_.chunksize;
     ChunkIndex endChunkIndex = static_cast<uint64_t>(segmentIndex + 1) *
                                fileInfo_.segmentsize / fileInfo_.chunksize;
 
-    auto currentIndex = beginChunkIndex;
-    while (currentIndex < endChunkIndex) {
-        chunkindex2idMap_.erase(currentIndex);
-        ++currentIndex;
-    }
+    chunkIndexTable_.Erase(beginChunkIndex, endChunkIndex);
 }
 
 }   // namespace client
@@ -22,6 +22,7 @@
 #ifndef SRC_CLIENT_METACACHE_H_
 #define SRC_CLIENT_METACACHE_H_
 
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -30,6 +31,7 @@
 #include "src/client/client_config.h"
 #include "src/client/client_metric.h"
 #include "src/client/mds_client.h"
+#include "src/client/metacache_index.h"
 #include "src/client/metacache_struct.h"
 #include "src/client/service_helper.h"
 #include "src/client/unstable_helper.h"
@@ -53,7 +55,6 @@ class MetaCache {
     using LogicPoolCopysetID = uint64_t;
     using ChunkInfoMap = std::unordered_map<ChunkID, ChunkIDInfo>;
     using CopysetInfoMap = std::unordered_map<LogicPoolCopysetID, CopysetInfo>;
-    using ChunkIndexInfoMap = std::unordered_map<ChunkIndex, ChunkIDInfo>;
 
     MetaCache() = default;
     virtual ~MetaCache() = default;
@@ -206,9 +207,10 @@ class MetaCache {
     virtual void UpdateChunkserverCopysetInfo(LogicPoolID lpid,
                                               const CopysetInfo& cpinfo);
 
-    void UpdateFileInfo(const FInfo& fileInfo) {
-        fileInfo_ = fileInfo;
-    }
+    /**
+     * 更新文件信息，并按文件长度预分配chunk索引表和segment表
+     */
+    void UpdateFileInfo(const FInfo& fileInfo);
 
     const FInfo* GetFileInfo() const {
         return &fileInfo_;
@@ -290,15 +292,29 @@ class MetaCache {
         CopysetID copysetId,
         const ChunkServerAddr& leaderAddr);
 
+    /**
+     * 根据copyset信息更新leader缓存，leader未知或者可能变更时从缓存中删除
+     * 调用者需要持有rwlock4CopysetInfo_
+     * @param: key为copyset对应的key
+     * @param: cpinfo为当前metacache中的copyset信息
+     */
+    void PublishLeader(LogicPoolCopysetID key, CopysetInfo* cpinfo);
+    void PublishLeaderLocked(LogicPoolCopysetID key, CopysetInfo* cpinfo);
+
  private:
     MDSClient*          mdsclient_;
     MetaCacheOption   metacacheopt_;
 
-    // chunkindex到chunkidinfo的映射表
-    CURVE_CACHELINE_ALIGNMENT ChunkIndexInfoMap     chunkindex2idMap_;
+    // chunkindex到chunkidinfo的映射表，查询无锁
+    CURVE_CACHELINE_ALIGNMENT ChunkIndexTable       chunkIndexTable_;
+
+    // segmentindex到segment的映射表，查询无锁，segmentMtx_串行化插入
+    CURVE_CACHELINE_ALIGNMENT std::mutex segmentMtx_;
+    CURVE_CACHELINE_ALIGNMENT AtomicPtrArray<FileSegment> segments_;
 
-    CURVE_CACHELINE_ALIGNMENT RWLock rwlock4Segments_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<SegmentIndex, FileSegment> segments_;  // NOLINT
+    // copyset的leader缓存，查询无锁
+    // 写操作在持有rwlock4CopysetInfo_时进行，以保证与copyset信息一致
+    CURVE_CACHELINE_ALIGNMENT LeaderCache           leaderCache_;
 
     // logicalpoolid和copysetid到copysetinfo的映射表
     CURVE_CACHELINE_ALIGNMENT CopysetInfoMap        lpcsid2CopsetInfoMap_;
@@ -306,9 +322,8 @@ class MetaCache {
     // chunkid到chunkidinfo的映射表
     CURVE_CACHELINE_ALIGNMENT ChunkInfoMap          chunkid2chunkInfoMap_;
 
-    // 三个读写锁分别保护上述三个映射表
+    // 两个读写锁分别保护上述两个映射表
     CURVE_CACHELINE_ALIGNMENT RWLock    rwlock4chunkInfoMap_;
-    CURVE_CACHELINE_ALIGNMENT RWLock    rwlock4ChunkInfo_;
     CURVE_CACHELINE_ALIGNMENT RWLock    rwlock4CopysetInfo_;
 
     // chunkserverCopysetIDMap_存放当前chunkserver到copyset的映射
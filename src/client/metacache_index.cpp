@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Tue Dec 29 14:06:31 CST 2020
+ * Author: wuhanqing
+ */
+
+#include "src/client/metacache_index.h"
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint32_t kSlotValid = 1;
+const uint32_t kSlotChunkExist = 2;
+
+}  // namespace
+
+const uint32_t ChunkIndexTable::kChunksPerBlock;
+const uint32_t LeaderCache::kSlotBits;
+
+void ChunkIndexTable::Reserve(uint64_t chunkCount) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    blocks_.Reserve((chunkCount + kChunksPerBlock - 1) / kChunksPerBlock);
+}
+
+bool ChunkIndexTable::Get(ChunkIndex index, ChunkIDInfo* info) const {
+    const Block* block = blocks_.Get(index / kChunksPerBlock);
+    if (block == nullptr) {
+        return false;
+    }
+
+    const Slot& slot = block->slots[index % kChunksPerBlock];
+    uint32_t seq = 0;
+    uint32_t flags = 0;
+    uint64_t cid = 0;
+    uint64_t lpcpid = 0;
+    do {
+        seq = slot.seq.load(std::memory_order_acquire);
+        flags = slot.flags.load(std::memory_order_relaxed);
+        cid = slot.cid.load(std::memory_order_relaxed);
+        lpcpid = slot.lpcpid.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 ||
+             seq != slot.seq.load(std::memory_order_relaxed));
+
+    if ((flags & kSlotValid) == 0) {
+        return false;
+    }
+
+    info->cid_ = cid;
+    info->lpid_ = static_cast<LogicPoolID>(lpcpid >> 32);
+    info->cpid_ = static_cast<CopysetID>(lpcpid);
+    info->chunkExist = (flags & kSlotChunkExist) != 0;
+    return true;
+}
+
+void ChunkIndexTable::Update(ChunkIndex index, const ChunkIDInfo& info) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    const uint64_t blockIndex = index / kChunksPerBlock;
+    Block* block = blocks_.Get(blockIndex);
+    if (block == nullptr) {
+        block = blocks_.Set(blockIndex, new Block());
+    }
+
+    uint32_t flags = kSlotValid | (info.chunkExist ? kSlotChunkExist : 0);
+    uint64_t lpcpid = (static_cast<uint64_t>(info.lpid_) << 32) | info.cpid_;
+    WriteSlot(&block->slots[index % kChunksPerBlock], flags, info.cid_,
+              lpcpid);
+}
+
+void ChunkIndexTable::Erase(ChunkIndex begin, ChunkIndex end) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (ChunkIndex index = begin; index < end; ++index) {
+        Block* block = blocks_.Get(index / kChunksPerBlock);
+        if (block == nullptr) {
+            // skip to the next block
+            index = (index / kChunksPerBlock + 1) * kChunksPerBlock - 1;
+            continue;
+        }
+        WriteSlot(&block->slots[index % kChunksPerBlock], 0, 0, 0);
+    }
+}
+
+void ChunkIndexTable::WriteSlot(Slot* slot, uint32_t flags, uint64_t cid,
+                                uint64_t lpcpid) {
+    const uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->flags.store(flags, std::memory_order_relaxed);
+    slot->cid.store(cid, std::memory_order_relaxed);
+    slot->lpcpid.store(lpcpid, std::memory_order_relaxed);
+    slot->seq.store(seq + 2, std::memory_order_release);
+}
+
+LeaderCache::LeaderCache() : slots_(new Slot[1 << kSlotBits]) {}
+
+bool LeaderCache::Get(uint64_t key, ChunkServerID* leaderId,
+                      butil::EndPoint* leaderAddr) const {
+    const Slot& slot = GetSlot(key);
+    uint32_t seq = 0;
+    uint64_t slotKey = 0;
+    uint32_t id = 0;
+    uint32_t ip = 0;
+    uint32_t port = 0;
+    do {
+        seq = slot.seq.load(std::memory_order_acquire);
+        slotKey = slot.key.load(std::memory_order_relaxed);
+        id = slot.leaderId.load(std::memory_order_relaxed);
+        ip = slot.ip.load(std::memory_order_relaxed);
+        port = slot.port.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 ||
+             seq != slot.seq.load(std::memory_order_relaxed));
+
+    if (slotKey != key) {
+        return false;
+    }
+
+    *leaderId = id;
+    *leaderAddr = butil::EndPoint(butil::int2ip(ip), static_cast<int>(port));
+    return true;
+}
+
+void LeaderCache::Put(uint64_t key, ChunkServerID leaderId,
+                      const butil::EndPoint& leaderAddr) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    PutLocked(key, leaderId, leaderAddr);
+}
+
+void LeaderCache::Invalidate(uint64_t key) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    InvalidateLocked(key);
+}
+
+void LeaderCache::PutLocked(uint64_t key, ChunkServerID leaderId,
+                            const butil::EndPoint& leaderAddr) {
+    WriteSlot(GetSlot(key), key, leaderId, butil::ip2int(leaderAddr.ip),
+              static_cast<uint32_t>(leaderAddr.port));
+}
+
+void LeaderCache::InvalidateLocked(uint64_t key) {
+    Slot* slot = GetSlot(key);
+    if (slot->key.load(std::memory_order_relaxed) == key) {
+        WriteSlot(slot, 0, 0, 0, 0);
+    }
+}
+
+void LeaderCache::WriteSlot(Slot* slot, uint64_t key, uint32_t leaderId,
+                            uint32_t ip, uint32_t port) {
+    const uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->key.store(key, std::memory_order_relaxed);
+    slot->leaderId.store(leaderId, std::memory_order_relaxed);
+    slot->ip.store(ip, std::memory_order_relaxed);
+    slot->port.store(port, std::memory_order_relaxed);
+    slot->seq.store(seq + 2, std::memory_order_release);
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,266 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Tue Dec 29 14:06:31 CST 2020
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_CLIENT_METACACHE_INDEX_H_
+#define SRC_CLIENT_METACACHE_INDEX_H_
+
+#include <butil/endpoint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "src/client/client_common.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * Array of atomic pointers which is looked up without any lock.
+ *
+ * Pointees are owned by the array and live until it is destroyed. When the
+ * array grows, a larger copy is published and the old one is retired until
+ * destruction, because readers may still be walking it. The array grows at
+ * least twice as large every time, so retired copies take at most as much
+ * memory as the current one.
+ *
+ * Writers must be serialized by the caller.
+ */
+template <typename T>
+class AtomicPtrArray {
+ public:
+    AtomicPtrArray() : current_(nullptr) {}
+
+    ~AtomicPtrArray() {
+        Version* version = current_.load(std::memory_order_relaxed);
+        if (version != nullptr) {
+            for (uint64_t i = 0; i < version->size; ++i) {
+                delete version->ptrs[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    AtomicPtrArray(const AtomicPtrArray&) = delete;
+    AtomicPtrArray& operator=(const AtomicPtrArray&) = delete;
+
+    /**
+     * @brief Get the pointer at index
+     * @return the pointer, nullptr if it is not set yet
+     */
+    T* Get(uint64_t index) const {
+        const Version* version = current_.load(std::memory_order_acquire);
+        if (version == nullptr || index >= version->size) {
+            return nullptr;
+        }
+        return version->ptrs[index].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Set the pointer at index if it is not set yet
+     * @return the pointer at index, ptr is deleted if it is already set
+     */
+    T* Set(uint64_t index, T* ptr) {
+        Reserve(index + 1);
+        Version* version = current_.load(std::memory_order_relaxed);
+        T* exist = version->ptrs[index].load(std::memory_order_relaxed);
+        if (exist != nullptr) {
+            delete ptr;
+            return exist;
+        }
+        version->ptrs[index].store(ptr, std::memory_order_release);
+        return ptr;
+    }
+
+    /**
+     * @brief Make the array hold at least size pointers
+     */
+    void Reserve(uint64_t size) {
+        Version* version = current_.load(std::memory_order_relaxed);
+        uint64_t current = version != nullptr ? version->size : 0;
+        if (size <= current) {
+            return;
+        }
+
+        std::unique_ptr<Version> grown(
+            new Version(std::max(size, current * 2)));
+        for (uint64_t i = 0; i < current; ++i) {
+            grown->ptrs[i].store(
+                version->ptrs[i].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        }
+        current_.store(grown.get(), std::memory_order_release);
+        versions_.push_back(std::move(grown));
+    }
+
+    uint64_t Size() const {
+        const Version* version = current_.load(std::memory_order_acquire);
+        return version != nullptr ? version->size : 0;
+    }
+
+ private:
+    struct Version {
+        explicit Version(uint64_t n)
+            : size(n), ptrs(new std::atomic<T*>[n]) {
+            for (uint64_t i = 0; i < n; ++i) {
+                ptrs[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        const uint64_t size;
+        std::unique_ptr<std::atomic<T*>[]> ptrs;
+    };
+
+    std::atomic<Version*> current_;
+    // all published versions, the last one is current
+    std::vector<std::unique_ptr<Version>> versions_;
+};
+
+/**
+ * Chunk index to ChunkIDInfo table of a file.
+ *
+ * Chunks are grouped into fixed size blocks published by an AtomicPtrArray,
+ * and every chunk is a seqlock protected slot, so lookups neither take a
+ * lock nor write any shared cache line. Blocks are never freed before the
+ * table, a cleaned chunk only has its slot reset.
+ */
+class ChunkIndexTable {
+ public:
+    ChunkIndexTable() = default;
+
+    ChunkIndexTable(const ChunkIndexTable&) = delete;
+    ChunkIndexTable& operator=(const ChunkIndexTable&) = delete;
+
+    /**
+     * @brief Size the table for chunkCount chunks
+     */
+    void Reserve(uint64_t chunkCount);
+
+    /**
+     * @brief Get chunk info of the index
+     * @return true if found, otherwise false
+     */
+    bool Get(ChunkIndex index, ChunkIDInfo* info) const;
+
+    void Update(ChunkIndex index, const ChunkIDInfo& info);
+
+    /**
+     * @brief Remove chunks in [begin, end)
+     */
+    void Erase(ChunkIndex begin, ChunkIndex end);
+
+ private:
+    static const uint32_t kChunksPerBlock = 64;
+
+    struct Slot {
+        // odd while the slot is being written
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> flags{0};
+        std::atomic<uint64_t> cid{0};
+        // logical pool id and copyset id
+        std::atomic<uint64_t> lpcpid{0};
+    };
+
+    struct Block {
+        Slot slots[kChunksPerBlock];
+    };
+
+    void WriteSlot(Slot* slot, uint32_t flags, uint64_t cid, uint64_t lpcpid);
+
+ private:
+    // serialize writers
+    std::mutex mtx_;
+    AtomicPtrArray<Block> blocks_;
+};
+
+/**
+ * Direct mapped cache of copyset leaders.
+ *
+ * It only holds leaders which are known and not likely to change, so that
+ * a hit can be used without checking the copyset info. A missed lookup falls
+ * back to the copyset info, and two copysets mapped to the same slot just
+ * evict each other. Lookups are lock free as ChunkIndexTable.
+ */
+class LeaderCache {
+ public:
+    LeaderCache();
+
+    LeaderCache(const LeaderCache&) = delete;
+    LeaderCache& operator=(const LeaderCache&) = delete;
+
+    /**
+     * @brief Get leader of a copyset
+     * @param key key of the copyset, it can't be 0
+     * @return true if found, otherwise false
+     */
+    bool Get(uint64_t key, ChunkServerID* leaderId,
+             butil::EndPoint* leaderAddr) const;
+
+    void Put(uint64_t key, ChunkServerID leaderId,
+             const butil::EndPoint& leaderAddr);
+
+    void Invalidate(uint64_t key);
+
+    // writers that have to check other states before updating the cache
+    // hold the lock across the check and the update
+    std::mutex& GetMutex() {
+        return mtx_;
+    }
+
+    void PutLocked(uint64_t key, ChunkServerID leaderId,
+                   const butil::EndPoint& leaderAddr);
+
+    void InvalidateLocked(uint64_t key);
+
+ private:
+    static const uint32_t kSlotBits = 12;
+
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> leaderId{0};
+        // key of the cached copyset, 0 if the slot is empty
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint32_t> ip{0};
+        std::atomic<uint32_t> port{0};
+    };
+
+    const Slot& GetSlot(uint64_t key) const {
+        return slots_[(key * 0x9E3779B97F4A7C15ULL) >> (64 - kSlotBits)];
+    }
+
+    Slot* GetSlot(uint64_t key) {
+        return &slots_[(key * 0x9E3779B97F4A7C15ULL) >> (64 - kSlotBits)];
+    }
+
+    void WriteSlot(Slot* slot, uint64_t key, uint32_t leaderId, uint32_t ip,
+                   uint32_t port);
+
+ private:
+    std::mutex mtx_;
+    std::unique_ptr<Slot[]> slots_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_METACACHE_INDEX_H_
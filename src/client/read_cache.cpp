@@ -0,0 +1,275 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Dec 28 10:12:45 CST 2020
+ * Author: wuhanqing
+ */
+
+#include "src/client/read_cache.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>  // NOLINT
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint32_t kWriteSlotNum = 1024;
+
+void BlockDeleter(void* ptr) {
+    delete[] static_cast<char*>(ptr);
+}
+
+}  // namespace
+
+ReadCache::ReadCache(const ReadCacheOption& option, ReadCacheMetric* metric)
+    : option_(option),
+      metric_(metric),
+      epoch_(0),
+      clearEpoch_(0),
+      sn_(0),
+      lastWrites_(kWriteSlotNum, 0),
+      inflightWrites_(kWriteSlotNum, 0),
+      probationBytes_(0),
+      protectedBytes_(0) {
+    CHECK_GT(option_.blockSize, 0u) << "read cache block size is 0";
+}
+
+void ReadCache::FullBlocks(off_t offset, size_t length, uint64_t* begin,
+                           uint64_t* end) const {
+    *begin = (offset + option_.blockSize - 1) / option_.blockSize;
+    *end = (offset + length) / option_.blockSize;
+    if (*end < *begin) {
+        *end = *begin;
+    }
+}
+
+bool ReadCache::Read(uint64_t sn, off_t offset, size_t length,
+                     butil::IOBuf* data, uint64_t* epoch) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    CheckSnLocked(sn);
+    *epoch = epoch_;
+    if (length == 0) {
+        return false;
+    }
+
+    const uint64_t first = offset / option_.blockSize;
+    const uint64_t last = (offset + length - 1) / option_.blockSize;
+    std::vector<BlockList::iterator> hits;
+    hits.reserve(last - first + 1);
+    for (uint64_t index = first; index <= last; ++index) {
+        auto iter = blocks_.find(index);
+        if (iter == blocks_.end()) {
+            metric_->miss << 1;
+            return false;
+        }
+        hits.push_back(iter->second);
+    }
+
+    data->clear();
+    size_t pos = offset % option_.blockSize;
+    size_t left = length;
+    for (auto& iter : hits) {
+        size_t n = std::min(left, option_.blockSize - pos);
+        iter->data.append_to(data, n, pos);
+        left -= n;
+        pos = 0;
+        TouchLocked(iter);
+    }
+    metric_->hit << 1;
+    return true;
+}
+
+void ReadCache::EndRead(uint64_t epoch, off_t offset,
+                        const butil::IOBuf& data) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    if (epoch < clearEpoch_) {
+        return;
+    }
+
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    FullBlocks(offset, data.size(), &begin, &end);
+    for (uint64_t index = begin; index < end; ++index) {
+        uint32_t slot = Slot(index);
+        if (inflightWrites_[slot] > 0 || lastWrites_[slot] > epoch) {
+            continue;
+        }
+        PutLocked(index, data, index * option_.blockSize - offset);
+    }
+}
+
+uint64_t ReadCache::BeginWrite(uint64_t sn, off_t offset, size_t length) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    CheckSnLocked(sn);
+    ++epoch_;
+    if (length == 0) {
+        return epoch_;
+    }
+
+    const uint64_t first = offset / option_.blockSize;
+    const uint64_t last = (offset + length - 1) / option_.blockSize;
+    for (uint64_t index = first; index <= last; ++index) {
+        EraseLocked(index);
+    }
+    // every slot is counted only once by a write
+    const uint64_t slotEnd = std::min<uint64_t>(last + 1,
+                                                first + lastWrites_.size());
+    for (uint64_t index = first; index < slotEnd; ++index) {
+        ++inflightWrites_[Slot(index)];
+        lastWrites_[Slot(index)] = epoch_;
+    }
+    return epoch_;
+}
+
+void ReadCache::EndWrite(uint64_t epoch, off_t offset, size_t length,
+                         const butil::IOBuf* data) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    if (length == 0) {
+        return;
+    }
+
+    // the data is the latest only if no other write on the block was
+    // issued after it or is still inflight
+    if (data != nullptr && epoch >= clearEpoch_) {
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        FullBlocks(offset, length, &begin, &end);
+        for (uint64_t index = begin; index < end; ++index) {
+            uint32_t slot = Slot(index);
+            if (inflightWrites_[slot] != 1 || lastWrites_[slot] != epoch) {
+                continue;
+            }
+            PutLocked(index, *data, index * option_.blockSize - offset);
+        }
+    }
+
+    ++epoch_;
+    const uint64_t first = offset / option_.blockSize;
+    const uint64_t last = (offset + length - 1) / option_.blockSize;
+    const uint64_t slotEnd = std::min<uint64_t>(last + 1,
+                                                first + lastWrites_.size());
+    for (uint64_t index = first; index < slotEnd; ++index) {
+        --inflightWrites_[Slot(index)];
+        lastWrites_[Slot(index)] = epoch_;
+    }
+}
+
+void ReadCache::Clear() {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    ClearLocked();
+}
+
+uint64_t ReadCache::CachedBytes() const {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    return probationBytes_ + protectedBytes_;
+}
+
+void ReadCache::CheckSnLocked(uint64_t sn) {
+    if (sn != sn_) {
+        if (!blocks_.empty()) {
+            LOG(INFO) << "File sn changed from " << sn_ << " to " << sn
+                      << ", clear read cache";
+        }
+        ClearLocked();
+        sn_ = sn;
+    }
+}
+
+void ReadCache::ClearLocked() {
+    metric_->bytes << -static_cast<int64_t>(probationBytes_ + protectedBytes_);
+    probation_.clear();
+    protected_.clear();
+    blocks_.clear();
+    probationBytes_ = 0;
+    protectedBytes_ = 0;
+    clearEpoch_ = ++epoch_;
+}
+
+void ReadCache::PutLocked(uint64_t index, const butil::IOBuf& data,
+                          size_t pos) {
+    // copy the block, so that neither the user buffer nor the whole
+    // rpc response is referenced by the cache
+    char* buf = new char[option_.blockSize];
+    data.copy_to(buf, option_.blockSize, pos);
+
+    EraseLocked(index);
+    probation_.push_front(Block{index, butil::IOBuf(), false});
+    probation_.front().data.append_user_data(buf, option_.blockSize,
+                                             BlockDeleter);
+    blocks_[index] = probation_.begin();
+    probationBytes_ += option_.blockSize;
+    metric_->bytes << option_.blockSize;
+    EvictLocked();
+}
+
+void ReadCache::EraseLocked(uint64_t index) {
+    auto iter = blocks_.find(index);
+    if (iter == blocks_.end()) {
+        return;
+    }
+
+    if (iter->second->isProtected) {
+        protectedBytes_ -= option_.blockSize;
+        protected_.erase(iter->second);
+    } else {
+        probationBytes_ -= option_.blockSize;
+        probation_.erase(iter->second);
+    }
+    metric_->bytes << -static_cast<int64_t>(option_.blockSize);
+    blocks_.erase(iter);
+}
+
+void ReadCache::TouchLocked(BlockList::iterator iter) {
+    if (iter->isProtected) {
+        protected_.splice(protected_.begin(), protected_, iter);
+        return;
+    }
+
+    protected_.splice(protected_.begin(), probation_, iter);
+    iter->isProtected = true;
+    probationBytes_ -= option_.blockSize;
+    protectedBytes_ += option_.blockSize;
+
+    // demote the least recently used protected blocks
+    const uint64_t protectedCapacity =
+        option_.capacityMB * MiB * option_.protectedPercent / 100;
+    while (protectedBytes_ > protectedCapacity && protected_.size() > 1) {
+        auto victim = std::prev(protected_.end());
+        victim->isProtected = false;
+        probation_.splice(probation_.begin(), protected_, victim);
+        protectedBytes_ -= option_.blockSize;
+        probationBytes_ += option_.blockSize;
+    }
+}
+
+void ReadCache::EvictLocked() {
+    const uint64_t capacity = option_.capacityMB * MiB;
+    while (probationBytes_ + protectedBytes_ > capacity) {
+        BlockList& list = probation_.empty() ? protected_ : probation_;
+        EraseLocked(list.back().index);
+        metric_->eviction << 1;
+    }
+}
+
+}  // namespace client
+}  // namespace curve
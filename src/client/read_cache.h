@@ -0,0 +1,173 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Dec 28 10:12:45 CST 2020
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_CLIENT_READ_CACHE_H_
+#define SRC_CLIENT_READ_CACHE_H_
+
+#include <bthread/mutex.h>
+#include <butil/iobuf.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "src/client/client_metric.h"
+#include "src/client/config_info.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * Per file block cache of read and written data.
+ *
+ * Only whole blocks are cached, and a read is served from the cache only if
+ * all of its blocks are cached. Blocks are evicted by segmented LRU: a new
+ * block enters the probationary segment, and is promoted to the protected
+ * segment when it is hit again, so a sequential scan can't flush out the
+ * hot blocks.
+ *
+ * Data completed by a read or a write may be stale by the time it reaches
+ * the cache if another write on the same blocks was in flight, so every
+ * block remembers when it was last touched by a write, and the data is
+ * dropped if any write on the block was in flight or completed since the
+ * read or write was issued. Blocks are hashed into a fixed number of slots
+ * for this, a collision only causes an unnecessary drop.
+ *
+ * The cache is only used by the writer holding the lease of the file, it
+ * is cleared when the snapshot sequence number of the file changes or the
+ * lease is lost.
+ */
+class ReadCache {
+ public:
+    ReadCache(const ReadCacheOption& option, ReadCacheMetric* metric);
+
+    ~ReadCache() = default;
+
+    ReadCache(const ReadCache&) = delete;
+    ReadCache& operator=(const ReadCache&) = delete;
+
+    /**
+     * @brief Read data from cache
+     * @param sn current sequence number of the file
+     * @param offset read offset
+     * @param length read length
+     * @param[out] data read data if all blocks are cached
+     * @param[out] epoch if missed, the epoch passed to EndRead
+     * @return true if all blocks are cached, otherwise false
+     */
+    bool Read(uint64_t sn, off_t offset, size_t length, butil::IOBuf* data,
+              uint64_t* epoch);
+
+    /**
+     * @brief Put data of a completed read into cache
+     * @param epoch epoch returned by Read
+     * @param offset read offset
+     * @param data read data
+     */
+    void EndRead(uint64_t epoch, off_t offset, const butil::IOBuf& data);
+
+    /**
+     * @brief Invalidate blocks before writing them
+     * @param sn current sequence number of the file
+     * @param offset write offset
+     * @param length write length
+     * @return epoch passed to EndWrite
+     */
+    uint64_t BeginWrite(uint64_t sn, off_t offset, size_t length);
+
+    /**
+     * @brief Put data of a completed write into cache
+     * @param epoch epoch returned by BeginWrite
+     * @param offset write offset
+     * @param length write length
+     * @param data written data, nullptr if the write failed
+     */
+    void EndWrite(uint64_t epoch, off_t offset, size_t length,
+                  const butil::IOBuf* data);
+
+    /**
+     * @brief Drop all cached blocks
+     */
+    void Clear();
+
+    uint64_t CachedBytes() const;
+
+ private:
+    struct Block {
+        uint64_t index;
+        butil::IOBuf data;
+        bool isProtected;
+    };
+
+    using BlockList = std::list<Block>;
+
+    // blocks fully covered by [offset, offset + length)
+    void FullBlocks(off_t offset, size_t length,
+                    uint64_t* begin, uint64_t* end) const;
+
+    uint32_t Slot(uint64_t index) const {
+        return index % lastWrites_.size();
+    }
+
+    void CheckSnLocked(uint64_t sn);
+
+    void ClearLocked();
+
+    // put the block at pos of data into cache
+    void PutLocked(uint64_t index, const butil::IOBuf& data, size_t pos);
+
+    void EraseLocked(uint64_t index);
+
+    // move a hit block to the head of protected segment
+    void TouchLocked(BlockList::iterator iter);
+
+    void EvictLocked();
+
+ private:
+    const ReadCacheOption option_;
+    ReadCacheMetric* metric_;
+
+    mutable bthread::Mutex mtx_;
+
+    // bumped when a write begins or ends and when the cache is cleared
+    uint64_t epoch_;
+    // epoch of the last clear, data issued before it is dropped
+    uint64_t clearEpoch_;
+    // sequence number of the file that the cached data belongs to
+    uint64_t sn_;
+
+    // epoch when the blocks of each slot were last touched by a write
+    std::vector<uint64_t> lastWrites_;
+    // number of inflight writes on the blocks of each slot
+    std::vector<uint32_t> inflightWrites_;
+
+    BlockList probation_;
+    BlockList protected_;
+    uint64_t probationBytes_;
+    uint64_t protectedBytes_;
+    std::unordered_map<uint64_t, BlockList::iterator> blocks_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_READ_CACHE_H_
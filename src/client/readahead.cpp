@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Wed Dec 30 10:21:37 CST 2020
+ * Author: wuhanqing
+ */
+
+#include "src/client/readahead.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+#include "src/client/client_common.h"
+
+namespace curve {
+namespace client {
+
+namespace {
+
+// number of sequential streams tracked of each file
+const uint32_t kMaxStreams = 8;
+
+}  // namespace
+
+Readahead::Readahead(const ReadaheadOption& option, ReadaheadMetric* metric)
+    : option_(option),
+      metric_(metric),
+      streams_(kMaxStreams, Stream{0, 0, 0, 0, 0}),
+      accessCount_(0),
+      inflightBytes_(0) {}
+
+Readahead::Stream* Readahead::MatchLocked(uint64_t offset) {
+    for (auto& stream : streams_) {
+        if (stream.nextOffset != 0 && stream.nextOffset == offset) {
+            return &stream;
+        }
+    }
+    return nullptr;
+}
+
+void Readahead::OnRead(off_t offset, size_t length, uint64_t fileLength,
+                       uint64_t chunkSize, uint64_t blockSize,
+                       std::vector<ReadaheadRange>* ranges) {
+    ranges->clear();
+    if (length == 0) {
+        return;
+    }
+
+    const uint64_t end = offset + length;
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    ++accessCount_;
+
+    Stream* stream = MatchLocked(offset);
+    if (stream == nullptr) {
+        // start a new stream in place of the least recently used one
+        stream = &*std::min_element(
+            streams_.begin(), streams_.end(),
+            [](const Stream& lhs, const Stream& rhs) {
+                return lhs.lastAccess < rhs.lastAccess;
+            });
+        stream->seqCount = 0;
+        stream->window = option_.windowMinKB * KiB;
+        stream->prefetchEnd = 0;
+    }
+
+    stream->nextOffset = end;
+    stream->lastAccess = accessCount_;
+    if (++stream->seqCount < option_.triggerCount) {
+        return;
+    }
+
+    if (stream->prefetchEnd <= end) {
+        // nothing is prefetched ahead of the reader yet
+        stream->prefetchEnd = end;
+    } else if (stream->prefetchEnd - end >= stream->window / 2) {
+        // enough data is prefetched ahead
+        return;
+    } else {
+        // the reader is catching up, prefetch more every time
+        stream->window = std::min<uint64_t>(stream->window * 2,
+                                            option_.windowMaxKB * KiB);
+    }
+
+    const uint64_t begin = stream->prefetchEnd / blockSize * blockSize;
+    const uint64_t prefetchEnd = std::min<uint64_t>(
+        (end + stream->window + blockSize - 1) / blockSize * blockSize,
+        fileLength);
+    if (prefetchEnd <= begin) {
+        return;
+    }
+
+    const uint64_t bytes = prefetchEnd - begin;
+    if (inflightBytes_ + bytes > option_.maxInflightMB * MiB) {
+        metric_->throttled << 1;
+        return;
+    }
+
+    inflightBytes_ += bytes;
+    stream->prefetchEnd = prefetchEnd;
+    metric_->inflightBytes << bytes;
+    metric_->issuedBytes << bytes;
+
+    uint64_t pos = begin;
+    while (pos < prefetchEnd) {
+        uint64_t next = prefetchEnd;
+        if (chunkSize != 0) {
+            next = std::min(prefetchEnd, (pos / chunkSize + 1) * chunkSize);
+        }
+        ranges->push_back(ReadaheadRange{static_cast<off_t>(pos),
+                                         static_cast<size_t>(next - pos)});
+        pos = next;
+    }
+    metric_->issued << ranges->size();
+}
+
+void Readahead::OnPrefetchDone(size_t length) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    inflightBytes_ -= length;
+    metric_->inflightBytes << -static_cast<int64_t>(length);
+}
+
+uint64_t Readahead::InflightBytes() const {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    return inflightBytes_;
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Wed Dec 30 10:21:37 CST 2020
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_CLIENT_READAHEAD_H_
+#define SRC_CLIENT_READAHEAD_H_
+
+#include <bthread/mutex.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#include "src/client/client_metric.h"
+#include "src/client/config_info.h"
+
+namespace curve {
+namespace client {
+
+struct ReadaheadRange {
+    off_t offset;
+    size_t length;
+};
+
+/**
+ * Sequential read detector of a file.
+ *
+ * Every user read is matched against a few recent streams, a read starting
+ * where a stream ended continues the stream. Once a stream has seen
+ * triggerCount sequential reads, data ahead of it is prefetched into the
+ * read cache. A new window is prefetched when the reader has consumed half
+ * of the prefetched data, so the next reads hit the cache instead of
+ * waiting for it, and the window doubles every time up to windowMaxKB.
+ *
+ * Prefetched ranges are aligned to cache blocks, so that all of them can
+ * be cached, and split at chunk boundaries.
+ */
+class Readahead {
+ public:
+    Readahead(const ReadaheadOption& option, ReadaheadMetric* metric);
+
+    Readahead(const Readahead&) = delete;
+    Readahead& operator=(const Readahead&) = delete;
+
+    /**
+     * @brief Record a user read and get the ranges to prefetch
+     * @param offset read offset
+     * @param length read length
+     * @param fileLength length of the file, nothing is prefetched beyond it
+     * @param chunkSize chunk size of the file
+     * @param blockSize block size of the read cache
+     * @param[out] ranges ranges to prefetch, the caller must call
+     *             OnPrefetchDone for every one of them
+     */
+    void OnRead(off_t offset, size_t length, uint64_t fileLength,
+                uint64_t chunkSize, uint64_t blockSize,
+                std::vector<ReadaheadRange>* ranges);
+
+    /**
+     * @brief Prefetch of a range returned by OnRead completed
+     */
+    void OnPrefetchDone(size_t length);
+
+    uint64_t InflightBytes() const;
+
+ private:
+    struct Stream {
+        // where the next sequential read starts, 0 if unused
+        uint64_t nextOffset;
+        uint32_t seqCount;
+        uint64_t window;
+        // end of issued readahead data
+        uint64_t prefetchEnd;
+        uint64_t lastAccess;
+    };
+
+    Stream* MatchLocked(uint64_t offset);
+
+ private:
+    const ReadaheadOption option_;
+    ReadaheadMetric* metric_;
+
+    mutable bthread::Mutex mtx_;
+    std::vector<Stream> streams_;
+    uint64_t accessCount_;
+    uint64_t inflightBytes_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_READAHEAD_H_
@@ -37,6 +37,24 @@ void RequestClosure::Run() {
     tracker_->HandleResponse(reqCtx_);
 }
 
+void MergedRequestClosure::Run() {
+    ReleaseInflightRPCToken();
+    if (IsSuspendRPC()) {
+        MetricHelper::DecremIOSuspendNum(GetMetric());
+    }
+
+    for (auto ctx : merged_) {
+        ctx->done_->SetFailed(GetErrorCode());
+        ctx->done_->Run();
+    }
+
+    // 合并后的请求由closure自己释放，closure不是从对象池中申请的
+    RequestContext* reqCtx = GetReqCtx();
+    reqCtx->done_ = nullptr;
+    ObjectPool<RequestContext>::GetInstance()->Delete(reqCtx);
+    delete this;
+}
+
 void RequestClosure::GetInflightRPCToken() {
     if (ioManager_ != nullptr) {
         ioManager_->GetInflightRpcToken();
@@ -49,6 +67,7 @@ void RequestClosure::ReleaseInflightRPCToken() {
     if (ioManager_ != nullptr && ownInflight_) {
         ioManager_->ReleaseInflightRpcToken();
         MetricHelper::DecremInflightRPC(metric_);
+        ownInflight_ = false;
     }
 }
 
@@ -26,6 +26,9 @@
 // for Closure
 #include <google/protobuf/stubs/callback.h>
 
+#include <utility>
+#include <vector>
+
 #include "include/curve_compiler_specific.h"
 #include "src/client/client_common.h"
 #include "src/client/client_metric.h"
@@ -99,6 +102,13 @@ class CURVE_CACHELINE_ALIGNMENT RequestClosure
         ioManager_ = ioManager;
     }
 
+    /**
+     * @brief 获取所属的iomanager
+     */
+    IOManager* GetIOManager() const {
+        return ioManager_;
+    }
+
     /**
      * @brief 设置当前closure重试次数
      */
@@ -178,6 +188,23 @@ class CURVE_CACHELINE_ALIGNMENT RequestClosure
     uint64_t nextTimeoutMS_ = 0;
 };
 
+/**
+ * 多个写请求合并后发送的请求的closure
+ * rpc返回后将结果分发给被合并的各个请求，然后释放合并后的请求
+ */
+class MergedRequestClosure : public RequestClosure {
+ public:
+    MergedRequestClosure(RequestContext* reqctx,
+                         std::vector<RequestContext*>&& merged)
+        : RequestClosure(reqctx), merged_(std::move(merged)) {}
+
+    void Run() override;
+
+ private:
+    // 被合并的请求
+    std::vector<RequestContext*> merged_;
+};
+
 }  // namespace client
 }  // namespace curve
 
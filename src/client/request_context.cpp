@@ -27,5 +27,19 @@ namespace client {
 
 std::atomic<uint64_t> RequestContext::requestId(0);
 
+namespace {
+
+// 暴露请求对象池的统计信息，live_count持续增长说明有请求没有释放
+struct RequestPoolMetricExposer {
+    RequestPoolMetricExposer() {
+        ObjectPool<RequestContext>::GetInstance()->Expose(
+            "curve_client_request_context_pool");
+        ObjectPool<RequestClosure>::GetInstance()->Expose(
+            "curve_client_request_closure_pool");
+    }
+} requestPoolMetricExposer;
+
+}  // namespace
+
 }  // namespace client
 }  // namespace curve
@@ -30,11 +30,14 @@
 
 #include "src/client/client_common.h"
 #include "src/client/request_closure.h"
+#include "src/common/object_pool.h"
 #include "include/curve_compiler_specific.h"
 
 namespace curve {
 namespace client {
 
+using curve::common::ObjectPool;
+
 struct RequestSourceInfo {
     std::string cloneFileSource;
     uint64_t cloneFileOffset = 0;
@@ -64,12 +67,12 @@ struct CURVE_CACHELINE_ALIGNMENT RequestContext {
     ~RequestContext() = default;
 
     bool Init() {
-         done_ = new (std::nothrow) RequestClosure(this);
+         done_ = ObjectPool<RequestClosure>::GetInstance()->New(this);
          return done_ != nullptr;
     }
 
     void UnInit() {
-        delete done_;
+        ObjectPool<RequestClosure>::GetInstance()->Delete(done_);
         done_ = nullptr;
     }
 
@@ -113,17 +116,27 @@ struct CURVE_CACHELINE_ALIGNMENT RequestContext {
     // 当前request context id
     uint64_t            id_ = 0;
 
+    // 重新调度过的请求和合并后的请求不再参与写合并
+    bool                skipWriteMerge_ = false;
+
+    // RequestContext和RequestClosure都从对象池中申请，
+    // 需要通过DeleteInitedRequestContext释放
     static RequestContext* NewInitedRequestContext() {
-        RequestContext* ctx = new (std::nothrow) RequestContext();
+        RequestContext* ctx = ObjectPool<RequestContext>::GetInstance()->New();
         if (ctx && ctx->Init()) {
             return ctx;
         } else {
             LOG(ERROR) << "Allocate or Init RequestContext Failed";
-            delete ctx;
+            ObjectPool<RequestContext>::GetInstance()->Delete(ctx);
             return nullptr;
         }
     }
 
+    static void DeleteInitedRequestContext(RequestContext* ctx) {
+        ctx->UnInit();
+        ObjectPool<RequestContext>::GetInstance()->Delete(ctx);
+    }
+
  private:
     static std::atomic<uint64_t> requestId;
 
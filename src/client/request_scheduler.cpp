@@ -25,13 +25,19 @@
 #include <brpc/closure_guard.h>
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "src/client/request_context.h"
 #include "src/client/request_closure.h"
 #include "src/client/chunk_closure.h"
+#include "src/common/timeutility.h"
 
 namespace curve {
 namespace client {
 
+using curve::common::TimeUtility;
+
 RequestScheduler::~RequestScheduler() {}
 
 int RequestScheduler::Init(const RequestScheduleOption& reqSchdulerOpt,
@@ -39,6 +45,7 @@ int RequestScheduler::Init(const RequestScheduleOption& reqSchdulerOpt,
                            FileMetric* fm) {
     blockIO_.store(false);
     reqschopt_ = reqSchdulerOpt;
+    fileMetric_ = fm;
 
     int rc = 0;
     rc = queue_.Init(reqschopt_.scheduleQueueCapacity);
@@ -61,7 +68,12 @@ int RequestScheduler::Init(const RequestScheduleOption& reqSchdulerOpt,
               << "scheduleQueueCapacity = "
               << reqschopt_.scheduleQueueCapacity
               << ", scheduleThreadpoolSize = "
-              << reqschopt_.scheduleThreadpoolSize;
+              << reqschopt_.scheduleThreadpoolSize
+              << ", enableWriteMerge = " << reqschopt_.enableWriteMerge
+              << ", writeMergeWindowUs = " << reqschopt_.writeMergeWindowUs
+              << ", writeMergeMaxBytes = " << reqschopt_.writeMergeMaxBytes
+              << ", writeMergeMaxRequests = "
+              << reqschopt_.writeMergeMaxRequests;
     return 0;
 }
 
@@ -90,6 +102,8 @@ int RequestScheduler::ScheduleRequest(
     const std::vector<RequestContext*>& requests) {
     if (running_.load(std::memory_order_acquire)) {
         /* TODO(wudemiao): 后期考虑 qos */
+        std::vector<BBQItem<RequestContext *>> reqs;
+        reqs.reserve(requests.size());
         for (auto it : requests) {
             // skip the fake request
             if (!it->idinfo_.chunkExist) {
@@ -99,9 +113,10 @@ int RequestScheduler::ScheduleRequest(
                 continue;
             }
 
-            BBQItem<RequestContext *> req(it);
-            queue_.PutBack(req);
+            reqs.emplace_back(it);
         }
+        // 一次放入队列，只唤醒一次调度线程
+        queue_.PutBack(reqs.begin(), reqs.end());
         return 0;
     }
     return -1;
@@ -117,6 +132,8 @@ int RequestScheduler::ScheduleRequest(RequestContext *request) {
 }
 
 int RequestScheduler::ReSchedule(RequestContext *request) {
+    // 重新调度的请求可能已经被合并过, 或者是合并后的请求
+    request->skipWriteMerge_ = true;
     if (running_.load(std::memory_order_acquire)) {
         BBQItem<RequestContext *> req(request);
         queue_.PutFront(req);
@@ -148,6 +165,10 @@ void RequestScheduler::Process() {
         BBQItem<RequestContext*> item = queue_.TakeFront();
         if (!item.IsStop()) {
             RequestContext* req = item.Item();
+            if (reqschopt_.enableWriteMerge &&
+                req->optype_ == OpType::WRITE) {
+                req = MergeWrites(req);
+            }
             ProcessOne(req);
         } else {
             /**
@@ -159,6 +180,103 @@ void RequestScheduler::Process() {
     }
 }
 
+RequestContext* RequestScheduler::MergeWrites(RequestContext* ctx) {
+    if (ctx->skipWriteMerge_) {
+        return ctx;
+    }
+
+    std::vector<RequestContext*> merged{ctx};
+    off_t begin = ctx->offset_;
+    off_t end = ctx->offset_ + ctx->rawlength_;
+    butil::IOBuf data = ctx->writeData_;
+
+    auto mergeable = [&](BBQItem<RequestContext*>& item) {
+        if (item.IsStop()) {
+            return false;
+        }
+
+        RequestContext* next = item.Item();
+        if (next->skipWriteMerge_ ||
+            next->optype_ != OpType::WRITE ||
+            next->idinfo_.cid_ != ctx->idinfo_.cid_ ||
+            next->idinfo_.lpid_ != ctx->idinfo_.lpid_ ||
+            next->idinfo_.cpid_ != ctx->idinfo_.cpid_ ||
+            next->seq_ != ctx->seq_ ||
+            next->sourceInfo_.valid != ctx->sourceInfo_.valid ||
+            next->sourceInfo_.cloneFileSource !=
+                ctx->sourceInfo_.cloneFileSource ||
+            next->sourceInfo_.cloneFileOffset !=
+                ctx->sourceInfo_.cloneFileOffset) {
+            return false;
+        }
+
+        // 只合并相邻或重叠的请求
+        off_t nextEnd = next->offset_ + next->rawlength_;
+        if (next->offset_ > end || nextEnd < begin) {
+            return false;
+        }
+
+        return std::max(end, nextEnd) - std::min(begin, next->offset_) <=
+               reqschopt_.writeMergeMaxBytes;
+    };
+
+    const uint64_t deadline =
+        TimeUtility::GetTimeofDayUs() + reqschopt_.writeMergeWindowUs;
+    BBQItem<RequestContext*> item(nullptr);
+    while (merged.size() < reqschopt_.writeMergeMaxRequests) {
+        uint64_t now = TimeUtility::GetTimeofDayUs();
+        uint64_t waitUs = deadline > now ? deadline - now : 0;
+        if (!queue_.TakeFrontIf(mergeable, waitUs, &item)) {
+            break;
+        }
+
+        // 重叠的部分以后取出的请求为准
+        RequestContext* next = item.Item();
+        off_t nextEnd = next->offset_ + next->rawlength_;
+        butil::IOBuf newData;
+        if (next->offset_ > begin) {
+            data.append_to(&newData, next->offset_ - begin, 0);
+        }
+        newData.append(next->writeData_);
+        if (nextEnd < end) {
+            data.append_to(&newData, end - nextEnd, nextEnd - begin);
+        }
+        data.swap(newData);
+        begin = std::min(begin, next->offset_);
+        end = std::max(end, nextEnd);
+        merged.push_back(next);
+    }
+
+    if (merged.size() == 1) {
+        return ctx;
+    }
+
+    RequestContext* mergedCtx =
+        ObjectPool<RequestContext>::GetInstance()->New();
+    CHECK(mergedCtx != nullptr) << "allocate merged request failed";
+    mergedCtx->optype_ = OpType::WRITE;
+    mergedCtx->idinfo_ = ctx->idinfo_;
+    mergedCtx->seq_ = ctx->seq_;
+    mergedCtx->sourceInfo_ = ctx->sourceInfo_;
+    mergedCtx->offset_ = begin;
+    mergedCtx->rawlength_ = end - begin;
+    mergedCtx->writeData_.swap(data);
+    mergedCtx->skipWriteMerge_ = true;
+    for (auto req : merged) {
+        req->skipWriteMerge_ = true;
+    }
+
+    RequestClosure* done = ctx->done_;
+    MetricHelper::IncremMergedWriteCount(fileMetric_, merged.size() - 1);
+    mergedCtx->done_ = new MergedRequestClosure(mergedCtx, std::move(merged));
+    mergedCtx->done_->SetFileMetric(done->GetMetric());
+    mergedCtx->done_->SetIOManager(done->GetIOManager());
+    mergedCtx->done_->SetIOTracker(done->GetIOTracker());
+
+    DVLOG(9) << "merge write requests into " << *mergedCtx;
+    return mergedCtx;
+}
+
 void RequestScheduler::ProcessOne(RequestContext* ctx) {
     brpc::ClosureGuard guard(ctx->done_);
 
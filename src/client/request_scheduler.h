@@ -52,7 +52,8 @@ class RequestScheduler : public Uncopyable {
         : running_(false),
           stop_(true),
           blockingQueue_(true),
-          client_() {}
+          client_(),
+          fileMetric_(nullptr) {}
     virtual ~RequestScheduler();
 
     /**
@@ -140,6 +141,13 @@ class RequestScheduler : public Uncopyable {
 
     void ProcessOne(RequestContext* ctx);
 
+    /**
+     * 从队首取出与ctx在同一chunk上相邻或重叠的写请求，与ctx合并为一个请求
+     * @param ctx: 从队列中取出的写请求
+     * @return 没有可合并的请求时返回ctx，否则返回合并后的请求
+     */
+    RequestContext* MergeWrites(RequestContext* ctx);
+
     void WaitValidSession() {
         // lease续约失败的时候需要阻塞IO直到续约成功
         if (blockIO_.load(std::memory_order_acquire) && blockingQueue_) {
@@ -165,6 +173,8 @@ class RequestScheduler : public Uncopyable {
     std::atomic<bool> stop_;
     // 访问复制组Chunk的客户端
     CopysetClient client_;
+    // 文件的metric信息
+    FileMetric* fileMetric_;
     // 续约失败，卡住IO
     std::atomic<bool> blockIO_;
     // 此锁与LeaseRefreshcv_条件变量配合使用
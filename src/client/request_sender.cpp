@@ -55,6 +55,12 @@ inline void RequestSender::SetRpcStuff(
         std::max(request->GetNextTimeoutMS(),
                  iosenderopt_.failRequestOpt.chunkserverRPCTimeoutMS));
 
+    // 当前chunkserver的inflight rpc达到窗口大小时等待
+    if (limiter_ != nullptr) {
+        limiter_->Acquire();
+        done->SetInflightLimiter(limiter_);
+    }
+
     done->SetCntl(cntl);
     done->SetResponse(rpcResponse);
     done->SetChunkServerID(chunkServerId_);
@@ -70,6 +76,13 @@ int RequestSender::Init(const IOSenderOption& ioSenderOpt) {
     iosenderopt_ = ioSenderOpt;
     ClientClosure::SetFailureRequestOption(iosenderopt_.failRequestOpt);
 
+    if (iosenderopt_.inflightLimiterOpt.enable) {
+        limiter_ = InflightLimiterManager::GetInstance().GetOrCreateLimiter(
+            chunkServerId_, iosenderopt_.inflightLimiterOpt);
+    } else {
+        limiter_.reset();
+    }
+
     return 0;
 }
 
@@ -110,6 +123,33 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
     return 0;
 }
 
+int RequestSender::ReadChunkFromFollower(const ChunkIDInfo& idinfo,
+                                         uint64_t sn,
+                                         off_t offset,
+                                         size_t length,
+                                         uint64_t appliedindex,
+                                         brpc::Controller* cntl,
+                                         ChunkResponse* response,
+                                         Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    cntl->set_timeout_ms(iosenderopt_.failRequestOpt.chunkserverRPCTimeoutMS);
+
+    ChunkRequest request;
+    request.set_optype(curve::chunkserver::CHUNK_OP_TYPE::CHUNK_OP_READ);
+    request.set_logicpoolid(idinfo.lpid_);
+    request.set_copysetid(idinfo.cpid_);
+    request.set_chunkid(idinfo.cid_);
+    request.set_offset(offset);
+    request.set_size(length);
+    request.set_appliedindex(appliedindex);
+    request.set_followerread(true);
+
+    ChunkService_Stub stub(&channel_);
+    stub.ReadChunk(cntl, &request, response, doneGuard.release());
+
+    return 0;
+}
+
 int RequestSender::WriteChunk(const ChunkIDInfo& idinfo,
                               uint64_t sn,
                               const butil::IOBuf& data,
@@ -27,11 +27,13 @@
 #include <butil/endpoint.h>
 #include <butil/iobuf.h>
 
+#include <memory>
 #include <string>
 
 #include "src/client/client_config.h"
 #include "src/client/client_common.h"
 #include "src/client/chunk_closure.h"
+#include "src/client/inflight_limiter.h"
 #include "include/curve_compiler_specific.h"
 #include "src/client/request_context.h"
 
@@ -53,6 +55,17 @@ class RequestSender {
 
     int Init(const IOSenderOption& ioSenderOpt);
 
+    ChunkServerID GetChunkServerID() const {
+        return chunkServerId_;
+    }
+
+    /**
+     * 返回当前chunkserver的inflight rpc限制，未开启时为nullptr
+     */
+    std::shared_ptr<AdaptiveInflightLimiter> GetInflightLimiter() const {
+        return limiter_;
+    }
+
     /**
      * 读Chunk
      * @param idinfo为chunk相关的id信息
@@ -71,6 +84,27 @@ class RequestSender {
                   const RequestSourceInfo& sourceInfo,
                   ClientClosure *done);
 
+    /**
+     * 读follower上的Chunk，用于hedged read
+     * follower上的applied index不小于appliedindex时才会返回数据，否则返回重定向
+     * @param idinfo为chunk相关的id信息
+     * @param sn:文件版本号
+     * @param offset:读的偏移
+     * @param length:读的长度
+     * @param appliedindex:需要读到>=appliedIndex的数据
+     * @param cntl:rpc controller
+     * @param response:rpc response
+     * @param done:rpc回调
+     */
+    int ReadChunkFromFollower(const ChunkIDInfo& idinfo,
+                              uint64_t sn,
+                              off_t offset,
+                              size_t length,
+                              uint64_t appliedindex,
+                              brpc::Controller* cntl,
+                              ChunkResponse* response,
+                              google::protobuf::Closure* done);
+
     /**
    * 写Chunk
    * @param idinfo为chunk相关的id信息
@@ -186,6 +220,8 @@ class RequestSender {
     // ChunkServer 的地址
     butil::EndPoint serverEndPoint_;
     brpc::Channel channel_; /* TODO(wudemiao): 后期会维护多个 channel */
+    // 发往当前chunkserver的inflight rpc的自适应限制
+    std::shared_ptr<AdaptiveInflightLimiter> limiter_;
 };
 
 }   // namespace client
@@ -25,6 +25,9 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -213,15 +216,60 @@ bool Splitor::AssignInternal(IOTracker* iotracker, MetaCache* metaCache,
     return false;
 }
 
+uint32_t Splitor::GetSegmentPrefetchNum(uint64_t segOffset,
+                                        MetaCache* metaCache,
+                                        const FInfo* fileInfo) {
+    // stripe io does not go through segments in order
+    if (iosplitopt_.segmentPrefetchNum <= 1 || fileInfo->stripeCount > 1) {
+        return 1;
+    }
+
+    // only prefetch at the sequential write frontier, that is the first
+    // segment or the segment right after an allocated one
+    if (segOffset >= fileInfo->segmentsize) {
+        ChunkIDInfo prevChunkInfo;
+        ChunkIndex prevChunkIdx = segOffset / fileInfo->chunksize - 1;
+        MetaCacheErrorType errCode =
+            metaCache->GetChunkInfoByIndex(prevChunkIdx, &prevChunkInfo);
+        if (errCode != MetaCacheErrorType::OK || !prevChunkInfo.chunkExist) {
+            return 1;
+        }
+    }
+
+    if (fileInfo->length <= segOffset) {
+        return 1;
+    }
+    uint64_t remainSegments =
+        (fileInfo->length - segOffset) / fileInfo->segmentsize;
+    return std::max<uint64_t>(
+        1, std::min<uint64_t>(iosplitopt_.segmentPrefetchNum, remainSegments));
+}
+
 bool Splitor::GetOrAllocateSegment(bool allocateIfNotExist,
                                    uint64_t offset,
                                    MDSClient* mdsClient,
                                    MetaCache* metaCache,
                                    const FInfo* fileInfo,
                                    ChunkIndex chunkidx) {
-    SegmentInfo segmentInfo;
-    LIBCURVE_ERROR errCode = mdsClient->GetOrAllocateSegment(
-        allocateIfNotExist, offset, fileInfo, &segmentInfo);
+    const uint64_t segOffset =
+        offset / fileInfo->segmentsize * fileInfo->segmentsize;
+    const uint32_t segmentNum =
+        allocateIfNotExist ? GetSegmentPrefetchNum(segOffset, metaCache,
+                                                   fileInfo)
+                           : 1;
+
+    // hold read locks of the prefetched segments until their chunks are
+    // cached, otherwise a discard task may deallocate them in between
+    std::vector<std::unique_ptr<FileSegmentReadLockGuard>> prefetchLocks;
+    const SegmentIndex segmentIndex = segOffset / fileInfo->segmentsize;
+    for (uint32_t i = 1; i < segmentNum; ++i) {
+        prefetchLocks.emplace_back(new FileSegmentReadLockGuard(
+            metaCache->GetFileSegment(segmentIndex + i)));
+    }
+
+    std::vector<SegmentInfo> segmentInfos;
+    LIBCURVE_ERROR errCode = mdsClient->GetOrAllocateSegments(
+        allocateIfNotExist, offset, fileInfo, segmentNum, &segmentInfos);
 
     if (errCode == LIBCURVE_ERROR::FAILED ||
         errCode == LIBCURVE_ERROR::AUTHFAIL) {
@@ -237,43 +285,51 @@ bool Splitor::GetOrAllocateSegment(bool allocateIfNotExist,
     }
 
     const auto chunksize = fileInfo->chunksize;
-    uint32_t count = 0;
-    for (const auto& chunkIdInfo : segmentInfo.chunkvec) {
-        uint64_t chunkIdx =
-            (segmentInfo.startoffset + count * chunksize) / chunksize;
-        metaCache->UpdateChunkInfoByIndex(chunkIdx, chunkIdInfo);
-        ++count;
+    std::map<LogicPoolID, std::set<CopysetID>> copysetIds;
+    for (const auto& segmentInfo : segmentInfos) {
+        uint32_t count = 0;
+        for (const auto& chunkIdInfo : segmentInfo.chunkvec) {
+            uint64_t chunkIdx =
+                (segmentInfo.startoffset + count * chunksize) / chunksize;
+            metaCache->UpdateChunkInfoByIndex(chunkIdx, chunkIdInfo);
+            ++count;
+        }
+
+        copysetIds[segmentInfo.lpcpIDInfo.lpid].insert(
+            segmentInfo.lpcpIDInfo.cpidVec.begin(),
+            segmentInfo.lpcpIDInfo.cpidVec.end());
     }
 
-    std::vector<CopysetInfo> copysetInfos;
-    errCode = mdsClient->GetServerList(segmentInfo.lpcpIDInfo.lpid,
-                                       segmentInfo.lpcpIDInfo.cpidVec,
-                                       &copysetInfos);
+    for (const auto& item : copysetIds) {
+        const LogicPoolID lpid = item.first;
+        std::vector<CopysetID> cpidVec(item.second.begin(), item.second.end());
+        std::vector<CopysetInfo> copysetInfos;
+        errCode = mdsClient->GetServerList(lpid, cpidVec, &copysetInfos);
 
-    if (errCode == LIBCURVE_ERROR::FAILED) {
-        std::string failedCopysets;
-        for (const auto& id : segmentInfo.lpcpIDInfo.cpidVec) {
-            failedCopysets.append(std::to_string(id)).append(",");
-        }
+        if (errCode == LIBCURVE_ERROR::FAILED) {
+            std::string failedCopysets;
+            for (const auto& id : cpidVec) {
+                failedCopysets.append(std::to_string(id)).append(",");
+            }
 
-        LOG(ERROR) << "GetServerList failed, logicpool id: "
-                   << segmentInfo.lpcpIDInfo.lpid
-                   << ", copysets: " << failedCopysets;
+            LOG(ERROR) << "GetServerList failed, logicpool id: " << lpid
+                       << ", copysets: " << failedCopysets;
 
-        return false;
-    }
+            return false;
+        }
 
-    for (const auto& copysetInfo : copysetInfos) {
-        for (const auto& peerInfo : copysetInfo.csinfos_) {
-            metaCache->AddCopysetIDInfo(
-                peerInfo.chunkserverID,
-                CopysetIDInfo(segmentInfo.lpcpIDInfo.lpid, copysetInfo.cpid_));
+        for (const auto& copysetInfo : copysetInfos) {
+            for (const auto& peerInfo : copysetInfo.csinfos_) {
+                metaCache->AddCopysetIDInfo(
+                    peerInfo.chunkserverID,
+                    CopysetIDInfo(lpid, copysetInfo.cpid_));
+            }
         }
-    }
 
-    for (const auto& copysetInfo : copysetInfos) {
-        metaCache->UpdateCopysetInfo(segmentInfo.lpcpIDInfo.lpid,
-                                     copysetInfo.cpid_, copysetInfo);
+        for (const auto& copysetInfo : copysetInfos) {
+            metaCache->UpdateCopysetInfo(lpid, copysetInfo.cpid_,
+                                         copysetInfo);
+        }
     }
 
     return true;
@@ -122,6 +122,15 @@ class Splitor {
                                      const FInfo* fileInfo,
                                      ChunkIndex chunkidx);
 
+    /**
+     * 计算写到未分配的segment时一次向mds申请的segment数量
+     * @param: segOffset为segment在文件中的偏移
+     * @return: 不在顺序写的边界上或者未开启预分配时返回1
+     */
+    static uint32_t GetSegmentPrefetchNum(uint64_t segOffset,
+                                          MetaCache* metaCache,
+                                          const FInfo* fileInfo);
+
     static int SplitForNormal(IOTracker* iotracker, MetaCache* metaCache,
                               std::vector<RequestContext*>* targetlist,
                               butil::IOBuf* data, off_t offset, size_t length,
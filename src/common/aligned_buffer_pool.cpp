@@ -0,0 +1,268 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-14
+ * Author: yangyaokai
+ */
+
+#include <dirent.h>
+#include <glog/logging.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "src/common/aligned_buffer_pool.h"
+
+namespace curve {
+namespace common {
+
+DEFINE_uint64(alignedBufferPoolMaxCachedBytes, 64 * 1024 * 1024,
+              "max bytes cached in the shared lists of aligned buffer pool");
+
+const size_t AlignedBufferPool::kAlignment;
+const size_t AlignedBufferPool::kMinBufferSize;
+const size_t AlignedBufferPool::kMaxBufferSize;
+const int AlignedBufferPool::kSizeClassNum;
+
+// 每个线程每个size class最多缓存的字节数，至少缓存一个
+const size_t kThreadCacheBytesPerClass = 128 * 1024;
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+    : data_(other.data_), size_(other.size_), capacity_(other.capacity_),
+      sizeClass_(other.sizeClass_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.sizeClass_ = -1;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        sizeClass_ = other.sizeClass_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.sizeClass_ = -1;
+    }
+    return *this;
+}
+
+void AlignedBuffer::Reset() {
+    if (data_ == nullptr) {
+        return;
+    }
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    if (sizeClass_ < 0) {
+        pool->Free(data_, capacity_);
+    } else {
+        pool->Put(data_, sizeClass_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+    sizeClass_ = -1;
+}
+
+struct AlignedBufferPool::ThreadCache {
+    std::vector<char*> lists[kSizeClassNum];
+
+    ~ThreadCache() {
+        AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+        for (int i = 0; i < kSizeClassNum; ++i) {
+            for (char* data : lists[i]) {
+                pool->PutToNode(data, i);
+            }
+            lists[i].clear();
+        }
+    }
+};
+
+AlignedBufferPool* AlignedBufferPool::GetInstance() {
+    // 线程缓存在线程退出时会访问pool，pool不随进程退出析构
+    static AlignedBufferPool* instance = new AlignedBufferPool();
+    return instance;
+}
+
+AlignedBufferPool::AlignedBufferPool()
+    : nodeNum_(1),
+      nodeCachedBytes_(0),
+      hit_("aligned_buffer_pool", "hit_count"),
+      miss_("aligned_buffer_pool", "miss_count"),
+      footprint_("aligned_buffer_pool", "footprint_bytes"),
+      cached_("aligned_buffer_pool", "cached_bytes"),
+      hitRatio_("aligned_buffer_pool", "hit_ratio",
+                &AlignedBufferPool::GetHitRatio, this) {
+    DIR* dir = ::opendir("/sys/devices/system/node");
+    if (dir != nullptr) {
+        int count = 0;
+        struct dirent* entry;
+        while ((entry = ::readdir(dir)) != nullptr) {
+            if (strncmp(entry->d_name, "node", 4) == 0 &&
+                entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                ++count;
+            }
+        }
+        ::closedir(dir);
+        nodeNum_ = count > 0 ? count : 1;
+    }
+    for (int i = 0; i < nodeNum_; ++i) {
+        nodes_.emplace_back(new NodeCache());
+    }
+    LOG(INFO) << "Aligned buffer pool inited, numa node num: " << nodeNum_;
+}
+
+AlignedBuffer AlignedBufferPool::Get(size_t size, size_t alignment) {
+    int sizeClass = SizeClassOf(size);
+    if (sizeClass < 0 || alignment > kAlignment) {
+        miss_ << 1;
+        char* data = Allocate(size, alignment);
+        return AlignedBuffer(data, size, size, -1);
+    }
+
+    ThreadCache* cache = GetThreadCache();
+    std::vector<char*>& list = cache->lists[sizeClass];
+    char* data = nullptr;
+    if (!list.empty()) {
+        data = list.back();
+        list.pop_back();
+    } else {
+        data = GetFromNode(sizeClass);
+    }
+
+    size_t capacity = ClassSize(sizeClass);
+    if (data != nullptr) {
+        hit_ << 1;
+        cached_ << -static_cast<int64_t>(capacity);
+    } else {
+        miss_ << 1;
+        data = Allocate(capacity, kAlignment);
+    }
+    return AlignedBuffer(data, size, capacity, sizeClass);
+}
+
+void AlignedBufferPool::Put(char* data, int sizeClass) {
+    size_t capacity = ClassSize(sizeClass);
+    cached_ << static_cast<int64_t>(capacity);
+    ThreadCache* cache = GetThreadCache();
+    std::vector<char*>& list = cache->lists[sizeClass];
+    size_t limit = std::max<size_t>(1, kThreadCacheBytesPerClass / capacity);
+    if (list.size() < limit) {
+        list.push_back(data);
+        return;
+    }
+    PutToNode(data, sizeClass);
+}
+
+void AlignedBufferPool::PutToNode(char* data, int sizeClass) {
+    size_t capacity = ClassSize(sizeClass);
+    uint64_t cached = nodeCachedBytes_.fetch_add(capacity,
+                                                 std::memory_order_relaxed);
+    if (cached + capacity > FLAGS_alignedBufferPoolMaxCachedBytes) {
+        nodeCachedBytes_.fetch_sub(capacity, std::memory_order_relaxed);
+        cached_ << -static_cast<int64_t>(capacity);
+        Free(data, capacity);
+        return;
+    }
+    NodeCache* node = nodes_[CurrentNode()].get();
+    LockGuard lk(node->mtx);
+    node->lists[sizeClass].push_back(data);
+}
+
+char* AlignedBufferPool::GetFromNode(int sizeClass) {
+    if (nodeCachedBytes_.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    // 优先从本节点获取，本节点没有时再从其他节点获取，避免重复申请
+    int current = CurrentNode();
+    for (int i = 0; i < nodeNum_; ++i) {
+        NodeCache* node = nodes_[(current + i) % nodeNum_].get();
+        LockGuard lk(node->mtx);
+        std::vector<char*>& list = node->lists[sizeClass];
+        if (list.empty()) {
+            continue;
+        }
+        char* data = list.back();
+        list.pop_back();
+        nodeCachedBytes_.fetch_sub(ClassSize(sizeClass),
+                                   std::memory_order_relaxed);
+        return data;
+    }
+    return nullptr;
+}
+
+char* AlignedBufferPool::Allocate(size_t size, size_t alignment) {
+    char* data = nullptr;
+    int ret = posix_memalign(reinterpret_cast<void **>(&data),
+                             alignment, size);
+    LOG_IF(FATAL, ret != 0 || data == nullptr)
+        << "posix_memalign aligned buffer failed, size: " << size
+        << ", alignment: " << alignment << ", error: " << strerror(ret);
+    footprint_ << static_cast<int64_t>(size);
+    return data;
+}
+
+void AlignedBufferPool::Free(char* data, size_t size) {
+    footprint_ << -static_cast<int64_t>(size);
+    free(data);
+}
+
+int AlignedBufferPool::CurrentNode() const {
+    if (nodeNum_ == 1) {
+        return 0;
+    }
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 ||
+        node >= static_cast<unsigned>(nodeNum_)) {
+        return 0;
+    }
+    return node;
+}
+
+int AlignedBufferPool::SizeClassOf(size_t size) {
+    if (size > kMaxBufferSize) {
+        return -1;
+    }
+    int sizeClass = 0;
+    while (ClassSize(sizeClass) < size) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+AlignedBufferPool::ThreadCache* AlignedBufferPool::GetThreadCache() {
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+double AlignedBufferPool::GetHitRatio(void* arg) {
+    AlignedBufferPool* pool = static_cast<AlignedBufferPool*>(arg);
+    uint64_t hit = pool->GetHitCount();
+    uint64_t total = hit + pool->GetMissCount();
+    return total == 0 ? 0 : static_cast<double>(hit) / total;
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,183 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-14
+ * Author: yangyaokai
+ */
+
+#ifndef SRC_COMMON_ALIGNED_BUFFER_POOL_H_
+#define SRC_COMMON_ALIGNED_BUFFER_POOL_H_
+
+#include <bvar/bvar.h>
+#include <gflags/gflags.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curve {
+namespace common {
+
+DECLARE_uint64(alignedBufferPoolMaxCachedBytes);
+
+class AlignedBufferPool;
+
+/**
+ * 从AlignedBufferPool中获取的对齐内存，析构时自动归还给pool
+ * 内存内容不做初始化，使用方需要自己清零
+ */
+class AlignedBuffer {
+ public:
+    AlignedBuffer()
+        : data_(nullptr), size_(0), capacity_(0), sizeClass_(-1) {}
+    ~AlignedBuffer() {
+        Reset();
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept;
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    char* data() const {
+        return data_;
+    }
+
+    // 申请时指定的大小
+    size_t size() const {
+        return size_;
+    }
+
+    // 实际分配的大小，不小于size()
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * 提前把内存归还给pool
+     */
+    void Reset();
+
+ private:
+    friend class AlignedBufferPool;
+    AlignedBuffer(char* data, size_t size, size_t capacity, int sizeClass)
+        : data_(data), size_(size), capacity_(capacity),
+          sizeClass_(sizeClass) {}
+
+    char* data_;
+    size_t size_;
+    size_t capacity_;
+    // 所属的size class，-1表示不经过pool缓存，直接释放
+    int sizeClass_;
+};
+
+/**
+ * 进程级的对齐内存池，供WAL、chunk快照拷贝等需要O_DIRECT对齐内存的路径使用
+ * 按2的幂划分size class，每个线程有自己的本地缓存，线程缓存满了以后
+ * 放回按NUMA节点划分的共享缓存，共享缓存总量超过上限时直接释放。
+ * 内存由申请线程first touch，归还时优先留在本线程/本节点，
+ * 从而尽量保证内存和使用它的CPU在同一个节点上
+ */
+class AlignedBufferPool {
+ public:
+    static const size_t kAlignment = 4096;
+    static const size_t kMinBufferSize = 4096;
+    static const size_t kMaxBufferSize = 2 * 1024 * 1024;
+    static const int kSizeClassNum = 10;
+
+    static AlignedBufferPool* GetInstance();
+
+    /**
+     * 获取一块至少size大小、按alignment对齐的内存
+     * 超过kMaxBufferSize或者alignment大于kAlignment的请求不缓存，
+     * 直接向系统申请和释放
+     */
+    AlignedBuffer Get(size_t size, size_t alignment = kAlignment);
+
+    uint64_t GetHitCount() const {
+        return hit_.get_value();
+    }
+
+    uint64_t GetMissCount() const {
+        return miss_.get_value();
+    }
+
+    // 当前向系统申请且未释放的内存总量，包括正在使用和缓存的
+    int64_t GetFootprint() const {
+        return footprint_.get_value();
+    }
+
+    // 当前缓存在pool中未被使用的内存总量
+    int64_t GetCachedBytes() const {
+        return cached_.get_value();
+    }
+
+ private:
+    friend class AlignedBuffer;
+    struct ThreadCache;
+
+    struct NodeCache {
+        Mutex mtx;
+        std::vector<char*> lists[kSizeClassNum];
+    };
+
+    AlignedBufferPool();
+
+    void Put(char* data, int sizeClass);
+
+    // 线程退出时，把线程缓存中的内存放回共享缓存
+    void PutToNode(char* data, int sizeClass);
+
+    char* GetFromNode(int sizeClass);
+
+    char* Allocate(size_t size, size_t alignment);
+
+    void Free(char* data, size_t size);
+
+    int CurrentNode() const;
+
+    static int SizeClassOf(size_t size);
+
+    static size_t ClassSize(int sizeClass) {
+        return kMinBufferSize << sizeClass;
+    }
+
+    static ThreadCache* GetThreadCache();
+
+    static double GetHitRatio(void* arg);
+
+ private:
+    int nodeNum_;
+    std::vector<std::unique_ptr<NodeCache>> nodes_;
+    // 共享缓存中的内存总量，用于控制上限
+    std::atomic<uint64_t> nodeCachedBytes_;
+
+    bvar::Adder<uint64_t> hit_;
+    bvar::Adder<uint64_t> miss_;
+    bvar::Adder<int64_t> footprint_;
+    bvar::Adder<int64_t> cached_;
+    bvar::PassiveStatus<double> hitRatio_;
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_ALIGNED_BUFFER_POOL_H_
@@ -0,0 +1,316 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-23
+ * Author: yangyaokai
+ */
+
+#include <memory.h>
+#include <algorithm>
+#include <utility>
+
+#include "src/common/compact_bitmap.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+const uint8_t kFullUnit = 0xff;
+
+// 从持久化的bitmap中解析出置位的run，整字节全0或全1时跳过整个字节
+void FlatToRuns(uint32_t bits, const char* bitmap, vector<BitRange>* runs) {
+    runs->clear();
+    bool inRun = false;
+    uint32_t begin = 0;
+    uint32_t index = 0;
+    while (index < bits) {
+        uint8_t unit = static_cast<uint8_t>(bitmap[index >> ALIGN_FACTOR]);
+        if (index % BITMAP_UNIT_SIZE == 0
+            && index + BITMAP_UNIT_SIZE <= bits
+            && unit == (inRun ? kFullUnit : 0)) {
+            index += BITMAP_UNIT_SIZE;
+            continue;
+        }
+        bool set = unit & (0x01 << (index % BITMAP_UNIT_SIZE));
+        if (set && !inRun) {
+            begin = index;
+            inRun = true;
+        } else if (!set && inRun) {
+            runs->push_back({begin, index - 1});
+            inRun = false;
+        }
+        ++index;
+    }
+    if (inRun) {
+        runs->push_back({begin, bits - 1});
+    }
+}
+
+// 将持久化格式的bitmap中[begin, end]的位置1
+void SetFlatRange(char* bitmap, uint32_t begin, uint32_t end) {
+    uint32_t index = begin;
+    while (index <= end) {
+        if (index % BITMAP_UNIT_SIZE == 0
+            && end - index >= BITMAP_UNIT_SIZE - 1) {
+            bitmap[index >> ALIGN_FACTOR] = kFullUnit;
+            index += BITMAP_UNIT_SIZE;
+            continue;
+        }
+        bitmap[index >> ALIGN_FACTOR] |= 0x01 << (index % BITMAP_UNIT_SIZE);
+        ++index;
+    }
+}
+
+// 合并两组有序的run，相交或相邻的run合并为一个
+vector<BitRange> MergeRuns(const vector<BitRange>& a,
+                           const vector<BitRange>& b) {
+    vector<BitRange> result;
+    result.reserve(a.size() + b.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() || j < b.size()) {
+        bool fromA = j >= b.size()
+                     || (i < a.size() && a[i].beginIndex <= b[j].beginIndex);
+        const BitRange& next = fromA ? a[i++] : b[j++];
+        if (!result.empty()
+            && next.beginIndex <= result.back().endIndex + 1) {
+            result.back().endIndex =
+                std::max(result.back().endIndex, next.endIndex);
+        } else {
+            result.push_back(next);
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+CompactBitmap::CompactBitmap(uint32_t bits) : bits_(bits) {}
+
+CompactBitmap::CompactBitmap(uint32_t bits, const char* bitmap)
+    : bits_(bits) {
+    if (bitmap != nullptr) {
+        vector<BitRange> runs;
+        FlatToRuns(bits_, bitmap, &runs);
+        assign(std::move(runs));
+    }
+}
+
+CompactBitmap::CompactBitmap(const Bitmap& bitmap)
+    : CompactBitmap(bitmap.Size(), bitmap.GetBitmap()) {}
+
+CompactBitmap::CompactBitmap(uint32_t bits, vector<BitRange>&& runs)
+    : bits_(bits) {
+    assign(std::move(runs));
+}
+
+void CompactBitmap::assign(vector<BitRange>&& runs) {
+    if (runs.size() * sizeof(BitRange) > unitCount()) {
+        vector<char> bitmap(unitCount(), 0);
+        for (auto& run : runs) {
+            SetFlatRange(bitmap.data(), run.beginIndex, run.endIndex);
+        }
+        flat_.reset(new Bitmap(bits_, bitmap.data()));
+        runs_.clear();
+        runs_.shrink_to_fit();
+    } else {
+        runs_ = std::move(runs);
+        runs_.shrink_to_fit();
+        flat_ = nullptr;
+    }
+}
+
+void CompactBitmap::getRuns(vector<BitRange>* runs) const {
+    if (flat_ != nullptr) {
+        FlatToRuns(bits_, flat_->GetBitmap(), runs);
+    } else {
+        *runs = runs_;
+    }
+}
+
+vector<BitRange>::const_iterator CompactBitmap::lowerRun(
+    uint32_t index) const {
+    return std::lower_bound(runs_.begin(), runs_.end(), index,
+        [](const BitRange& run, uint32_t index) {
+            return run.endIndex < index;
+        });
+}
+
+bool CompactBitmap::operator == (const CompactBitmap& bitmap) const {
+    if (bits_ != bitmap.Size())
+        return false;
+    vector<BitRange> runs;
+    vector<BitRange> otherRuns;
+    getRuns(&runs);
+    bitmap.getRuns(&otherRuns);
+    if (runs.size() != otherRuns.size())
+        return false;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].beginIndex != otherRuns[i].beginIndex
+            || runs[i].endIndex != otherRuns[i].endIndex)
+            return false;
+    }
+    return true;
+}
+
+bool CompactBitmap::operator != (const CompactBitmap& bitmap) const {
+    return !(*this == bitmap);
+}
+
+CompactBitmapPtr CompactBitmap::Set(const std::set<uint32_t>& indexes) const {
+    vector<BitRange> added;
+    for (uint32_t index : indexes) {
+        if (index >= bits_)
+            break;
+        if (!added.empty() && added.back().endIndex + 1 == index) {
+            added.back().endIndex = index;
+        } else {
+            added.push_back({index, index});
+        }
+    }
+    vector<BitRange> runs;
+    getRuns(&runs);
+    return CompactBitmapPtr(
+        new CompactBitmap(bits_, MergeRuns(runs, added)));
+}
+
+CompactBitmapPtr CompactBitmap::Set(uint32_t startIndex,
+                                    uint32_t endIndex) const {
+    vector<BitRange> added;
+    if (bits_ > 0) {
+        endIndex = std::min(endIndex, bits_ - 1);
+        if (startIndex <= endIndex)
+            added.push_back({startIndex, endIndex});
+    }
+    vector<BitRange> runs;
+    getRuns(&runs);
+    return CompactBitmapPtr(
+        new CompactBitmap(bits_, MergeRuns(runs, added)));
+}
+
+bool CompactBitmap::Test(uint32_t index) const {
+    if (flat_ != nullptr)
+        return flat_->Test(index);
+    if (index >= bits_)
+        return false;
+    auto it = lowerRun(index);
+    return it != runs_.end() && it->beginIndex <= index;
+}
+
+uint32_t CompactBitmap::NextSetBit(uint32_t index) const {
+    if (bits_ == 0)
+        return Bitmap::NO_POS;
+    return NextSetBit(index, bits_ - 1);
+}
+
+uint32_t CompactBitmap::NextSetBit(uint32_t startIndex,
+                                   uint32_t endIndex) const {
+    if (flat_ != nullptr)
+        return flat_->NextSetBit(startIndex, endIndex);
+    if (bits_ == 0)
+        return Bitmap::NO_POS;
+    endIndex = std::min(endIndex, bits_ - 1);
+    if (startIndex > endIndex)
+        return Bitmap::NO_POS;
+    auto it = lowerRun(startIndex);
+    if (it == runs_.end())
+        return Bitmap::NO_POS;
+    uint32_t index = std::max(it->beginIndex, startIndex);
+    return index <= endIndex ? index : Bitmap::NO_POS;
+}
+
+uint32_t CompactBitmap::NextClearBit(uint32_t index) const {
+    if (bits_ == 0)
+        return Bitmap::NO_POS;
+    return NextClearBit(index, bits_ - 1);
+}
+
+uint32_t CompactBitmap::NextClearBit(uint32_t startIndex,
+                                     uint32_t endIndex) const {
+    if (flat_ != nullptr)
+        return flat_->NextClearBit(startIndex, endIndex);
+    if (bits_ == 0)
+        return Bitmap::NO_POS;
+    endIndex = std::min(endIndex, bits_ - 1);
+    if (startIndex > endIndex)
+        return Bitmap::NO_POS;
+    auto it = lowerRun(startIndex);
+    if (it == runs_.end() || it->beginIndex > startIndex)
+        return startIndex;
+    // run之间不相邻，run之后的第一位一定为0
+    uint32_t index = it->endIndex + 1;
+    return index <= endIndex ? index : Bitmap::NO_POS;
+}
+
+void CompactBitmap::Divide(uint32_t startIndex,
+                           uint32_t endIndex,
+                           vector<BitRange>* clearRanges,
+                           vector<BitRange>* setRanges) const {
+    if (flat_ != nullptr) {
+        flat_->Divide(startIndex, endIndex, clearRanges, setRanges);
+        return;
+    }
+    if (endIndex < startIndex || bits_ == 0)
+        return;
+    endIndex = std::min(endIndex, bits_ - 1);
+
+    vector<BitRange> tmpClearRanges;
+    vector<BitRange> tmpSetRanges;
+    // 下一个未划分的位置
+    uint64_t index = startIndex;
+    for (auto it = lowerRun(startIndex);
+         it != runs_.end() && it->beginIndex <= endIndex; ++it) {
+        uint32_t begin = std::max(it->beginIndex, startIndex);
+        uint32_t end = std::min(it->endIndex, endIndex);
+        if (begin > index) {
+            tmpClearRanges.push_back(
+                {static_cast<uint32_t>(index), begin - 1});
+        }
+        tmpSetRanges.push_back({begin, end});
+        index = static_cast<uint64_t>(end) + 1;
+    }
+    if (index <= endIndex) {
+        tmpClearRanges.push_back({static_cast<uint32_t>(index), endIndex});
+    }
+
+    if (clearRanges != nullptr) {
+        *clearRanges = std::move(tmpClearRanges);
+    }
+    if (setRanges != nullptr) {
+        *setRanges = std::move(tmpSetRanges);
+    }
+}
+
+uint32_t CompactBitmap::Size() const {
+    return bits_;
+}
+
+void CompactBitmap::Encode(char* buf) const {
+    if (flat_ != nullptr) {
+        memcpy(buf, flat_->GetBitmap(), unitCount());
+        return;
+    }
+    memset(buf, 0, unitCount());
+    for (auto& run : runs_) {
+        SetFlatRange(buf, run.beginIndex, run.endIndex);
+    }
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-23
+ * Author: yangyaokai
+ */
+
+#ifndef SRC_COMMON_COMPACT_BITMAP_H_
+#define SRC_COMMON_COMPACT_BITMAP_H_
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "src/common/bitmap.h"
+
+namespace curve {
+namespace common {
+
+class CompactBitmap;
+using CompactBitmapPtr = std::shared_ptr<const CompactBitmap>;
+
+/**
+ * 不可变的压缩bitmap
+ * 以有序的置位连续区域(run)表示，run的内存超过普通bitmap时退化为普通bitmap，
+ * 取两者中内存较小的一种；查询直接在压缩形式上进行
+ * 对象构造后不再修改，通过CompactBitmapPtr在读者之间共享，
+ * 修改时由Set基于当前版本生成新的版本，写者发布新版本后持有旧版本的读者不受影响
+ */
+class CompactBitmap {
+ public:
+    /**
+     * 构造所有位为0的bitmap
+     * @param bits: bitmap的位数
+     */
+    explicit CompactBitmap(uint32_t bits);
+    /**
+     * 从持久化的bitmap构造，格式同Bitmap::GetBitmap
+     * @param bits: bitmap的位数
+     * @param bitmap: 持久化的bitmap，为nullptr时所有位为0
+     */
+    CompactBitmap(uint32_t bits, const char* bitmap);
+    /**
+     * 从普通bitmap构造
+     */
+    explicit CompactBitmap(const Bitmap& bitmap);
+    CompactBitmap(const CompactBitmap&) = delete;
+    CompactBitmap& operator = (const CompactBitmap&) = delete;
+
+    bool operator == (const CompactBitmap& bitmap) const;
+    bool operator != (const CompactBitmap& bitmap) const;
+
+    /**
+     * 生成将指定位置1后的新版本，当前版本不变
+     * @param indexes: 要置1的位
+     * @return: 新版本的bitmap
+     */
+    CompactBitmapPtr Set(const std::set<uint32_t>& indexes) const;
+    /**
+     * 生成将指定范围的位置1后的新版本，当前版本不变
+     * @param startIndex: 范围起始位置,包括此位置
+     * @param endIndex: 范围结束位置，包括此位置
+     * @return: 新版本的bitmap
+     */
+    CompactBitmapPtr Set(uint32_t startIndex, uint32_t endIndex) const;
+
+    /**
+     * 以下查询接口的语义同Bitmap
+     */
+    bool Test(uint32_t index) const;
+    uint32_t NextSetBit(uint32_t index) const;
+    uint32_t NextSetBit(uint32_t startIndex, uint32_t endIndex) const;
+    uint32_t NextClearBit(uint32_t index) const;
+    uint32_t NextClearBit(uint32_t startIndex, uint32_t endIndex) const;
+    void Divide(uint32_t startIndex,
+                uint32_t endIndex,
+                vector<BitRange>* clearRanges,
+                vector<BitRange>* setRanges) const;
+    uint32_t Size() const;
+
+    /**
+     * 按Bitmap::GetBitmap的格式输出bitmap，用于持久化
+     * @param buf: 输出的buffer，长度至少为(bits + 7) / 8字节
+     */
+    void Encode(char* buf) const;
+    /**
+     * 是否以run的形式表示，用于测试
+     */
+    bool IsCompressed() const {
+        return flat_ == nullptr;
+    }
+
+ private:
+    CompactBitmap(uint32_t bits, vector<BitRange>&& runs);
+    // 根据run的数量选择表示形式
+    void assign(vector<BitRange>&& runs);
+    // 获取所有置位的run
+    void getRuns(vector<BitRange>* runs) const;
+    // 第一个endIndex不小于index的run
+    vector<BitRange>::const_iterator lowerRun(uint32_t index) const;
+
+    inline uint32_t unitCount() const {
+        return (bits_ + BITMAP_UNIT_SIZE - 1) >> ALIGN_FACTOR;
+    }
+
+ private:
+    uint32_t bits_;
+    // 有序、不相交且不相邻的置位区域，flat_不为nullptr时为空
+    vector<BitRange> runs_;
+    // run的内存超过普通bitmap时使用的普通bitmap
+    std::unique_ptr<Bitmap> flat_;
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_COMPACT_BITMAP_H_
@@ -24,6 +24,7 @@
 #define SRC_COMMON_CONCURRENT_BOUNDED_BLOCKING_QUEUE_H_
 
 #include <cassert>
+#include <chrono>               //NOLINT
 #include <cstdio>
 #include <condition_variable>   //NOLINT
 #include <deque>
@@ -100,6 +101,23 @@ class BoundedBlockingDeque : public Uncopyable {
         notEmpty_.notify_one();
     }
 
+    /**
+     * 一次放入多个元素，只加一次锁，放入之后统一唤醒等待的线程
+     */
+    template<typename Iterator>
+    void PutBack(Iterator first, Iterator last) {
+        std::unique_lock<std::mutex> guard(mutex_);
+        for (; first != last; ++first) {
+            while (deque_.size() == capacity_) {
+                // 队列已满时先唤醒消费者取走已经放入的元素
+                notEmpty_.notify_all();
+                notFull_.wait(guard);
+            }
+            deque_.push_back(*first);
+        }
+        notEmpty_.notify_all();
+    }
+
     void PutFront(const T &x) {
         std::unique_lock<std::mutex> guard(mutex_);
         while (deque_.size() == capacity_) {
@@ -120,6 +138,35 @@ class BoundedBlockingDeque : public Uncopyable {
         return front;
     }
 
+    /**
+     * 队首元素满足条件时将其取出，队列为空时最多等待waitUs
+     * @param pred: 判断队首元素是否可以取出
+     * @param waitUs: 队列为空时的最长等待时间
+     * @param[out] out: 取出的元素
+     * @return 是否取出了元素
+     */
+    template<typename Pred>
+    bool TakeFrontIf(Pred pred, uint64_t waitUs, T *out) {
+        std::unique_lock<std::mutex> guard(mutex_);
+        bool waited = false;
+        if (deque_.empty() && waitUs > 0) {
+            waited = notEmpty_.wait_for(guard,
+                                        std::chrono::microseconds(waitUs),
+                                        [this]() { return !deque_.empty(); });
+        }
+        if (deque_.empty() || !pred(deque_.front())) {
+            // 把被消费掉的通知转给其他等待的线程
+            if (waited) {
+                notEmpty_.notify_one();
+            }
+            return false;
+        }
+        *out = std::move(deque_.front());
+        deque_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
     T TakeBack() {
         std::unique_lock<std::mutex> guard(mutex_);
         while (deque_.empty()) {
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-16
+ * Author: lixiaocui
+ */
+
+#ifndef SRC_COMMON_CONCURRENT_MPMC_QUEUE_H_
+#define SRC_COMMON_CONCURRENT_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace curve {
+namespace common {
+
+/**
+ * 有界的无锁多生产者多消费者队列，基于Dmitry Vyukov的环形队列实现
+ * 每个槽位带有序号，生产者和消费者各自通过CAS推进位置，不需要加锁。
+ * 队列满或者空时TryPush/TryPop直接返回false，由调用方决定如何等待
+ */
+template <typename T>
+class MPMCQueue {
+ public:
+    /**
+     * @param capacity: 队列容量，会向上取整为2的幂，最小为2
+     */
+    explicit MPMCQueue(size_t capacity)
+        : capacity_(RoundUp(capacity)),
+          mask_(capacity_ - 1),
+          cells_(new Cell[capacity_]),
+          enqueuePos_(0),
+          dequeuePos_(0) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    /**
+     * 入队，成功时value会被move走，失败时value保持不变
+     * @return 队列满返回false
+     */
+    bool TryPush(T* value) {
+        Cell* cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(*value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(T value) {
+        return TryPush(&value);
+    }
+
+    /**
+     * 出队
+     * @return 队列空返回false
+     */
+    bool TryPop(T* value) {
+        Cell* cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        *value = std::move(cell->data);
+        cell->data = T();
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 队列中元素的近似个数，并发修改时只作为参考
+     */
+    size_t SizeApprox() const {
+        size_t enqueue = enqueuePos_.load(std::memory_order_relaxed);
+        size_t dequeue = dequeuePos_.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+ private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    static size_t RoundUp(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static const size_t kCacheLineSize = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    // 生产者和消费者的位置放在不同的cache line上，避免伪共享
+    char pad0_[kCacheLineSize];
+    std::atomic<size_t> enqueuePos_;
+    char pad1_[kCacheLineSize];
+    std::atomic<size_t> dequeuePos_;
+    char pad2_[kCacheLineSize];
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_CONCURRENT_MPMC_QUEUE_H_
@@ -0,0 +1,212 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_COMMON_OBJECT_POOL_H_
+#define SRC_COMMON_OBJECT_POOL_H_
+
+#include <bvar/bvar.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curve {
+namespace common {
+
+/**
+ * 固定类型对象的内存池，用于IO路径上频繁申请释放的小对象
+ * 每个线程有自己的本地缓存，本地缓存满了以后把一半放回共享缓存，
+ * 本地缓存为空时从共享缓存批量取回，共享缓存超过上限时直接释放。
+ * 在一个线程申请、另一个线程释放的对象（例如在rpc回调中释放的请求）
+ * 通过共享缓存回到申请线程，锁的开销由批量移动分摊。
+ *
+ * New每次都会重新构造对象，只复用内存，对象的状态和直接new出来的一样。
+ * live_count为当前申请且未释放的对象数，长期增长说明有对象泄漏。
+ */
+template <typename T>
+class ObjectPool {
+ public:
+    // 每个线程最多缓存的对象数
+    static const size_t kThreadCacheSize = 256;
+    // 本地缓存和共享缓存之间一次移动的对象数
+    static const size_t kBatchSize = kThreadCacheSize / 2;
+    // 共享缓存最多缓存的对象数
+    static const size_t kSharedCacheSize = 64 * kThreadCacheSize;
+
+    static ObjectPool* GetInstance() {
+        // 线程缓存在线程退出时会访问pool，pool不随进程退出析构
+        static ObjectPool* instance = new ObjectPool();
+        return instance;
+    }
+
+    /**
+     * 构造一个对象，内存不足时返回nullptr
+     */
+    template <typename... Args>
+    T* New(Args&&... args) {
+        void* mem = nullptr;
+        ThreadCache* cache = GetThreadCache();
+        if (cache->blocks.empty()) {
+            GetFromShared(&cache->blocks);
+        }
+        if (!cache->blocks.empty()) {
+            mem = cache->blocks.back();
+            cache->blocks.pop_back();
+            cached_ << -1;
+        } else {
+            mem = Allocate();
+            if (mem == nullptr) {
+                return nullptr;
+            }
+        }
+
+        live_ << 1;
+        return new (mem) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * 析构一个由New构造的对象，并回收其内存
+     */
+    void Delete(T* obj) {
+        if (obj == nullptr) {
+            return;
+        }
+
+        obj->~T();
+        live_ << -1;
+        cached_ << 1;
+
+        ThreadCache* cache = GetThreadCache();
+        cache->blocks.push_back(obj);
+        if (cache->blocks.size() > kThreadCacheSize) {
+            PutToShared(&cache->blocks, kBatchSize);
+        }
+    }
+
+    // 当前申请且未释放的对象数
+    int64_t GetLiveCount() const {
+        return live_.get_value();
+    }
+
+    // 当前缓存在pool中未被使用的对象数
+    int64_t GetCachedCount() const {
+        return cached_.get_value();
+    }
+
+    // 向系统申请内存的次数
+    uint64_t GetAllocCount() const {
+        return alloc_.get_value();
+    }
+
+    /**
+     * 以prefix为前缀暴露统计信息
+     */
+    void Expose(const std::string& prefix) {
+        live_.expose_as(prefix, "live_count");
+        cached_.expose_as(prefix, "cached_count");
+        alloc_.expose_as(prefix, "alloc_count");
+    }
+
+ private:
+    struct ThreadCache {
+        std::vector<void*> blocks;
+
+        ~ThreadCache() {
+            ObjectPool::GetInstance()->PutToShared(&blocks, blocks.size());
+        }
+    };
+
+    ObjectPool() : sharedCount_(0) {}
+
+    static ThreadCache* GetThreadCache() {
+        static thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    void* Allocate() {
+        void* mem = nullptr;
+        size_t alignment = std::max(alignof(T), sizeof(void*));
+        if (posix_memalign(&mem, alignment, sizeof(T)) != 0) {
+            return nullptr;
+        }
+        alloc_ << 1;
+        return mem;
+    }
+
+    // 把blocks末尾的count个对象放回共享缓存，超过上限的直接释放
+    void PutToShared(std::vector<void*>* blocks, size_t count) {
+        size_t start = blocks->size() - count;
+        {
+            LockGuard lk(mtx_);
+            while (blocks->size() > start &&
+                   shared_.size() < kSharedCacheSize) {
+                shared_.push_back(blocks->back());
+                blocks->pop_back();
+            }
+            sharedCount_.store(shared_.size(), std::memory_order_relaxed);
+        }
+        while (blocks->size() > start) {
+            free(blocks->back());
+            blocks->pop_back();
+            cached_ << -1;
+        }
+    }
+
+    void GetFromShared(std::vector<void*>* blocks) {
+        // 共享缓存为空时不加锁，避免每次申请都竞争锁
+        if (sharedCount_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        LockGuard lk(mtx_);
+        size_t count = std::min(kBatchSize, shared_.size());
+        blocks->insert(blocks->end(), shared_.end() - count, shared_.end());
+        shared_.resize(shared_.size() - count);
+        sharedCount_.store(shared_.size(), std::memory_order_relaxed);
+    }
+
+ private:
+    Mutex mtx_;
+    std::vector<void*> shared_;
+    std::atomic<size_t> sharedCount_;
+
+    bvar::Adder<int64_t> live_;
+    bvar::Adder<int64_t> cached_;
+    bvar::Adder<uint64_t> alloc_;
+};
+
+template <typename T>
+const size_t ObjectPool<T>::kThreadCacheSize;
+template <typename T>
+const size_t ObjectPool<T>::kBatchSize;
+template <typename T>
+const size_t ObjectPool<T>::kSharedCacheSize;
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_OBJECT_POOL_H_
@@ -118,6 +118,21 @@ int Ext4FileSystemImpl::Init(const LocalFileSystemOption& option) {
         if (!CheckKernelVersion())
             return -1;
     }
+    if (option.enableIoUring && aioEngine_ == nullptr) {
+        // 内核不支持io_uring时仍然可以工作，异步接口退化为同步IO
+        if (!IoUringEngine::IsSupported()) {
+            LOG(WARNING) << "io_uring is not supported by kernel, "
+                         << "fall back to synchronous io.";
+            return 0;
+        }
+        auto engine = std::make_shared<IoUringEngine>();
+        int rc = engine->Init(option.ioUringQueueDepth);
+        if (rc < 0) {
+            LOG(ERROR) << "Init io_uring engine failed: " << strerror(-rc);
+            return rc;
+        }
+        aioEngine_ = engine;
+    }
     return 0;
 }
 
@@ -394,5 +409,70 @@ int Ext4FileSystemImpl::Fsync(int fd) {
     return 0;
 }
 
+int Ext4FileSystemImpl::CloneRange(int srcFd,
+                                   uint64_t srcOffset,
+                                   int dstFd,
+                                   uint64_t dstOffset,
+                                   int length) {
+    struct file_clone_range range;
+    range.src_fd = srcFd;
+    range.src_offset = srcOffset;
+    range.src_length = length;
+    range.dest_offset = dstOffset;
+    int rc = posixWrapper_->ficlonerange(dstFd, &range);
+    if (rc < 0) {
+        // 文件系统不支持reflink时由调用方回退到拷贝，不打印错误
+        if (errno != EOPNOTSUPP && errno != EXDEV && errno != EINVAL) {
+            LOG(ERROR) << "ficlonerange failed: " << strerror(errno);
+        }
+        return -errno;
+    }
+    return 0;
+}
+
+bool Ext4FileSystemImpl::AsyncIOEnabled() {
+    return aioEngine_ != nullptr;
+}
+
+int Ext4FileSystemImpl::ReadAsync(int fd,
+                                  char *buf,
+                                  uint64_t offset,
+                                  int length,
+                                  AioCallback cb) {
+    if (aioEngine_ == nullptr) {
+        return LocalFileSystem::ReadAsync(fd, buf, offset, length, cb);
+    }
+    return aioEngine_->SubmitRead(fd, buf, offset, length, cb);
+}
+
+int Ext4FileSystemImpl::WriteAsync(int fd,
+                                   const char *buf,
+                                   uint64_t offset,
+                                   int length,
+                                   AioCallback cb) {
+    if (aioEngine_ == nullptr) {
+        return LocalFileSystem::WriteAsync(fd, buf, offset, length, cb);
+    }
+    return aioEngine_->SubmitWrite(fd, buf, offset, length, cb);
+}
+
+int Ext4FileSystemImpl::WriteAsync(int fd,
+                                   const butil::IOBuf& buf,
+                                   uint64_t offset,
+                                   int length,
+                                   AioCallback cb) {
+    if (aioEngine_ == nullptr) {
+        return LocalFileSystem::WriteAsync(fd, buf, offset, length, cb);
+    }
+    return aioEngine_->SubmitWrite(fd, buf, offset, length, cb);
+}
+
+int Ext4FileSystemImpl::FsyncAsync(int fd, AioCallback cb) {
+    if (aioEngine_ == nullptr) {
+        return LocalFileSystem::FsyncAsync(fd, cb);
+    }
+    return aioEngine_->SubmitFsync(fd, cb);
+}
+
 }  // namespace fs
 }  // namespace curve
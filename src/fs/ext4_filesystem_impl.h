@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "src/fs/local_filesystem.h"
+#include "src/fs/io_uring_engine.h"
 #include "src/fs/wrap_posix.h"
 
 const int MAX_RETYR_TIME = 3;
@@ -60,6 +61,16 @@ class Ext4FileSystemImpl : public LocalFileSystem {
                   int length) override;
     int Fstat(int fd, struct stat* info) override;
     int Fsync(int fd) override;
+    int CloneRange(int srcFd, uint64_t srcOffset,
+                   int dstFd, uint64_t dstOffset, int length) override;
+    bool AsyncIOEnabled() override;
+    int ReadAsync(int fd, char* buf, uint64_t offset, int length,
+                  AioCallback cb) override;
+    int WriteAsync(int fd, const char* buf, uint64_t offset, int length,
+                   AioCallback cb) override;
+    int WriteAsync(int fd, const butil::IOBuf& buf, uint64_t offset,
+                   int length, AioCallback cb) override;
+    int FsyncAsync(int fd, AioCallback cb) override;
 
  private:
     explicit Ext4FileSystemImpl(std::shared_ptr<PosixWrapper>);
@@ -73,6 +84,8 @@ class Ext4FileSystemImpl : public LocalFileSystem {
     static std::mutex mutex_;
     std::shared_ptr<PosixWrapper> posixWrapper_;
     bool enableRenameat2_;
+    // 开启io_uring时的异步IO引擎，为nullptr时异步接口退化为同步IO
+    std::shared_ptr<IoUringEngine> aioEngine_;
 };
 
 }  // namespace fs
@@ -23,6 +23,9 @@
 #ifndef SRC_FS_FS_COMMON_H_
 #define SRC_FS_FS_COMMON_H_
 
+#include <stdint.h>
+#include <functional>
+
 namespace curve {
 namespace fs {
 
@@ -38,6 +41,12 @@ struct FileSystemInfo {
     uint64_t stored = 0;        // Bytes actually stored by the user
 };
 
+/**
+ * 异步IO完成后的回调
+ * 参数为IO结果，与对应同步接口的返回值含义相同
+ */
+typedef std::function<void(int)> AioCallback;
+
 }  // namespace fs
 }  // namespace curve
 #endif  // SRC_FS_FS_COMMON_H_
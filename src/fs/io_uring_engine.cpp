@@ -0,0 +1,538 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: 2020-12-07
+ * Author: yangyaokai
+ */
+
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "src/fs/io_uring_engine.h"
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+namespace curve {
+namespace fs {
+
+namespace {
+
+const int kMaxRetryTimes = 3;
+// io_uring_enter等待失败后重试的最大退避时间
+const int kMaxReapBackoffMs = 1000;
+
+// ring本身已经不可用，重试也不会成功
+bool IsFatalRingError(int err) {
+    return err == EBADF || err == EFAULT || err == EINVAL
+        || err == ENXIO || err == EOPNOTSUPP;
+}
+
+int IoUringSetup(uint32_t entries, struct io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int IoUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete,
+                 uint32_t flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+IoUringEngine::IoUringEngine()
+    : ringFd_(-1)
+    , queueDepth_(0)
+    , running_(false)
+    , inflight_(0)
+    , sqRing_(MAP_FAILED)
+    , sqRingSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqMask_(nullptr)
+    , sqArray_(nullptr)
+    , sqes_(reinterpret_cast<struct io_uring_sqe*>(MAP_FAILED))
+    , sqesSize_(0)
+    , cqRing_(MAP_FAILED)
+    , cqRingSize_(0)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(nullptr)
+    , cqes_(nullptr)
+    , ringBroken_(false) {}
+
+IoUringEngine::~IoUringEngine() {
+    Stop();
+}
+
+bool IoUringEngine::IsSupported() {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = IoUringSetup(1, &p);
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+int IoUringEngine::Init(uint32_t queueDepth) {
+    if (running_.load()) {
+        return 0;
+    }
+    // 释放出错后停止的ring
+    Stop();
+    if (queueDepth == 0) {
+        LOG(ERROR) << "io_uring queue depth must be greater than 0";
+        return -EINVAL;
+    }
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ringFd_ = IoUringSetup(queueDepth, &p);
+    if (ringFd_ < 0) {
+        int err = errno;
+        LOG(ERROR) << "io_uring_setup failed: " << strerror(err);
+        return -err;
+    }
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    singleMmap = p.features & IORING_FEAT_SINGLE_MMAP;
+#endif
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        int err = errno;
+        LOG(ERROR) << "mmap io_uring sq ring failed: " << strerror(err);
+        ReleaseRing();
+        return -err;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            int err = errno;
+            LOG(ERROR) << "mmap io_uring cq ring failed: " << strerror(err);
+            ReleaseRing();
+            return -err;
+        }
+    }
+    sqesSize_ = p.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = reinterpret_cast<struct io_uring_sqe*>(
+        mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        int err = errno;
+        LOG(ERROR) << "mmap io_uring sqes failed: " << strerror(err);
+        ReleaseRing();
+        return -err;
+    }
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.head);
+    sqTail_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.tail);
+    sqMask_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.array);
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<uint32_t*>(cq + p.cq_off.head);
+    cqTail_ = reinterpret_cast<uint32_t*>(cq + p.cq_off.tail);
+    cqMask_ = reinterpret_cast<uint32_t*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    // 内核会把队列深度向上取整到2的幂，completion ring为其两倍，
+    // 限制在途请求数不超过sq_entries就不会发生completion溢出
+    queueDepth_ = p.sq_entries;
+    ringBroken_ = false;
+    running_.store(true);
+    reaper_ = std::thread(&IoUringEngine::ReapLoop, this);
+    LOG(INFO) << "Init io_uring engine success, queue depth: " << queueDepth_;
+    return 0;
+}
+
+void IoUringEngine::Stop() {
+    bool broken = false;
+    {
+        // 与Submit在同一把锁下修改running_，之后不会再有新的在途请求
+        std::unique_lock<std::mutex> lk(slotMutex_);
+        // reap线程因ring出错退出时running_已经为false，但ring还需要释放
+        broken = ringBroken_;
+        ringBroken_ = false;
+        if (!running_.load() && !broken) {
+            return;
+        }
+        running_.store(false);
+        slotCond_.notify_all();
+        slotCond_.wait(lk, [this]() { return inflight_.load() == 0; });
+    }
+    if (!broken) {
+        // 提交一个空请求唤醒reap线程
+        std::lock_guard<std::mutex> lk(sqMutex_);
+        IoRequest* wakeup = nullptr;
+        PushSqe(wakeup);
+    }
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+    ReleaseRing();
+    LOG(INFO) << "Stop io_uring engine success.";
+}
+
+void IoUringEngine::ReleaseRing() {
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, sqesSize_);
+        sqes_ = reinterpret_cast<struct io_uring_sqe*>(MAP_FAILED);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = MAP_FAILED;
+    if (sqRing_ != MAP_FAILED) {
+        munmap(sqRing_, sqRingSize_);
+        sqRing_ = MAP_FAILED;
+    }
+    if (ringFd_ >= 0) {
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+}
+
+int IoUringEngine::SubmitRead(int fd, char* buf, uint64_t offset, int length,
+                              AioCallback cb) {
+    IoRequest* req = new IoRequest();
+    req->type = IoType::READ;
+    req->fd = fd;
+    req->buf = buf;
+    req->offset = offset;
+    req->length = length;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = cb;
+    return Submit(req);
+}
+
+int IoUringEngine::SubmitWrite(int fd, const char* buf, uint64_t offset,
+                               int length, AioCallback cb) {
+    IoRequest* req = new IoRequest();
+    req->type = IoType::WRITE;
+    req->fd = fd;
+    req->buf = const_cast<char*>(buf);
+    req->offset = offset;
+    req->length = length;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = cb;
+    return Submit(req);
+}
+
+int IoUringEngine::SubmitWrite(int fd, const butil::IOBuf& buf,
+                               uint64_t offset, int length, AioCallback cb) {
+    IoRequest* req = new IoRequest();
+    req->type = IoType::WRITEV;
+    req->fd = fd;
+    req->buf = nullptr;
+    buf.append_to(&req->data, length);
+    req->offset = offset;
+    req->length = length;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = cb;
+    return Submit(req);
+}
+
+int IoUringEngine::SubmitFsync(int fd, AioCallback cb) {
+    IoRequest* req = new IoRequest();
+    req->type = IoType::FSYNC;
+    req->fd = fd;
+    req->buf = nullptr;
+    req->offset = 0;
+    req->length = 0;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = cb;
+    return Submit(req);
+}
+
+int IoUringEngine::Submit(IoRequest* req) {
+    if (!running_.load()) {
+        delete req;
+        return -ESHUTDOWN;
+    }
+    {
+        std::unique_lock<std::mutex> lk(slotMutex_);
+        slotCond_.wait(lk, [this]() {
+            return !running_.load() || inflight_.load() < queueDepth_;
+        });
+        // 等待期间可能已经Stop
+        if (!running_.load()) {
+            delete req;
+            return -ESHUTDOWN;
+        }
+        inflight_.fetch_add(1);
+        pending_.insert(req);
+    }
+
+    int rc = 0;
+    {
+        std::lock_guard<std::mutex> lk(sqMutex_);
+        rc = PushSqe(req);
+    }
+    if (rc < 0) {
+        std::lock_guard<std::mutex> lk(slotMutex_);
+        if (pending_.erase(req) == 0) {
+            // ring出错时reap线程已经以错误回调了该请求
+            return 0;
+        }
+        inflight_.fetch_sub(1);
+        slotCond_.notify_all();
+        delete req;
+    }
+    return rc;
+}
+
+int IoUringEngine::PushSqe(IoRequest* req) {
+    uint32_t tail = *sqTail_;
+    uint32_t index = tail & *sqMask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    PrepareSqe(req, sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+    int retryTimes = 0;
+    while (true) {
+        int ret = IoUringEnter(ringFd_, 1, 0, 0);
+        if (ret >= 0) {
+            return 0;
+        }
+        if ((errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            && retryTimes < kMaxRetryTimes) {
+            ++retryTimes;
+            continue;
+        }
+        int err = errno;
+        LOG(ERROR) << "io_uring_enter submit failed: " << strerror(err);
+        // 回滚未被内核消费的sqe
+        if (__atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == tail) {
+            __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+        }
+        return -err;
+    }
+}
+
+void IoUringEngine::PrepareSqe(IoRequest* req, struct io_uring_sqe* sqe) {
+    memset(sqe, 0, sizeof(*sqe));
+    if (req == nullptr) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        return;
+    }
+
+    sqe->fd = req->fd;
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    switch (req->type) {
+        case IoType::READ:
+        case IoType::WRITE: {
+            req->iovs.resize(1);
+            req->iovs[0].iov_base = req->buf + req->done;
+            req->iovs[0].iov_len = req->length - req->done;
+            sqe->opcode = req->type == IoType::READ ? IORING_OP_READV
+                                                     : IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(req->iovs.data());
+            sqe->len = 1;
+            sqe->off = req->offset + req->done;
+            break;
+        }
+        case IoType::WRITEV: {
+            // data中只保留尚未写入的部分，短写后已经从头部裁掉
+            size_t blockNum = std::min(req->data.backing_block_num(),
+                                       static_cast<size_t>(IOV_MAX));
+            req->iovs.resize(blockNum);
+            for (size_t i = 0; i < blockNum; ++i) {
+                butil::StringPiece block = req->data.backing_block(i);
+                req->iovs[i].iov_base = const_cast<char*>(block.data());
+                req->iovs[i].iov_len = block.size();
+            }
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(req->iovs.data());
+            sqe->len = blockNum;
+            sqe->off = req->offset + req->done;
+            break;
+        }
+        case IoType::FSYNC:
+            sqe->opcode = IORING_OP_FSYNC;
+            break;
+    }
+}
+
+void IoUringEngine::ReapLoop() {
+    int backoffMs = 0;
+    while (true) {
+        int ret = IoUringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR) {
+            int err = errno;
+            LOG_EVERY_SECOND(ERROR) << "io_uring_enter wait failed: "
+                                    << strerror(err);
+            if (IsFatalRingError(err)) {
+                FailPending(-err);
+                return;
+            }
+            // ENOMEM等错误可能持续一段时间，退避后再重试
+            backoffMs = std::min(std::max(backoffMs * 2, 1),
+                                 kMaxReapBackoffMs);
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(backoffMs));
+        } else {
+            backoffMs = 0;
+        }
+
+        bool stop = false;
+        uint32_t head = *cqHead_;
+        uint32_t tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe* cqe = &cqes_[head & *cqMask_];
+            IoRequest* req = reinterpret_cast<IoRequest*>(cqe->user_data);
+            int res = cqe->res;
+            ++head;
+            // 先归还cqe，HandleCompletion中可能会重新提交
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            if (req == nullptr) {
+                stop = true;
+                continue;
+            }
+            HandleCompletion(req, res);
+        }
+
+        if (stop && !running_.load()) {
+            break;
+        }
+    }
+}
+
+void IoUringEngine::FailPending(int res) {
+    std::unordered_set<IoRequest*> reqs;
+    {
+        std::lock_guard<std::mutex> lk(slotMutex_);
+        running_.store(false);
+        ringBroken_ = true;
+        slotCond_.notify_all();
+        reqs.swap(pending_);
+    }
+    LOG(ERROR) << "io_uring ring is broken, fail " << reqs.size()
+               << " inflight requests: " << strerror(-res);
+    for (auto req : reqs) {
+        Finish(req, res);
+    }
+}
+
+void IoUringEngine::HandleCompletion(IoRequest* req, int res) {
+    if (res < 0) {
+        if ((res == -EINTR || res == -EAGAIN)
+            && req->retryTimes < kMaxRetryTimes) {
+            ++req->retryTimes;
+            std::lock_guard<std::mutex> lk(sqMutex_);
+            if (PushSqe(req) == 0) {
+                return;
+            }
+        }
+        LOG(ERROR) << "io_uring request failed: " << strerror(-res)
+                   << ", fd: " << req->fd
+                   << ", offset: " << req->offset
+                   << ", length: " << req->length;
+        Finish(req, res);
+        return;
+    }
+
+    switch (req->type) {
+        case IoType::FSYNC:
+            Finish(req, 0);
+            return;
+        case IoType::READ:
+            // 如果offset大于文件长度，读会返回0
+            if (res == 0) {
+                LOG(WARNING) << "io_uring read returns zero."
+                             << "offset: " << req->offset + req->done
+                             << ", length: " << req->length - req->done;
+                Finish(req, req->done);
+                return;
+            }
+            break;
+        case IoType::WRITE:
+        case IoType::WRITEV:
+            if (res == 0) {
+                LOG(ERROR) << "io_uring write returns zero."
+                           << "offset: " << req->offset + req->done
+                           << ", length: " << req->length - req->done;
+                Finish(req, -EIO);
+                return;
+            }
+            if (req->type == IoType::WRITEV) {
+                req->data.pop_front(res);
+            }
+            break;
+    }
+
+    req->done += res;
+    if (req->done >= req->length) {
+        Finish(req, req->length);
+        return;
+    }
+
+    // 短读写，继续提交剩余部分
+    int rc = 0;
+    {
+        std::lock_guard<std::mutex> lk(sqMutex_);
+        rc = PushSqe(req);
+    }
+    if (rc < 0) {
+        Finish(req, rc);
+    }
+}
+
+void IoUringEngine::Finish(IoRequest* req, int res) {
+    if (req->cb) {
+        req->cb(res);
+    }
+    std::lock_guard<std::mutex> lk(slotMutex_);
+    pending_.erase(req);
+    delete req;
+    inflight_.fetch_sub(1);
+    slotCond_.notify_all();
+}
+
+}  // namespace fs
+}  // namespace curve
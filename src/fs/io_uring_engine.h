@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: 2020-12-07
+ * Author: yangyaokai
+ */
+
+#ifndef SRC_FS_IO_URING_ENGINE_H_
+#define SRC_FS_IO_URING_ENGINE_H_
+
+#include <butil/iobuf.h>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "src/fs/fs_common.h"
+
+namespace curve {
+namespace fs {
+
+/**
+ * 基于io_uring的异步IO引擎
+ * 直接通过系统调用建立submission/completion ring，不依赖liburing；
+ * 提交可以来自多个线程，完成事件由引擎内部的一个reap线程处理并回调，
+ * 回调在reap线程中执行，不能在回调中做阻塞操作。
+ * 同时在途的请求数不超过队列深度，超过时提交线程会等待。
+ * ring出现不可恢复的错误时，在途请求以错误回调，之后的提交返回-ESHUTDOWN
+ */
+class IoUringEngine {
+ public:
+    IoUringEngine();
+    ~IoUringEngine();
+
+    /**
+     * 当前内核是否支持io_uring
+     */
+    static bool IsSupported();
+
+    /**
+     * 初始化ring并启动reap线程
+     * @param queueDepth: submission queue深度，同时也是最大在途请求数
+     * @return 成功返回0，失败返回-errno
+     */
+    int Init(uint32_t queueDepth);
+
+    /**
+     * 等待在途请求全部完成后停止reap线程，释放ring
+     */
+    void Stop();
+
+    /**
+     * 异步读，语义与LocalFileSystem::Read相同
+     * buf在回调执行之前必须保持有效
+     * @return 提交成功返回0，此时结果通过回调返回；失败返回-errno，不会回调
+     */
+    int SubmitRead(int fd, char* buf, uint64_t offset, int length,
+                   AioCallback cb);
+
+    /**
+     * 异步写，语义与LocalFileSystem::Write相同
+     * buf在回调执行之前必须保持有效
+     */
+    int SubmitWrite(int fd, const char* buf, uint64_t offset, int length,
+                    AioCallback cb);
+
+    /**
+     * 异步写，IOBuf中的block直接作为iovec提交，不做拷贝
+     * 引擎内部持有IOBuf的引用直到回调结束
+     */
+    int SubmitWrite(int fd, const butil::IOBuf& buf, uint64_t offset,
+                    int length, AioCallback cb);
+
+    /**
+     * 异步fsync
+     */
+    int SubmitFsync(int fd, AioCallback cb);
+
+    /**
+     * 当前在途的请求数
+     */
+    uint32_t InflightCount() const {
+        return inflight_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    enum class IoType {
+        READ,
+        WRITE,
+        WRITEV,
+        FSYNC,
+    };
+
+    struct IoRequest {
+        IoType type;
+        int fd;
+        char* buf;
+        butil::IOBuf data;
+        std::vector<struct iovec> iovs;
+        uint64_t offset;
+        // 请求的总长度
+        int length;
+        // 已经完成的长度，短读写时据此重新提交剩余部分
+        int done;
+        int retryTimes;
+        AioCallback cb;
+    };
+
+    int Submit(IoRequest* req);
+    // 调用方需持有sqMutex_
+    int PushSqe(IoRequest* req);
+    void PrepareSqe(IoRequest* req, struct io_uring_sqe* sqe);
+    void ReapLoop();
+    // ring不可用时以res回调所有在途请求，并拒绝新的提交
+    void FailPending(int res);
+    void HandleCompletion(IoRequest* req, int res);
+    void Finish(IoRequest* req, int res);
+    void ReleaseRing();
+
+ private:
+    int ringFd_;
+    uint32_t queueDepth_;
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> inflight_;
+
+    // submission ring
+    void* sqRing_;
+    size_t sqRingSize_;
+    uint32_t* sqHead_;
+    uint32_t* sqTail_;
+    uint32_t* sqMask_;
+    uint32_t* sqArray_;
+    struct io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    // completion ring
+    void* cqRing_;
+    size_t cqRingSize_;
+    uint32_t* cqHead_;
+    uint32_t* cqTail_;
+    uint32_t* cqMask_;
+    struct io_uring_cqe* cqes_;
+
+    // 保护submission ring，多个apply线程会并发提交
+    std::mutex sqMutex_;
+    // 在途请求达到队列深度时提交方在此等待
+    std::mutex slotMutex_;
+    std::condition_variable slotCond_;
+    // 在途请求，ring出错时据此回调，由slotMutex_保护
+    std::unordered_set<IoRequest*> pending_;
+    // reap线程因ring出错已经退出，由slotMutex_保护
+    bool ringBroken_;
+    std::thread reaper_;
+};
+
+}  // namespace fs
+}  // namespace curve
+
+#endif  // SRC_FS_IO_URING_ENGINE_H_
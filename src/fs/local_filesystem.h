@@ -26,6 +26,7 @@
 #include <inttypes.h>
 #include <assert.h>
 #include <sys/stat.h>
+#include <errno.h>
 #include <butil/iobuf.h>
 #include <memory>
 #include <vector>
@@ -45,7 +46,13 @@ namespace fs {
 
 struct LocalFileSystemOption {
     bool enableRenameat2;
-    LocalFileSystemOption() : enableRenameat2(false) {}
+    // 是否使用io_uring处理异步IO，不支持时退化为同步IO
+    bool enableIoUring;
+    // io_uring的队列深度，即最大在途异步IO数
+    uint32_t ioUringQueueDepth;
+    LocalFileSystemOption() : enableRenameat2(false)
+                            , enableIoUring(false)
+                            , ioUringQueueDepth(128) {}
 };
 
 class LocalFileSystem {
@@ -206,6 +213,73 @@ class LocalFileSystem {
      */
     virtual int Fsync(int fd) = 0;
 
+    /**
+     * 将源文件指定区域共享(reflink)到目标文件，不拷贝数据
+     * 之后对任一文件的写入由文件系统写时复制，不影响另一个文件
+     * 偏移和长度需按文件系统块大小对齐，仅XFS(reflink=1)、btrfs等支持
+     * @param srcFd：源文件句柄id
+     * @param srcOffset：源文件区域的起始偏移
+     * @param dstFd：目标文件句柄id
+     * @param dstOffset：目标文件区域的起始偏移
+     * @param length：区域长度
+     * @return 成功返回0，文件系统不支持时返回-EOPNOTSUPP等负值
+     */
+    virtual int CloneRange(int srcFd, uint64_t srcOffset,
+                           int dstFd, uint64_t dstOffset, int length) {
+        return -EOPNOTSUPP;
+    }
+
+    /**
+     * 当前文件系统是否真正以异步方式执行*Async接口
+     * 为false时*Async接口在当前线程同步完成IO并执行回调
+     */
+    virtual bool AsyncIOEnabled() { return false; }
+
+    /**
+     * 异步读取文件指定区域的数据
+     * buf在回调执行前必须保持有效
+     * @param cb：IO完成后的回调，参数与Read的返回值含义相同
+     * @return 提交成功返回0，失败返回负值，失败时不会执行回调
+     */
+    virtual int ReadAsync(int fd, char* buf, uint64_t offset, int length,
+                          AioCallback cb) {
+        cb(Read(fd, buf, offset, length));
+        return 0;
+    }
+
+    /**
+     * 异步向文件指定区域写入数据
+     * buf在回调执行前必须保持有效
+     * @param cb：IO完成后的回调，参数与Write的返回值含义相同
+     * @return 提交成功返回0，失败返回负值，失败时不会执行回调
+     */
+    virtual int WriteAsync(int fd, const char* buf, uint64_t offset,
+                           int length, AioCallback cb) {
+        cb(Write(fd, buf, offset, length));
+        return 0;
+    }
+
+    /**
+     * 异步向文件指定区域写入数据，IOBuf的生命周期由实现保证
+     * @param cb：IO完成后的回调，参数与Write的返回值含义相同
+     * @return 提交成功返回0，失败返回负值，失败时不会执行回调
+     */
+    virtual int WriteAsync(int fd, const butil::IOBuf& buf, uint64_t offset,
+                           int length, AioCallback cb) {
+        cb(Write(fd, buf, offset, length));
+        return 0;
+    }
+
+    /**
+     * 异步将文件数据和元数据刷新到磁盘
+     * @param cb：IO完成后的回调，参数与Fsync的返回值含义相同
+     * @return 提交成功返回0，失败返回负值，失败时不会执行回调
+     */
+    virtual int FsyncAsync(int fd, AioCallback cb) {
+        cb(Fsync(fd));
+        return 0;
+    }
+
  private:
     virtual int DoRename(const string& oldPath,
                          const string& newPath,
@@ -23,6 +23,7 @@
 #include <glog/logging.h>
 #include <stdio.h>
 #include <sys/syscall.h>
+#include <sys/ioctl.h>
 
 #include "src/fs/wrap_posix.h"
 
@@ -117,6 +118,10 @@ int PosixWrapper::fsync(int fd) {
     return ::fsync(fd);
 }
 
+int PosixWrapper::ficlonerange(int destFd, struct file_clone_range *range) {
+    return ::ioctl(destFd, FICLONERANGE, range);
+}
+
 int PosixWrapper::statfs(const char *path, struct statfs *buf) {
     return ::statfs(path, buf);
 }
@@ -193,20 +193,48 @@ int EtcdClientImp::TxnN(const std::vector<Operation> &ops) {
     bool needRetry = false;
     int retry = 0;
     int errCode;
+    if (ops.empty() || ops.size() > static_cast<size_t>(kMaxTxnOps)) {
+        LOG(ERROR) << "do not support Txn " << ops.size();
+        return EtcdErrCode::EtcdInvalidArgument;
+    }
     do {
         if (ops.size() == 2) {
             errCode = EtcdClientTxn2(timeout_, ops[0], ops[1]);
         } else if (ops.size() == 3) {
             errCode = EtcdClientTxn3(timeout_, ops[0], ops[1], ops[2]);
         } else {
-            LOG(ERROR) << "do not support Txn " << ops.size();
-            return EtcdErrCode::EtcdInvalidArgument;
+            EtcdClientTxnN_return res = EtcdClientTxnN(timeout_,
+                const_cast<Operation*>(ops.data()),
+                static_cast<int>(ops.size()));
+            errCode = res.r0;
         }
         needRetry = NeedRetry(errCode);
     } while (needRetry && ++retry <= retryTimes_);
     return errCode;
 }
 
+int EtcdClientImp::TxnNRewithRevision(
+    const std::vector<Operation> &ops, int64_t *revision) {
+    bool needRetry = false;
+    int retry = 0;
+    int errCode;
+    if (ops.empty() || ops.size() > static_cast<size_t>(kMaxTxnOps)) {
+        LOG(ERROR) << "do not support Txn " << ops.size();
+        return EtcdErrCode::EtcdInvalidArgument;
+    }
+    do {
+        EtcdClientTxnN_return res = EtcdClientTxnN(timeout_,
+            const_cast<Operation*>(ops.data()),
+            static_cast<int>(ops.size()));
+        if (res.r0 == EtcdErrCode::EtcdOK) {
+            *revision = res.r1;
+        }
+        errCode = res.r0;
+        needRetry = NeedRetry(errCode);
+    } while (needRetry && ++retry <= retryTimes_);
+    return errCode;
+}
+
 int EtcdClientImp::GetCurrentRevision(int64_t *revision) {
     bool needRetry = false;
     int retry = 0;
@@ -30,6 +30,10 @@
 
 namespace curve {
 namespace kvstorage {
+
+// max operations in one transaction, same as the default --max-txn-ops of etcd
+const int kMaxTxnOps = 128;
+
 class KVStorageClient {
  public:
     KVStorageClient() {}
@@ -112,7 +116,7 @@ class KVStorageClient {
         const std::string &key, int64_t *revision) = 0;
 
     /*
-    * @brief TxnN Operate transactions in the order of ops[0] ops[1] ..., currently 2 and 3 operations are supported //NOLINT
+    * @brief TxnN Operate transactions in the order of ops[0] ops[1] ..., at most kMaxTxnOps operations are supported //NOLINT
     *
     * @param[in] ops Operation set
     *
@@ -120,6 +124,17 @@ class KVStorageClient {
     */
     virtual int TxnN(const std::vector<Operation> &ops) = 0;
 
+    /**
+     * @brief TxnNRewithRevision Operate transactions like TxnN
+     *
+     * @param[in] ops Operation set
+     * @param[out] revision Version number of the transaction
+     *
+     * @return error code
+     */
+    virtual int TxnNRewithRevision(
+        const std::vector<Operation> &ops, int64_t *revision) = 0;
+
     /**
      * @brief CompareAndSwap Transaction, to achieve CAS
      *
@@ -174,6 +189,9 @@ class EtcdClientImp : public KVStorageClient {
 
     int TxnN(const std::vector<Operation> &ops) override;
 
+    int TxnNRewithRevision(
+        const std::vector<Operation> &ops, int64_t *revision) override;
+
     int CompareAndSwap(const std::string &key, const std::string &preV,
         const std::string &target) override;
 
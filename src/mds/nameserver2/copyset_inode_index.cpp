@@ -0,0 +1,153 @@
+/*
+ *  Copyright (c) 2021 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+#include "src/mds/nameserver2/copyset_inode_index.h"
+
+#include <algorithm>
+
+namespace curve {
+namespace mds {
+
+using ::curve::common::ReadLockGuard;
+using ::curve::common::WriteLockGuard;
+
+void CopysetInodeIndex::AddSegment(const FileInfo& fileInfo,
+                                   const PageFileSegment& segment) {
+    std::set<CopysetKey> copysets;
+    for (int i = 0; i < segment.chunks_size(); i++) {
+        copysets.emplace(segment.logicalpoolid(),
+                         segment.chunks(i).copysetid());
+    }
+
+    // most segments of a file are on copysets already indexed
+    {
+        ReadLockGuard guard(rwLock_);
+        auto iter = inodes_.find(fileInfo.id());
+        if (iter != inodes_.end() &&
+            iter->second.parentId == fileInfo.parentid() &&
+            iter->second.fileName == fileInfo.filename() &&
+            std::includes(iter->second.copysets.begin(),
+                          iter->second.copysets.end(),
+                          copysets.begin(), copysets.end())) {
+            return;
+        }
+    }
+
+    WriteLockGuard guard(rwLock_);
+    AddCopysets(fileInfo, copysets);
+}
+
+void CopysetInodeIndex::BuildFile(
+    const FileInfo& fileInfo, const std::vector<PageFileSegment>& segments) {
+    std::set<CopysetKey> copysets;
+    for (const auto& segment : segments) {
+        for (int i = 0; i < segment.chunks_size(); i++) {
+            copysets.emplace(segment.logicalpoolid(),
+                             segment.chunks(i).copysetid());
+        }
+    }
+
+    WriteLockGuard guard(rwLock_);
+    if (removedInodes_.count(fileInfo.id()) != 0) {
+        return;
+    }
+    AddCopysets(fileInfo, copysets);
+}
+
+void CopysetInodeIndex::AddCopysets(const FileInfo& fileInfo,
+                                    const std::set<CopysetKey>& copysets) {
+    auto& entry = inodes_[fileInfo.id()];
+    entry.parentId = fileInfo.parentid();
+    entry.fileName = fileInfo.filename();
+    for (const auto& key : copysets) {
+        if (entry.copysets.insert(key).second) {
+            copysetInodes_[key].insert(fileInfo.id());
+        }
+    }
+}
+
+void CopysetInodeIndex::SetReady() {
+    WriteLockGuard guard(rwLock_);
+    removedInodes_.clear();
+    ready_.store(true, std::memory_order_release);
+}
+
+void CopysetInodeIndex::UpdateFile(InodeID id, InodeID parentId,
+                                   const std::string& fileName) {
+    WriteLockGuard guard(rwLock_);
+    auto iter = inodes_.find(id);
+    if (iter == inodes_.end()) {
+        return;
+    }
+    iter->second.parentId = parentId;
+    iter->second.fileName = fileName;
+}
+
+void CopysetInodeIndex::RemoveInode(InodeID id) {
+    WriteLockGuard guard(rwLock_);
+    if (!IsReady()) {
+        removedInodes_.insert(id);
+    }
+    auto iter = inodes_.find(id);
+    if (iter == inodes_.end()) {
+        return;
+    }
+    for (const auto& key : iter->second.copysets) {
+        auto copysetIter = copysetInodes_.find(key);
+        if (copysetIter == copysetInodes_.end()) {
+            continue;
+        }
+        copysetIter->second.erase(id);
+        if (copysetIter->second.empty()) {
+            copysetInodes_.erase(copysetIter);
+        }
+    }
+    inodes_.erase(iter);
+}
+
+void CopysetInodeIndex::FindInodes(
+    const std::vector<common::CopysetInfo>& copysets,
+    std::vector<FileInfo>* files) const {
+    std::set<InodeID> found;
+    ReadLockGuard guard(rwLock_);
+    for (const auto& copyset : copysets) {
+        auto iter = copysetInodes_.find(
+            CopysetKey(copyset.logicalpoolid(), copyset.copysetid()));
+        if (iter == copysetInodes_.end()) {
+            continue;
+        }
+        for (InodeID id : iter->second) {
+            if (!found.insert(id).second) {
+                continue;
+            }
+            const auto& entry = inodes_.at(id);
+            FileInfo file;
+            file.set_id(id);
+            file.set_parentid(entry.parentId);
+            file.set_filename(entry.fileName);
+            files->emplace_back(std::move(file));
+        }
+    }
+}
+
+}  // namespace mds
+}  // namespace curve
@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2021 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+#ifndef SRC_MDS_NAMESERVER2_COPYSET_INODE_INDEX_H_
+#define SRC_MDS_NAMESERVER2_COPYSET_INODE_INDEX_H_
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "proto/common.pb.h"
+#include "proto/nameserver2.pb.h"
+#include "src/common/concurrent/concurrent.h"
+#include "src/mds/common/mds_define.h"
+
+using ::curve::mds::topology::CopySetIdType;
+using ::curve::mds::topology::LogicalPoolIdType;
+
+namespace curve {
+namespace mds {
+
+// Reverse index from copyset to the inodes of the files which have
+// segments on it.
+//
+// Inodes are added when their segments are allocated and removed when the
+// file is handed to the clean manager. The parent id and filename of an
+// inode are updated when the file is moved. Discarded segments are not removed,
+// so the index may return inodes that no longer have chunks on the copyset,
+// callers should check the segments of the returned inodes.
+class CopysetInodeIndex {
+ public:
+    CopysetInodeIndex() : ready_(false) {}
+
+    /**
+     * @brief add the copysets of segment to the index
+     * @param fileInfo the file which segment belongs to, its parent id and
+     *        filename are remembered to find the file later
+     * @param segment
+     */
+    void AddSegment(const FileInfo& fileInfo, const PageFileSegment& segment);
+
+    /**
+     * @brief add the segments of a file listed when building the index,
+     *        files removed since the build started are skipped
+     * @param fileInfo
+     * @param segments all segments of the file
+     */
+    void BuildFile(const FileInfo& fileInfo,
+                   const std::vector<PageFileSegment>& segments);
+
+    /**
+     * @brief update where the file is after it is moved, files not in the
+     *        index are ignored
+     * @param id inode id
+     * @param parentId new parent id
+     * @param fileName new filename
+     */
+    void UpdateFile(InodeID id, InodeID parentId, const std::string& fileName);
+
+    /**
+     * @brief remove the inode from the index, before the index is ready the
+     *        inode is also remembered so that BuildFile won't add it back
+     * @param id inode id
+     */
+    void RemoveInode(InodeID id);
+
+    /**
+     * @brief find the inodes which may have segments on the copysets
+     * @param copysets
+     * @param[out] files inodes found, only id, parentid and filename are set
+     */
+    void FindInodes(const std::vector<common::CopysetInfo>& copysets,
+                    std::vector<FileInfo>* files) const;
+
+    /**
+     * @brief whether all segments in storage have been added to the index
+     */
+    bool IsReady() const {
+        return ready_.load(std::memory_order_acquire);
+    }
+
+    void SetReady();
+
+ private:
+    using CopysetKey = std::pair<LogicalPoolIdType, CopySetIdType>;
+
+    void AddCopysets(const FileInfo& fileInfo,
+                     const std::set<CopysetKey>& copysets);
+
+    struct InodeEntry {
+        InodeID parentId;
+        std::string fileName;
+        std::set<CopysetKey> copysets;
+    };
+
+    mutable ::curve::common::RWLock rwLock_;
+    std::map<CopysetKey, std::unordered_set<InodeID>> copysetInodes_;
+    std::unordered_map<InodeID, InodeEntry> inodes_;
+    // inodes removed while the index is being built
+    std::unordered_set<InodeID> removedInodes_;
+
+    std::atomic<bool> ready_;
+};
+
+}  // namespace mds
+}  // namespace curve
+
+#endif  // SRC_MDS_NAMESERVER2_COPYSET_INODE_INDEX_H_
@@ -28,6 +28,7 @@
 #include <set>
 #include <utility>
 #include <map>
+#include <algorithm>
 #include "src/common/string_util.h"
 #include "src/common/encode.h"
 #include "src/common/timeutility.h"
@@ -127,6 +128,9 @@ bool CurveFS::Init(std::shared_ptr<NameServerStorage> storage,
     maxFileLength_ = curveFSOptions.maxFileLength;
     topology_ = topology;
     snapshotCloneClient_ = snapshotCloneClient;
+    copysetIndex_ = std::make_shared<CopysetInodeIndex>();
+    buildCopysetIndex_ = curveFSOptions.buildCopysetIndex;
+    stopBuildCopysetIndex_ = false;
 
     InitRootFile();
     bool ret = InitRecycleBinDir();
@@ -142,10 +146,19 @@ bool CurveFS::Init(std::shared_ptr<NameServerStorage> storage,
 
 void CurveFS::Run() {
     fileRecordManager_->Start();
+    if (buildCopysetIndex_) {
+        copysetIndexBuilder_ = std::thread([this]() {
+            BuildCopysetIndex();
+        });
+    }
 }
 
 void CurveFS::Uninit() {
     fileRecordManager_->Stop();
+    stopBuildCopysetIndex_ = true;
+    if (copysetIndexBuilder_.joinable()) {
+        copysetIndexBuilder_.join();
+    }
     storage_ = nullptr;
     InodeIDGenerator_ = nullptr;
     chunkSegAllocator_ = nullptr;
@@ -153,6 +166,7 @@ void CurveFS::Uninit() {
     allocStatistic_ = nullptr;
     fileRecordManager_ = nullptr;
     snapshotCloneClient_ = nullptr;
+    copysetIndex_ = nullptr;
 }
 
 void CurveFS::InitRootFile(void) {
@@ -684,6 +698,9 @@ StatusCode CurveFS::DeleteFile(const std::string & filename, uint64_t fileId,
                         << ", ret = " << ret1;
                 return StatusCode::kStorageError;
             }
+            copysetIndex_->UpdateFile(recycleFileInfo.id(),
+                                      recycleFileInfo.parentid(),
+                                      recycleFileInfo.filename());
             LOG(INFO) << "file delete to recyclebin, fileName = " << filename
                       << ", recycle filename = " << recycleFileInfo.filename();
             return StatusCode::kOK;
@@ -723,6 +740,7 @@ StatusCode CurveFS::DeleteFile(const std::string & filename, uint64_t fileId,
                         << ", submit delete file job fail.";
                 return StatusCode::KInternalError;
             }
+            copysetIndex_->RemoveInode(fileInfo.id());
 
             LOG(INFO) << "delete file task submitted, file is pagefile"
                         << ", inode = " << fileInfo.id()
@@ -810,6 +828,9 @@ StatusCode CurveFS::RecoverFile(const std::string & originFileName,
         LOG(ERROR) << "storage_ recoverfile error, error = " << ret1;
         return StatusCode::kStorageError;
     }
+    copysetIndex_->UpdateFile(recoverFileInfo.id(),
+                              recoverFileInfo.parentid(),
+                              recoverFileInfo.filename());
     return StatusCode::kOK;
 }
 
@@ -999,6 +1020,11 @@ StatusCode CurveFS::RenameFile(const std::string & sourceFileName,
 
             return StatusCode::kStorageError;
         }
+        copysetIndex_->UpdateFile(destFileInfo.id(), destFileInfo.parentid(),
+                                  destFileInfo.filename());
+        copysetIndex_->UpdateFile(recycleFileInfo.id(),
+                                  recycleFileInfo.parentid(),
+                                  recycleFileInfo.filename());
         return StatusCode::kOK;
     } else if (ret3 == StatusCode::kFileNotExists) {
         // destFileName does not exist, rename directly
@@ -1012,6 +1038,8 @@ StatusCode CurveFS::RenameFile(const std::string & sourceFileName,
             LOG(ERROR) << "storage_ renamefile error, error = " << ret;
             return StatusCode::kStorageError;
         }
+        copysetIndex_->UpdateFile(destFileInfo.id(), destFileInfo.parentid(),
+                                  destFileInfo.filename());
         return StatusCode::kOK;
     } else {
         LOG(INFO) << "dest file LookUpFile return: " << ret3;
@@ -1182,6 +1210,7 @@ StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
             allocStatistic_->AllocSpace(segment->logicalpoolid(),
                     segment->segmentsize(),
                     revision);
+            copysetIndex_->AddSegment(fileInfo, *segment);
 
             LOG(INFO) << "alloc segment success, fileInfo.id() = "
                       << fileInfo.id()
@@ -1193,6 +1222,110 @@ StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
     }
 }
 
+StatusCode CurveFS::GetOrAllocateSegments(const std::string & filename,
+        offset_t offset, uint32_t segmentNum, bool allocateIfNoExist,
+        std::vector<PageFileSegment> *segments) {
+    assert(segments != nullptr);
+    segments->clear();
+
+    FileInfo  fileInfo;
+    auto ret = GetFileInfo(filename, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        LOG(INFO) << "get source file error, errCode = " << ret;
+        return  ret;
+    }
+
+    if (fileInfo.filetype() != FileType::INODE_PAGEFILE) {
+        LOG(INFO) << "not pageFile, can't do this";
+        return StatusCode::kParaError;
+    }
+
+    if (offset % fileInfo.segmentsize() != 0) {
+        LOG(INFO) << "offset not align with segment";
+        return StatusCode::kParaError;
+    }
+
+    if (offset + fileInfo.segmentsize() > fileInfo.length()) {
+        LOG(INFO) << "bigger than file length, first extentFile";
+        return StatusCode::kParaError;
+    }
+
+    uint64_t maxNum = (fileInfo.length() - offset) / fileInfo.segmentsize();
+    segmentNum = std::min<uint64_t>({segmentNum, maxNum,
+                                     kMaxAllocateSegmentNum});
+    segmentNum = std::max<uint32_t>(segmentNum, 1);
+
+    // segments allocated in this call, stored at the end
+    std::vector<PageFileSegment> newSegments;
+    for (uint32_t i = 0; i < segmentNum; i++) {
+        offset_t segOffset = offset + i * fileInfo.segmentsize();
+        PageFileSegment segment;
+        auto storeRet = storage_->GetSegment(fileInfo.id(), segOffset,
+                                             &segment);
+        if (storeRet == StoreStatus::OK) {
+            segments->emplace_back(std::move(segment));
+            continue;
+        } else if (storeRet != StoreStatus::KeyNotExist) {
+            if (i == 0) {
+                return StatusCode::KInternalError;
+            }
+            break;
+        }
+
+        if (allocateIfNoExist == false) {
+            if (i == 0) {
+                LOG(INFO) << "file = " << filename << ", segment offset = "
+                          << offset << ", not allocated";
+                return  StatusCode::kSegmentNotAllocated;
+            }
+            continue;
+        }
+
+        auto ifok = chunkSegAllocator_->AllocateChunkSegment(
+                        fileInfo.filetype(), fileInfo.segmentsize(),
+                        fileInfo.chunksize(), segOffset, &segment);
+        if (ifok == false) {
+            LOG(ERROR) << "AllocateChunkSegment error, offset = " << segOffset;
+            if (i == 0) {
+                return StatusCode::kSegmentAllocateError;
+            }
+            // return the segments before it
+            break;
+        }
+        newSegments.emplace_back(segment);
+        segments->emplace_back(std::move(segment));
+    }
+
+    if (newSegments.empty()) {
+        return StatusCode::kOK;
+    }
+
+    int64_t revision;
+    if (storage_->PutSegments(fileInfo.id(), newSegments, &revision)
+        != StoreStatus::OK) {
+        LOG(ERROR) << "PutSegments fail, fileInfo.id() = " << fileInfo.id()
+                   << ", offset = " << offset
+                   << ", segment num = " << newSegments.size();
+        segments->clear();
+        return StatusCode::kStorageError;
+    }
+
+    // AllocSpace records one change per revision of each logical pool
+    std::map<PoolIdType, int64_t> allocSize;
+    for (const auto &segment : newSegments) {
+        allocSize[segment.logicalpoolid()] += segment.segmentsize();
+        copysetIndex_->AddSegment(fileInfo, segment);
+    }
+    for (const auto &item : allocSize) {
+        allocStatistic_->AllocSpace(item.first, item.second, revision);
+    }
+
+    LOG(INFO) << "alloc segments success, fileInfo.id() = " << fileInfo.id()
+              << ", offset = " << offset
+              << ", segment num = " << newSegments.size();
+    return StatusCode::kOK;
+}
+
 StatusCode CurveFS::DeAllocateSegment(const std::string& fileName,
                                       uint64_t offset) {
     FileInfo fileInfo;
@@ -2270,11 +2403,69 @@ StatusCode CurveFS::ListVolumesOnCopyset(
                         const std::vector<common::CopysetInfo>& copysets,
                         std::vector<std::string>* fileNames) {
     std::vector<FileInfo> files;
-    StatusCode ret = ListAllFiles(ROOTINODEID, &files);
-    if (ret != StatusCode::kOK) {
-        LOG(ERROR) << "List all files in root directory fail";
-        return ret;
+    if (!copysetIndex_->IsReady()) {
+        StatusCode ret = ListAllFiles(ROOTINODEID, &files);
+        if (ret != StatusCode::kOK) {
+            LOG(ERROR) << "List all files in root directory fail";
+            return ret;
+        }
+        return FilterVolumesOnCopyset(files, copysets, fileNames);
+    }
+
+    std::vector<FileInfo> candidates;
+    copysetIndex_->FindInodes(copysets, &candidates);
+    if (candidates.empty()) {
+        return StatusCode::kOK;
+    }
+
+    // files moved by a path that doesn't update the index are found by
+    // listing all files, and their new place is written back to the index
+    std::set<InodeID> movedFiles;
+    for (const auto& candidate : candidates) {
+        FileInfo file;
+        StoreStatus ret = storage_->GetFile(candidate.parentid(),
+                                            candidate.filename(), &file);
+        if (ret == StoreStatus::OK && file.id() == candidate.id()) {
+            files.emplace_back(std::move(file));
+        } else if (ret == StoreStatus::OK ||
+                   ret == StoreStatus::KeyNotExist) {
+            movedFiles.insert(candidate.id());
+        } else {
+            LOG(ERROR) << "Get file " << candidate.filename()
+                       << " fail, inodeid = " << candidate.id();
+            return StatusCode::kStorageError;
+        }
+    }
+
+    if (!movedFiles.empty()) {
+        std::vector<FileInfo> allFiles;
+        StatusCode ret = ListAllFiles(ROOTINODEID, &allFiles);
+        if (ret != StatusCode::kOK) {
+            LOG(ERROR) << "List all files in root directory fail";
+            return ret;
+        }
+        for (auto& file : allFiles) {
+            if (movedFiles.erase(file.id()) != 0) {
+                copysetIndex_->UpdateFile(file.id(), file.parentid(),
+                                          file.filename());
+                files.emplace_back(std::move(file));
+            }
+        }
+        // the files have been deleted
+        for (InodeID id : movedFiles) {
+            LOG(INFO) << "Remove deleted inode " << id
+                      << " from copyset index";
+            copysetIndex_->RemoveInode(id);
+        }
     }
+
+    return FilterVolumesOnCopyset(files, copysets, fileNames);
+}
+
+StatusCode CurveFS::FilterVolumesOnCopyset(
+                        const std::vector<FileInfo>& files,
+                        const std::vector<common::CopysetInfo>& copysets,
+                        std::vector<std::string>* fileNames) {
     std::map<LogicalPoolIdType, std::set<CopySetIdType>> copysetMap;
     for (const auto& copyset : copysets) {
         copysetMap[copyset.logicalpoolid()].insert(copyset.copysetid());
@@ -2307,6 +2498,40 @@ StatusCode CurveFS::ListVolumesOnCopyset(
     return StatusCode::kOK;
 }
 
+StatusCode CurveFS::BuildCopysetIndex() {
+    LOG(INFO) << "Start building copyset index";
+    std::vector<FileInfo> files;
+    StatusCode ret = ListAllFiles(ROOTINODEID, &files);
+    if (ret != StatusCode::kOK) {
+        LOG(ERROR) << "Build copyset index fail, list all files fail";
+        return ret;
+    }
+
+    for (const auto& file : files) {
+        if (stopBuildCopysetIndex_) {
+            LOG(INFO) << "Build copyset index stopped";
+            return StatusCode::KInternalError;
+        }
+        // chunks of the deleting files are being cleaned
+        if (file.filestatus() == FileStatus::kFileDeleting) {
+            continue;
+        }
+        std::vector<PageFileSegment> segments;
+        StoreStatus storeRet = storage_->ListSegment(file.id(), &segments);
+        if (storeRet != StoreStatus::OK) {
+            LOG(ERROR) << "Build copyset index fail, list segments of "
+                       << file.filename() << " fail";
+            return StatusCode::kStorageError;
+        }
+        // skipped if the file is deleted after it is listed
+        copysetIndex_->BuildFile(file, segments);
+    }
+
+    copysetIndex_->SetReady();
+    LOG(INFO) << "Build copyset index success, file num = " << files.size();
+    return StatusCode::kOK;
+}
+
 StatusCode CurveFS::ListAllFiles(uint64_t inodeId,
                                  std::vector<FileInfo>* files) {
     std::vector<FileInfo> tempFiles;
@@ -30,11 +30,13 @@
 #include <thread>  //NOLINT
 #include <chrono>  //NOLINT
 #include <unordered_map>
+#include <atomic>
 #include "proto/nameserver2.pb.h"
 #include "src/mds/nameserver2/namespace_storage.h"
 #include "src/mds/common/mds_define.h"
 #include "src/mds/nameserver2/chunk_allocator.h"
 #include "src/mds/nameserver2/clean_manager.h"
+#include "src/mds/nameserver2/copyset_inode_index.h"
 #include "src/mds/nameserver2/async_delete_snapshot_entity.h"
 #include "src/mds/nameserver2/file_record.h"
 #include "src/mds/nameserver2/idgenerator/inode_id_generator.h"
@@ -70,6 +72,9 @@ struct CurveFSOption {
     RootAuthOption authOptions;
     FileRecordOptions fileRecordOptions;
     ThrottleOption throttleOption;
+    // build the copyset to inodes index in background when mds starts,
+    // ListVolumesOnCopyset scans all segments until the index is built
+    bool buildCopysetIndex = false;
 };
 
 struct AllocatedSize {
@@ -83,6 +88,9 @@ struct AllocatedSize {
 
 using ::curve::mds::DeleteSnapShotResponse;
 
+// max segments of a file got or allocated in one GetOrAllocateSegments
+const uint32_t kMaxAllocateSegmentNum = 64;
+
 class CurveFS {
  public:
     // singleton, supported in c++11
@@ -273,6 +281,27 @@ class CurveFS {
         offset_t offset,
         bool allocateIfNoExist, PageFileSegment *segment);
 
+    /**
+     *  @brief query consecutive segments start at offset, allocate the
+     *         missing ones if allocateIfNoExist, new segments are stored
+     *         in one transaction
+     *
+     *  @param filename
+     *  @param offset: offset of the first segment
+     *  @param segmentNum: number of segments, truncated to the file length
+     *                     and kMaxAllocateSegmentNum
+     *  @param allocateIfNoExist: If the segment does not exist,
+     *                            whether or not creating a new one
+     *  @param segments: Return the segments in order of offset, the first one
+     *                   is always at offset, later ones that are not
+     *                   allocated are skipped
+     *  @return StatusCode::kOK if the first segment is got or allocated
+     */
+    StatusCode GetOrAllocateSegments(
+        const std::string & filename,
+        offset_t offset, uint32_t segmentNum,
+        bool allocateIfNoExist, std::vector<PageFileSegment> *segments);
+
     /**
      * @brief deallocate file segment start at offset
      * @param filename
@@ -538,6 +567,13 @@ class CurveFS {
                         const std::vector<common::CopysetInfo>& copysets,
                         std::vector<std::string>* fileNames);
 
+    /**
+     * @brief Add segments of all files to the copyset index, the index is
+     *        used by ListVolumesOnCopyset after building succeeded
+     * @return StatusCode::kOK if succeeded
+     */
+    StatusCode BuildCopysetIndex();
+
     /**
      * @brief Update file throttle params
      * @param filename
@@ -734,6 +770,18 @@ class CurveFS {
      */
     StatusCode ListAllFiles(uint64_t inodeId, std::vector<FileInfo>* files);
 
+    /**
+     *  @brief Find the files which have chunks on copysets by their segments
+     *  @param: files files to check
+     *  @param: copysets
+     *  @param[out]: fileNames names of the files found
+     *  @return StatusCode::kOK if succeeded
+     */
+    StatusCode FilterVolumesOnCopyset(
+                        const std::vector<FileInfo>& files,
+                        const std::vector<common::CopysetInfo>& copysets,
+                        std::vector<std::string>* fileNames);
+
     /**
      * @brief check whether mds has started for enough time, based on the
      *        file record expiration time(mds.file.expiredTimeUs)
@@ -774,6 +822,7 @@ class CurveFS {
     std::shared_ptr<AllocStatistic> allocStatistic_;
     std::shared_ptr<Topology> topology_;
     std::shared_ptr<SnapshotCloneClient> snapshotCloneClient_;
+    std::shared_ptr<CopysetInodeIndex> copysetIndex_;
     struct RootAuthOption       rootAuthOptions_;
     ThrottleOption throttleOption_;
 
@@ -782,6 +831,10 @@ class CurveFS {
     uint64_t minFileLength_;
     uint64_t maxFileLength_;
     std::chrono::steady_clock::time_point startTime_;
+
+    bool buildCopysetIndex_;
+    std::thread copysetIndexBuilder_;
+    std::atomic<bool> stopBuildCopysetIndex_;
 };
 extern CurveFS &kCurveFS;
 }   // namespace mds
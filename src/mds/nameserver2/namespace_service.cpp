@@ -448,10 +448,23 @@ void NameSpaceService::GetOrAllocateSegment(
         return;
     }
 
-    retCode = kCurveFS.GetOrAllocateSegment(request->filename(),
-                request->offset(),
-                request->allocateifnotexist(),
-                response->mutable_pagefilesegment());
+    if (request->has_segmentnum() && request->segmentnum() > 1) {
+        std::vector<PageFileSegment> segments;
+        retCode = kCurveFS.GetOrAllocateSegments(request->filename(),
+                    request->offset(), request->segmentnum(),
+                    request->allocateifnotexist(), &segments);
+        if (retCode == StatusCode::kOK) {
+            response->mutable_pagefilesegment()->Swap(&segments[0]);
+            for (size_t i = 1; i < segments.size(); i++) {
+                response->add_extrasegments()->Swap(&segments[i]);
+            }
+        }
+    } else {
+        retCode = kCurveFS.GetOrAllocateSegment(request->filename(),
+                    request->offset(),
+                    request->allocateifnotexist(),
+                    response->mutable_pagefilesegment());
+    }
 
     if (retCode != StatusCode::kOK)  {
         response->set_statuscode(retCode);
@@ -475,12 +488,15 @@ void NameSpaceService::GetOrAllocateSegment(
                 << ", cost " << expiredTime.ExpiredMs() << " ms";
         }
         response->clear_pagefilesegment();
+        response->clear_extrasegments();
     } else {
         response->set_statuscode(StatusCode::kOK);
         LOG(INFO) << "logid = " << cntl->log_id()
                   << ", GetOrAllocateSegment ok, filename = "
                   << request->filename() << ", offset = " << request->offset()
                   << ", allocateTag = " << request->allocateifnotexist()
+                  << ", segmentNum = "
+                  << 1 + response->extrasegments_size()
                   << ", cost " << expiredTime.ExpiredMs() << " ms";
     }
     return;
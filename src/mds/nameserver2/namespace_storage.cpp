@@ -482,6 +482,48 @@ StoreStatus NameServerStorageImp::PutSegment(InodeID id,
     return getErrorCode(errCode);
 }
 
+StoreStatus NameServerStorageImp::PutSegments(
+    InodeID id, const std::vector<PageFileSegment> &segments,
+    int64_t *revision) {
+    if (segments.empty()) {
+        return StoreStatus::OK;
+    }
+    if (segments.size() == 1) {
+        return PutSegment(id, segments[0].startoffset(), &segments[0],
+                          revision);
+    }
+
+    std::vector<std::string> storeKeys(segments.size());
+    std::vector<std::string> encodeSegments(segments.size());
+    std::vector<Operation> ops;
+    ops.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        storeKeys[i] = NameSpaceStorageCodec::EncodeSegmentStoreKey(
+            id, segments[i].startoffset());
+        if (!NameSpaceStorageCodec::EncodeSegment(segments[i],
+                                                  &encodeSegments[i])) {
+            return StoreStatus::InternalError;
+        }
+        ops.emplace_back(Operation{
+            OpType::OpPut,
+            const_cast<char*>(storeKeys[i].c_str()),
+            const_cast<char*>(encodeSegments[i].c_str()),
+            static_cast<int>(storeKeys[i].size()),
+            static_cast<int>(encodeSegments[i].size())});
+    }
+
+    int errCode = client_->TxnNRewithRevision(ops, revision);
+    if (errCode != EtcdErrCode::EtcdOK) {
+        LOG(ERROR) << "put " << segments.size() << " segments of inodeid: "
+                   << id << " err:" << errCode;
+    } else {
+        for (size_t i = 0; i < segments.size(); i++) {
+            cache_->Put(storeKeys[i], encodeSegments[i]);
+        }
+    }
+    return getErrorCode(errCode);
+}
+
 StoreStatus NameServerStorageImp::GetSegment(InodeID id,
                                              uint64_t off,
                                              PageFileSegment *segment) {
@@ -209,6 +209,19 @@ class NameServerStorage {
                                     const PageFileSegment * segment,
                                     int64_t *revision) = 0;
 
+    /**
+     * @brief PutSegments: Store several segments of a file in one transaction
+     *
+     * @param[in] id: Inode ID of the target file
+     * @param[in] segments: Segments info, stored at their startoffset
+     * @param[out] revision: The version number of this operation
+     *
+     * @return StoreStatus: error code
+     */
+    virtual StoreStatus PutSegments(
+        InodeID id, const std::vector<PageFileSegment> &segments,
+        int64_t *revision) = 0;
+
     /**
      * @brief DeleteSegment: Delete the specified segment metadata
      *
@@ -324,6 +337,10 @@ class NameServerStorageImp : public NameServerStorage {
                             const PageFileSegment * segment,
                             int64_t *revision) override;
 
+    StoreStatus PutSegments(InodeID id,
+                            const std::vector<PageFileSegment> &segments,
+                            int64_t *revision) override;
+
     StoreStatus DeleteSegment(
         InodeID id, uint64_t off, int64_t *revision) override;
 
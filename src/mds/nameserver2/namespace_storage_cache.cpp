@@ -42,7 +42,7 @@ bool LRUCache::Get(const std::string &key, std::string *value) {
 
     // update the position of the target item in the list
     MoveToFront(iter->second);
-    *value = cache_[key]->value;
+    *value = iter->second->value;
     return true;
 }
 
@@ -69,7 +69,9 @@ void LRUCache::PutLocked(const std::string &key, const std::string &value) {
     cache_[key] = ll_.begin();
     cacheMetrics_->UpdateAddToCacheCount();
     cacheMetrics_->UpdateAddToCacheBytes(key.size() + value.size());
-    if (maxCount_ != 0 && ll_.size() > maxCount_) {
+    bytes_ += key.size() + value.size();
+    while ((maxCount_ != 0 && ll_.size() > maxCount_) ||
+           (maxBytes_ != 0 && bytes_ > maxBytes_)) {
         RemoveOldest();
     }
 }
@@ -82,10 +84,8 @@ void LRUCache::RemoveLocked(const std::string &key) {
 }
 
 void LRUCache::MoveToFront(const std::list<Item>::iterator &elem) {
-    Item duplica{elem->key, elem->value};
-    ll_.erase(elem);
-    ll_.push_front(duplica);
-    cache_[duplica.key] = ll_.begin();
+    // splice keeps the iterator in cache_ valid and copies nothing
+    ll_.splice(ll_.begin(), ll_, elem);
 }
 
 void LRUCache::RemoveOldest() {
@@ -98,10 +98,49 @@ void LRUCache::RemoveElement(const std::list<Item>::iterator &elem) {
     cacheMetrics_->UpdateRemoveFromCacheCount();
     cacheMetrics_->UpdateRemoveFromCacheBytes(
         elem->key.size() + elem->value.size());
+    bytes_ -= elem->key.size() + elem->value.size();
 
-    auto iter = cache_.find(elem->key);
-    cache_.erase(iter);
-    ll_.erase(elem);
+    // elem may refer to the value in cache_, copy it before erasing
+    std::list<Item>::iterator listIter = elem;
+    cache_.erase(listIter->key);
+    ll_.erase(listIter);
+}
+
+ShardedLRUCache::ShardedLRUCache(uint32_t shardNum, int maxCount,
+                                 uint64_t maxBytes) {
+    if (shardNum == 0) {
+        shardNum = 1;
+    }
+    cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
+
+    // round up so that a small non-zero limit doesn't become unlimited
+    int shardMaxCount = (maxCount + shardNum - 1) / shardNum;
+    uint64_t shardMaxBytes = (maxBytes + shardNum - 1) / shardNum;
+    for (uint32_t i = 0; i < shardNum; ++i) {
+        shards_.emplace_back(
+            new LRUCache(shardMaxCount, shardMaxBytes, cacheMetrics_));
+    }
+}
+
+void ShardedLRUCache::Put(const std::string &key, const std::string &value) {
+    GetShard(key)->Put(key, value);
+}
+
+bool ShardedLRUCache::Get(const std::string &key, std::string *value) {
+    return GetShard(key)->Get(key, value);
+}
+
+void ShardedLRUCache::Remove(const std::string &key) {
+    GetShard(key)->Remove(key);
+}
+
+std::shared_ptr<NameserverCacheMetrics>
+ShardedLRUCache::GetCacheMetrics() const {
+    return cacheMetrics_;
+}
+
+LRUCache* ShardedLRUCache::GetShard(const std::string &key) const {
+    return shards_[std::hash<std::string>()(key) % shards_.size()].get();
 }
 
 }  // namespace mds
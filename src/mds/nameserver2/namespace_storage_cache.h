@@ -27,6 +27,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "src/common/concurrent/concurrent.h"
 #include "src/mds/nameserver2/metric.h"
 
@@ -67,12 +68,24 @@ class Cache {
 
 class LRUCache : public Cache {
  public:
-    LRUCache() : maxCount_(0) {
+    LRUCache() : maxCount_(0), maxBytes_(0), bytes_(0) {
         cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
     }
-    explicit LRUCache(int maxCount) : maxCount_(maxCount) {
+    explicit LRUCache(int maxCount)
+        : maxCount_(maxCount), maxBytes_(0), bytes_(0) {
         cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
     }
+    /*
+    * @param[in] maxCount the maximum number of items, 0 means unlimited
+    * @param[in] maxBytes the maximum bytes of keys and values,
+    *            0 means unlimited
+    * @param[in] cacheMetrics metrics updated by this cache, can be shared
+    *            with other caches
+    */
+    LRUCache(int maxCount, uint64_t maxBytes,
+             std::shared_ptr<NameserverCacheMetrics> cacheMetrics)
+        : maxCount_(maxCount), maxBytes_(maxBytes), bytes_(0),
+          cacheMetrics_(cacheMetrics) {}
 
     void Put(const std::string &key, const std::string &value) override;
     bool Get(const std::string &key, std::string *value) override;
@@ -103,7 +116,7 @@ class LRUCache : public Cache {
     void MoveToFront(const std::list<Item>::iterator &elem);
 
     /*
-    * @brief RemoveOldest Remove elements exceeded maxCount
+    * @brief RemoveOldest Remove the least recently used element
     */
     void RemoveOldest();
 
@@ -119,6 +132,10 @@ class LRUCache : public Cache {
 
     // the maximum length of the queue. 0 indicates unlimited length
     int maxCount_;
+    // the maximum bytes of keys and values. 0 indicates unlimited bytes
+    uint64_t maxBytes_;
+    // bytes of keys and values in the cache
+    uint64_t bytes_;
     // dequeue for storing items
     std::list<Item> ll_;
     // record the position of the item corresponding to the key in the dequeue
@@ -128,6 +145,33 @@ class LRUCache : public Cache {
     std::shared_ptr<NameserverCacheMetrics> cacheMetrics_;
 };
 
+// LRUCache split into shards by the hash of key. Each shard has its own lock
+// and limits, so lookups of different keys seldom wait for each other. All
+// shards update the same NameserverCacheMetrics.
+class ShardedLRUCache : public Cache {
+ public:
+    /*
+    * @param[in] shardNum the number of shards
+    * @param[in] maxCount the maximum number of items of all shards,
+    *            0 means unlimited
+    * @param[in] maxBytes the maximum bytes of keys and values of all shards,
+    *            0 means unlimited
+    */
+    ShardedLRUCache(uint32_t shardNum, int maxCount, uint64_t maxBytes);
+
+    void Put(const std::string &key, const std::string &value) override;
+    bool Get(const std::string &key, std::string *value) override;
+    void Remove(const std::string &key) override;
+    std::shared_ptr<NameserverCacheMetrics> GetCacheMetrics() const;
+
+ private:
+    LRUCache* GetShard(const std::string &key) const;
+
+ private:
+    std::vector<std::unique_ptr<LRUCache>> shards_;
+    std::shared_ptr<NameserverCacheMetrics> cacheMetrics_;
+};
+
 }  // namespace mds
 }  // namespace curve
 
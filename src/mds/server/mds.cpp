@@ -59,6 +59,9 @@ void MDS::InitMdsOptions(std::shared_ptr<Configuration> conf) {
 
     // cache size of namestorage
     conf_->GetValueFatalIfFail("mds.cache.count", &options_.mdsCacheCount);
+    conf_->GetValueFatalIfFail("mds.cache.bytes", &options_.mdsCacheBytes);
+    conf_->GetValueFatalIfFail(
+        "mds.cache.shardNum", &options_.mdsCacheShardNum);
 
     conf_->GetValueFatalIfFail("mds.listen.addr", &options_.mdsListenAddr);
 
@@ -115,7 +118,8 @@ void MDS::StartCompaginLeader() {
 void MDS::Init() {
     InitSegmentAllocStatistic(options_.retryInterTimes,
                               options_.periodicPersistInterMs);
-    InitNameServerStorage(options_.mdsCacheCount);
+    InitNameServerStorage(options_.mdsCacheCount, options_.mdsCacheBytes,
+                          options_.mdsCacheShardNum);
     InitTopology(options_.topologyOption);
     InitTopologyStat();
     InitTopologyChunkAllocator(options_.topologyOption);
@@ -285,6 +289,9 @@ void MDS::InitTopologyOption(TopologyOption *topologyOption) {
     conf_->GetValueFatalIfFail(
         "mds.topology.TopologyUpdateToRepoSec",
         &topologyOption->TopologyUpdateToRepoSec);
+    conf_->GetValueFatalIfFail(
+        "mds.topology.FlushBatchSize",
+        &topologyOption->FlushBatchSize);
     conf_->GetValueFatalIfFail(
         "mds.topology.CreateCopysetRpcTimeoutMs",
         &topologyOption->CreateCopysetRpcTimeoutMs);
@@ -386,10 +393,12 @@ void MDS::InitTopologyChunkAllocator(const TopologyOption& option) {
     LOG(INFO) << "init topologyChunkAllocator success.";
 }
 
-void MDS::InitNameServerStorage(int mdsCacheCount) {
+void MDS::InitNameServerStorage(int mdsCacheCount, uint64_t mdsCacheBytes,
+                                uint32_t mdsCacheShardNum) {
     // init LRUCache
-    auto cache = std::make_shared<LRUCache>(mdsCacheCount);
-    LOG(INFO) << "init LRUCache success.";
+    auto cache = std::make_shared<ShardedLRUCache>(
+        mdsCacheShardNum, mdsCacheCount, mdsCacheBytes);
+    LOG(INFO) << "init LRUCache success, shard num = " << mdsCacheShardNum;
 
     // init NameServerStorage
     nameServerStorage_ = std::make_shared<NameServerStorageImp>(etcdClient_,
@@ -493,6 +502,8 @@ void MDS::InitCurveFSOptions(CurveFSOption *curveFSOptions) {
         "mds.curvefs.minFileLength", &curveFSOptions->minFileLength);
     conf_->GetValueFatalIfFail(
         "mds.curvefs.maxFileLength", &curveFSOptions->maxFileLength);
+    conf_->GetValueFatalIfFail(
+        "mds.curvefs.buildCopysetIndex", &curveFSOptions->buildCopysetIndex);
     FileRecordOptions fileRecordOptions;
     InitFileRecordOptions(&curveFSOptions->fileRecordOptions);
 
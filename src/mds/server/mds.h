@@ -95,6 +95,8 @@ struct MDSOptions {
     uint64_t periodicPersistInterMs;
     // cache size of namestorage
     int mdsCacheCount;
+    uint64_t mdsCacheBytes;
+    uint32_t mdsCacheShardNum;
     int mdsFilelockBucketNum;
 
     FileRecordOptions fileRecordOptions;
@@ -178,7 +180,8 @@ class MDS {
     void InitSegmentAllocStatistic(uint64_t retryInterTimes,
                                    uint64_t periodicPersistInterMs);
 
-    void InitNameServerStorage(int mdsCacheCount);
+    void InitNameServerStorage(int mdsCacheCount, uint64_t mdsCacheBytes,
+                               uint32_t mdsCacheShardNum);
 
     void StartServer();
 
@@ -21,9 +21,11 @@
  */
 #include "src/mds/topology/topology.h"
 #include <glog/logging.h>
+#include <butil/time.h>
 #include "src/common/timeutility.h"
 #include "src/common/uuid.h"
 
+#include <algorithm>
 #include <chrono>  //NOLINT
 
 using ::curve::common::UUIDGenerator;
@@ -403,6 +405,7 @@ int TopologyImpl::UpdateChunkServerRwState(const ChunkServerStatus &rwState,
             csCapacity = it->second.GetChunkServerState().GetDiskCapacity();
             it->second.SetStatus(rwState);
             it->second.SetDirtyFlag(true);
+            MarkChunkServerDirty(id);
         }
     }
     // update physical pool
@@ -486,6 +489,7 @@ int TopologyImpl::UpdateChunkServerOnlineState(const OnlineState &onlineState,
         WriteLockGuard wlockChunkServer(it->second.GetRWLockRef());
         it->second.SetOnlineState(onlineState);
         it->second.SetDirtyFlag(true);
+        MarkChunkServerDirty(id);
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeChunkServerNotFound;
@@ -515,6 +519,7 @@ int TopologyImpl::UpdateChunkServerDiskStatus(const ChunkServerState &state,
             // database by background process regularly
             it->second.SetChunkServerState(state);
             it->second.SetDirtyFlag(true);
+            MarkChunkServerDirty(id);
         } else {
             return kTopoErrCodeChunkServerNotFound;
         }
@@ -885,6 +890,15 @@ std::list<ZoneIdType> TopologyImpl::GetZoneInLogicalPool(PoolIdType id,
 
 int TopologyImpl::Init(const TopologyOption &option) {
     option_ = option;
+    // a batch larger than one transaction always fails to flush
+    if (option_.FlushBatchSize == 0 ||
+        option_.FlushBatchSize > kMaxUpdateBatchSize) {
+        uint32_t batchSize = std::min(std::max(option_.FlushBatchSize, 1u),
+                                      kMaxUpdateBatchSize);
+        LOG(WARNING) << "invalid FlushBatchSize " << option_.FlushBatchSize
+                     << ", use " << batchSize << " instead";
+        option_.FlushBatchSize = batchSize;
+    }
 
     int ret = LoadClusterInfo();
     if (ret != kTopoErrCodeSuccess) {
@@ -1012,6 +1026,8 @@ int TopologyImpl::Init(const TopologyOption &option) {
     }
     LOG(INFO) << "Clean Invalid LogicalPool and copyset success.";
 
+    BuildCopySetIndex();
+
     return kTopoErrCodeSuccess;
 }
 
@@ -1062,6 +1078,7 @@ int TopologyImpl::AddCopySet(const CopySetInfo &data) {
                 return kTopoErrCodeStorgeFail;
             }
             copySetMap_[key] = data;
+            AddCopySetToIndex(key, data.GetCopySetMembers());
             return kTopoErrCodeSuccess;
         } else {
             return kTopoErrCodeIdDuplicated;
@@ -1078,7 +1095,8 @@ int TopologyImpl::RemoveCopySet(CopySetKey key) {
         if (!storage_->DeleteCopySet(key)) {
             return kTopoErrCodeStorgeFail;
         }
-        copySetMap_.erase(key);
+        RemoveCopySetFromIndex(key, it->second.GetCopySetMembers());
+        copySetMap_.erase(it);
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeCopySetNotFound;
@@ -1093,7 +1111,14 @@ int TopologyImpl::UpdateCopySetTopo(const CopySetInfo &data) {
         WriteLockGuard wlockCopySet(it->second.GetRWLockRef());
         it->second.SetLeader(data.GetLeader());
         it->second.SetEpoch(data.GetEpoch());
-        it->second.SetCopySetMembers(data.GetCopySetMembers());
+        std::set<ChunkServerIdType> oldMembers =
+            it->second.GetCopySetMembers();
+        std::set<ChunkServerIdType> newMembers = data.GetCopySetMembers();
+        if (oldMembers != newMembers) {
+            RemoveCopySetFromIndex(key, oldMembers);
+            AddCopySetToIndex(key, newMembers);
+            it->second.SetCopySetMembers(newMembers);
+        }
         if (data.HasCandidate()) {
             it->second.SetCandidate(data.GetCandidate());
         } else {
@@ -1110,6 +1135,7 @@ int TopologyImpl::UpdateCopySetTopo(const CopySetInfo &data) {
         }
 
         it->second.SetDirtyFlag(true);
+        MarkCopySetDirty(key);
         return kTopoErrCodeSuccess;
     } else {
         LOG(WARNING) << "UpdateCopySetTopo can not find copyset, "
@@ -1158,9 +1184,10 @@ std::vector<CopySetIdType> TopologyImpl::GetCopySetsInLogicalPool(
     CopySetFilter filter) const {
     std::vector<CopySetIdType> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.first.first == logicalPoolId) {
-            ret.push_back(it.first.second);
+    for (auto it = copySetMap_.lower_bound(CopySetKey(logicalPoolId, 0));
+         it != copySetMap_.end() && it->first.first == logicalPoolId; ++it) {
+        if (filter(it->second)) {
+            ret.push_back(it->first.second);
         }
     }
     return ret;
@@ -1171,9 +1198,10 @@ std::vector<CopySetInfo> TopologyImpl::GetCopySetInfosInLogicalPool(
     CopySetFilter filter) const {
     std::vector<CopySetInfo> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.first.first == logicalPoolId) {
-            ret.push_back(it.second);
+    for (auto it = copySetMap_.lower_bound(CopySetKey(logicalPoolId, 0));
+         it != copySetMap_.end() && it->first.first == logicalPoolId; ++it) {
+        if (filter(it->second)) {
+            ret.push_back(it->second);
         }
     }
     return ret;
@@ -1183,7 +1211,7 @@ std::vector<CopySetKey> TopologyImpl::GetCopySetsInCluster(
     CopySetFilter filter) const {
     std::vector<CopySetKey> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
+    for (const auto &it : copySetMap_) {
         if (filter(it.second)) {
             ret.push_back(it.first);
         }
@@ -1196,14 +1224,59 @@ std::vector<CopySetKey> TopologyImpl::GetCopySetsInChunkServer(
     CopySetFilter filter) const {
     std::vector<CopySetKey> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.second.GetCopySetMembers().count(id) > 0) {
-            ret.push_back(it.first);
+    // filter is not called with the index lock held
+    std::vector<CopySetKey> keys;
+    {
+        ReadLockGuard rlockIndex(chunkServerCopySetsMutex_);
+        auto ix = chunkServerCopySets_.find(id);
+        if (ix == chunkServerCopySets_.end()) {
+            return ret;
+        }
+        keys.assign(ix->second.begin(), ix->second.end());
+    }
+    ret.reserve(keys.size());
+    for (const auto &key : keys) {
+        auto it = copySetMap_.find(key);
+        if (it != copySetMap_.end() && filter(it->second)) {
+            ret.push_back(key);
         }
     }
     return ret;
 }
 
+void TopologyImpl::AddCopySetToIndex(const CopySetKey &key,
+    const std::set<ChunkServerIdType> &members) {
+    WriteLockGuard wlockIndex(chunkServerCopySetsMutex_);
+    for (auto csId : members) {
+        chunkServerCopySets_[csId].insert(key);
+    }
+}
+
+void TopologyImpl::RemoveCopySetFromIndex(const CopySetKey &key,
+    const std::set<ChunkServerIdType> &members) {
+    WriteLockGuard wlockIndex(chunkServerCopySetsMutex_);
+    for (auto csId : members) {
+        auto ix = chunkServerCopySets_.find(csId);
+        if (ix == chunkServerCopySets_.end()) {
+            continue;
+        }
+        ix->second.erase(key);
+        if (ix->second.empty()) {
+            chunkServerCopySets_.erase(ix);
+        }
+    }
+}
+
+void TopologyImpl::BuildCopySetIndex() {
+    WriteLockGuard wlockIndex(chunkServerCopySetsMutex_);
+    chunkServerCopySets_.clear();
+    for (const auto &it : copySetMap_) {
+        for (auto csId : it.second.GetCopySetMembers()) {
+            chunkServerCopySets_[csId].insert(it.first);
+        }
+    }
+}
+
 int TopologyImpl::Run() {
     if (isStop_.exchange(false)) {
         backEndThread_ = curve::common::Thread(
@@ -1231,42 +1304,141 @@ void TopologyImpl::BackEndFunc() {
 }
 
 void TopologyImpl::FlushCopySetToStorage() {
-    std::vector<PoolIdType> pools = GetLogicalPoolInCluster();
-    for (const auto poolId : pools) {
+    std::set<CopySetKey> dirty;
+    {
+        LockGuard lockDirty(dirtyMutex_);
+        dirty.swap(dirtyCopySets_);
+    }
+    if (dirty.empty()) {
+        return;
+    }
+
+    butil::Timer timer;
+    timer.start();
+    // only the copysets in dirty set are visited, and the map lock is
+    // released before writing to storage
+    std::vector<CopySetInfo> toUpdate;
+    toUpdate.reserve(dirty.size());
+    {
         ReadLockGuard rlockCopySetMap(copySetMutex_);
-        for (auto &c : copySetMap_) {
-            WriteLockGuard wlockCopySet(c.second.GetRWLockRef());
-            if (c.second.GetDirtyFlag() &&
-                        c.second.GetLogicalPoolId() == poolId) {
-                c.second.SetDirtyFlag(false);
-                if (!storage_->UpdateCopySet(c.second)) {
-                    LOG(WARNING) << "update copyset("
-                                 << c.second.GetLogicalPoolId()
-                                 << "," << c.second.GetId() << ") to repo fail";
-                }
+        for (const auto &key : dirty) {
+            auto it = copySetMap_.find(key);
+            // the copyset has been removed
+            if (it == copySetMap_.end()) {
+                continue;
+            }
+            WriteLockGuard wlockCopySet(it->second.GetRWLockRef());
+            if (it->second.GetDirtyFlag()) {
+                it->second.SetDirtyFlag(false);
+                toUpdate.push_back(it->second);
             }
         }
     }
+
+    uint32_t batchSize = option_.FlushBatchSize;
+    for (size_t i = 0; i < toUpdate.size(); i += batchSize) {
+        auto begin = toUpdate.begin() + i;
+        auto end = toUpdate.begin() +
+            std::min(toUpdate.size(), i + batchSize);
+        std::vector<CopySetInfo> batch(begin, end);
+        flushMetric_.copysetBatchSize << batch.size();
+        if (!storage_->UpdateCopySets(batch)) {
+            LOG(WARNING) << "update " << batch.size()
+                         << " copysets to repo fail, first copyset("
+                         << batch[0].GetLogicalPoolId()
+                         << "," << batch[0].GetId() << ")";
+            flushMetric_.flushFailCount << 1;
+            RedirtyCopySets(batch);
+        }
+    }
+    timer.stop();
+    flushMetric_.copysetFlushLatency << timer.u_elapsed();
 }
 
 void TopologyImpl::FlushChunkServerToStorage() {
+    std::unordered_set<ChunkServerIdType> dirty;
+    {
+        LockGuard lockDirty(dirtyMutex_);
+        dirty.swap(dirtyChunkServers_);
+    }
+    if (dirty.empty()) {
+        return;
+    }
+
+    butil::Timer timer;
+    timer.start();
     std::vector<ChunkServer> toUpdate;
+    toUpdate.reserve(dirty.size());
     {
         ReadLockGuard rlockChunkServerMap(chunkServerMutex_);
-        for (auto &c : chunkServerMap_) {
-            // update DirtyFlag only, thus only read lock is needed
-            ReadLockGuard rlockChunkServer(c.second.GetRWLockRef());
-            if (c.second.GetDirtyFlag()) {
-                c.second.SetDirtyFlag(false);
-                toUpdate.push_back(c.second);
+        for (const auto id : dirty) {
+            auto it = chunkServerMap_.find(id);
+            // the chunkserver has been removed
+            if (it == chunkServerMap_.end()) {
+                continue;
+            }
+            WriteLockGuard wlockChunkServer(it->second.GetRWLockRef());
+            if (it->second.GetDirtyFlag()) {
+                it->second.SetDirtyFlag(false);
+                toUpdate.push_back(it->second);
             }
         }
     }
-    for (auto &v : toUpdate) {
-        if (!storage_->UpdateChunkServer(v)) {
-            LOG(WARNING) << "update chunkserver to repo fail"
-                         << ", chunkserverid = " << v.GetId();
+
+    uint32_t batchSize = option_.FlushBatchSize;
+    for (size_t i = 0; i < toUpdate.size(); i += batchSize) {
+        auto begin = toUpdate.begin() + i;
+        auto end = toUpdate.begin() +
+            std::min(toUpdate.size(), i + batchSize);
+        std::vector<ChunkServer> batch(begin, end);
+        flushMetric_.chunkserverBatchSize << batch.size();
+        if (!storage_->UpdateChunkServers(batch)) {
+            LOG(WARNING) << "update " << batch.size()
+                         << " chunkservers to repo fail"
+                         << ", first chunkserverid = " << batch[0].GetId();
+            flushMetric_.flushFailCount << 1;
+            RedirtyChunkServers(batch);
+        }
+    }
+    timer.stop();
+    flushMetric_.chunkserverFlushLatency << timer.u_elapsed();
+}
+
+void TopologyImpl::MarkCopySetDirty(const CopySetKey &key) {
+    LockGuard lockDirty(dirtyMutex_);
+    dirtyCopySets_.insert(key);
+}
+
+void TopologyImpl::MarkChunkServerDirty(ChunkServerIdType id) {
+    LockGuard lockDirty(dirtyMutex_);
+    dirtyChunkServers_.insert(id);
+}
+
+void TopologyImpl::RedirtyCopySets(const std::vector<CopySetInfo> &copysets) {
+    ReadLockGuard rlockCopySetMap(copySetMutex_);
+    for (const auto &cs : copysets) {
+        CopySetKey key(cs.GetLogicalPoolId(), cs.GetId());
+        auto it = copySetMap_.find(key);
+        if (it == copySetMap_.end()) {
+            continue;
+        }
+        WriteLockGuard wlockCopySet(it->second.GetRWLockRef());
+        it->second.SetDirtyFlag(true);
+        MarkCopySetDirty(key);
+    }
+}
+
+void TopologyImpl::RedirtyChunkServers(
+    const std::vector<ChunkServer> &chunkservers) {
+    ReadLockGuard rlockChunkServerMap(chunkServerMutex_);
+    for (const auto &cs : chunkservers) {
+        auto it = chunkServerMap_.find(cs.GetId());
+        if (it == chunkServerMap_.end()) {
+            continue;
         }
+        WriteLockGuard wlockChunkServer(it->second.GetRWLockRef());
+        it->second.SetDirtyFlag(true);
+        MarkChunkServerDirty(cs.GetId());
     }
 }
 
@@ -22,7 +22,11 @@
 #ifndef SRC_MDS_TOPOLOGY_TOPOLOGY_H_
 #define SRC_MDS_TOPOLOGY_TOPOLOGY_H_
 
+#include <bvar/bvar.h>
+
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
 #include <string>
 #include <list>
 #include <memory>
@@ -42,6 +46,7 @@
 using ::curve::common::RWLock;
 using ::curve::common::ReadLockGuard;
 using ::curve::common::WriteLockGuard;
+using ::curve::common::LockGuard;
 using ::curve::common::InterruptibleSleeper;
 
 namespace curve {
@@ -328,6 +333,26 @@ class Topology {
             return true;}) const = 0;
 };
 
+// metric of flushing dirty copysets and chunkservers to storage
+struct TopologyFlushMetric {
+    const std::string prefix = "mds_topology_flush";
+    // time cost of each flush (us)
+    bvar::LatencyRecorder copysetFlushLatency;
+    bvar::LatencyRecorder chunkserverFlushLatency;
+    // number of items written in one transaction
+    bvar::IntRecorder copysetBatchSize;
+    bvar::IntRecorder chunkserverBatchSize;
+    // number of failed transactions
+    bvar::Adder<uint64_t> flushFailCount;
+
+    TopologyFlushMetric()
+        : copysetFlushLatency(prefix, "copyset"),
+          chunkserverFlushLatency(prefix, "chunkserver"),
+          copysetBatchSize(prefix, "copyset_batch_size"),
+          chunkserverBatchSize(prefix, "chunkserver_batch_size"),
+          flushFailCount(prefix, "fail_count") {}
+};
+
 class TopologyImpl : public Topology {
  public:
     TopologyImpl(std::shared_ptr<TopologyIdGenerator> idGenerator,
@@ -574,10 +599,58 @@ class TopologyImpl : public Topology {
 
     void BackEndFunc();
 
+    /**
+     * @brief write dirty copysets to storage in batches, only the copysets
+     *        recorded in dirtyCopySets_ are visited
+     */
     void FlushCopySetToStorage();
 
+    /**
+     * @brief write dirty chunkservers to storage in batches, only the
+     *        chunkservers recorded in dirtyChunkServers_ are visited
+     */
     void FlushChunkServerToStorage();
 
+    /**
+     * @brief record the copyset which needs to be flushed,
+     *        called with write lock of the copyset held
+     */
+    void MarkCopySetDirty(const CopySetKey &key);
+
+    /**
+     * @brief record the chunkserver which needs to be flushed,
+     *        called with write lock of the chunkserver held
+     */
+    void MarkChunkServerDirty(ChunkServerIdType id);
+
+    /**
+     * @brief mark the copysets dirty again after failed to flush them,
+     *        so that they will be retried in the next round
+     */
+    void RedirtyCopySets(const std::vector<CopySetInfo> &copysets);
+
+    void RedirtyChunkServers(const std::vector<ChunkServer> &chunkservers);
+
+    /**
+     * @brief add copyset to the index of its members,
+     *        called with write lock of copySetMutex_ or the copyset held
+     */
+    void AddCopySetToIndex(const CopySetKey &key,
+        const std::set<ChunkServerIdType> &members);
+
+    /**
+     * @brief remove copyset from the index of its members,
+     *        called with write lock of copySetMutex_ or the copyset held
+     */
+    void RemoveCopySetFromIndex(const CopySetKey &key,
+        const std::set<ChunkServerIdType> &members);
+
+    /**
+     * @brief build the index of copysets on each chunkserver from
+     *        copySetMap_, called during Init
+     */
+    void BuildCopySetIndex();
+
     void SetChunkServerExternalIp();
 
  private:
@@ -587,7 +660,13 @@ class TopologyImpl : public Topology {
     std::unordered_map<ServerIdType, Server> serverMap_;
     std::unordered_map<ChunkServerIdType, ChunkServer> chunkServerMap_;
 
+    // ordered by logical pool id first, so copysets in a logical pool
+    // are visited by range
     std::map<CopySetKey, CopySetInfo> copySetMap_;
+    // copysets on each chunkserver, updated along with copySetMap_
+    // and members of copysets
+    std::unordered_map<ChunkServerIdType, std::set<CopySetKey>>
+        chunkServerCopySets_;
 
     // cluster info
     ClusterInformation clusterInfo;
@@ -603,6 +682,16 @@ class TopologyImpl : public Topology {
     mutable curve::common::RWLock serverMutex_;
     mutable curve::common::RWLock chunkServerMutex_;
     mutable curve::common::RWLock copySetMutex_;
+    // protect chunkServerCopySets_, fetched after copySetMutex_
+    // and the lock of copyset
+    mutable curve::common::RWLock chunkServerCopySetsMutex_;
+
+    // copysets and chunkservers changed since last flush,
+    // dirtyMutex_ is always fetched last
+    curve::common::Mutex dirtyMutex_;
+    std::set<CopySetKey> dirtyCopySets_;
+    std::unordered_set<ChunkServerIdType> dirtyChunkServers_;
+    TopologyFlushMetric flushMetric_;
 
     TopologyOption option_;
     curve::common::Thread backEndThread_;
@@ -32,6 +32,8 @@ namespace topology {
 struct TopologyOption {
     // time interval that topology data updated to storage
     uint32_t TopologyUpdateToRepoSec;
+    // max number of copysets or chunkservers written in one etcd transaction
+    uint32_t FlushBatchSize;
     // timeout peroid of RPC for copyset creation (in ms)
     uint32_t CreateCopysetRpcTimeoutMs;
     // retry times after timeout of RPC for copyset creation
@@ -49,6 +51,7 @@ struct TopologyOption {
 
     TopologyOption()
         : TopologyUpdateToRepoSec(0),
+          FlushBatchSize(64),
           CreateCopysetRpcTimeoutMs(500),
           CreateCopysetRpcRetryTimes(3),
           CreateCopysetRpcRetrySleepTimeMs(500),
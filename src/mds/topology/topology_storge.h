@@ -37,6 +37,10 @@ namespace curve {
 namespace mds {
 namespace topology {
 
+// max number of items updated in one transaction, equal to the max number
+// of ops in one etcd transaction
+const uint32_t kMaxUpdateBatchSize = 128;
+
 class TopologyStorage {
  public:
     TopologyStorage() {}
@@ -82,6 +86,11 @@ class TopologyStorage {
     virtual bool UpdateChunkServer(const ChunkServer &data) = 0;
     virtual bool UpdateCopySet(const CopySetInfo &data) = 0;
 
+    // update several items in one transaction, at most
+    // kMaxUpdateBatchSize items
+    virtual bool UpdateChunkServers(const std::vector<ChunkServer> &data) = 0;
+    virtual bool UpdateCopySets(const std::vector<CopySetInfo> &data) = 0;
+
     virtual bool LoadClusterInfo(std::vector<ClusterInformation> *info) = 0;
     virtual bool StorageClusterInfo(const ClusterInformation &info) = 0;
 };
@@ -31,6 +31,9 @@ namespace curve {
 namespace mds {
 namespace topology {
 
+static_assert(kMaxUpdateBatchSize <= static_cast<uint32_t>(kMaxTxnOps),
+              "batch update must fit in one etcd transaction");
+
 bool TopologyStorageEtcd::LoadLogicalPool(
     std::unordered_map<PoolIdType, LogicalPool> *logicalPoolMap,
     PoolIdType *maxLogicalPoolId) {
@@ -468,6 +471,76 @@ bool TopologyStorageEtcd::UpdateCopySet(const CopySetInfo &data) {
     return StorageCopySet(data);
 }
 
+bool TopologyStorageEtcd::UpdateChunkServers(
+    const std::vector<ChunkServer> &data) {
+    std::vector<std::pair<std::string, std::string>> kvs;
+    kvs.reserve(data.size());
+    for (auto &cs : data) {
+        std::string value;
+        if (!codec_->EncodeChunkServerData(cs, &value)) {
+            LOG(ERROR) << "EncodeChunkServerData err"
+                       << ", chunkServerId = " << cs.GetId();
+            return false;
+        }
+        kvs.emplace_back(codec_->EncodeChunkServerKey(cs.GetId()),
+                         std::move(value));
+    }
+    int errCode = PutInTxn(kvs);
+    if (errCode != EtcdErrCode::EtcdOK) {
+        LOG(ERROR) << "Put ChunkServers into etcd err"
+                   << ", errcode = " << errCode
+                   << ", count = " << data.size();
+        return false;
+    }
+    return true;
+}
+
+bool TopologyStorageEtcd::UpdateCopySets(
+    const std::vector<CopySetInfo> &data) {
+    std::vector<std::pair<std::string, std::string>> kvs;
+    kvs.reserve(data.size());
+    for (auto &cs : data) {
+        std::string value;
+        if (!codec_->EncodeCopySetData(cs, &value)) {
+            LOG(ERROR) << "EncodeCopySetData err"
+                       << ", logicalPoolId = " << cs.GetLogicalPoolId()
+                       << ", copysetId = " << cs.GetId();
+            return false;
+        }
+        CopySetKey id(cs.GetLogicalPoolId(), cs.GetId());
+        kvs.emplace_back(codec_->EncodeCopySetKey(id), std::move(value));
+    }
+    int errCode = PutInTxn(kvs);
+    if (errCode != EtcdErrCode::EtcdOK) {
+        LOG(ERROR) << "Put Copysets into etcd err"
+                   << ", errcode = " << errCode
+                   << ", count = " << data.size();
+        return false;
+    }
+    return true;
+}
+
+int TopologyStorageEtcd::PutInTxn(
+    const std::vector<std::pair<std::string, std::string>> &kvs) {
+    if (kvs.empty()) {
+        return EtcdErrCode::EtcdOK;
+    }
+    // no need of transaction for a single key
+    if (kvs.size() == 1) {
+        return client_->Put(kvs[0].first, kvs[0].second);
+    }
+    std::vector<Operation> ops;
+    ops.reserve(kvs.size());
+    for (auto &kv : kvs) {
+        ops.emplace_back(Operation{OpType::OpPut,
+            const_cast<char*>(kv.first.c_str()),
+            const_cast<char*>(kv.second.c_str()),
+            static_cast<int>(kv.first.size()),
+            static_cast<int>(kv.second.size())});
+    }
+    return client_->TxnN(ops);
+}
+
 bool TopologyStorageEtcd::LoadClusterInfo(
     std::vector<ClusterInformation> *info) {
     std::string value;
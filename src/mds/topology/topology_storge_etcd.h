@@ -27,6 +27,8 @@
 #include <map>
 #include <unordered_map>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "src/mds/topology/topology_storge.h"
 #include "src/kvstorageclient/etcd_client.h"
@@ -88,9 +90,22 @@ class TopologyStorageEtcd : public TopologyStorage {
     bool UpdateChunkServer(const ChunkServer &data) override;
     bool UpdateCopySet(const CopySetInfo &data) override;
 
+    bool UpdateChunkServers(const std::vector<ChunkServer> &data) override;
+    bool UpdateCopySets(const std::vector<CopySetInfo> &data) override;
+
     bool LoadClusterInfo(std::vector<ClusterInformation> *info) override;
     bool StorageClusterInfo(const ClusterInformation &info) override;
 
+ private:
+    /**
+     * @brief put keys and values into etcd in one transaction
+     *
+     * @param kvs keys and values, at most kMaxTxnOps
+     *
+     * @return error code of etcd
+     */
+    int PutInTxn(const std::vector<std::pair<std::string, std::string>> &kvs);
+
  private:
     // underlying storage media
     std::shared_ptr<KVStorageClient> client_;
@@ -195,12 +195,14 @@ TEST_F(CloneCoreTest, ReadChunkTest2) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     std::shared_ptr<CloneCore> core
         = std::make_shared<CloneCore>(SLICE_SIZE, true, copyer_);
     // case1
     {
-        info.bitmap->Set();
+        bitmap->Set();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -237,7 +239,8 @@ TEST_F(CloneCoreTest, ReadChunkTest2) {
 
     // case2
     {
-        info.bitmap->Clear();
+        bitmap->Clear();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -287,8 +290,9 @@ TEST_F(CloneCoreTest, ReadChunkTest2) {
 
     // case3
     {
-        info.bitmap->Clear();
-        info.bitmap->Set(0, 2);
+        bitmap->Clear();
+        bitmap->Set(0, 2);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -346,8 +350,9 @@ TEST_F(CloneCoreTest, ReadChunkTest2) {
     {
         offset = 1024;
         length = 4 * PAGE_SIZE;
-        info.bitmap->Clear();
-        info.bitmap->Set(0, 2);
+        bitmap->Clear();
+        bitmap->Set(0, 2);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -390,13 +395,15 @@ TEST_F(CloneCoreTest, ReadChunkTest3) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     std::shared_ptr<CloneCore> core
         = std::make_shared<CloneCore>(SLICE_SIZE, true, copyer_);
 
     // case1
     {
-        info.bitmap->Clear();
+        bitmap->Clear();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -461,9 +468,10 @@ TEST_F(CloneCoreTest, ReadChunkErrorTest) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
-    info.bitmap->Clear();
-    info.bitmap->Set(0, 2);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    bitmap->Clear();
+    bitmap->Set(0, 2);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     std::shared_ptr<CloneCore> core
         = std::make_shared<CloneCore>(SLICE_SIZE, true, copyer_);
     // case1
@@ -611,12 +619,14 @@ TEST_F(CloneCoreTest, RecoverChunkTest2) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     std::shared_ptr<CloneCore> core
         = std::make_shared<CloneCore>(SLICE_SIZE, true, copyer_);
     // case1
     {
-        info.bitmap->Set();
+        bitmap->Set();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_RECOVER, offset, length); //NOLINT
@@ -643,7 +653,8 @@ TEST_F(CloneCoreTest, RecoverChunkTest2) {
 
     // case2
     {
-        info.bitmap->Clear();
+        bitmap->Clear();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_RECOVER, offset, length);  //NOLINT
@@ -696,13 +707,15 @@ TEST_F(CloneCoreTest, DisablePasteTest) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     std::shared_ptr<CloneCore> core
         = std::make_shared<CloneCore>(SLICE_SIZE, false, copyer_);
 
     // case1
     {
-        info.bitmap->Clear();
+        bitmap->Clear();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, offset, length);
@@ -741,7 +754,8 @@ TEST_F(CloneCoreTest, DisablePasteTest) {
 
     // case2
     {
-        info.bitmap->Clear();
+        bitmap->Clear();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         // 每次调HandleReadRequest后会被closure释放
         std::shared_ptr<ReadChunkRequest> readRequest
             = GenerateReadRequest(CHUNK_OP_TYPE::CHUNK_OP_RECOVER, offset, length);  //NOLINT
@@ -607,6 +607,62 @@ TEST_F(OpRequestTest, ReadChunkTest) {
                   closure->response_->status());
         // ASSERT_STREQ(closure->response_->redirect().c_str(), PEER_STRING);
     }
+    /**
+     * 测试Process
+     * 用例： node_->IsLeaderTerm() == false, 请求为follower read，
+     *       请求的 apply index 大于 node的 apply index
+     * 预期： 会要求转发请求，返回CHUNK_OP_STATUS_REDIRECTED
+     */
+    {
+        // 重置closure
+        closure->Reset();
+
+        request->set_followerread(true);
+        request->set_appliedindex(LAST_INDEX + 1);
+
+        // 设置预期
+        EXPECT_CALL(*node_, IsLeaderTerm())
+            .WillRepeatedly(Return(false));
+        EXPECT_CALL(*node_, Propose(_))
+            .Times(0);
+
+        opReq->Process();
+
+        // 验证结果
+        ASSERT_TRUE(closure->isDone_);
+        ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED,
+                  closure->response_->status());
+    }
+    /**
+     * 测试Process
+     * 用例： node_->IsLeaderTerm() == false, 请求为follower read，
+     *       请求的 apply index 小于等于 node的 apply index
+     * 预期： 不会转发请求，请求提交给concurrentApplyModule_处理
+     */
+    {
+        // 重置closure
+        closure->Reset();
+
+        request->set_appliedindex(3);
+
+        // 设置预期
+        EXPECT_CALL(*node_, IsLeaderTerm())
+            .WillRepeatedly(Return(false));
+        EXPECT_CALL(*node_, Propose(_))
+            .Times(0);
+
+        opReq->Process();
+
+        // 验证结果
+        ASSERT_FALSE(closure->isDone_);
+        ASSERT_FALSE(response->has_appliedindex());
+        ASSERT_FALSE(closure->response_->has_status());
+
+        closure->Run();
+        ASSERT_TRUE(closure->isDone_);
+        request->clear_followerread();
+        request->clear_appliedindex();
+    }
     /**
      * 测试Process
      * 用例： node_->IsLeaderTerm() == true,
@@ -669,7 +725,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     /**
      * 测试OnApply
      * 用例：请求的 chunk 不是 clone chunk
@@ -717,7 +774,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Set();
+        bitmap->Set();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -754,7 +812,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Clear(1);
+        bitmap->Clear(1);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -853,7 +912,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Set();
+        bitmap->Set();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -939,7 +999,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Clear(1);
+        bitmap->Clear(1);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -1106,7 +1167,8 @@ TEST_F(OpRequestTest, RecoverChunkTest) {
     info.isClone = true;
     info.pageSize = PAGE_SIZE;
     info.chunkSize = CHUNK_SIZE;
-    info.bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    auto bitmap = std::make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+    info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     /**
      * 测试OnApply
      * 用例：请求的 chunk 不是 clone chunk
@@ -1147,7 +1209,8 @@ TEST_F(OpRequestTest, RecoverChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Set();
+        bitmap->Set();
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -1177,7 +1240,8 @@ TEST_F(OpRequestTest, RecoverChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Clear(1);
+        bitmap->Clear(1);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -1265,7 +1329,8 @@ TEST_F(OpRequestTest, RecoverChunkTest) {
 
         // 设置预期
         info.isClone = true;
-        info.bitmap->Clear(1);
+        bitmap->Clear(1);
+        info.bitmap = std::make_shared<CompactBitmap>(*bitmap);
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
@@ -24,6 +24,8 @@
 
 #include <atomic>
 #include <functional>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "src/common/timeutility.h"
@@ -166,3 +168,117 @@ TEST(ConcurrentApplyModule, ConcurrentTest) {
     concurrentapply.Stop();
 }
 
+
+TEST(ConcurrentApplyModule, OrderTest) {
+    // tasks with the same key are executed in push order
+    ConcurrentApplyModule concurrentapply;
+    ConcurrentApplyOption opt{4, 8, 1, 1};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    const int kKeyNum = 16;
+    const int kTaskNum = 10000;
+    std::vector<int> last(kKeyNum, -1);
+    std::atomic<int> disorder(0);
+    for (int i = 0; i < kTaskNum; i++) {
+        int key = i % kKeyNum;
+        auto task = [&last, &disorder, key, i]() {
+            if (last[key] >= i) {
+                disorder.fetch_add(1);
+            }
+            last[key] = i;
+        };
+        concurrentapply.Push(key, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
+    }
+
+    concurrentapply.Flush();
+    ASSERT_EQ(0, disorder.load());
+    for (int i = 0; i < kKeyNum; i++) {
+        ASSERT_EQ(kTaskNum - kKeyNum + i, last[i]);
+    }
+
+    concurrentapply.Stop();
+}
+
+TEST(ConcurrentApplyModule, StealTest) {
+    // key 0 and key 2 have the same home thread, the task of key 2 is
+    // stolen by the other thread while key 0 is blocked
+    ConcurrentApplyModule concurrentapply;
+    ConcurrentApplyOption opt{2, 1, 1, 1};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    std::atomic<bool> release(false);
+    std::atomic<bool> blocked(false);
+    auto slowtask = [&release, &blocked]() {
+        blocked.store(true);
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    std::atomic<int> testnum(0);
+    auto task = [&testnum]() {
+        testnum.fetch_add(1);
+    };
+
+    concurrentapply.Push(0, CHUNK_OP_TYPE::CHUNK_OP_WRITE, slowtask);
+    while (!blocked.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    concurrentapply.Push(2, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
+    concurrentapply.Push(2, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
+
+    int retry = 0;
+    while (testnum.load() < 2 && retry++ < 1000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(2, testnum.load());
+    ASSERT_FALSE(release.load());
+
+    release.store(true);
+    concurrentapply.Flush();
+    concurrentapply.Stop();
+}
+
+TEST(ConcurrentApplyModule, BlockWhenFullTest) {
+    // the pusher waits while the task queue of the group is full, and
+    // continues after the running thread takes tasks from it
+    ConcurrentApplyModule concurrentapply;
+    ConcurrentApplyOption opt{1, 1, 1, 1};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    std::atomic<bool> release(false);
+    std::atomic<bool> blocked(false);
+    auto slowtask = [&release, &blocked]() {
+        blocked.store(true);
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    std::atomic<int> testnum(0);
+    auto task = [&testnum]() {
+        testnum.fetch_add(1);
+    };
+
+    concurrentapply.Push(0, CHUNK_OP_TYPE::CHUNK_OP_WRITE, slowtask);
+    while (!blocked.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const int kTaskNum = 100;
+    std::atomic<bool> pushed(false);
+    std::thread pusher([&]() {
+        for (int i = 0; i < kTaskNum; i++) {
+            concurrentapply.Push(0, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
+        }
+        pushed.store(true);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(pushed.load());
+    ASSERT_EQ(0, testnum.load());
+
+    release.store(true);
+    pusher.join();
+    concurrentapply.Flush();
+    ASSERT_EQ(kTaskNum, testnum.load());
+    concurrentapply.Stop();
+}
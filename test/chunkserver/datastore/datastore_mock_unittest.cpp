@@ -126,7 +126,9 @@ class CSDataStore_test : public testing::Test {
             metaPage.version = FORMAT_VERSION;
             metaPage.sn = sn;
             metaPage.correctedSn = correctedSn;
-            metaPage.bitmap = bitmap;
+            if (bitmap != nullptr) {
+                metaPage.bitmap = std::make_shared<CompactBitmap>(*bitmap);
+            }
             metaPage.location = location;
             metaPage.encode(buf);
         }
@@ -1120,6 +1122,171 @@ TEST_F(CSDataStore_test, WriteChunkTest9) {
         .Times(1);
 }
 
+/**
+ * WriteChunkReflinkTest
+ * case:开启reflink快照，chunk存在快照，请求sn等于chunk的sn
+ * 预期结果:cow时通过reflink共享数据块，不读写数据；reflink失败时回退为拷贝
+ */
+TEST_F(CSDataStore_test, WriteChunkReflinkTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.enableReflinkSnapshot = true;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+
+    // initialize, the filesystem supports reflink
+    FakeEnv();
+    // probe with an unnamed tmpfile, nothing to delete after the probe
+    EXPECT_CALL(*lfs_, Open(string(baseDir), O_RDWR|O_TMPFILE))
+        .WillOnce(Return(10));
+    EXPECT_CALL(*lfs_, CloneRange(10, 0, 10, PAGE_SIZE, PAGE_SIZE))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(10))
+        .Times(1);
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 1;
+    SequenceNum sn = 2;
+    off_t offset = 0;
+    size_t length = PAGE_SIZE;
+    char buf[length];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    // will share the extents with the snapshot instead of copying
+    EXPECT_CALL(*lfs_, CloneRange(1, PAGE_SIZE + offset,
+                                  2, PAGE_SIZE + offset, length))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE + offset, length))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()),
+                             PAGE_SIZE + offset, length))
+        .Times(0);
+    // will sync the snapshot before updating its metapage
+    EXPECT_CALL(*lfs_, Fsync(2))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+        .Times(1);
+    // will write data
+    EXPECT_CALL(*lfs_,
+                Write(1, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->WriteChunk(id,
+                                    sn,
+                                    buf,
+                                    offset,
+                                    length,
+                                    nullptr));
+
+    // falls back to copying if the reflink fails
+    offset = PAGE_SIZE;
+    EXPECT_CALL(*lfs_, CloneRange(1, PAGE_SIZE + offset,
+                                  2, PAGE_SIZE + offset, length))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()),
+                             PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Fsync(2))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+        .Times(1);
+    EXPECT_CALL(*lfs_,
+                Write(1, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->WriteChunk(id,
+                                    sn,
+                                    buf,
+                                    offset,
+                                    length,
+                                    nullptr));
+
+    // the pages in the snapshot will not be cloned again
+    offset = 0;
+    length = 2 * PAGE_SIZE;
+    EXPECT_CALL(*lfs_, CloneRange(_, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(*lfs_,
+                Write(1, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->WriteChunk(id,
+                                    sn,
+                                    buf,
+                                    offset,
+                                    length,
+                                    nullptr));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/**
+ * WriteChunkReflinkTest
+ * case:开启reflink快照，但文件系统不支持reflink
+ * 预期结果:初始化时探测失败，cow时拷贝数据
+ */
+TEST_F(CSDataStore_test, WriteChunkReflinkNotSupportTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.enableReflinkSnapshot = true;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+
+    FakeEnv();
+    // probe with an unnamed tmpfile, nothing to delete after the probe
+    EXPECT_CALL(*lfs_, Open(string(baseDir), O_RDWR|O_TMPFILE))
+        .WillOnce(Return(10));
+    EXPECT_CALL(*lfs_, CloneRange(10, 0, 10, PAGE_SIZE, PAGE_SIZE))
+        .WillOnce(Return(-EOPNOTSUPP));
+    EXPECT_CALL(*lfs_, Close(10))
+        .Times(1);
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 1;
+    SequenceNum sn = 2;
+    off_t offset = 0;
+    size_t length = PAGE_SIZE;
+    char buf[length];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    // will copy on write
+    EXPECT_CALL(*lfs_, CloneRange(1, _, 2, _, _))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()),
+                             PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Write(2, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+        .Times(1);
+    EXPECT_CALL(*lfs_,
+                Write(1, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset, length))
+        .Times(1);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->WriteChunk(id,
+                                    sn,
+                                    buf,
+                                    offset,
+                                    length,
+                                    nullptr));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * WriteChunkTest
  * case:chunk存在,请求sn大于chunk的sn，等于correctSn
@@ -1406,6 +1573,144 @@ TEST_F(CSDataStore_test, WriteChunkTest13) {
         .Times(1);
 }
 
+/**
+ * WriteChunkDeferMetaTest
+ * 写clone chunk，clone_meta_sync_pages为4
+ * case1:写入之前未写过的3个page
+ * 预期结果1:bitmap只在内存中更新，不写metapage
+ * case2:SyncMetaPages
+ * 预期结果2:只更新存在未持久化page的chunk的metapage，再次调用不写metapage
+ * case3:写入之前未写过的4个page
+ * 预期结果3:达到阈值，更新metapage
+ * case4:遍写整个chunk
+ * 预期结果4:clone chunk转为普通chunk时立即更新metapage
+ */
+TEST_F(CSDataStore_test, WriteChunkDeferMetaTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.cloneMetaSyncPages = 4;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 3;
+    SequenceNum sn = 1;
+    SequenceNum correctedSn = 0;
+    CSChunkInfo info;
+    std::unique_ptr<char[]> buf(new char[CHUNK_SIZE]);
+    // 创建 clone chunk
+    {
+        char chunk3MetaPage[PAGE_SIZE];
+        memset(chunk3MetaPage, 0, sizeof(chunk3MetaPage));
+        shared_ptr<Bitmap> bitmap =
+            make_shared<Bitmap>(CHUNK_SIZE / PAGE_SIZE);
+        FakeEncodeChunk(chunk3MetaPage, correctedSn, sn, bitmap, location);
+        string chunk3Path = string(baseDir) + "/" +
+                            FileNameOperator::GenerateChunkFileName(id);
+        EXPECT_CALL(*lfs_, FileExists(chunk3Path))
+            .WillOnce(Return(false));
+        EXPECT_CALL(*fpool_, GetFileImpl(chunk3Path, NotNull()))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*lfs_, Open(chunk3Path, _))
+            .Times(1)
+            .WillOnce(Return(4));
+        EXPECT_CALL(*lfs_, Read(4, NotNull(), 0, PAGE_SIZE))
+            .WillOnce(DoAll(SetArrayArgument<1>(chunk3MetaPage,
+                            chunk3MetaPage + PAGE_SIZE),
+                            Return(PAGE_SIZE)));
+        EXPECT_EQ(CSErrorCode::Success,
+                  dataStore->CreateCloneChunk(id,
+                                              sn,
+                                              correctedSn,
+                                              CHUNK_SIZE,
+                                              location));
+    }
+    // 其他chunk没有未持久化的page，不会更新metapage
+    EXPECT_CALL(*lfs_, Write(1, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Write(3, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+        .Times(0);
+
+    // case1:写入[0, 4KB)和[4KB, 12KB)，共3个page
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<butil::IOBuf>(_), _, _))
+            .Times(2);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(0);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->WriteChunk(id, sn, buf.get(),
+                                        0, PAGE_SIZE, nullptr));
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->WriteChunk(id, sn, buf.get(),
+                                        PAGE_SIZE, 2 * PAGE_SIZE, nullptr));
+        // 读写请求看到的是内存中的bitmap
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_TRUE(info.isClone);
+        ASSERT_EQ(0, info.bitmap->NextSetBit(0));
+        ASSERT_EQ(3, info.bitmap->NextClearBit(0));
+        ASSERT_EQ(Bitmap::NO_POS, info.bitmap->NextSetBit(3));
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->ReadChunk(id, sn, buf.get(), 0, 3 * PAGE_SIZE));
+    }
+
+    // case2:SyncMetaPages
+    {
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(1);
+        ASSERT_EQ(CSErrorCode::Success, dataStore->SyncMetaPages());
+        ASSERT_EQ(CSErrorCode::Success, dataStore->SyncMetaPages());
+    }
+
+    // case3:写入[12KB, 28KB)，共4个page
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<butil::IOBuf>(_),
+                                 PAGE_SIZE + 3 * PAGE_SIZE, 4 * PAGE_SIZE))
+            .Times(1);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(1);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->WriteChunk(id, sn, buf.get(),
+                                        3 * PAGE_SIZE, 4 * PAGE_SIZE,
+                                        nullptr));
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_EQ(7, info.bitmap->NextClearBit(0));
+        ASSERT_EQ(CSErrorCode::Success, dataStore->SyncMetaPages());
+    }
+
+    // case4:遍写整个chunk
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<butil::IOBuf>(_),
+                                 PAGE_SIZE, CHUNK_SIZE))
+            .Times(1);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(1);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->WriteChunk(id, sn, buf.get(),
+                                        0, CHUNK_SIZE, nullptr));
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_FALSE(info.isClone);
+        ASSERT_EQ(nullptr, info.bitmap);
+        ASSERT_EQ(CSErrorCode::Success, dataStore->SyncMetaPages());
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(4))
+        .Times(1);
+}
+
 /**
  * WriteChunkTest
  * 写clone chunk，模拟恢复
@@ -1722,6 +2027,72 @@ TEST_F(CSDataStore_test, WriteChunkTest16) {
         .Times(1);
 }
 
+/**
+ * WriteChunkAsyncTest
+ * case1:chunk存在，请求sn等于chunk的sn，不需要cow
+ * 预期结果1:只写数据，不更新metapage，回调返回成功
+ * case2:请求sn大于chunk的sn
+ * 预期结果2:走同步写流程，先更新metapage再写数据，回调返回成功
+ */
+TEST_F(CSDataStore_test, WriteChunkAsyncTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 2;
+    off_t offset = 0;
+    size_t length = PAGE_SIZE;
+    char buf[length];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    butil::IOBuf data;
+    data.append(buf, length);
+
+    // case1
+    {
+        CSErrorCode result = CSErrorCode::InternalError;
+        auto cb = [&result](CSErrorCode ret) { result = ret; };
+        // will not update metapage
+        EXPECT_CALL(*lfs_,
+                    Write(3, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(0);
+        // will write data
+        EXPECT_CALL(*lfs_,
+                    Write(3, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset,
+                          length))
+            .Times(1);
+        dataStore->WriteChunkAsync(id, 2, data, offset, length, nullptr, cb);
+        dataStore->WaitAsyncWrites();
+        ASSERT_EQ(CSErrorCode::Success, result);
+    }
+    // case2
+    {
+        CSErrorCode result = CSErrorCode::InternalError;
+        auto cb = [&result](CSErrorCode ret) { result = ret; };
+        // will update sn
+        EXPECT_CALL(*lfs_,
+                    Write(3, Matcher<const char*>(NotNull()), 0, PAGE_SIZE))
+            .Times(1);
+        // will write data
+        EXPECT_CALL(*lfs_,
+                    Write(3, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset,
+                          length))
+            .Times(1);
+        dataStore->WriteChunkAsync(id, 3, data, offset, length, nullptr, cb);
+        dataStore->WaitAsyncWrites();
+        ASSERT_EQ(CSErrorCode::Success, result);
+        CSChunkInfo info;
+        dataStore->GetChunkInfo(id, &info);
+        ASSERT_EQ(3, info.curSn);
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * WriteChunkTest 异常测试
  * case:创建快照文件时出错
@@ -982,6 +982,56 @@ TEST_F(CSChunkfilePoolMockTest, RecycleFileTest) {
         ASSERT_EQ(0, pool.RecycleFile(targetPath));
         ASSERT_EQ(1, pool.Size());
     }
+
+    /****************unshareOnRecycle为true**************/
+    options.unshareOnRecycle = true;
+    // 解除共享失败，直接Delete，不放回池中
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        struct stat fileInfo;
+        fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+
+        EXPECT_CALL(*lfs_, Open(targetPath, _))
+            .WillOnce(Return(1));
+        EXPECT_CALL(*lfs_, Fstat(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(fileInfo),
+                            Return(0)));
+        EXPECT_CALL(*lfs_, Fallocate(1, FALLOC_FL_UNSHARE_RANGE, 0,
+                                     CHUNK_SIZE + PAGE_SIZE))
+            .WillOnce(Return(-ENOSPC));
+        EXPECT_CALL(*lfs_, Close(1))
+            .Times(1);
+        EXPECT_CALL(*lfs_, Delete(targetPath))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*lfs_, Rename(_, _, _))
+            .Times(0);
+        ASSERT_EQ(0, pool.RecycleFile(targetPath));
+        ASSERT_EQ(0, pool.Size());
+    }
+
+    // 解除共享成功，rename放回池中
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        struct stat fileInfo;
+        fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+
+        EXPECT_CALL(*lfs_, Open(targetPath, _))
+            .WillOnce(Return(1));
+        EXPECT_CALL(*lfs_, Fstat(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(fileInfo),
+                            Return(0)));
+        EXPECT_CALL(*lfs_, Fallocate(1, FALLOC_FL_UNSHARE_RANGE, 0,
+                                     CHUNK_SIZE + PAGE_SIZE))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*lfs_, Close(1))
+            .Times(1);
+        EXPECT_CALL(*lfs_, Rename(_, _, _))
+            .WillOnce(Return(0));
+        ASSERT_EQ(0, pool.RecycleFile(targetPath));
+        ASSERT_EQ(1, pool.Size());
+    }
 }
 
 }  // namespace chunkserver
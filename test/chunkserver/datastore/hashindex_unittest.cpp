@@ -0,0 +1,268 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-21
+ * Author: yangyaokai
+ */
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/chunkserver/datastore/chunkserver_hashindex.h"
+#include "src/fs/local_filesystem.h"
+
+using curve::fs::FileSystemType;
+using curve::fs::LocalFsFactory;
+
+namespace curve {
+namespace chunkserver {
+
+const char HASHINDEX_DIR[] = "./hashindextest";
+const PageSizeType kPageSize = 4096;
+const uint32_t kPageNum = 16;
+
+class ChunkHashIndexTest : public testing::Test {
+ protected:
+    void SetUp() {
+        lfs_ = LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+        if (lfs_->DirExists(HASHINDEX_DIR)) {
+            ASSERT_EQ(0, lfs_->Delete(HASHINDEX_DIR));
+        }
+        ASSERT_EQ(0, lfs_->Mkdir(HASHINDEX_DIR));
+        path_ = std::string(HASHINDEX_DIR) + "/chunk_1_hash";
+
+        memset(&chunkStat_, 0, sizeof(chunkStat_));
+        chunkStat_.st_ino = 100;
+        chunkStat_.st_size = kPageSize * (kPageNum + 1);
+        chunkStat_.st_mtim.tv_sec = 1000;
+        chunkStat_.st_ctim.tv_sec = 1000;
+    }
+
+    void TearDown() {
+        lfs_->Delete(HASHINDEX_DIR);
+    }
+
+    std::shared_ptr<ChunkHashIndex> NewIndex() {
+        return std::make_shared<ChunkHashIndex>(lfs_, path_,
+                                                kPageSize, kPageNum);
+    }
+
+    // digest of the data, the same as the scan without index
+    uint32_t DataDigest(const char* buf, size_t length) {
+        std::vector<uint32_t> crcs;
+        ChunkHashIndex::PageCrcs(buf, length, kPageSize, &crcs);
+        return ChunkHashIndex::Digest(crcs);
+    }
+
+ protected:
+    std::shared_ptr<LocalFileSystem> lfs_;
+    std::string path_;
+    struct stat chunkStat_;
+};
+
+TEST_F(ChunkHashIndexTest, UpdateTest) {
+    auto index = NewIndex();
+    ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+    uint32_t digest = 0;
+    // all pages are unknown for a new index
+    ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+
+    size_t length = 4 * kPageSize;
+    std::unique_ptr<char[]> buf(new char[length]);
+    for (size_t i = 0; i < length; ++i) {
+        buf[i] = i % 251;
+    }
+    index->MarkDirty();
+    index->Update(buf.get(), kPageSize, length);
+    ASSERT_TRUE(index->GetDigest(kPageSize, length, &digest));
+    ASSERT_EQ(DataDigest(buf.get(), length), digest);
+    ASSERT_TRUE(index->GetDigest(2 * kPageSize, kPageSize, &digest));
+    ASSERT_EQ(DataDigest(buf.get() + kPageSize, kPageSize), digest);
+    // range containing unknown pages
+    ASSERT_FALSE(index->GetDigest(0, 2 * kPageSize, &digest));
+
+    // pages of the iobuf span its blocks
+    butil::IOBuf iobuf;
+    iobuf.append(buf.get(), 100);
+    iobuf.append(buf.get() + 100, kPageSize);
+    iobuf.append(buf.get() + 100 + kPageSize, length - 100 - kPageSize);
+    std::vector<uint32_t> crcs;
+    std::vector<uint32_t> expected;
+    ChunkHashIndex::PageCrcs(iobuf, length, kPageSize, &crcs);
+    ChunkHashIndex::PageCrcs(buf.get(), length, kPageSize, &expected);
+    ASSERT_EQ(expected, crcs);
+
+    index->Update(iobuf, 8 * kPageSize, length);
+    ASSERT_TRUE(index->GetDigest(8 * kPageSize, length, &digest));
+    ASSERT_EQ(DataDigest(buf.get(), length), digest);
+
+    // out of range
+    ASSERT_FALSE(index->GetDigest(kPageNum * kPageSize, kPageSize, &digest));
+}
+
+TEST_F(ChunkHashIndexTest, PersistTest) {
+    size_t length = kPageNum * kPageSize;
+    std::unique_ptr<char[]> buf(new char[length]);
+    memset(buf.get(), 'a', length);
+    uint32_t digest = 0;
+
+    // closed clean, the index is trusted for the same chunk file
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        index->MarkDirty();
+        index->Update(buf.get(), 0, length / 2);
+        index->Close(chunkStat_);
+    }
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        // the known pages are persisted too
+        ASSERT_TRUE(index->GetDigest(0, length / 2, &digest));
+        ASSERT_EQ(DataDigest(buf.get(), length / 2), digest);
+        ASSERT_FALSE(index->GetDigest(0, length, &digest));
+        index->MarkDirty();
+        index->Update(buf.get(), length / 2, length / 2);
+        index->Close(chunkStat_);
+    }
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        ASSERT_TRUE(index->GetDigest(0, length, &digest));
+        ASSERT_EQ(DataDigest(buf.get(), length), digest);
+        index->Close(chunkStat_);
+    }
+
+    // the chunk file is changed after the index is closed
+    struct stat changed = chunkStat_;
+    changed.st_mtim.tv_nsec = 1;
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(changed));
+        ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+        index->Close(changed);
+    }
+    // the chunk file is replaced by another one
+    changed = chunkStat_;
+    changed.st_ino = 101;
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(changed));
+        ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+    }
+}
+
+TEST_F(ChunkHashIndexTest, CrashTest) {
+    size_t length = kPageNum * kPageSize;
+    std::unique_ptr<char[]> buf(new char[length]);
+    memset(buf.get(), 'a', length);
+    uint32_t digest = 0;
+
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        index->MarkDirty();
+        index->Update(buf.get(), 0, length);
+        index->Close(chunkStat_);
+    }
+    // crash after the index is marked dirty, the chunk file is not
+    // changed yet, but the index must not be trusted
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        ASSERT_TRUE(index->GetDigest(0, length, &digest));
+        index->MarkDirty();
+    }
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+    }
+
+    // corrupted header
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        index->Update(buf.get(), 0, length);
+        index->Close(chunkStat_);
+        int fd = lfs_->Open(path_, O_RDWR);
+        ASSERT_GE(fd, 0);
+        char garbage[8];
+        memset(garbage, 0xff, sizeof(garbage));
+        ASSERT_EQ(8, lfs_->Write(fd, garbage, 16, sizeof(garbage)));
+        lfs_->Close(fd);
+    }
+    {
+        auto index = NewIndex();
+        ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+        ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+    }
+}
+
+TEST_F(ChunkHashIndexTest, VerifyTest) {
+    size_t length = 4 * kPageSize;
+    std::unique_ptr<char[]> buf(new char[length]);
+    memset(buf.get(), 'a', length);
+    uint32_t digest = 0;
+
+    auto index = NewIndex();
+    ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+    index->MarkDirty();
+    index->Update(buf.get(), 0, 2 * kPageSize);
+
+    // the data of page 1 is changed behind the index, page 2 and 3 are
+    // unknown and not counted as mismatch
+    memset(buf.get() + kPageSize, 'b', kPageSize);
+    std::vector<uint32_t> crcs;
+    ChunkHashIndex::PageCrcs(buf.get(), length, kPageSize, &crcs);
+    ASSERT_EQ(1, index->Verify(0, crcs));
+
+    // the index is rebuilt from the data
+    ASSERT_TRUE(index->GetDigest(0, length, &digest));
+    ASSERT_EQ(DataDigest(buf.get(), length), digest);
+    ASSERT_EQ(0, index->Verify(0, crcs));
+}
+
+TEST_F(ChunkHashIndexTest, DeleteTest) {
+    auto index = NewIndex();
+    ASSERT_EQ(CSErrorCode::Success, index->Open(chunkStat_));
+    ASSERT_TRUE(lfs_->FileExists(path_));
+    ASSERT_EQ(CSErrorCode::Success, index->Delete());
+    ASSERT_FALSE(lfs_->FileExists(path_));
+
+    // nothing is written after delete
+    std::unique_ptr<char[]> buf(new char[kPageSize]);
+    memset(buf.get(), 'a', kPageSize);
+    index->MarkDirty();
+    index->Update(buf.get(), 0, kPageSize);
+    uint32_t digest = 0;
+    ASSERT_FALSE(index->GetDigest(0, kPageSize, &digest));
+    index->Close(chunkStat_);
+    ASSERT_FALSE(lfs_->FileExists(path_));
+    // delete again
+    ASSERT_EQ(CSErrorCode::Success, index->Delete());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-18
+ * Author: yangyaokai
+ */
+
+// Microbenchmark of CSMetaCache::Get, compares the sharded metacache with
+// a single map guarded by one read-write lock (the previous implementation)
+// at 1 to max_threads threads, reports Get/s.
+//
+// usage: metacache_bench -chunk_num=100000 -max_threads=64 -seconds=2
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <butil/time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/chunkserver/datastore/chunkserver_metacache.h"
+#include "src/common/concurrent/rw_lock.h"
+#include "src/fs/local_filesystem.h"
+
+DEFINE_uint64(chunk_num, 100000, "number of chunks in the metacache");
+DEFINE_uint32(max_threads, 64, "max number of reader threads");
+DEFINE_uint32(seconds, 2, "running time of each round");
+DEFINE_uint32(write_per_second, 0,
+              "chunks created and deleted per second while reading");
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::RWLock;
+using curve::common::ReadLockGuard;
+using curve::common::WriteLockGuard;
+
+// the previous CSMetaCache, one map guarded by a read-write lock
+class RWLockMetaCache {
+ public:
+    CSChunkFilePtr Get(ChunkID id) {
+        ReadLockGuard readGuard(rwLock_);
+        auto iter = chunkMap_.find(id);
+        if (iter == chunkMap_.end()) {
+            return nullptr;
+        }
+        return iter->second;
+    }
+
+    CSChunkFilePtr Set(ChunkID id, CSChunkFilePtr chunkFile) {
+        WriteLockGuard writeGuard(rwLock_);
+        return chunkMap_.emplace(id, chunkFile).first->second;
+    }
+
+    void Remove(ChunkID id) {
+        WriteLockGuard writeGuard(rwLock_);
+        chunkMap_.erase(id);
+    }
+
+ private:
+    RWLock      rwLock_;
+    ChunkMap    chunkMap_;
+};
+
+template <typename Cache>
+double RunBench(Cache* cache, uint32_t threadNum,
+                const std::vector<CSChunkFilePtr>& extra) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> total(0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadNum; ++i) {
+        threads.emplace_back([cache, i, &stop, &total]() {
+            uint64_t count = 0;
+            ChunkID id = i * 7919;
+            while (!stop.load(std::memory_order_relaxed)) {
+                CHECK(cache->Get(id % FLAGS_chunk_num) != nullptr);
+                id += 13;
+                ++count;
+            }
+            total.fetch_add(count);
+        });
+    }
+
+    butil::Timer timer;
+    timer.start();
+    uint64_t deadline = butil::gettimeofday_us() + FLAGS_seconds * 1000000L;
+    size_t next = 0;
+    while (butil::gettimeofday_us() < deadline) {
+        if (FLAGS_write_per_second == 0 || extra.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        // create and delete chunks not read by the readers
+        const CSChunkFilePtr& chunk = extra[next++ % extra.size()];
+        ChunkID id = FLAGS_chunk_num + next % extra.size();
+        cache->Set(id, chunk);
+        cache->Remove(id);
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(1000000 / FLAGS_write_per_second));
+    }
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    timer.stop();
+    return total.load() * 1000000.0 / std::max<int64_t>(timer.u_elapsed(), 1);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
+
+int main(int argc, char* argv[]) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    using curve::chunkserver::ChunkOptions;
+    using curve::chunkserver::CSChunkFile;
+    using curve::chunkserver::CSChunkFilePtr;
+    using curve::chunkserver::CSMetaCache;
+    using curve::chunkserver::RWLockMetaCache;
+
+    auto lfs = curve::fs::LocalFsFactory::CreateFs(
+        curve::fs::FileSystemType::EXT4, "");
+    CSMetaCache sharded;
+    RWLockMetaCache locked;
+    std::vector<CSChunkFilePtr> extra;
+    for (uint64_t i = 0; i < FLAGS_chunk_num + 128; ++i) {
+        ChunkOptions options;
+        options.id = i;
+        options.baseDir = "./";
+        CSChunkFilePtr chunk =
+            std::make_shared<CSChunkFile>(lfs, nullptr, options);
+        if (i < FLAGS_chunk_num) {
+            sharded.Set(i, chunk);
+            locked.Set(i, chunk);
+        } else {
+            extra.push_back(chunk);
+        }
+    }
+
+    printf("chunk_num: %lu, write_per_second: %u\n",
+           FLAGS_chunk_num, FLAGS_write_per_second);
+    printf("%-10s %20s %20s\n", "threads", "rwlock get/s", "sharded get/s");
+    for (uint32_t n = 1; n <= FLAGS_max_threads; n *= 2) {
+        double lockedQps = curve::chunkserver::RunBench(&locked, n, extra);
+        double shardedQps = curve::chunkserver::RunBench(&sharded, n, extra);
+        printf("%-10u %20.0f %20.0f\n", n, lockedQps, shardedQps);
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-18
+ * Author: yangyaokai
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/chunkserver/datastore/chunkserver_metacache.h"
+#include "test/fs/mock_local_filesystem.h"
+
+using curve::fs::MockLocalFileSystem;
+
+namespace curve {
+namespace chunkserver {
+
+class CSMetaCacheTest : public testing::Test {
+ protected:
+    void SetUp() {
+        lfs_ = std::make_shared<MockLocalFileSystem>();
+    }
+
+    CSChunkFilePtr NewChunkFile(ChunkID id) {
+        ChunkOptions options;
+        options.id = id;
+        options.baseDir = "/data";
+        options.chunkSize = 16 * 1024 * 1024;
+        options.pageSize = 4096;
+        return std::make_shared<CSChunkFile>(lfs_, nullptr, options);
+    }
+
+ protected:
+    std::shared_ptr<MockLocalFileSystem> lfs_;
+};
+
+TEST_F(CSMetaCacheTest, BasicTest) {
+    CSMetaCache cache;
+    ASSERT_EQ(nullptr, cache.Get(1));
+
+    CSChunkFilePtr chunk1 = NewChunkFile(1);
+    ASSERT_EQ(chunk1, cache.Set(1, chunk1));
+    ASSERT_EQ(chunk1, cache.Get(1));
+
+    // the first set chunk file is kept
+    CSChunkFilePtr other = NewChunkFile(1);
+    ASSERT_EQ(chunk1, cache.Set(1, other));
+    ASSERT_EQ(chunk1, cache.Get(1));
+
+    // ids in the same shard
+    ChunkID id2 = 1 + CSMetaCache::kShardNum;
+    CSChunkFilePtr chunk2 = NewChunkFile(id2);
+    ASSERT_EQ(chunk2, cache.Set(id2, chunk2));
+    ASSERT_EQ(chunk1, cache.Get(1));
+    ASSERT_EQ(chunk2, cache.Get(id2));
+
+    cache.Remove(1);
+    ASSERT_EQ(nullptr, cache.Get(1));
+    ASSERT_EQ(chunk2, cache.Get(id2));
+    // remove not exist chunk
+    cache.Remove(1);
+
+    cache.Clear();
+    ASSERT_EQ(nullptr, cache.Get(id2));
+}
+
+TEST_F(CSMetaCacheTest, SnapshotTest) {
+    CSMetaCache cache;
+    ASSERT_TRUE(cache.GetSnapshot().empty());
+
+    const int kChunkNum = 3 * CSMetaCache::kShardNum + 7;
+    for (int i = 0; i < kChunkNum; ++i) {
+        cache.Set(i, NewChunkFile(i));
+    }
+
+    ChunkMapSnapshot snapshot = cache.GetSnapshot();
+    ASSERT_FALSE(snapshot.empty());
+    ASSERT_EQ(kChunkNum, snapshot.size());
+
+    // modifications after the snapshot is taken are not visible
+    cache.Remove(0);
+    cache.Set(kChunkNum, NewChunkFile(kChunkNum));
+    cache.Clear();
+
+    std::set<ChunkID> ids;
+    for (auto iter = snapshot.begin(); iter != snapshot.end(); iter++) {
+        ASSERT_NE(nullptr, iter->second);
+        ASSERT_TRUE(ids.insert(iter->first).second);
+    }
+    ASSERT_EQ(kChunkNum, ids.size());
+    ASSERT_EQ(0, *ids.begin());
+    ASSERT_EQ(kChunkNum - 1, *ids.rbegin());
+
+    // wrap a plain map
+    ChunkMap map;
+    map.emplace(1, NewChunkFile(1));
+    ChunkMapSnapshot wrapped = map;
+    ASSERT_EQ(1, wrapped.size());
+    ASSERT_EQ(1, wrapped.begin()->first);
+    ASSERT_TRUE(ChunkMapSnapshot().empty());
+}
+
+TEST_F(CSMetaCacheTest, ConcurrentTest) {
+    CSMetaCache cache;
+    const ChunkID kStableNum = 1024;
+    for (ChunkID id = 0; id < kStableNum; ++id) {
+        cache.Set(id, NewChunkFile(id));
+    }
+
+    // readers always find the stable chunks while writers create and
+    // delete other chunks in the same shards
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> missed(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&cache, &stop, &missed, kStableNum]() {
+            ChunkID id = 0;
+            while (!stop.load()) {
+                if (cache.Get(id % kStableNum) == nullptr) {
+                    missed.fetch_add(1);
+                }
+                ++id;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 2; ++i) {
+        writers.emplace_back([this, &cache, i, kStableNum]() {
+            for (int round = 0; round < 2000; ++round) {
+                ChunkID id = kStableNum + i * 2000 + round;
+                cache.Set(id, NewChunkFile(id));
+                if (round % 2 == 0) {
+                    cache.Remove(id);
+                }
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    stop.store(true);
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    ASSERT_EQ(0, missed.load());
+    ASSERT_EQ(kStableNum + 2000, cache.GetSnapshot().size());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
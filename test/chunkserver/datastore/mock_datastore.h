@@ -66,8 +66,13 @@ class MockDataStore : public CSDataStore {
                                          off_t,
                                          size_t));
     MOCK_METHOD2(GetChunkInfo, CSErrorCode(ChunkID, CSChunkInfo*));
+    MOCK_METHOD5(GetChunkDigest, CSErrorCode(ChunkID,
+                                             off_t,
+                                             size_t,
+                                             bool,
+                                             uint32_t*));
     MOCK_METHOD0(GetStatus, DataStoreStatus());
-    MOCK_METHOD0(GetChunkMap, ChunkMap());
+    MOCK_METHOD0(GetChunkMap, ChunkMapSnapshot());
 };
 
 }  // namespace chunkserver
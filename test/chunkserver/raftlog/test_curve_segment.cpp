@@ -27,9 +27,13 @@
 // Date: 2015/10/08 17:00:05
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <gtest/gtest.h>
 #include <braft/log.h>
+#include <bvar/bvar.h>
 #include <memory>
+#include <string>
+#include <vector>
 #include "src/chunkserver/raftlog/curve_segment.h"
 #include "src/chunkserver/raftlog/define.h"
 #include "test/fs/mock_local_filesystem.h"
@@ -234,5 +238,158 @@ TEST_F(CurveSegmentTest, closed_segment) {
     delete configuration_manager;
 }
 
+TEST_F(CurveSegmentTest, append_batch) {
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+
+    std::vector<braft::LogEntry*> entries;
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->AddRef();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = i + 1;
+        char data_buf[128];
+        snprintf(data_buf, sizeof(data_buf), "hello, world: %d", i + 1);
+        entry->data.append(data_buf);
+        entries.push_back(entry);
+    }
+    // empty batch
+    ASSERT_EQ(EINVAL, seg1->append_batch(&entries[0], 0));
+    // 10 small entries are padded to one page together
+    ASSERT_EQ(0, seg1->append_batch(&entries[0], 10));
+    ASSERT_EQ(10, seg1->last_index());
+    ASSERT_EQ(kPageSize * 2, seg1->bytes());
+    read_entries_curve_segment(seg1);
+
+    // load the batch back
+    braft::ConfigurationManager configuration_manager;
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    ASSERT_EQ(0, seg2->load(&configuration_manager));
+    ASSERT_EQ(10, seg2->last_index());
+    read_entries_curve_segment(seg2);
+
+    // truncate in the middle of the batch and append another batch
+    ASSERT_EQ(0, seg1->truncate(5));
+    for (int i = 5; i < 10; i++) {
+        entries[i]->data.clear();
+        char data_buf[128];
+        snprintf(data_buf, sizeof(data_buf), "HELLO, WORLD: %d", i + 1);
+        entries[i]->data.append(data_buf);
+    }
+    ASSERT_EQ(0, seg1->append_batch(&entries[5], 5));
+    read_entries_curve_segment(seg1, "hello, world: %d", 0, 5);
+    read_entries_curve_segment(seg1, "HELLO, WORLD: %d", 5, 10);
+    ASSERT_EQ(kPageSize * 2, seg1->bytes());
+    ASSERT_EQ(0, seg1->unlink());
+
+    for (auto entry : entries) {
+        entry->Release();
+    }
+}
+
+static uint64_t get_counter(const std::string& name) {
+    return std::stoull(bvar::Variable::describe_exposed(name));
+}
+
+static void free_aligned(void* ptr) {
+    free(ptr);
+}
+
+// append a block of size bytes aligned to kPageSize to data
+static void append_aligned(butil::IOBuf* data, size_t size, char c) {
+    void* buf = nullptr;
+    ASSERT_EQ(0, posix_memalign(&buf, kPageSize, size));
+    memset(buf, c, size);
+    data->append_user_data(buf, size, free_aligned);
+}
+
+TEST_F(CurveSegmentTest, zero_copy_append) {
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    FLAGS_walZeroCopyAppend = true;
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+
+    // entry1和entry4没有对齐的block，entry2有前缀和对齐的block，
+    // entry3只有对齐的block
+    std::vector<braft::LogEntry*> entries;
+    for (int i = 0; i < 4; i++) {
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->AddRef();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = i + 1;
+        entries.push_back(entry);
+    }
+    entries[0]->data.append("hello");
+    entries[1]->data.append("meta-2");
+    append_aligned(&entries[1]->data, 2 * kPageSize, 'a');
+    append_aligned(&entries[2]->data, kPageSize, 'b');
+    entries[3]->data.append("tail");
+    std::vector<std::string> expected;
+    for (auto entry : entries) {
+        expected.push_back(entry->data.to_string());
+    }
+
+    uint64_t zeroCopyEntries = get_counter("curve_wal_zero_copy_entries");
+    uint64_t zeroCopyBytes = get_counter("curve_wal_zero_copy_bytes");
+    ASSERT_EQ(0, seg1->append_batch(&entries[0], 4));
+    ASSERT_EQ(4, seg1->last_index());
+    ASSERT_EQ(zeroCopyEntries + 2,
+              get_counter("curve_wal_zero_copy_entries"));
+    ASSERT_EQ(zeroCopyBytes + 3 * kPageSize,
+              get_counter("curve_wal_zero_copy_bytes"));
+    // 对齐的block落在对齐的偏移上: 页0为meta page，页1为entry1和entry2的前缀，
+    // 页2-3为entry2的block，页4为entry3的header，页5为entry3的block，
+    // 页6为entry4
+    ASSERT_EQ(kPageSize * 7, seg1->bytes());
+    for (int i = 0; i < 4; i++) {
+        braft::LogEntry* entry = seg1->get(i + 1);
+        ASSERT_NE(nullptr, entry);
+        ASSERT_EQ(expected[i], entry->data.to_string());
+        entry->Release();
+    }
+
+    // 重新加载segment，关闭开关后依然可以读取
+    FLAGS_walZeroCopyAppend = false;
+    braft::ConfigurationManager configuration_manager;
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    ASSERT_EQ(0, seg2->load(&configuration_manager));
+    ASSERT_EQ(4, seg2->last_index());
+    ASSERT_EQ(kPageSize * 7, seg2->bytes());
+    for (int i = 0; i < 4; i++) {
+        braft::LogEntry* entry = seg2->get(i + 1);
+        ASSERT_NE(nullptr, entry);
+        ASSERT_EQ(expected[i], entry->data.to_string());
+        entry->Release();
+    }
+    ASSERT_EQ(0, seg1->unlink());
+
+    for (auto entry : entries) {
+        entry->Release();
+    }
+}
+
 }  // namespace chunkserver
 }  // namespace curve
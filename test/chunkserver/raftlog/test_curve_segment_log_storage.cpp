@@ -56,6 +56,9 @@ class CurveSegmentLogStorageTest : public testing::Test {
         fp_option.fileSize = kSegmentSize;
     }
     void SetUp() {
+        // segment boundaries in the cases below assume every entry is
+        // padded alone, the batched layout is covered by batch_append
+        FLAGS_walBatchMaxBytes = 0;
         lfs = std::make_shared<MockLocalFileSystem>();
         file_pool = std::make_shared<MockFilePool>(lfs);
         std::string cmd = std::string("mkdir ") + kRaftLogDataDir;
@@ -73,6 +76,7 @@ class CurveSegmentLogStorageTest : public testing::Test {
             .WillRepeatedly(Invoke(recycleFile));
     }
     void TearDown() {
+        FLAGS_walBatchMaxBytes = 1048576;
         std::string cmd = std::string("rm -rf ") + kRaftLogDataDir;
         ::system(cmd.c_str());
     }
@@ -434,6 +438,151 @@ TEST_F(CurveSegmentLogStorageTest, compatibility) {
     delete configuration_manager;
 }
 
+TEST_F(CurveSegmentLogStorageTest, batch_append) {
+    FLAGS_walBatchMaxBytes = 1048576;
+    auto storage = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
+            true, file_pool);
+    ASSERT_EQ(0, storage->init(new braft::ConfigurationManager()));
+
+    // every entry takes 1028 bytes, 8 entries of one batch are padded to
+    // 3 pages together, the last 2 pages of a segment are filled by a
+    // shorter batch, so the first segment holds 682 * 8 + 7 entries
+    const int kEntryDataSize = 1000;
+    const int64_t kSegmentEntries = 682 * 8 + 7;
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0,  prepare_segment(path));
+    path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN,
+                          kSegmentEntries + 1);
+    ASSERT_EQ(0,  prepare_segment(path));
+    for (int i = 0; i < 1000; i++) {
+        std::vector<braft::LogEntry*> entries;
+        for (int j = 0; j < 8; j++) {
+            braft::LogEntry* entry = new braft::LogEntry();
+            entry->type = braft::ENTRY_TYPE_DATA;
+            entry->id.term = 1;
+            entry->id.index = 8 * i + j + 1;
+            entry->data.append(std::string(kEntryDataSize,
+                                           'a' + entry->id.index % 26));
+            entries.push_back(entry);
+        }
+        ASSERT_EQ(8, storage->append_entries(entries));
+    }
+    ASSERT_EQ(8000, storage->last_log_index());
+    ASSERT_EQ(countWalSegmentFile(), storage->GetStatus().walSegmentFileCount);
+    {
+        auto& segments = storage->segments();
+        ASSERT_EQ(1, segments.size());
+        auto seg = segments.begin()->second;
+        ASSERT_EQ(kSegmentEntries, seg->last_index());
+        // no space is wasted at the end of the closed segment
+        ASSERT_EQ(kSegmentSize + kPageSize, seg->bytes());
+    }
+
+    auto check_entries = [&](std::shared_ptr<CurveSegmentLogStorage> s) {
+        for (int64_t index = 1; index <= 8000; index++) {
+            braft::LogEntry* entry = s->get_entry(index);
+            ASSERT_TRUE(entry != nullptr);
+            ASSERT_EQ(1, entry->id.term);
+            ASSERT_EQ(index, entry->id.index);
+            ASSERT_EQ(std::string(kEntryDataSize, 'a' + index % 26),
+                      entry->data.to_string());
+            entry->Release();
+        }
+    };
+    check_entries(storage);
+
+    // reload from the batched log data
+    auto storage2 = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
+            true, file_pool);
+    ASSERT_EQ(0, storage2->init(new braft::ConfigurationManager()));
+    ASSERT_EQ(1, storage2->first_log_index());
+    ASSERT_EQ(8000, storage2->last_log_index());
+    check_entries(storage2);
+
+    // truncate inside a batch and append again
+    ASSERT_EQ(0, storage2->truncate_suffix(7996));
+    ASSERT_EQ(7996, storage2->last_log_index());
+    std::vector<braft::LogEntry*> entries;
+    for (int64_t index = 7997; index <= 8000; index++) {
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = index;
+        entry->data.append(std::string(kEntryDataSize, 'a' + index % 26));
+        entries.push_back(entry);
+    }
+    ASSERT_EQ(4, storage2->append_entries(entries));
+    check_entries(storage2);
+}
+
+TEST_F(CurveSegmentLogStorageTest, append_after_unaligned_truncate) {
+    FLAGS_walBatchMaxBytes = 1048576;
+    auto storage = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
+            true, file_pool);
+    ASSERT_EQ(0, storage->init(new braft::ConfigurationManager()));
+
+    // 682 batches of 8 entries take 2046 pages, 2 pages are left
+    const int kEntryDataSize = 1000;
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0,  prepare_segment(path));
+    for (int i = 0; i < 682; i++) {
+        std::vector<braft::LogEntry*> entries;
+        for (int j = 0; j < 8; j++) {
+            braft::LogEntry* entry = new braft::LogEntry();
+            entry->type = braft::ENTRY_TYPE_DATA;
+            entry->id.term = 1;
+            entry->id.index = 8 * i + j + 1;
+            entry->data.append(std::string(kEntryDataSize, 'a'));
+            entries.push_back(entry);
+        }
+        ASSERT_EQ(8, storage->append_entries(entries));
+    }
+
+    // keep 3 entries of the last batch, the segment ends in the middle of
+    // a page and 5 pages minus 3 entries are left
+    ASSERT_EQ(0, storage->truncate_suffix(681 * 8 + 3));
+    const uint64_t left = 5 * kPageSize - 3 * (kEntryDataSize
+                                               + kEntryHeaderSize);
+    // the entry fits exactly once padded from the current offset, it is
+    // appended to the open segment instead of opening a new one
+    braft::LogEntry* entry = new braft::LogEntry();
+    entry->type = braft::ENTRY_TYPE_DATA;
+    entry->id.term = 1;
+    entry->id.index = 681 * 8 + 4;
+    entry->data.append(std::string(left - kEntryHeaderSize, 'b'));
+    std::vector<braft::LogEntry*> entries{entry};
+    ASSERT_EQ(1, storage->append_entries(entries));
+    ASSERT_EQ(0, storage->segments().size());
+
+    // the segment is full, the next entry opens a new segment
+    path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN,
+                          681 * 8 + 5);
+    ASSERT_EQ(0,  prepare_segment(path));
+    entry = new braft::LogEntry();
+    entry->type = braft::ENTRY_TYPE_DATA;
+    entry->id.term = 1;
+    entry->id.index = 681 * 8 + 5;
+    entry->data.append(std::string(kEntryDataSize, 'c'));
+    entries = {entry};
+    ASSERT_EQ(1, storage->append_entries(entries));
+    {
+        auto& segments = storage->segments();
+        ASSERT_EQ(1, segments.size());
+        auto seg = segments.begin()->second;
+        ASSERT_EQ(681 * 8 + 4, seg->last_index());
+        ASSERT_EQ(kSegmentSize + kPageSize, seg->bytes());
+    }
+    braft::LogEntry* read = storage->get_entry(681 * 8 + 4);
+    ASSERT_TRUE(read != nullptr);
+    ASSERT_EQ(std::string(left - kEntryHeaderSize, 'b'),
+              read->data.to_string());
+    read->Release();
+}
+
 TEST_F(CurveSegmentLogStorageTest, basic_test_without_direct) {
     FLAGS_enableWalDirectWrite = false;
     auto storage = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Jan  4 15:31:08 CST 2021
+ * Author: wuhanqing
+ */
+
+#include "src/client/hedged_read.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace curve {
+namespace client {
+
+TEST(ChunkServerLatencyTrackerTest, PercentileTest) {
+    ChunkServerLatencyTracker tracker(90, 10);
+
+    // unknown chunkserver
+    ASSERT_EQ(0, tracker.GetLatency(1));
+
+    // not enough samples
+    for (uint64_t i = 1; i < 10; ++i) {
+        tracker.Record(1, i * 100);
+    }
+    ASSERT_EQ(0, tracker.GetLatency(1));
+
+    // samples are 100, 200, ..., 1000
+    tracker.Record(1, 1000);
+    ASSERT_EQ(900, tracker.GetLatency(1));
+
+    // other chunkservers are not affected
+    ASSERT_EQ(0, tracker.GetLatency(2));
+}
+
+TEST(ChunkServerLatencyTrackerTest, RecentSamplesTest) {
+    ChunkServerLatencyTracker tracker(50, 16);
+
+    for (uint32_t i = 0; i < ChunkServerLatencyTracker::kMaxSamples; ++i) {
+        tracker.Record(1, 100);
+    }
+    ASSERT_EQ(100, tracker.GetLatency(1));
+
+    // chunkserver becomes slow, old samples are replaced
+    for (uint32_t i = 0; i < ChunkServerLatencyTracker::kMaxSamples; ++i) {
+        tracker.Record(1, 10000);
+    }
+    ASSERT_EQ(10000, tracker.GetLatency(1));
+}
+
+TEST(ChunkServerLatencyTrackerTest, ConcurrentTest) {
+    ChunkServerLatencyTracker tracker(99, 64);
+
+    std::vector<std::thread> threads;
+    for (ChunkServerID id = 1; id <= 8; ++id) {
+        threads.emplace_back([&tracker, id]() {
+            for (int i = 0; i < 10000; ++i) {
+                tracker.Record(id % 4 + 1, id * 100);
+                tracker.GetLatency(id % 4 + 1);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (ChunkServerID id = 1; id <= 4; ++id) {
+        ASSERT_NE(0, tracker.GetLatency(id));
+    }
+}
+
+TEST(HedgedReadContextTest, ClaimTest) {
+    auto tracker = std::make_shared<ChunkServerLatencyTracker>(95, 64);
+    HedgedReadContext ctx(nullptr, nullptr, tracker);
+
+    ASSERT_FALSE(ctx.IsClaimed());
+    ASSERT_TRUE(ctx.Claim());
+    ASSERT_TRUE(ctx.IsClaimed());
+    ASSERT_FALSE(ctx.Claim());
+}
+
+}  // namespace client
+}  // namespace curve
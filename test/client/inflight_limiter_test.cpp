@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Tue Jan  5 14:40:52 CST 2021
+ * Author: wuhanqing
+ */
+
+#include "src/client/inflight_limiter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+namespace curve {
+namespace client {
+
+class AdaptiveInflightLimiterTest : public ::testing::Test {
+ public:
+    void SetUp() override {
+        option.enable = true;
+        option.initWindow = 4;
+        option.minWindow = 2;
+        option.maxWindow = 8;
+        option.latencyTolerancePercent = 300;
+        option.latencyDecreasePercent = 10;
+        option.overloadDecreasePercent = 50;
+        option.minRttPeriodS = 10;
+    }
+
+    // send a full window of rpcs, and all of them return with latency
+    void RunWindow(AdaptiveInflightLimiter* limiter, uint64_t latencyUs,
+                   bool congested) {
+        uint32_t count = 0;
+        while (limiter->TryAcquire()) {
+            ++count;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            limiter->OnResponse(latencyUs, congested);
+        }
+    }
+
+ protected:
+    InflightLimiterOption option;
+};
+
+TEST_F(AdaptiveInflightLimiterTest, AdditiveIncreaseTest) {
+    AdaptiveInflightLimiter limiter("AdditiveIncreaseTest", option);
+    ASSERT_EQ(4, limiter.Window());
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(limiter.TryAcquire());
+    }
+    ASSERT_FALSE(limiter.TryAcquire());
+    ASSERT_EQ(4, limiter.Inflight());
+
+    // a full window of responses grows the window by about one
+    for (uint32_t i = 0; i < 4; ++i) {
+        limiter.OnResponse(100, false);
+    }
+    ASSERT_EQ(0, limiter.Inflight());
+    RunWindow(&limiter, 100, false);
+    ASSERT_EQ(5, limiter.Window());
+
+    // never beyond max window
+    for (int i = 0; i < 100; ++i) {
+        RunWindow(&limiter, 100, false);
+    }
+    ASSERT_EQ(8, limiter.Window());
+}
+
+TEST_F(AdaptiveInflightLimiterTest, IdleNotIncreaseTest) {
+    AdaptiveInflightLimiter limiter("IdleNotIncreaseTest", option);
+
+    // only one rpc inflight at a time, the window is not used
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(limiter.TryAcquire());
+        limiter.OnResponse(100, false);
+    }
+    ASSERT_EQ(4, limiter.Window());
+}
+
+TEST_F(AdaptiveInflightLimiterTest, LatencyDecreaseTest) {
+    option.initWindow = 8;
+    AdaptiveInflightLimiter limiter("LatencyDecreaseTest", option);
+
+    // baseline rtt is 100us
+    RunWindow(&limiter, 100, false);
+    ASSERT_EQ(8, limiter.Window());
+
+    // rtt within tolerance
+    RunWindow(&limiter, 300, false);
+    ASSERT_EQ(8, limiter.Window());
+
+    // rtt rises, the window shrinks once for the whole window of responses
+    RunWindow(&limiter, 1000 * 1000, false);
+    ASSERT_EQ(7, limiter.Window());
+}
+
+TEST_F(AdaptiveInflightLimiterTest, OverloadDecreaseTest) {
+    option.initWindow = 8;
+    AdaptiveInflightLimiter limiter("OverloadDecreaseTest", option);
+
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.OnResponse(1000 * 1000, true);
+    ASSERT_EQ(4, limiter.Window());
+
+    // responses of rpcs sent before the decrease don't shrink it again
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.OnResponse(1000 * 1000, true);
+    ASSERT_EQ(4, limiter.Window());
+
+    // never below min window
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(limiter.TryAcquire());
+        limiter.OnResponse(0, true);
+    }
+    ASSERT_EQ(2, limiter.Window());
+}
+
+TEST_F(AdaptiveInflightLimiterTest, AcquireWaitTest) {
+    option.initWindow = 2;
+    AdaptiveInflightLimiter limiter("AcquireWaitTest", option);
+
+    limiter.Acquire();
+    limiter.Acquire();
+
+    std::atomic<bool> acquired(false);
+    std::thread t([&]() {
+        limiter.Acquire();
+        acquired = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(acquired);
+
+    limiter.Release();
+    t.join();
+    ASSERT_TRUE(acquired);
+    ASSERT_EQ(2, limiter.Inflight());
+}
+
+}  // namespace client
+}  // namespace curve
@@ -58,10 +58,15 @@ TEST(InflightRPCTest, TestMetric) {
     requestClosure.GetInflightRPCToken();
     ASSERT_EQ(1, fileMetric->inflightRPCNum.get_value());
 
-    requestClosure.GetInflightRPCToken();
-    ASSERT_EQ(2, fileMetric->inflightRPCNum.get_value());
+    requestClosure.ReleaseInflightRPCToken();
+    ASSERT_EQ(0, fileMetric->inflightRPCNum.get_value());
 
+    // 已经释放的token不会被重复释放
     requestClosure.ReleaseInflightRPCToken();
+    ASSERT_EQ(0, fileMetric->inflightRPCNum.get_value());
+
+    // 重新调度后再次获取token
+    requestClosure.GetInflightRPCToken();
     ASSERT_EQ(1, fileMetric->inflightRPCNum.get_value());
 
     requestClosure.ReleaseInflightRPCToken();
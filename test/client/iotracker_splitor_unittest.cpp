@@ -414,6 +414,103 @@ TEST_F(IOTrackerSplitorTest, AsyncStartWrite) {
     delete[] data;
 }
 
+TEST_F(IOTrackerSplitorTest, AsyncStartReadv) {
+    MockRequestScheduler* mockschuler = new MockRequestScheduler;
+    mockschuler->DelegateToFake();
+
+    curve::client::IOManager4File* iomana = fileinstance_->GetIOManager4File();
+    iomana->SetRequestScheduler(mockschuler);
+
+    CurveAioContext aioctx;
+    aioctx.offset = 4 * 1024 * 1024 - 4 * 1024;  // 4M - 4k
+    aioctx.length = 4 * 1024 * 1024 + 8 * 1024;  // 4M + 8K
+    aioctx.ret = LIBCURVE_ERROR::OK;
+    aioctx.cb = readcallback;
+    aioctx.buf = nullptr;
+    aioctx.op = LIBCURVE_OP::LIBCURVE_OP_READ;
+
+    // 读到不连续的三段buffer中
+    std::unique_ptr<char[]> head(new char[4 * 1024]);
+    std::unique_ptr<char[]> body(new char[chunk_size]);
+    std::unique_ptr<char[]> tail(new char[4 * 1024]);
+    struct iovec iov[3] = {{head.get(), 4 * 1024},
+                           {body.get(), chunk_size},
+                           {tail.get(), 4 * 1024}};
+
+    ioreadflag = false;
+    iomana->AioReadv(&aioctx, iov, 3, mdsclient_.get());
+
+    {
+        std::unique_lock<std::mutex> lk(readmtx);
+        readcv.wait(lk, []()->bool{return ioreadflag;});
+    }
+    ASSERT_EQ('a', head[0]);
+    ASSERT_EQ('a', head[4 * 1024 - 1]);
+    ASSERT_EQ('b', body[0]);
+    ASSERT_EQ('e', body[chunk_size - 1]);
+    ASSERT_EQ('f', tail[0]);
+    ASSERT_EQ('f', tail[4 * 1024 - 1]);
+}
+
+TEST_F(IOTrackerSplitorTest, AsyncStartWritev) {
+    MockRequestScheduler* mockschuler = new MockRequestScheduler;
+    mockschuler->DelegateToFake();
+
+    curve::client::IOManager4File* iomana = fileinstance_->GetIOManager4File();
+    iomana->SetRequestScheduler(mockschuler);
+
+    CurveAioContext aioctx;
+    aioctx.offset = 4 * 1024 * 1024 - 4 * 1024;
+    aioctx.length = 4 * 1024 * 1024 + 8 * 1024;
+    aioctx.ret = LIBCURVE_ERROR::OK;
+    aioctx.cb = writecallback;
+    aioctx.buf = nullptr;
+    aioctx.op = LIBCURVE_OP::LIBCURVE_OP_WRITE;
+
+    std::unique_ptr<char[]> head(new char[4 * 1024]);
+    std::unique_ptr<char[]> body(new char[chunk_size]);
+    std::unique_ptr<char[]> tail(new char[4 * 1024]);
+    memset(head.get(), 'a', 4 * 1024);
+    memset(body.get(), 'b', chunk_size);
+    memset(tail.get(), 'c', 4 * 1024);
+    struct iovec iov[3] = {{head.get(), 4 * 1024},
+                           {body.get(), chunk_size},
+                           {tail.get(), 4 * 1024}};
+
+    iowriteflag = false;
+    iomana->AioWritev(&aioctx, iov, 3, mdsclient_.get());
+
+    {
+        std::unique_lock<std::mutex> lk(writemtx);
+        writecv.wait(lk, []() -> bool { return iowriteflag; });
+    }
+
+    std::string written = writeData.to_string();
+    ASSERT_EQ(aioctx.length, written.size());
+    ASSERT_EQ('a', written[0]);
+    ASSERT_EQ('a', written[4 * 1024 - 1]);
+    ASSERT_EQ('b', written[4 * 1024]);
+    ASSERT_EQ('b', written[4 * 1024 + chunk_size - 1]);
+    ASSERT_EQ('c', written[4 * 1024 + chunk_size]);
+    ASSERT_EQ('c', written[aioctx.length - 1]);
+}
+
+TEST_F(IOTrackerSplitorTest, AioSubmitRejectIOVector) {
+    CurveAioContext aioctx;
+    aioctx.offset = 0;
+    aioctx.length = 4 * 1024;
+    aioctx.ret = LIBCURVE_ERROR::OK;
+    aioctx.cb = readcallback;
+    aioctx.buf = nullptr;
+    aioctx.op = LIBCURVE_OP::LIBCURVE_OP_READ;
+
+    // aioctx中无法传入iovec，批量提交不支持IOVector
+    CurveAioContext* aioctxs[] = {&aioctx};
+    FileClient fc;
+    ASSERT_EQ(-LIBCURVE_ERROR::PARAM_ERROR,
+              fc.AioSubmit(1, aioctxs, 1, UserDataType::IOVector));
+}
+
 TEST_F(IOTrackerSplitorTest, StartRead) {
     MockRequestScheduler* mockschuler = new MockRequestScheduler;
     mockschuler->DelegateToFake();
@@ -871,6 +968,71 @@ TEST_F(IOTrackerSplitorTest, largeIOTest) {
     delete[] buf;
 }
 
+TEST_F(IOTrackerSplitorTest, SegmentPrefetchTest) {
+    // mds返回从1G开始的3个segment
+    curve::mds::GetOrAllocateSegmentResponse* response =
+        new curve::mds::GetOrAllocateSegmentResponse();
+    response->set_statuscode(::curve::mds::StatusCode::kOK);
+    for (uint64_t seg = 1; seg <= 3; seg++) {
+        curve::mds::PageFileSegment* pfs =
+            seg == 1 ? response->mutable_pagefilesegment()
+                     : response->add_extrasegments();
+        pfs->set_logicalpoolid(1234);
+        pfs->set_segmentsize(1 * 1024 * 1024 * 1024);
+        pfs->set_chunksize(4 * 1024 * 1024);
+        pfs->set_startoffset(seg * 1024 * 1024 * 1024);
+        for (int i = 0; i < 256; i++) {
+            auto chunk = pfs->add_chunks();
+            chunk->set_copysetid(i);
+            chunk->set_chunkid(seg * 256 + i);
+        }
+    }
+    FakeReturn* fakeret = new FakeReturn(nullptr,
+                                         static_cast<void*>(response));
+    curvefsservice.SetGetOrAllocateSegmentFakeReturn(fakeret);
+
+    IOSplitOption splitOpt = fopt.ioOpt.ioSplitOpt;
+    splitOpt.segmentPrefetchNum = 4;
+    Splitor::Init(splitOpt);
+
+    FInfo_t fi;
+    fi.userinfo = userinfo;
+    fi.fullPathName = "/1_userinfo_.txt";
+    fi.seqnum = 0;
+    fi.chunksize = 4 * 1024 * 1024;
+    fi.segmentsize = 1 * 1024 * 1024 * 1024ul;
+    fi.length = 4 * 1024 * 1024 * 1024ul;
+
+    MockRequestScheduler mockschuler;
+    mockschuler.DelegateToFake();
+    curve::client::IOManager4File* iomana = fileinstance_->GetIOManager4File();
+    MetaCache* mc = fileinstance_->GetIOManager4File()->GetMetaCache();
+    IOTracker* iotracker = new IOTracker(iomana, mc, &mockschuler);
+    iotracker->SetOpType(OpType::WRITE);
+
+    // segment 0已经在metacache中，写segment 1时预分配之后的segment，
+    // segment数量按文件长度截断
+    butil::IOBuf writeData;
+    writeData.append(std::string(4096, 'a'));
+    std::vector<RequestContext*> reqlist;
+    ASSERT_EQ(0, curve::client::Splitor::IO2ChunkRequests(
+                     iotracker, mc, &reqlist, &writeData,
+                     1 * 1024 * 1024 * 1024ul, 4096, mdsclient_.get(), &fi));
+    ASSERT_EQ(1, reqlist.size());
+    ASSERT_EQ(256, reqlist[0]->idinfo_.cid_);
+
+    for (uint64_t seg = 1; seg <= 3; seg++) {
+        ChunkIDInfo chunkInfo;
+        ASSERT_EQ(MetaCacheErrorType::OK,
+                  mc->GetChunkInfoByIndex(seg * 256 + 255, &chunkInfo));
+        ASSERT_EQ(seg * 256 + 255, chunkInfo.cid_);
+        ASSERT_EQ(1234, chunkInfo.lpid_);
+    }
+
+    Splitor::Init(fopt.ioOpt.ioSplitOpt);
+    curvefsservice.SetGetOrAllocateSegmentFakeReturn(getsegmentfakeret);
+}
+
 TEST_F(IOTrackerSplitorTest, InvalidParam) {
     uint64_t length = 2 * 64 * 1024;
     uint64_t offset = 4 * 1024 * 1024 - length;
@@ -25,6 +25,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 #include <vector>
 
@@ -110,5 +113,83 @@ TEST_F(MetaCacheTest, TestCleanChunksInSegment) {
     }
 }
 
+TEST_F(MetaCacheTest, TestChunkInfoConcurrentUpdate) {
+    InsertMetaCache(4 * GiB, 1 * GiB, 16 * MiB);
+
+    // reader always sees a consistent chunk info while it is updated
+    std::atomic<bool> stop(false);
+    std::thread reader([this, &stop]() {
+        ChunkIDInfo info;
+        while (!stop.load()) {
+            ASSERT_EQ(MetaCacheErrorType::OK,
+                      metaCache_.GetChunkInfoByIndex(1, &info));
+            ASSERT_EQ(info.cid_, info.lpid_);
+            ASSERT_EQ(info.cid_, info.cpid_);
+        }
+    });
+
+    for (uint64_t i = 1; i < 100000; ++i) {
+        metaCache_.UpdateChunkInfoByIndex(1, ChunkIDInfo(i, i, i));
+    }
+    stop.store(true);
+    reader.join();
+
+    // chunk index beyond the file length
+    ChunkIDInfo info;
+    ASSERT_EQ(MetaCacheErrorType::CHUNKINFO_NOT_FOUND,
+              metaCache_.GetChunkInfoByIndex(10000, &info));
+    metaCache_.UpdateChunkInfoByIndex(10000, ChunkIDInfo(1, 2, 3));
+    ASSERT_EQ(MetaCacheErrorType::OK,
+              metaCache_.GetChunkInfoByIndex(10000, &info));
+    ASSERT_EQ(1, info.cid_);
+    ASSERT_EQ(2, info.lpid_);
+    ASSERT_EQ(3, info.cpid_);
+
+    // segments are created once
+    FileSegment* segment = metaCache_.GetFileSegment(100);
+    ASSERT_EQ(segment, metaCache_.GetFileSegment(100));
+    ASSERT_NE(segment, metaCache_.GetFileSegment(1));
+}
+
+TEST_F(MetaCacheTest, TestLeaderCache) {
+    const LogicPoolID lpid = 1;
+    const CopysetID cpid = 1;
+
+    CopysetInfo cpinfo;
+    cpinfo.cpid_ = cpid;
+    for (ChunkServerID id = 1; id <= 3; ++id) {
+        ChunkServerAddr addr;
+        addr.Parse("127.0.0.1:" + std::to_string(9000 + id) + ":0");
+        cpinfo.AddCopysetPeerInfo(CopysetPeerInfo(id, addr, addr));
+    }
+    cpinfo.UpdateLeaderIndex(0);
+    metaCache_.UpdateCopysetInfo(lpid, cpid, cpinfo);
+
+    ChunkServerID leaderId = 0;
+    butil::EndPoint leaderAddr;
+    ASSERT_EQ(0, metaCache_.GetLeader(lpid, cpid, &leaderId, &leaderAddr));
+    ASSERT_EQ(1, leaderId);
+    ASSERT_EQ(9001, leaderAddr.port);
+
+    // leader is redirected
+    butil::EndPoint newLeader;
+    butil::str2endpoint("127.0.0.1:9002", &newLeader);
+    ASSERT_EQ(0, metaCache_.UpdateLeader(lpid, cpid, newLeader));
+    ASSERT_EQ(0, metaCache_.GetLeader(lpid, cpid, &leaderId, &leaderAddr));
+    ASSERT_EQ(2, leaderId);
+    ASSERT_EQ(9002, leaderAddr.port);
+
+    // leader may change
+    metaCache_.AddCopysetIDInfo(2, CopysetIDInfo(lpid, cpid));
+    metaCache_.SetChunkserverUnstable(2);
+    ASSERT_TRUE(metaCache_.IsLeaderMayChange(lpid, cpid));
+
+    // copyset info is updated with an unknown leader
+    cpinfo.UpdateLeaderIndex(-1);
+    metaCache_.UpdateCopysetInfo(lpid, cpid, cpinfo);
+    ASSERT_FALSE(metaCache_.IsLeaderMayChange(lpid, cpid));
+    ASSERT_EQ(-1, metaCache_.GetLeader(lpid, cpid, &leaderId, &leaderAddr));
+}
+
 }  // namespace client
 }  // namespace curve
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Mon Dec 28 15:32:08 CST 2020
+ * Author: wuhanqing
+ */
+
+#include "src/client/read_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint32_t kBlockSize = 256 * 1024;
+const uint64_t kSn = 1;
+
+butil::IOBuf MakeData(char c, size_t length) {
+    butil::IOBuf data;
+    data.resize(length, c);
+    return data;
+}
+
+}  // namespace
+
+class ReadCacheTest : public ::testing::Test {
+ public:
+    void SetUp() override {
+        // 4 blocks in total, and 2 of them can be protected
+        ReadCacheOption option;
+        option.enable = true;
+        option.capacityMB = 1;
+        option.blockSize = kBlockSize;
+        option.protectedPercent = 50;
+
+        metric.reset(new ReadCacheMetric("ReadCacheTest"));
+        cache.reset(new ReadCache(option, metric.get()));
+    }
+
+    // read a missed block and fill it with c
+    void Fill(uint64_t index, char c) {
+        butil::IOBuf data;
+        uint64_t epoch = 0;
+        ASSERT_FALSE(cache->Read(kSn, index * kBlockSize, kBlockSize, &data,
+                                 &epoch));
+        cache->EndRead(epoch, index * kBlockSize, MakeData(c, kBlockSize));
+    }
+
+    bool Hit(uint64_t index, char c) {
+        butil::IOBuf data;
+        uint64_t epoch = 0;
+        if (!cache->Read(kSn, index * kBlockSize, kBlockSize, &data,
+                         &epoch)) {
+            return false;
+        }
+        return data.to_string() == std::string(kBlockSize, c);
+    }
+
+ protected:
+    std::unique_ptr<ReadCacheMetric> metric;
+    std::unique_ptr<ReadCache> cache;
+};
+
+TEST_F(ReadCacheTest, ReadTest) {
+    Fill(0, 'a');
+    ASSERT_TRUE(Hit(0, 'a'));
+    ASSERT_EQ(kBlockSize, cache->CachedBytes());
+
+    // read inside a cached block
+    butil::IOBuf data;
+    uint64_t epoch = 0;
+    ASSERT_TRUE(cache->Read(kSn, 100, 10, &data, &epoch));
+    ASSERT_EQ(std::string(10, 'a'), data.to_string());
+
+    // read across a missed block
+    ASSERT_FALSE(cache->Read(kSn, 100, kBlockSize, &data, &epoch));
+
+    // only whole blocks are cached
+    cache->EndRead(epoch, 100, MakeData('b', kBlockSize));
+    ASSERT_FALSE(Hit(1, 'b'));
+    cache->EndRead(epoch, kBlockSize - 100, MakeData('b', kBlockSize + 100));
+    ASSERT_TRUE(Hit(1, 'b'));
+    ASSERT_TRUE(Hit(0, 'a'));
+
+    // sequence number changed after snapshot
+    ASSERT_FALSE(cache->Read(kSn + 1, 0, kBlockSize, &data, &epoch));
+    ASSERT_EQ(0, cache->CachedBytes());
+    ASSERT_EQ(0, metric->bytes.get_value());
+}
+
+TEST_F(ReadCacheTest, WriteTest) {
+    Fill(0, 'a');
+
+    // partial write only invalidates the block
+    uint64_t epoch = cache->BeginWrite(kSn, 10, 10);
+    ASSERT_FALSE(Hit(0, 'a'));
+    cache->EndWrite(epoch, 10, 10, nullptr);
+    ASSERT_FALSE(Hit(0, 'a'));
+
+    // completed write fills the cache
+    butil::IOBuf data = MakeData('b', 2 * kBlockSize);
+    epoch = cache->BeginWrite(kSn, 0, data.size());
+    cache->EndWrite(epoch, 0, data.size(), &data);
+    ASSERT_TRUE(Hit(0, 'b'));
+    ASSERT_TRUE(Hit(1, 'b'));
+
+    // failed write
+    epoch = cache->BeginWrite(kSn, 0, kBlockSize);
+    cache->EndWrite(epoch, 0, kBlockSize, nullptr);
+    ASSERT_FALSE(Hit(0, 'b'));
+    ASSERT_TRUE(Hit(1, 'b'));
+}
+
+TEST_F(ReadCacheTest, StaleFillTest) {
+    // read completes while a write is inflight
+    butil::IOBuf data;
+    uint64_t readEpoch = 0;
+    ASSERT_FALSE(cache->Read(kSn, 0, kBlockSize, &data, &readEpoch));
+    butil::IOBuf writeData = MakeData('b', kBlockSize);
+    uint64_t writeEpoch = cache->BeginWrite(kSn, 0, kBlockSize);
+    cache->EndRead(readEpoch, 0, MakeData('a', kBlockSize));
+    ASSERT_FALSE(Hit(0, 'a'));
+
+    // read completes after the write
+    cache->EndWrite(writeEpoch, 0, kBlockSize, &writeData);
+    cache->EndRead(readEpoch, 0, MakeData('a', kBlockSize));
+    ASSERT_TRUE(Hit(0, 'b'));
+
+    // overlapped writes complete out of order
+    butil::IOBuf data1 = MakeData('c', kBlockSize);
+    butil::IOBuf data2 = MakeData('d', kBlockSize);
+    uint64_t epoch1 = cache->BeginWrite(kSn, 0, kBlockSize);
+    uint64_t epoch2 = cache->BeginWrite(kSn, 0, kBlockSize);
+    cache->EndWrite(epoch2, 0, kBlockSize, &data2);
+    cache->EndWrite(epoch1, 0, kBlockSize, &data1);
+    ASSERT_FALSE(Hit(0, 'c'));
+    ASSERT_FALSE(Hit(0, 'd'));
+
+    // read completes after the cache is cleared
+    ASSERT_FALSE(cache->Read(kSn, 0, kBlockSize, &data, &readEpoch));
+    cache->Clear();
+    cache->EndRead(readEpoch, 0, MakeData('a', kBlockSize));
+    ASSERT_FALSE(Hit(0, 'a'));
+}
+
+TEST_F(ReadCacheTest, EvictionTest) {
+    // hit blocks 0 and 1 again, they are protected
+    Fill(0, 'a');
+    Fill(1, 'a');
+    ASSERT_TRUE(Hit(0, 'a'));
+    ASSERT_TRUE(Hit(1, 'a'));
+
+    // a scan only evicts the blocks of itself
+    for (uint64_t index = 2; index < 6; ++index) {
+        Fill(index, 's');
+    }
+    ASSERT_EQ(4 * kBlockSize, cache->CachedBytes());
+    ASSERT_EQ(2, metric->eviction.get_value());
+    ASSERT_TRUE(Hit(0, 'a'));
+    ASSERT_TRUE(Hit(1, 'a'));
+    ASSERT_FALSE(Hit(2, 's'));
+    ASSERT_FALSE(Hit(3, 's'));
+
+    // promoting block 4 demotes block 0, which is evicted after block 5
+    ASSERT_TRUE(Hit(4, 's'));
+    Fill(6, 's');
+    ASSERT_FALSE(Hit(5, 's'));
+    Fill(7, 's');
+    ASSERT_FALSE(Hit(0, 'a'));
+    ASSERT_TRUE(Hit(1, 'a'));
+    ASSERT_TRUE(Hit(4, 's'));
+    ASSERT_EQ(4 * kBlockSize, metric->bytes.get_value());
+}
+
+}  // namespace client
+}  // namespace curve
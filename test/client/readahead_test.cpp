@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: Wed Dec 30 15:47:12 CST 2020
+ * Author: wuhanqing
+ */
+
+#include "src/client/readahead.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/client/client_common.h"
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint64_t kFileLength = 1 * GiB;
+const uint64_t kChunkSize = 16 * MiB;
+const uint64_t kBlockSize = 4 * KiB;
+
+uint64_t TotalLength(const std::vector<ReadaheadRange>& ranges) {
+    uint64_t total = 0;
+    for (const auto& range : ranges) {
+        total += range.length;
+    }
+    return total;
+}
+
+}  // namespace
+
+class ReadaheadTest : public ::testing::Test {
+ public:
+    void SetUp() override {
+        option.enable = true;
+        option.triggerCount = 2;
+        option.windowMinKB = 1024;
+        option.windowMaxKB = 4096;
+        option.maxInflightMB = 16;
+
+        metric.reset(new ReadaheadMetric("ReadaheadTest"));
+        readahead.reset(new Readahead(option, metric.get()));
+    }
+
+    void Read(off_t offset, size_t length,
+              std::vector<ReadaheadRange>* ranges) {
+        readahead->OnRead(offset, length, kFileLength, kChunkSize, kBlockSize,
+                          ranges);
+    }
+
+ protected:
+    ReadaheadOption option;
+    std::unique_ptr<ReadaheadMetric> metric;
+    std::unique_ptr<Readahead> readahead;
+};
+
+TEST_F(ReadaheadTest, SequentialTest) {
+    std::vector<ReadaheadRange> ranges;
+    const size_t length = 128 * KiB;
+
+    // first read doesn't trigger readahead
+    Read(0, length, &ranges);
+    ASSERT_TRUE(ranges.empty());
+
+    // second sequential read prefetches a window ahead
+    Read(length, length, &ranges);
+    ASSERT_EQ(1, ranges.size());
+    ASSERT_EQ(2 * length, ranges[0].offset);
+    ASSERT_EQ(1 * MiB, ranges[0].length);
+    ASSERT_EQ(1 * MiB, readahead->InflightBytes());
+
+    // nothing more until half of the window is consumed
+    Read(2 * length, length, &ranges);
+    ASSERT_TRUE(ranges.empty());
+    Read(3 * length, length, &ranges);
+    ASSERT_TRUE(ranges.empty());
+    Read(4 * length, length, &ranges);
+    ASSERT_TRUE(ranges.empty());
+    Read(5 * length, length, &ranges);
+    ASSERT_TRUE(ranges.empty());
+
+    // window doubles
+    Read(6 * length, length, &ranges);
+    ASSERT_EQ(1, ranges.size());
+    ASSERT_EQ(2 * length + 1 * MiB, ranges[0].offset);
+    ASSERT_EQ(7 * length + 2 * MiB, ranges[0].offset + ranges[0].length);
+
+    readahead->OnPrefetchDone(1 * MiB);
+    readahead->OnPrefetchDone(ranges[0].length);
+    ASSERT_EQ(0, readahead->InflightBytes());
+}
+
+TEST_F(ReadaheadTest, RandomTest) {
+    std::vector<ReadaheadRange> ranges;
+    const size_t length = 4 * KiB;
+
+    for (uint64_t i = 0; i < 100; ++i) {
+        Read((i * 7919 % 1000) * 64 * KiB, length, &ranges);
+        ASSERT_TRUE(ranges.empty());
+    }
+    ASSERT_EQ(0, metric->issued.get_value());
+}
+
+TEST_F(ReadaheadTest, AlignTest) {
+    std::vector<ReadaheadRange> ranges;
+
+    // unaligned reads, prefetch range is aligned to blocks
+    Read(100, 1000, &ranges);
+    Read(1100, 1000, &ranges);
+    ASSERT_EQ(1, ranges.size());
+    ASSERT_EQ(0, ranges[0].offset % kBlockSize);
+    ASSERT_EQ(0, (ranges[0].offset + ranges[0].length) % kBlockSize);
+    ASSERT_LE(ranges[0].offset, 2100);
+
+    // split at chunk boundary
+    const uint64_t offset = kChunkSize - 512 * KiB;
+    Read(offset, 64 * KiB, &ranges);
+    Read(offset + 64 * KiB, 64 * KiB, &ranges);
+    ASSERT_EQ(2, ranges.size());
+    ASSERT_EQ(kChunkSize, ranges[0].offset + ranges[0].length);
+    ASSERT_EQ(kChunkSize, ranges[1].offset);
+
+    // never beyond file length
+    Read(kFileLength - 128 * KiB, 64 * KiB, &ranges);
+    Read(kFileLength - 64 * KiB, 64 * KiB, &ranges);
+    ASSERT_TRUE(ranges.empty());
+}
+
+TEST_F(ReadaheadTest, MultiStreamTest) {
+    std::vector<ReadaheadRange> ranges;
+    const size_t length = 64 * KiB;
+    const uint64_t base1 = 0;
+    const uint64_t base2 = 512 * MiB;
+
+    // two interleaved streams are both detected
+    Read(base1, length, &ranges);
+    Read(base2, length, &ranges);
+    Read(base1 + length, length, &ranges);
+    ASSERT_EQ(1, ranges.size());
+    ASSERT_EQ(base1 + 2 * length, ranges[0].offset);
+    Read(base2 + length, length, &ranges);
+    ASSERT_EQ(1, ranges.size());
+    ASSERT_EQ(base2 + 2 * length, ranges[0].offset);
+}
+
+TEST_F(ReadaheadTest, InflightLimitTest) {
+    std::vector<ReadaheadRange> ranges;
+    const size_t length = 64 * KiB;
+
+    // 20 streams each prefetch 1MiB, at most 16MiB can be inflight
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < 20; ++i) {
+        const uint64_t base = i * 32 * MiB;
+        Read(base, length, &ranges);
+        Read(base + length, length, &ranges);
+        total += TotalLength(ranges);
+    }
+    ASSERT_EQ(16 * MiB, total);
+    ASSERT_EQ(16 * MiB, readahead->InflightBytes());
+    ASSERT_EQ(4, metric->throttled.get_value());
+
+    // prefetch goes on after inflight ones complete
+    readahead->OnPrefetchDone(1 * MiB);
+    Read(20 * 32 * MiB, length, &ranges);
+    Read(20 * 32 * MiB + length, length, &ranges);
+    ASSERT_EQ(1 * MiB, TotalLength(ranges));
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,239 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+// Microbenchmark of small random aio through libcurve's FileInstance against
+// the fake mds and chunkservers, reports ops/s and heap allocations per I/O.
+// Allocations are counted by replacing the global operator new, so they
+// include those of the in-process fake chunkservers, compare the numbers
+// between builds rather than reading them as absolute values. The system
+// allocations of the RequestContext, RequestClosure and IOTracker pools
+// are reported separately.
+//
+// usage: client-request-alloc-bench -io_size=4096 -iodepth=32 -seconds=5
+
+#include <butil/fast_rand.h>
+#include <butil/time.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <new>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "include/client/libcurve.h"
+#include "src/client/io_tracker.h"
+#include "src/client/request_closure.h"
+#include "src/client/request_context.h"
+#include "src/common/object_pool.h"
+#include "test/client/fake/fakeMDS.h"
+
+DEFINE_string(config, "./test/client/configs/client.conf",
+              "client config path");
+DEFINE_uint64(io_size, 4096, "size of each I/O");
+DEFINE_uint32(iodepth, 32, "number of inflight I/Os");
+DEFINE_uint32(read_percent, 50, "percent of read I/Os");
+DEFINE_uint32(seconds, 5, "running time");
+DEFINE_uint32(warmup_seconds, 1, "running time before measuring");
+
+DECLARE_uint64(test_disk_size);
+
+namespace {
+
+std::atomic<uint64_t> gAllocCount(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+namespace curve {
+namespace client {
+
+using curve::common::ObjectPool;
+
+struct BenchContext : public CurveAioContext {
+    char* data;
+};
+
+std::mutex gMtx;
+std::condition_variable gCond;
+// contexts of completed I/Os, ready to be submitted again
+std::vector<BenchContext*> gFreeCtxs;
+std::atomic<uint64_t> gCompleted(0);
+std::atomic<uint64_t> gFailed(0);
+
+void BenchCallback(CurveAioContext* aioctx) {
+    if (aioctx->ret < 0) {
+        gFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    gCompleted.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lk(gMtx);
+    gFreeCtxs.push_back(static_cast<BenchContext*>(aioctx));
+    gCond.notify_one();
+}
+
+struct PoolAllocs {
+    uint64_t requestContext;
+    uint64_t requestClosure;
+    uint64_t ioTracker;
+};
+
+PoolAllocs GetPoolAllocs() {
+    return {ObjectPool<RequestContext>::GetInstance()->GetAllocCount(),
+            ObjectPool<RequestClosure>::GetInstance()->GetAllocCount(),
+            ObjectPool<IOTracker>::GetInstance()->GetAllocCount()};
+}
+
+// submit random I/Os for seconds, keeping iodepth I/Os inflight
+void RunBench(int fd, uint32_t seconds) {
+    const uint64_t blocks = FLAGS_test_disk_size / FLAGS_io_size;
+    const uint64_t deadline = butil::gettimeofday_us() + seconds * 1000000ul;
+    while (butil::gettimeofday_us() < deadline) {
+        BenchContext* ctx = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(gMtx);
+            gCond.wait(lk, []() { return !gFreeCtxs.empty(); });
+            ctx = gFreeCtxs.back();
+            gFreeCtxs.pop_back();
+        }
+
+        ctx->offset = butil::fast_rand_less_than(blocks) * FLAGS_io_size;
+        ctx->length = FLAGS_io_size;
+        ctx->buf = ctx->data;
+        ctx->cb = BenchCallback;
+        if (butil::fast_rand_less_than(100) < FLAGS_read_percent) {
+            ctx->op = LIBCURVE_OP_READ;
+            AioRead(fd, ctx);
+        } else {
+            ctx->op = LIBCURVE_OP_WRITE;
+            AioWrite(fd, ctx);
+        }
+    }
+
+    std::unique_lock<std::mutex> lk(gMtx);
+    gCond.wait(lk, []() { return gFreeCtxs.size() == FLAGS_iodepth; });
+}
+
+}  // namespace client
+}  // namespace curve
+
+int main(int argc, char* argv[]) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    using curve::client::BenchContext;
+    using curve::client::GetPoolAllocs;
+    using curve::client::PoolAllocs;
+    using curve::client::RunBench;
+    using curve::client::gCompleted;
+    using curve::client::gFailed;
+    using curve::client::gFreeCtxs;
+
+    std::string filename = "/1_userinfo_";
+    FakeMDS mds(filename);
+    mds.Initialize();
+    mds.StartService();
+    butil::EndPoint ep;
+    butil::str2endpoint("127.0.0.1", 9106, &ep);
+    PeerId pd(ep);
+    mds.StartCliService(pd);
+    mds.CreateCopysetNode(true);
+
+    if (Init(FLAGS_config.c_str()) != 0) {
+        LOG(FATAL) << "Fail to init config";
+    }
+
+    C_UserInfo_t userinfo;
+    memcpy(userinfo.owner, "userinfo", 9);
+    memset(userinfo.password, 0, sizeof(userinfo.password));
+    Create(filename.c_str(), &userinfo, FLAGS_test_disk_size);
+    int fd = Open(filename.c_str(), &userinfo);
+    if (fd < 0) {
+        LOG(FATAL) << "open file failed";
+    }
+
+    BenchContext* ctxs = new BenchContext[FLAGS_iodepth];
+    for (uint32_t i = 0; i < FLAGS_iodepth; ++i) {
+        ctxs[i].data = new char[FLAGS_io_size];
+        memset(ctxs[i].data, 'a' + i % 26, FLAGS_io_size);
+        gFreeCtxs.push_back(&ctxs[i]);
+    }
+
+    // fill the pools and caches before measuring
+    RunBench(fd, FLAGS_warmup_seconds);
+
+    uint64_t completed = gCompleted.load();
+    uint64_t failed = gFailed.load();
+    uint64_t allocs = gAllocCount.load();
+    PoolAllocs poolAllocs = GetPoolAllocs();
+    butil::Timer timer;
+    timer.start();
+    RunBench(fd, FLAGS_seconds);
+    timer.stop();
+
+    uint64_t ios = gCompleted.load() - completed;
+    double perIO = ios == 0 ? 0 : 1.0 / ios;
+    PoolAllocs poolAllocsEnd = GetPoolAllocs();
+
+    printf("io_size: %lu, iodepth: %u, read_percent: %u\n", FLAGS_io_size,
+           FLAGS_iodepth, FLAGS_read_percent);
+    printf("%-32s %16lu\n", "ios", ios);
+    printf("%-32s %16lu\n", "failed ios", gFailed.load() - failed);
+    printf("%-32s %16.0f\n", "ops/s",
+           ios * 1000000.0 / std::max<int64_t>(timer.u_elapsed(), 1));
+    printf("%-32s %16.2f\n", "allocations per io",
+           (gAllocCount.load() - allocs) * perIO);
+    printf("%-32s %16.4f\n", "request context allocs per io",
+           (poolAllocsEnd.requestContext - poolAllocs.requestContext) * perIO);
+    printf("%-32s %16.4f\n", "request closure allocs per io",
+           (poolAllocsEnd.requestClosure - poolAllocs.requestClosure) * perIO);
+    printf("%-32s %16.4f\n", "io tracker allocs per io",
+           (poolAllocsEnd.ioTracker - poolAllocs.ioTracker) * perIO);
+
+    Close(fd);
+    UnInit();
+    mds.UnInitialize();
+
+    for (uint32_t i = 0; i < FLAGS_iodepth; ++i) {
+        delete[] ctxs[i].data;
+    }
+    delete[] ctxs;
+    return 0;
+}
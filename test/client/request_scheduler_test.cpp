@@ -599,5 +599,160 @@ TEST(RequestSchedulerTest, CommonTest) {
     ASSERT_EQ(0, sche.Fini());
 }
 
+TEST(RequestSchedulerTest, WriteMergeTest) {
+    RequestScheduleOption opt;
+    opt.scheduleQueueCapacity = 4096;
+    opt.scheduleThreadpoolSize = 1;
+    opt.enableWriteMerge = true;
+    opt.writeMergeMaxBytes = 16;
+    opt.ioSenderOpt.failRequestOpt.chunkserverRPCTimeoutMS = 200;
+    opt.ioSenderOpt.failRequestOpt.chunkserverOPMaxRetry = 5;
+    opt.ioSenderOpt.failRequestOpt.chunkserverOPRetryIntervalUS = 5000;
+
+    brpc::Server server;
+    std::string listenAddr = "127.0.0.1:9109";
+    FakeChunkServiceImpl fakeChunkService;
+    ASSERT_EQ(server.AddService(&fakeChunkService,
+                                brpc::SERVER_DOESNT_OWN_SERVICE), 0);
+    brpc::ServerOptions option;
+    option.idle_timeout_sec = -1;
+    ASSERT_EQ(server.Start(listenAddr.c_str(), &option), 0);
+
+    RequestScheduler requestScheduler;
+    MockMetaCache mockMetaCache;
+    mockMetaCache.DelegateToFake();
+    EXPECT_CALL(mockMetaCache, GetLeader(_, _, _, _, _, _)).Times(AnyNumber());
+    FileMetric fm("WriteMergeTest");
+    IOTracker iot(nullptr, nullptr, nullptr, &fm);
+    ASSERT_EQ(0, requestScheduler.Init(opt, &mockMetaCache, &fm));
+
+    // [0, 8)和[8, 16)相邻，[4, 12)与两者重叠，[100, 108)不相邻，
+    // [16, 24)合并后超过writeMergeMaxBytes
+    struct {
+        off_t offset;
+        char c;
+    } writes[] = {{0, 'a'}, {8, 'b'}, {4, 'c'}, {100, 'd'}, {16, 'e'}};
+    const size_t len = 8;
+    curve::common::CountDownEvent cond(5);
+    std::vector<RequestContext*> reqCtxs;
+    for (auto& w : writes) {
+        RequestContext* reqCtx = new FakeRequestContext();
+        reqCtx->optype_ = OpType::WRITE;
+        reqCtx->idinfo_ = ChunkIDInfo(1, 1, 100001);
+        reqCtx->writeData_.append(std::string(len, w.c));
+        reqCtx->offset_ = w.offset;
+        reqCtx->rawlength_ = len;
+
+        RequestClosure* reqDone = new FakeRequestClosure(&cond, reqCtx);
+        reqDone->SetFileMetric(&fm);
+        reqDone->SetIOTracker(&iot);
+        reqCtx->done_ = reqDone;
+        reqCtxs.push_back(reqCtx);
+
+        // 在scheduler运行前放入队列，保证同时被取出
+        requestScheduler.GetQueue()->PutBack(BBQItem<RequestContext*>(reqCtx));
+    }
+
+    ASSERT_EQ(0, requestScheduler.Run());
+    cond.Wait();
+    for (auto reqCtx : reqCtxs) {
+        ASSERT_EQ(0, reqCtx->done_->GetErrorCode());
+    }
+    ASSERT_EQ(2, fm.mergedWriteQPS.count.get_value());
+
+    // 读出合并写入的数据
+    RequestContext* reqCtx = new FakeRequestContext();
+    reqCtx->optype_ = OpType::READ;
+    reqCtx->idinfo_ = ChunkIDInfo(1, 1, 100001);
+    reqCtx->offset_ = 0;
+    reqCtx->rawlength_ = 24;
+    curve::common::CountDownEvent readCond(1);
+    RequestClosure* reqDone = new FakeRequestClosure(&readCond, reqCtx);
+    reqDone->SetFileMetric(&fm);
+    reqDone->SetIOTracker(&iot);
+    reqCtx->done_ = reqDone;
+    ASSERT_EQ(0, requestScheduler.ScheduleRequest(reqCtx));
+    readCond.Wait();
+    ASSERT_EQ(0, reqDone->GetErrorCode());
+    ASSERT_EQ(std::string(4, 'a') + std::string(8, 'c') + std::string(4, 'b') +
+                  std::string(8, 'e'),
+              reqCtx->readData_.to_string());
+
+    requestScheduler.Fini();
+    ASSERT_EQ(0, server.Stop(0));
+    ASSERT_EQ(0, server.Join());
+}
+
+TEST(RequestSchedulerTest, WriteMergeSkipRescheduledTest) {
+    RequestScheduleOption opt;
+    opt.scheduleQueueCapacity = 4096;
+    opt.scheduleThreadpoolSize = 1;
+    opt.enableWriteMerge = true;
+    opt.writeMergeMaxBytes = 32;
+    opt.ioSenderOpt.failRequestOpt.chunkserverRPCTimeoutMS = 200;
+    opt.ioSenderOpt.failRequestOpt.chunkserverOPMaxRetry = 5;
+    opt.ioSenderOpt.failRequestOpt.chunkserverOPRetryIntervalUS = 5000;
+
+    brpc::Server server;
+    std::string listenAddr = "127.0.0.1:9109";
+    FakeChunkServiceImpl fakeChunkService;
+    ASSERT_EQ(server.AddService(&fakeChunkService,
+                                brpc::SERVER_DOESNT_OWN_SERVICE), 0);
+    brpc::ServerOptions option;
+    option.idle_timeout_sec = -1;
+    ASSERT_EQ(server.Start(listenAddr.c_str(), &option), 0);
+
+    RequestScheduler requestScheduler;
+    MockMetaCache mockMetaCache;
+    mockMetaCache.DelegateToFake();
+    EXPECT_CALL(mockMetaCache, GetLeader(_, _, _, _, _, _)).Times(AnyNumber());
+    FileMetric fm("WriteMergeSkipRescheduledTest");
+    IOTracker iot(nullptr, nullptr, nullptr, &fm);
+    ASSERT_EQ(0, requestScheduler.Init(opt, &mockMetaCache, &fm));
+
+    // 四个写请求两两相邻, [0, 8)和[24, 32)是重新调度的请求,
+    // 只有[8, 16)和[16, 24)被合并
+    struct {
+        off_t offset;
+        char c;
+        bool rescheduled;
+    } writes[] = {{0, 'a', true}, {8, 'b', false},
+                  {16, 'c', false}, {24, 'd', true}};
+    const size_t len = 8;
+    curve::common::CountDownEvent cond(4);
+    std::vector<RequestContext*> reqCtxs;
+    for (auto& w : writes) {
+        RequestContext* reqCtx = new FakeRequestContext();
+        reqCtx->optype_ = OpType::WRITE;
+        reqCtx->idinfo_ = ChunkIDInfo(1, 1, 100001);
+        reqCtx->writeData_.append(std::string(len, w.c));
+        reqCtx->offset_ = w.offset;
+        reqCtx->rawlength_ = len;
+
+        RequestClosure* reqDone = new FakeRequestClosure(&cond, reqCtx);
+        reqDone->SetFileMetric(&fm);
+        reqDone->SetIOTracker(&iot);
+        reqCtx->done_ = reqDone;
+        reqCtxs.push_back(reqCtx);
+
+        if (w.rescheduled) {
+            // scheduler未运行, 请求不会放入队列, 但会被标记为重新调度过
+            ASSERT_EQ(-1, requestScheduler.ReSchedule(reqCtx));
+        }
+        requestScheduler.GetQueue()->PutBack(BBQItem<RequestContext*>(reqCtx));
+    }
+
+    ASSERT_EQ(0, requestScheduler.Run());
+    cond.Wait();
+    for (auto reqCtx : reqCtxs) {
+        ASSERT_EQ(0, reqCtx->done_->GetErrorCode());
+    }
+    ASSERT_EQ(1, fm.mergedWriteQPS.count.get_value());
+
+    requestScheduler.Fini();
+    ASSERT_EQ(0, server.Stop(0));
+    ASSERT_EQ(0, server.Join());
+}
+
 }   // namespace client
 }   // namespace curve
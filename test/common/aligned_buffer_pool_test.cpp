@@ -0,0 +1,151 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-14
+ * Author: yangyaokai
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "src/common/aligned_buffer_pool.h"
+
+namespace curve {
+namespace common {
+
+TEST(AlignedBufferPoolTest, GetAndReuseTest) {
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    uint64_t hit = pool->GetHitCount();
+    uint64_t miss = pool->GetMissCount();
+
+    char* data = nullptr;
+    {
+        AlignedBuffer buf = pool->Get(5000);
+        data = buf.data();
+        ASSERT_NE(nullptr, data);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(data) %
+                     AlignedBufferPool::kAlignment);
+        ASSERT_EQ(5000, buf.size());
+        ASSERT_EQ(8192, buf.capacity());
+        ASSERT_EQ(miss + 1, pool->GetMissCount());
+    }
+    // 同一个线程再次申请同样大小的内存，命中线程缓存
+    {
+        AlignedBuffer buf = pool->Get(8192);
+        ASSERT_EQ(data, buf.data());
+        ASSERT_EQ(hit + 1, pool->GetHitCount());
+    }
+
+    // move之后只归还一次
+    {
+        AlignedBuffer buf1 = pool->Get(4096);
+        AlignedBuffer buf2(std::move(buf1));
+        ASSERT_EQ(nullptr, buf1.data());
+        AlignedBuffer buf3;
+        buf3 = std::move(buf2);
+        ASSERT_EQ(nullptr, buf2.data());
+        ASSERT_NE(nullptr, buf3.data());
+        buf3.Reset();
+        ASSERT_EQ(nullptr, buf3.data());
+    }
+}
+
+TEST(AlignedBufferPoolTest, NotPooledTest) {
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    int64_t footprint = pool->GetFootprint();
+    int64_t cached = pool->GetCachedBytes();
+    uint64_t miss = pool->GetMissCount();
+
+    // 超过最大size class的请求直接向系统申请，释放后不缓存
+    {
+        AlignedBuffer buf = pool->Get(AlignedBufferPool::kMaxBufferSize + 1);
+        ASSERT_EQ(miss + 1, pool->GetMissCount());
+        ASSERT_EQ(footprint + AlignedBufferPool::kMaxBufferSize + 1,
+                  pool->GetFootprint());
+    }
+    ASSERT_EQ(footprint, pool->GetFootprint());
+    ASSERT_EQ(cached, pool->GetCachedBytes());
+
+    // 对齐要求超过pool的对齐大小
+    {
+        AlignedBuffer buf = pool->Get(4096, 65536);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(buf.data()) % 65536);
+        ASSERT_EQ(miss + 2, pool->GetMissCount());
+    }
+    ASSERT_EQ(footprint, pool->GetFootprint());
+}
+
+TEST(AlignedBufferPoolTest, MultiThreadTest) {
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    const size_t kSize = 256 * 1024;
+
+    // 线程缓存只能保存一个256KB的buffer，其余的放回共享缓存
+    std::vector<AlignedBuffer> bufs;
+    std::thread producer([&]() {
+        for (int i = 0; i < 4; ++i) {
+            bufs.emplace_back(pool->Get(kSize));
+        }
+    });
+    producer.join();
+    int64_t footprint = pool->GetFootprint();
+
+    std::thread releaser([&]() {
+        bufs.clear();
+    });
+    releaser.join();
+    // releaser退出后，线程缓存中的buffer也回到了共享缓存
+    ASSERT_EQ(footprint, pool->GetFootprint());
+    ASSERT_GE(pool->GetCachedBytes(), 4 * kSize);
+
+    uint64_t hit = pool->GetHitCount();
+    std::thread consumer([&]() {
+        for (int i = 0; i < 4; ++i) {
+            bufs.emplace_back(pool->Get(kSize));
+        }
+        bufs.clear();
+    });
+    consumer.join();
+    ASSERT_EQ(hit + 4, pool->GetHitCount());
+    ASSERT_EQ(footprint, pool->GetFootprint());
+}
+
+TEST(AlignedBufferPoolTest, CacheLimitTest) {
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    uint64_t maxCached = FLAGS_alignedBufferPoolMaxCachedBytes;
+    FLAGS_alignedBufferPoolMaxCachedBytes = 0;
+
+    std::vector<AlignedBuffer> bufs;
+    std::thread t([&]() {
+        for (int i = 0; i < 4; ++i) {
+            bufs.emplace_back(pool->Get(AlignedBufferPool::kMaxBufferSize));
+        }
+        int64_t footprint = pool->GetFootprint();
+        // 线程缓存保留一个，共享缓存已满，其余的直接释放
+        bufs.clear();
+        ASSERT_EQ(footprint - 3 * AlignedBufferPool::kMaxBufferSize,
+                  pool->GetFootprint());
+    });
+    t.join();
+    FLAGS_alignedBufferPoolMaxCachedBytes = maxCached;
+}
+
+}  // namespace common
+}  // namespace curve
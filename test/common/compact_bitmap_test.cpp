@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-23
+ * Author: yangyaokai
+ */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "src/common/compact_bitmap.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+void ExpectRangesEqual(const vector<BitRange>& expected,
+                       const vector<BitRange>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i].beginIndex, actual[i].beginIndex);
+        ASSERT_EQ(expected[i].endIndex, actual[i].endIndex);
+    }
+}
+
+// 比较压缩bitmap与普通bitmap的所有查询结果
+void ExpectSameAs(const Bitmap& expected, const CompactBitmap& actual) {
+    uint32_t bits = expected.Size();
+    ASSERT_EQ(bits, actual.Size());
+    for (uint32_t i = 0; i < bits + 2; ++i) {
+        ASSERT_EQ(expected.Test(i), actual.Test(i)) << i;
+        ASSERT_EQ(expected.NextSetBit(i), actual.NextSetBit(i)) << i;
+        ASSERT_EQ(expected.NextClearBit(i), actual.NextClearBit(i)) << i;
+    }
+    for (int round = 0; round < 100; ++round) {
+        uint32_t start = rand() % bits;  // NOLINT
+        uint32_t end = rand() % (bits + 8);  // NOLINT
+        ASSERT_EQ(expected.NextSetBit(start, end),
+                  actual.NextSetBit(start, end));
+        ASSERT_EQ(expected.NextClearBit(start, end),
+                  actual.NextClearBit(start, end));
+        vector<BitRange> clear1, set1, clear2, set2;
+        expected.Divide(start, end, &clear1, &set1);
+        actual.Divide(start, end, &clear2, &set2);
+        ExpectRangesEqual(clear1, clear2);
+        ExpectRangesEqual(set1, set2);
+    }
+    std::vector<char> buf((bits + 7) / 8);
+    actual.Encode(buf.data());
+    ASSERT_EQ(expected, Bitmap(bits, buf.data()));
+}
+
+}  // namespace
+
+TEST(CompactBitmapTest, BasicTest) {
+    CompactBitmap empty(0);
+    ASSERT_EQ(Bitmap::NO_POS, empty.NextClearBit(0));
+    ASSERT_EQ(Bitmap::NO_POS, empty.NextSetBit(0));
+
+    CompactBitmap bitmap(1000);
+    ASSERT_TRUE(bitmap.IsCompressed());
+    ASSERT_EQ(0, bitmap.NextClearBit(0));
+    ASSERT_EQ(Bitmap::NO_POS, bitmap.NextSetBit(0));
+
+    // 写者生成新版本，旧版本不变
+    CompactBitmapPtr v1 = bitmap.Set(10, 19);
+    CompactBitmapPtr v2 = v1->Set(std::set<uint32_t>{20, 21, 50, 99, 200, 1000});
+    ASSERT_EQ(Bitmap::NO_POS, bitmap.NextSetBit(0));
+    ASSERT_EQ(10, v1->NextSetBit(0));
+    ASSERT_EQ(20, v1->NextClearBit(10));
+    ASSERT_EQ(22, v2->NextClearBit(10));
+    ASSERT_TRUE(v2->Test(99));
+    ASSERT_TRUE(v2->Test(200));
+    ASSERT_FALSE(v2->Test(1000));
+    ASSERT_TRUE(v2->IsCompressed());
+
+    vector<BitRange> clearRanges, setRanges;
+    v2->Divide(0, 99, &clearRanges, &setRanges);
+    ExpectRangesEqual({{0, 9}, {22, 49}, {51, 98}}, clearRanges);
+    ExpectRangesEqual({{10, 21}, {50, 50}, {99, 99}}, setRanges);
+
+    // 全部置位
+    CompactBitmapPtr full = v2->Set(0, 2000);
+    ASSERT_EQ(Bitmap::NO_POS, full->NextClearBit(0));
+    ASSERT_NE(*full, *v2);
+    Bitmap expected(1000);
+    expected.Set();
+    ASSERT_EQ(*full, CompactBitmap(expected));
+}
+
+TEST(CompactBitmapTest, FlatTest) {
+    // run过多时退化为普通bitmap
+    Bitmap expected(4096);
+    for (uint32_t i = 0; i < 4096; i += 2) {
+        expected.Set(i);
+    }
+    CompactBitmap bitmap(expected);
+    ASSERT_FALSE(bitmap.IsCompressed());
+    ExpectSameAs(expected, bitmap);
+
+    // 填满空洞后重新压缩
+    std::set<uint32_t> holes;
+    for (uint32_t i = 1; i < 4096; i += 2) {
+        holes.insert(i);
+    }
+    CompactBitmapPtr full = bitmap.Set(holes);
+    ASSERT_TRUE(full->IsCompressed());
+    ASSERT_EQ(Bitmap::NO_POS, full->NextClearBit(0));
+}
+
+TEST(CompactBitmapTest, RandomTest) {
+    unsigned int seed = time(nullptr);
+    srand(seed);
+    LOG(INFO) << "seed: " << seed;
+    for (uint32_t bits : {1, 7, 8, 63, 4096, 4099}) {
+        Bitmap expected(bits);
+        CompactBitmapPtr bitmap = std::make_shared<CompactBitmap>(bits);
+        ExpectSameAs(expected, *bitmap);
+        for (int round = 0; round < 20; ++round) {
+            if (rand() % 2) {  // NOLINT
+                uint32_t start = rand() % bits;  // NOLINT
+                uint32_t end = start + rand() % 64;  // NOLINT
+                expected.Set(start, end);
+                bitmap = bitmap->Set(start, end);
+            } else {
+                std::set<uint32_t> indexes;
+                for (int i = 0; i < 16; ++i) {
+                    indexes.insert(rand() % bits);  // NOLINT
+                }
+                for (auto index : indexes) {
+                    expected.Set(index);
+                }
+                bitmap = bitmap->Set(indexes);
+            }
+            ExpectSameAs(expected, *bitmap);
+            // 从持久化的数据恢复
+            ExpectSameAs(expected,
+                         CompactBitmap(bits, expected.GetBitmap()));
+        }
+    }
+}
+
+}  // namespace common
+}  // namespace curve
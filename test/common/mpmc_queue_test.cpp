@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-16
+ * Author: lixiaocui
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/common/concurrent/mpmc_queue.h"
+
+namespace curve {
+namespace common {
+
+TEST(MPMCQueueTest, BasicTest) {
+    // 容量向上取整为2的幂
+    MPMCQueue<int> queue(3);
+    ASSERT_EQ(4, queue.Capacity());
+    ASSERT_EQ(0, queue.SizeApprox());
+
+    int value = 0;
+    ASSERT_FALSE(queue.TryPop(&value));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPush(i));
+    }
+    ASSERT_FALSE(queue.TryPush(4));
+    ASSERT_EQ(4, queue.SizeApprox());
+
+    // 先进先出
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(queue.TryPop(&value));
+
+    // 回绕之后仍然可用
+    for (int round = 0; round < 10; ++round) {
+        ASSERT_TRUE(queue.TryPush(round));
+        ASSERT_TRUE(queue.TryPop(&value));
+        ASSERT_EQ(round, value);
+    }
+}
+
+TEST(MPMCQueueTest, MoveOnlyTest) {
+    MPMCQueue<std::unique_ptr<int>> queue(2);
+    std::unique_ptr<int> value(new int(1));
+    ASSERT_TRUE(queue.TryPush(&value));
+    ASSERT_EQ(nullptr, value);
+
+    // 队列满时push失败，value保持不变
+    value.reset(new int(2));
+    ASSERT_TRUE(queue.TryPush(&value));
+    value.reset(new int(3));
+    ASSERT_FALSE(queue.TryPush(&value));
+    ASSERT_EQ(3, *value);
+
+    ASSERT_TRUE(queue.TryPop(&value));
+    ASSERT_EQ(1, *value);
+}
+
+TEST(MPMCQueueTest, MultiThreadTest) {
+    const int kProducer = 4;
+    const int kConsumer = 4;
+    const int kCount = 100000;
+    MPMCQueue<int> queue(64);
+
+    std::atomic<int64_t> sum(0);
+    std::atomic<int> popped(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kProducer; ++i) {
+        threads.emplace_back([&queue]() {
+            for (int j = 1; j <= kCount; ++j) {
+                while (!queue.TryPush(j)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kConsumer; ++i) {
+        threads.emplace_back([&]() {
+            int value;
+            while (popped.load() < kProducer * kCount) {
+                if (queue.TryPop(&value)) {
+                    sum.fetch_add(value);
+                    popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(kProducer * kCount, popped.load());
+    ASSERT_EQ(static_cast<int64_t>(kProducer) * kCount * (kCount + 1) / 2,
+              sum.load());
+    ASSERT_EQ(0, queue.SizeApprox());
+}
+
+}  // namespace common
+}  // namespace curve
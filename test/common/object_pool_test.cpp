@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/common/object_pool.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+struct alignas(64) PooledObject {
+    PooledObject(int v, const std::string& s) : value(v), str(s) {
+        ++constructed;
+    }
+
+    ~PooledObject() {
+        ++destructed;
+    }
+
+    int value;
+    std::string str;
+
+    static int constructed;
+    static int destructed;
+};
+
+int PooledObject::constructed = 0;
+int PooledObject::destructed = 0;
+
+struct CrossThreadObject {
+    char data[128];
+};
+
+}  // namespace
+
+TEST(ObjectPoolTest, NewAndDeleteTest) {
+    ObjectPool<PooledObject>* pool = ObjectPool<PooledObject>::GetInstance();
+    ASSERT_EQ(0, pool->GetLiveCount());
+
+    PooledObject* obj = pool->New(1, "hello");
+    ASSERT_NE(nullptr, obj);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(obj) % 64);
+    ASSERT_EQ(1, obj->value);
+    ASSERT_EQ("hello", obj->str);
+    ASSERT_EQ(1, PooledObject::constructed);
+    ASSERT_EQ(1, pool->GetLiveCount());
+    ASSERT_EQ(1, pool->GetAllocCount());
+
+    pool->Delete(obj);
+    ASSERT_EQ(1, PooledObject::destructed);
+    ASSERT_EQ(0, pool->GetLiveCount());
+    ASSERT_EQ(1, pool->GetCachedCount());
+
+    // 同一个线程再次申请，复用缓存的内存，对象重新构造
+    PooledObject* obj2 = pool->New(2, "world");
+    ASSERT_EQ(obj, obj2);
+    ASSERT_EQ(2, obj2->value);
+    ASSERT_EQ("world", obj2->str);
+    ASSERT_EQ(1, pool->GetAllocCount());
+    ASSERT_EQ(0, pool->GetCachedCount());
+
+    pool->Delete(obj2);
+    pool->Delete(nullptr);
+    ASSERT_EQ(2, PooledObject::constructed);
+    ASSERT_EQ(2, PooledObject::destructed);
+    ASSERT_EQ(0, pool->GetLiveCount());
+}
+
+TEST(ObjectPoolTest, CrossThreadTest) {
+    using Pool = ObjectPool<CrossThreadObject>;
+    Pool* pool = Pool::GetInstance();
+    const size_t count = 4 * Pool::kThreadCacheSize;
+
+    // 一个线程申请，另一个线程释放，释放线程的缓存满了以后放回共享缓存
+    for (int round = 0; round < 4; ++round) {
+        std::vector<CrossThreadObject*> objs;
+        std::thread producer([&]() {
+            for (size_t i = 0; i < count; ++i) {
+                objs.push_back(pool->New());
+            }
+        });
+        producer.join();
+        ASSERT_EQ(static_cast<int64_t>(count), pool->GetLiveCount());
+
+        std::thread consumer([&]() {
+            for (auto obj : objs) {
+                pool->Delete(obj);
+            }
+        });
+        consumer.join();
+        ASSERT_EQ(0, pool->GetLiveCount());
+    }
+
+    // 后面几轮的内存都来自共享缓存，不会一直向系统申请
+    ASSERT_LT(pool->GetAllocCount(), 2 * count);
+    ASSERT_LE(pool->GetCachedCount(),
+              static_cast<int64_t>(Pool::kSharedCacheSize));
+}
+
+}  // namespace common
+}  // namespace curve
@@ -43,6 +43,7 @@ using ::testing::StrEq;
 using ::testing::ElementsAre;
 using ::testing::SetArgPointee;
 using ::testing::ReturnArg;
+using ::testing::SetErrnoAndReturn;
 
 namespace curve {
 namespace fs {
@@ -529,6 +530,22 @@ TEST_F(Ext4LocalFileSystemTest, FsyncTest) {
     ASSERT_EQ(lfs->Fsync(666), -errno);
 }
 
+// test CloneRange
+TEST_F(Ext4LocalFileSystemTest, CloneRangeTest) {
+    // success
+    EXPECT_CALL(*wrapper, ficlonerange(777, _))
+        .WillOnce(Return(0));
+    ASSERT_EQ(0, lfs->CloneRange(666, 4096, 777, 8192, 4096));
+    // filesystem does not support reflink
+    EXPECT_CALL(*wrapper, ficlonerange(777, _))
+        .WillOnce(SetErrnoAndReturn(EOPNOTSUPP, -1));
+    ASSERT_EQ(-EOPNOTSUPP, lfs->CloneRange(666, 4096, 777, 8192, 4096));
+    // other error
+    EXPECT_CALL(*wrapper, ficlonerange(777, _))
+        .WillOnce(SetErrnoAndReturn(EIO, -1));
+    ASSERT_EQ(-EIO, lfs->CloneRange(666, 4096, 777, 8192, 4096));
+}
+
 TEST_F(Ext4LocalFileSystemTest, ReadRealTest) {
     std::shared_ptr<PosixWrapper> pw = std::make_shared<PosixWrapper>();
     lfs->SetPosixWrapper(pw);
@@ -0,0 +1,240 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * File Created: 2020-12-07
+ * Author: yangyaokai
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/fs/io_uring_engine.h"
+
+namespace curve {
+namespace fs {
+
+const char kTestFile[] = "./io_uring_engine_test.dat";
+
+// 查找当前进程中io_uring ring的fd
+int FindRingFd() {
+    int ringFd = -1;
+    DIR* dir = ::opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return -1;
+    }
+    struct dirent* entry;
+    while ((entry = ::readdir(dir)) != nullptr) {
+        std::string path = std::string("/proc/self/fd/") + entry->d_name;
+        char target[64] = {0};
+        if (::readlink(path.c_str(), target, sizeof(target) - 1) > 0
+            && std::string(target) == "anon_inode:[io_uring]") {
+            ringFd = std::stoi(entry->d_name);
+        }
+    }
+    ::closedir(dir);
+    return ringFd;
+}
+
+class IoUringEngineTest : public testing::Test {
+ public:
+    void SetUp() {
+        fd_ = ::open(kTestFile, O_CREAT | O_RDWR | O_TRUNC, 0644);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() {
+        ::close(fd_);
+        ::unlink(kTestFile);
+    }
+
+ protected:
+    int fd_;
+};
+
+TEST_F(IoUringEngineTest, ReadWriteFsyncTest) {
+    if (!IoUringEngine::IsSupported()) {
+        LOG(INFO) << "io_uring is not supported, skip.";
+        return;
+    }
+    IoUringEngine engine;
+    ASSERT_EQ(-EINVAL, engine.Init(0));
+    ASSERT_EQ(0, engine.Init(4));
+
+    const int kLength = 64 * 1024;
+    std::string data(kLength, 'a');
+    for (int i = 0; i < kLength; ++i) {
+        data[i] = 'a' + i % 26;
+    }
+
+    // 提交数超过队列深度时提交方会等待，最终全部完成
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 16; ++i) {
+        auto done = std::make_shared<std::promise<int>>();
+        results.push_back(done->get_future());
+        butil::IOBuf buf;
+        buf.append(data.data(), 1000);
+        buf.append(data.data() + 1000, kLength - 1000);
+        ASSERT_EQ(0, engine.SubmitWrite(fd_, buf, i * kLength, kLength,
+                                        [done](int rc) {
+                                            done->set_value(rc);
+                                        }));
+    }
+    for (auto& result : results) {
+        ASSERT_EQ(kLength, result.get());
+    }
+
+    std::promise<int> fsyncDone;
+    ASSERT_EQ(0, engine.SubmitFsync(fd_, [&fsyncDone](int rc) {
+        fsyncDone.set_value(rc);
+    }));
+    ASSERT_EQ(0, fsyncDone.get_future().get());
+
+    std::unique_ptr<char[]> readBuf(new char[kLength]);
+    std::promise<int> readDone;
+    ASSERT_EQ(0, engine.SubmitRead(fd_, readBuf.get(), 15 * kLength, kLength,
+                                   [&readDone](int rc) {
+                                       readDone.set_value(rc);
+                                   }));
+    ASSERT_EQ(kLength, readDone.get_future().get());
+    ASSERT_EQ(0, memcmp(readBuf.get(), data.data(), kLength));
+
+    // 读超过文件末尾时返回实际读到的长度
+    std::promise<int> shortRead;
+    ASSERT_EQ(0, engine.SubmitRead(fd_, readBuf.get(), 16 * kLength - 100,
+                                   kLength, [&shortRead](int rc) {
+                                       shortRead.set_value(rc);
+                                   }));
+    ASSERT_EQ(100, shortRead.get_future().get());
+
+    // 写非法fd返回-EBADF
+    std::promise<int> badWrite;
+    ASSERT_EQ(0, engine.SubmitWrite(-1, data.data(), 0, kLength,
+                                    [&badWrite](int rc) {
+                                        badWrite.set_value(rc);
+                                    }));
+    ASSERT_EQ(-EBADF, badWrite.get_future().get());
+
+    engine.Stop();
+    ASSERT_EQ(0, engine.InflightCount());
+    // 停止后不再接受请求
+    ASSERT_EQ(-ESHUTDOWN, engine.SubmitFsync(fd_, nullptr));
+}
+
+TEST_F(IoUringEngineTest, StopWithWaitingSubmitTest) {
+    if (!IoUringEngine::IsSupported()) {
+        LOG(INFO) << "io_uring is not supported, skip.";
+        return;
+    }
+    IoUringEngine engine;
+    ASSERT_EQ(0, engine.Init(1));
+
+    // 回调阻塞住reap线程，在途请求占满队列
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<int> first;
+    ASSERT_EQ(0, engine.SubmitFsync(fd_, [&first, released](int rc) {
+        released.wait();
+        first.set_value(rc);
+    }));
+
+    // 等待空闲槽位的提交在Stop后返回-ESHUTDOWN，回调不会执行
+    bool called = false;
+    std::future<int> waiting = std::async(std::launch::async, [&]() {
+        return engine.SubmitFsync(fd_, [&called](int rc) { called = true; });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::future<void> stopped = std::async(std::launch::async,
+                                           [&engine]() { engine.Stop(); });
+    ASSERT_EQ(-ESHUTDOWN, waiting.get());
+
+    // Stop等待在途请求完成后才返回
+    ASSERT_EQ(std::future_status::timeout,
+              stopped.wait_for(std::chrono::milliseconds(100)));
+    release.set_value();
+    ASSERT_EQ(0, first.get_future().get());
+    stopped.get();
+    ASSERT_EQ(0, engine.InflightCount());
+    ASSERT_FALSE(called);
+}
+
+TEST_F(IoUringEngineTest, FatalRingErrorTest) {
+    if (!IoUringEngine::IsSupported()) {
+        LOG(INFO) << "io_uring is not supported, skip.";
+        return;
+    }
+    IoUringEngine engine;
+    ASSERT_EQ(0, engine.Init(4));
+    int ringFd = FindRingFd();
+    ASSERT_GE(ringFd, 0);
+
+    // 读空管道的请求会一直在途
+    int pending[2];
+    int wakeup[2];
+    ASSERT_EQ(0, ::pipe(pending));
+    ASSERT_EQ(0, ::pipe(wakeup));
+    char pendingBuf[16];
+    char wakeupBuf[1];
+    std::promise<int> pendingRet;
+    ASSERT_EQ(0, engine.SubmitRead(pending[0], pendingBuf, 0,
+                                   sizeof(pendingBuf), [&](int rc) {
+        pendingRet.set_value(rc);
+    }));
+    std::promise<int> wakeupRet;
+    ASSERT_EQ(0, engine.SubmitRead(wakeup[0], wakeupBuf, 0,
+                                   sizeof(wakeupBuf), [&](int rc) {
+        wakeupRet.set_value(rc);
+    }));
+
+    // ring的fd被替换成普通文件后，reap线程下次等待时io_uring_enter失败，
+    // 写管道唤醒阻塞在等待中的reap线程，该请求可能先完成也可能被一起失败
+    int nullFd = ::open("/dev/null", O_RDWR);
+    ASSERT_GE(nullFd, 0);
+    ASSERT_EQ(ringFd, ::dup2(nullFd, ringFd));
+    ::close(nullFd);
+    ASSERT_EQ(1, ::write(wakeup[1], "a", 1));
+    int rc = wakeupRet.get_future().get();
+    ASSERT_TRUE(rc == 1 || rc == -EOPNOTSUPP);
+
+    // 在途请求以错误回调，之后的提交直接失败
+    std::future<int> failed = pendingRet.get_future();
+    ASSERT_EQ(std::future_status::ready,
+              failed.wait_for(std::chrono::seconds(5)));
+    ASSERT_EQ(-EOPNOTSUPP, failed.get());
+    ASSERT_EQ(0, engine.InflightCount());
+    ASSERT_EQ(-ESHUTDOWN, engine.SubmitFsync(fd_, [](int rc) {}));
+    engine.Stop();
+
+    for (int fd : {pending[0], pending[1], wakeup[0], wakeup[1]}) {
+        ::close(fd);
+    }
+}
+
+}  // namespace fs
+}  // namespace curve
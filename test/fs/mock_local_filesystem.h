@@ -52,6 +52,7 @@ class MockLocalFileSystem : public LocalFileSystem {
     MOCK_METHOD4(Fallocate, int(int, int, uint64_t, int));
     MOCK_METHOD2(Fstat, int(int, struct stat*));
     MOCK_METHOD1(Fsync, int(int));
+    MOCK_METHOD5(CloneRange, int(int, uint64_t, int, uint64_t, int));
 };
 
 }  // namespace fs
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2020-12-23
+ * Author: yangyaokai
+ */
+
+#include <cstdlib>
+
+#include "test/integration/chunkserver/datastore/datastore_integration_base.h"
+
+namespace curve {
+namespace chunkserver {
+
+/**
+ * 数据目录默认在当前目录下，当前目录的文件系统不支持reflink时测试的是回退
+ * 为拷贝的路径，测试reflink时在回环设备上创建xfs并通过环境变量指定:
+ *   truncate -s 1G /tmp/xfs.img && mkfs.xfs -m reflink=1 /tmp/xfs.img
+ *   mkdir -p /mnt/xfs && mount -o loop /tmp/xfs.img /mnt/xfs
+ *   REFLINK_TEST_DIR=/mnt/xfs ./datastore_reflink_test
+ */
+static string ReflinkTestDir() {
+    const char* dir = getenv("REFLINK_TEST_DIR");
+    return dir == nullptr ? "." : dir;
+}
+
+const string baseDir = ReflinkTestDir() + "/data_int_ref";    // NOLINT
+const string poolDir = ReflinkTestDir() + "/chunkfilepool_int_ref";  // NOLINT
+const string poolMetaPath = ReflinkTestDir() + "/chunkfilepool_int_ref.meta";  // NOLINT
+
+class ReflinkTestSuit : public DatastoreIntegrationBase {
+ public:
+    ReflinkTestSuit() {}
+    ~ReflinkTestSuit() {}
+
+    void SetUp() override {
+        DatastoreIntegrationBase::SetUp();
+        dataStore_ = NewDataStore();
+        ASSERT_TRUE(dataStore_->Initialize());
+    }
+
+    std::shared_ptr<CSDataStore> NewDataStore() {
+        DataStoreOptions options;
+        options.baseDir = baseDir;
+        options.chunkSize = CHUNK_SIZE;
+        options.pageSize = PAGE_SIZE;
+        options.enableReflinkSnapshot = true;
+        return std::make_shared<CSDataStore>(lfs_, filePool_, options);
+    }
+
+    void CheckData(SequenceNum sn, bool snapshot, char expected,
+                   off_t offset, size_t length) {
+        std::unique_ptr<char[]> buf(new char[length]);
+        CSErrorCode errorCode = snapshot ?
+            dataStore_->ReadSnapshotChunk(1, sn, buf.get(), offset, length) :
+            dataStore_->ReadChunk(1, sn, buf.get(), offset, length);
+        ASSERT_EQ(CSErrorCode::Success, errorCode);
+        for (size_t i = 0; i < length; ++i) {
+            ASSERT_EQ(expected, buf[i]) << "offset: " << offset + i;
+        }
+    }
+};
+
+/**
+ * 开启reflink快照的快照场景测试
+ * 1.写chunk1
+ * 2.打快照后写chunk1的部分区域，快照数据不变
+ * 3.覆盖写chunk1的全部区域，已cow和未cow的区域快照数据都不变
+ * 4.重启datastore，快照和chunk的数据不变
+ * 5.删除快照
+ */
+TEST_F(ReflinkTestSuit, SnapshotTest) {
+    SequenceNum fileSn = 1;
+    ChunkID id = 1;
+    size_t length = 3 * PAGE_SIZE;
+    char buf[3 * PAGE_SIZE];
+
+    // 向chunk1的[0, 12KB)区域写入数据 "1"
+    memset(buf, '1', length);
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore_->WriteChunk(id, fileSn, buf, 0, length, nullptr));
+
+    // 打快照后向chunk1的[4KB, 8KB)区域写入数据 "2"
+    ++fileSn;
+    memset(buf, '2', length);
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore_->WriteChunk(id, fileSn, buf, PAGE_SIZE, PAGE_SIZE,
+                                     nullptr));
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_EQ(2, info.curSn);
+    ASSERT_EQ(1, info.snapSn);
+    CheckData(1, true, '1', 0, length);
+    CheckData(fileSn, false, '1', 0, PAGE_SIZE);
+    CheckData(fileSn, false, '2', PAGE_SIZE, PAGE_SIZE);
+    CheckData(fileSn, false, '1', 2 * PAGE_SIZE, PAGE_SIZE);
+
+    // 覆盖写chunk1的[0, 12KB)区域，快照的数据不变
+    memset(buf, '3', length);
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore_->WriteChunk(id, fileSn, buf, 0, length, nullptr));
+    CheckData(1, true, '1', 0, length);
+    CheckData(fileSn, false, '3', 0, length);
+
+    // 重启后共享的数据块依然有效
+    dataStore_ = NewDataStore();
+    ASSERT_TRUE(dataStore_->Initialize());
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_EQ(1, info.snapSn);
+    CheckData(1, true, '1', 0, length);
+    CheckData(fileSn, false, '3', 0, length);
+
+    // 删除快照，chunk的数据不变
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore_->DeleteSnapshotChunkOrCorrectSn(id, fileSn));
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_EQ(0, info.snapSn);
+    CheckData(fileSn, false, '3', 0, length);
+
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->DeleteChunk(id, fileSn));
+}
+
+}  // namespace chunkserver
+}  // namespace curve
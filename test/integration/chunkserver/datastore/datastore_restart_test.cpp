@@ -868,5 +868,76 @@ TEST_F(RestartTestSuit, RandomCombine) {
     ASSERT_TRUE(list.VerifyLogReplay());
 }
 
+// 测试延迟更新clone chunk的metapage后重启，通过回放快照之后的日志恢复bitmap
+TEST_F(RestartTestSuit, DeferredMetaPageTest) {
+    ChunkID id = 1;
+    SequenceNum sn = 1;
+    SequenceNum correctedSn = 0;
+    std::string location("test@s3");
+
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.cloneMetaSyncPages = 64;
+    // 模拟重启，从磁盘重新加载chunk
+    auto restart = [&]() {
+        dataStore_ = std::make_shared<CSDataStore>(lfs_, filePool_, options);
+        ASSERT_TRUE(dataStore_->Initialize());
+    };
+    restart();
+
+    // 第一步：通过CreateCloneChunk创建clone chunk
+    ExecCreateClone step1(&dataStore_, id, sn, correctedSn,
+                          CHUNK_SIZE, location);
+    // 第二步：WriteChunk，写[0kb, 8kb]区域
+    ExecWrite step2(&dataStore_, id, sn, RangeData('2', 0, 2 * PAGE_SIZE));
+    // 第三步：PasteChunk，写[4kb, 12kb]区域
+    ExecPaste step3(&dataStore_, id, RangeData('3', PAGE_SIZE, 2 * PAGE_SIZE));
+    // 第四步：WriteChunk，写[12kb, 20kb]区域
+    ExecWrite step4(&dataStore_, id, sn,
+                    RangeData('4', 3 * PAGE_SIZE, 2 * PAGE_SIZE));
+    // 第五步：PasteChunk，写[0kb, 32kb]区域
+    ExecPaste step5(&dataStore_, id, RangeData('5', 0, kMaxSize));
+
+    step1.Exec();
+    step2.Exec();
+    step3.Exec();
+    // 模拟raft快照，之前的日志不再回放
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->SyncMetaPages());
+    step4.Exec();
+    step5.Exec();
+    step5.SetExpectStatus();
+    std::shared_ptr<ExpectStatus> expectStatus = step5.GetStatus();
+    ASSERT_TRUE(expectStatus->exist);
+    ASSERT_EQ(Bitmap::NO_POS,
+              expectStatus->chunkInfo.bitmap->NextClearBit(
+                  0, kMaxSize / PAGE_SIZE - 1));
+
+    // 重启后快照之后写入的page在bitmap中丢失
+    restart();
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_TRUE(info.isClone);
+    ASSERT_EQ(3, info.bitmap->NextClearBit(0));
+    ASSERT_EQ(Bitmap::NO_POS, info.bitmap->NextSetBit(3));
+
+    // 回放快照之后的日志，chunk恢复为重启前的状态
+    step4.Exec();
+    step5.Exec();
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_TRUE(expectStatus->chunkInfo == info);
+    char actualData[kMaxSize];
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore_->ReadChunk(id, sn, actualData, 0, kMaxSize));
+    ASSERT_EQ(0, memcmp(expectStatus->chunkData, actualData, kMaxSize));
+
+    // 持久化后重启，bitmap不再丢失
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->SyncMetaPages());
+    restart();
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(id, &info));
+    ASSERT_TRUE(expectStatus->chunkInfo == info);
+}
+
 }  // namespace chunkserver
 }  // namespace curve
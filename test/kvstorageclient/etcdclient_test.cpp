@@ -287,6 +287,39 @@ TEST_F(TestEtcdClinetImp, test_EtcdClientInterface) {
     ops.emplace_back(op8);
     ops.emplace_back(op9);
     ASSERT_EQ(EtcdErrCode::EtcdInvalidArgument, client_->TxnN(ops));
+    ASSERT_EQ(EtcdErrCode::EtcdInvalidArgument,
+              client_->TxnN(std::vector<Operation>{}));
+    ASSERT_EQ(EtcdErrCode::EtcdInvalidArgument,
+              client_->TxnN(std::vector<Operation>(kMaxTxnOps + 1, op3)));
+
+    // put more than 3 keys in one Txn
+    std::vector<std::string> txnKeys;
+    for (int i = 0; i < 10; i++) {
+        txnKeys.emplace_back("txnkey" + std::to_string(i));
+    }
+    ops.clear();
+    for (auto &key : txnKeys) {
+        ops.emplace_back(Operation{ OpType::OpPut,
+            const_cast<char *>(key.c_str()), const_cast<char *>(key.c_str()),
+            static_cast<int>(key.size()), static_cast<int>(key.size()) });
+    }
+    ASSERT_EQ(EtcdErrCode::EtcdOK, client_->TxnN(ops));
+    for (auto &key : txnKeys) {
+        ASSERT_EQ(EtcdErrCode::EtcdOK, client_->Get(key, &out));
+        ASSERT_EQ(key, out);
+    }
+
+    // Txn返回revision
+    int64_t beforeRevision = 0;
+    int64_t txnRevision = 0;
+    ASSERT_EQ(EtcdErrCode::EtcdOK,
+              client_->GetCurrentRevision(&beforeRevision));
+    ASSERT_EQ(EtcdErrCode::EtcdOK,
+              client_->TxnNRewithRevision(ops, &txnRevision));
+    ASSERT_EQ(beforeRevision + 1, txnRevision);
+    ASSERT_EQ(EtcdErrCode::EtcdInvalidArgument,
+              client_->TxnNRewithRevision(std::vector<Operation>{},
+                                          &txnRevision));
 
     // 10. abnormal
     ops.clear();
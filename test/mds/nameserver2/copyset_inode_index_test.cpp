@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2021 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/mds/nameserver2/copyset_inode_index.h"
+
+namespace curve {
+namespace mds {
+
+namespace {
+
+FileInfo MakeFile(InodeID id, const std::string& name) {
+    FileInfo file;
+    file.set_id(id);
+    file.set_parentid(ROOTINODEID);
+    file.set_filename(name);
+    return file;
+}
+
+PageFileSegment MakeSegment(LogicalPoolIdType lpid,
+                            const std::vector<CopySetIdType>& copysets) {
+    PageFileSegment segment;
+    segment.set_logicalpoolid(lpid);
+    for (auto copysetId : copysets) {
+        auto chunk = segment.add_chunks();
+        chunk->set_copysetid(copysetId);
+        chunk->set_chunkid(1);
+    }
+    return segment;
+}
+
+std::vector<common::CopysetInfo> MakeCopysets(LogicalPoolIdType lpid,
+    const std::vector<CopySetIdType>& copysetIds) {
+    std::vector<common::CopysetInfo> copysets;
+    for (auto copysetId : copysetIds) {
+        common::CopysetInfo copyset;
+        copyset.set_logicalpoolid(lpid);
+        copyset.set_copysetid(copysetId);
+        copysets.emplace_back(copyset);
+    }
+    return copysets;
+}
+
+}  // namespace
+
+TEST(CopysetInodeIndexTest, TestAddFindRemove) {
+    CopysetInodeIndex index;
+    ASSERT_FALSE(index.IsReady());
+    index.SetReady();
+    ASSERT_TRUE(index.IsReady());
+
+    index.AddSegment(MakeFile(10, "file1"), MakeSegment(1, {1, 2}));
+    index.AddSegment(MakeFile(10, "file1"), MakeSegment(1, {2, 3}));
+    index.AddSegment(MakeFile(11, "file2"), MakeSegment(1, {3}));
+    index.AddSegment(MakeFile(12, "file3"), MakeSegment(2, {1}));
+
+    // 不存在的copyset
+    std::vector<FileInfo> files;
+    index.FindInodes(MakeCopysets(1, {4}), &files);
+    ASSERT_TRUE(files.empty());
+
+    // 同一逻辑池内的copyset
+    index.FindInodes(MakeCopysets(1, {1}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(10, files[0].id());
+    ASSERT_EQ(ROOTINODEID, files[0].parentid());
+    ASSERT_EQ("file1", files[0].filename());
+
+    // 多个copyset上的同一个文件只返回一次
+    files.clear();
+    index.FindInodes(MakeCopysets(1, {1, 2, 3}), &files);
+    ASSERT_EQ(2, files.size());
+
+    // 不同逻辑池的copyset id相同
+    files.clear();
+    index.FindInodes(MakeCopysets(2, {1}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(12, files[0].id());
+
+    // 重命名后再分配segment, 记录新的文件名
+    index.AddSegment(MakeFile(10, "file4"), MakeSegment(1, {1}));
+    files.clear();
+    index.FindInodes(MakeCopysets(1, {1}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ("file4", files[0].filename());
+
+    // 文件被移动
+    index.UpdateFile(10, RECYCLEBININODEID, "file4-10");
+    index.UpdateFile(100, ROOTINODEID, "file100");
+    files.clear();
+    index.FindInodes(MakeCopysets(1, {1}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(RECYCLEBININODEID, files[0].parentid());
+    ASSERT_EQ("file4-10", files[0].filename());
+
+    // 删除文件
+    index.RemoveInode(10);
+    index.RemoveInode(100);
+    files.clear();
+    index.FindInodes(MakeCopysets(1, {1, 2}), &files);
+    ASSERT_TRUE(files.empty());
+    index.FindInodes(MakeCopysets(1, {3}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(11, files[0].id());
+}
+
+TEST(CopysetInodeIndexTest, TestBuildWithRemovedInode) {
+    CopysetInodeIndex index;
+
+    // 构建索引时文件已经被删除, 不再加入索引
+    index.AddSegment(MakeFile(10, "file1"), MakeSegment(1, {1}));
+    index.RemoveInode(10);
+    index.BuildFile(MakeFile(10, "file1"), {MakeSegment(1, {1, 2})});
+    index.BuildFile(MakeFile(11, "file2"), {MakeSegment(1, {1}),
+                                            MakeSegment(1, {3})});
+    std::vector<FileInfo> files;
+    index.FindInodes(MakeCopysets(1, {1, 2, 3}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(11, files[0].id());
+
+    // 构建完成后删除的记录被清理
+    index.SetReady();
+    index.BuildFile(MakeFile(10, "file1"), {MakeSegment(1, {2})});
+    files.clear();
+    index.FindInodes(MakeCopysets(1, {2}), &files);
+    ASSERT_EQ(1, files.size());
+    ASSERT_EQ(10, files[0].id());
+}
+
+}  // namespace mds
+}  // namespace curve
@@ -45,6 +45,7 @@ using ::testing::ReturnArg;
 using ::testing::DoAll;
 using ::testing::SetArgPointee;
 using ::testing::SaveArg;
+using ::testing::Invoke;
 using curve::common::Authenticator;
 
 using curve::common::TimeUtility;
@@ -2356,6 +2357,186 @@ TEST_F(CurveFSTest, testGetOrAllocateSegment) {
     }
 }
 
+TEST_F(CurveFSTest, testGetOrAllocateSegments) {
+    FileInfo fileInfo1;
+    fileInfo1.set_filetype(FileType::INODE_DIRECTORY);
+
+    FileInfo fileInfo2;
+    fileInfo2.set_id(10);
+    fileInfo2.set_filetype(FileType::INODE_PAGEFILE);
+    fileInfo2.set_length(4 * DefaultSegmentSize);
+    fileInfo2.set_segmentsize(DefaultSegmentSize);
+
+    auto allocate = [](FileType type, uint64_t segmentSize,
+                       uint64_t chunkSize, offset_t offset,
+                       PageFileSegment *segment) {
+        segment->set_segmentsize(segmentSize);
+        segment->set_chunksize(chunkSize);
+        segment->set_startoffset(offset);
+        segment->set_logicalpoolid(offset / segmentSize % 2 + 1);
+        return true;
+    };
+
+    // get the existing first segment and allocate the others,
+    // segmentNum is truncated to the file length
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        PageFileSegment existSegment;
+        existSegment.set_startoffset(0);
+        EXPECT_CALL(*storage_, GetSegment(10, _, _))
+        .Times(4)
+        .WillOnce(DoAll(SetArgPointee<2>(existSegment),
+                        Return(StoreStatus::OK)))
+        .WillRepeatedly(Return(StoreStatus::KeyNotExist));
+
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _, _, _))
+        .Times(3)
+        .WillRepeatedly(Invoke(allocate));
+
+        std::vector<PageFileSegment> putSegments;
+        EXPECT_CALL(*storage_, PutSegments(10, _, _))
+        .WillOnce(DoAll(SaveArg<1>(&putSegments),
+                        SetArgPointee<2>(100),
+                        Return(StoreStatus::OK)));
+
+        // segment 1 and 3 in pool 2, segment 2 in pool 1
+        EXPECT_CALL(*allocStatistic_, AllocSpace(1, DefaultSegmentSize, 100))
+        .Times(1);
+        EXPECT_CALL(*allocStatistic_,
+                    AllocSpace(2, 2 * DefaultSegmentSize, 100))
+        .Times(1);
+
+        ASSERT_EQ(StatusCode::kOK, curvefs_->GetOrAllocateSegments(
+                  "/user1/file2", 0, 8, true, &segments));
+        ASSERT_EQ(4, segments.size());
+        ASSERT_EQ(3, putSegments.size());
+        for (int i = 0; i < 4; i++) {
+            ASSERT_EQ(i * DefaultSegmentSize, segments[i].startoffset());
+        }
+    }
+
+    // not allocate, segments not exist are skipped
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        PageFileSegment existSegment;
+        existSegment.set_startoffset(2 * DefaultSegmentSize);
+        EXPECT_CALL(*storage_, GetSegment(10, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(existSegment),
+                        Return(StoreStatus::OK)))
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        ASSERT_EQ(StatusCode::kOK, curvefs_->GetOrAllocateSegments(
+                  "/user1/file2", 2 * DefaultSegmentSize, 2, false,
+                  &segments));
+        ASSERT_EQ(1, segments.size());
+        ASSERT_EQ(2 * DefaultSegmentSize, segments[0].startoffset());
+    }
+
+    // first segment not allocated
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(10, _, _))
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        ASSERT_EQ(StatusCode::kSegmentNotAllocated,
+                  curvefs_->GetOrAllocateSegments(
+                      "/user1/file2", 0, 2, false, &segments));
+    }
+
+    // offset bigger than file length
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        ASSERT_EQ(StatusCode::kParaError,
+                  curvefs_->GetOrAllocateSegments(
+                      "/user1/file2", 4 * DefaultSegmentSize, 2, true,
+                      &segments));
+    }
+
+    // allocate the second segment fail, return the first one
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(10, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(StoreStatus::KeyNotExist));
+
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _, _, _))
+        .Times(2)
+        .WillOnce(Invoke(allocate))
+        .WillOnce(Return(false));
+
+        EXPECT_CALL(*storage_, PutSegments(10, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(101), Return(StoreStatus::OK)));
+        EXPECT_CALL(*allocStatistic_, AllocSpace(1, DefaultSegmentSize, 101))
+        .Times(1);
+
+        ASSERT_EQ(StatusCode::kOK, curvefs_->GetOrAllocateSegments(
+                  "/user1/file2", 0, 3, true, &segments));
+        ASSERT_EQ(1, segments.size());
+    }
+
+    // put segments fail
+    {
+        std::vector<PageFileSegment> segments;
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(10, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(StoreStatus::KeyNotExist));
+
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(allocate));
+
+        EXPECT_CALL(*storage_, PutSegments(10, _, _))
+        .WillOnce(Return(StoreStatus::InternalError));
+
+        ASSERT_EQ(StatusCode::kStorageError, curvefs_->GetOrAllocateSegments(
+                  "/user1/file2", 0, 2, true, &segments));
+        ASSERT_TRUE(segments.empty());
+    }
+}
+
 TEST_F(CurveFSTest, TestDeAllocateSegment) {
     const std::string filename = "/TestDeAllocateSegment";
     const uint64_t offset = 1ull * 1024 * 1024 * 1024;
@@ -4396,6 +4577,205 @@ TEST_F(CurveFSTest, ListAllVolumesOnCopyset) {
     }
 }
 
+TEST_F(CurveFSTest, ListVolumesOnCopysetWithIndex) {
+    FileInfo file1;
+    file1.set_id(10);
+    file1.set_parentid(ROOTINODEID);
+    file1.set_filetype(FileType::INODE_PAGEFILE);
+    file1.set_filename("file1");
+    FileInfo file2;
+    file2.set_id(11);
+    file2.set_parentid(ROOTINODEID);
+    file2.set_filetype(FileType::INODE_PAGEFILE);
+    file2.set_filename("file2");
+    FileInfo file3 = file2;
+    file3.set_id(12);
+    file3.set_filename("file3");
+    file3.set_filestatus(FileStatus::kFileDeleting);
+    std::vector<FileInfo> fileVec = {file1, file2, file3};
+
+    PageFileSegment segment1;
+    segment1.set_logicalpoolid(1);
+    segment1.set_segmentsize(DefaultSegmentSize);
+    segment1.set_chunksize(curvefs_->GetDefaultChunkSize());
+    segment1.set_startoffset(0);
+    PageFileSegment segment2 = segment1;
+    auto chunk = segment1.add_chunks();
+    chunk->set_copysetid(100);
+    chunk->set_chunkid(200);
+    chunk = segment2.add_chunks();
+    chunk->set_copysetid(101);
+    chunk->set_chunkid(201);
+    std::vector<PageFileSegment> segVec1 = {segment1};
+    std::vector<PageFileSegment> segVec2 = {segment2};
+
+    common::CopysetInfo copyset;
+    copyset.set_logicalpoolid(1);
+    copyset.set_copysetid(100);
+    std::vector<common::CopysetInfo> copysetVec = {copyset};
+
+    // 构建索引失败, 仍然扫描全部segment
+    {
+        EXPECT_CALL(*storage_, ListFile(_, _, _))
+            .WillOnce(DoAll(SetArgPointee<2>(fileVec),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListSegment(_, _))
+            .WillOnce(Return(StoreStatus::InternalError));
+        ASSERT_EQ(StatusCode::kStorageError, curvefs_->BuildCopysetIndex());
+
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, ListFile(_, _, _))
+            .WillOnce(DoAll(SetArgPointee<2>(fileVec),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListSegment(_, _))
+            .Times(3)
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)))
+            .WillRepeatedly(DoAll(SetArgPointee<1>(segVec2),
+                                  Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_EQ(std::vector<std::string>{"file1"}, fileNames);
+    }
+
+    // 构建索引成功, 正在删除的文件不加入索引
+    {
+        EXPECT_CALL(*storage_, ListFile(_, _, _))
+            .WillOnce(DoAll(SetArgPointee<2>(fileVec),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListSegment(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListSegment(11, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec2),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK, curvefs_->BuildCopysetIndex());
+    }
+
+    // copyset上没有文件, 不访问storage
+    {
+        common::CopysetInfo emptyCopyset;
+        emptyCopyset.set_logicalpoolid(1);
+        emptyCopyset.set_copysetid(102);
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, ListFile(_, _, _)).Times(0);
+        EXPECT_CALL(*storage_, ListSegment(_, _)).Times(0);
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset({emptyCopyset}, &fileNames));
+        ASSERT_TRUE(fileNames.empty());
+    }
+
+    // 只检查索引中找到的文件
+    {
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file1", _))
+            .WillOnce(DoAll(SetArgPointee<2>(file1),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListFile(_, _, _)).Times(0);
+        EXPECT_CALL(*storage_, ListSegment(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_EQ(std::vector<std::string>{"file1"}, fileNames);
+    }
+
+    // 文件被重命名, 通过遍历全部文件找到
+    {
+        FileInfo renamedFile = file1;
+        renamedFile.set_filename("file4");
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file1", _))
+            .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*storage_, ListFile(_, _, _))
+            .WillOnce(DoAll(SetArgPointee<2>(
+                                std::vector<FileInfo>{renamedFile, file2}),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListSegment(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_EQ(std::vector<std::string>{"file4"}, fileNames);
+    }
+
+    // 遍历找到的新文件名写回索引, 之后不再遍历全部文件
+    {
+        FileInfo renamedFile = file1;
+        renamedFile.set_filename("file4");
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file4", _))
+            .WillOnce(DoAll(SetArgPointee<2>(renamedFile),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListFile(_, _, _)).Times(0);
+        EXPECT_CALL(*storage_, ListSegment(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_EQ(std::vector<std::string>{"file4"}, fileNames);
+    }
+
+    // 通过RenameFile重命名时直接更新索引
+    {
+        FileInfo renamedFile = file1;
+        renamedFile.set_filename("file4");
+        FileInfo destFile = file1;
+        destFile.set_filename("file5");
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file4", _))
+            .WillRepeatedly(DoAll(SetArgPointee<2>(renamedFile),
+                                  Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file5", _))
+            .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*storage_, ListSnapshotFile(_, _, _))
+            .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*storage_, RenameFile(_, _))
+            .WillOnce(Return(StoreStatus::OK));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->RenameFile("/file4", "/file5", 0, 0));
+
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file5", _))
+            .WillOnce(DoAll(SetArgPointee<2>(destFile),
+                            Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, ListFile(_, _, _)).Times(0);
+        EXPECT_CALL(*storage_, ListSegment(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(segVec1),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_EQ(std::vector<std::string>{"file5"}, fileNames);
+    }
+
+    // get file失败
+    {
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file5", _))
+            .WillOnce(Return(StoreStatus::InternalError));
+        ASSERT_EQ(StatusCode::kStorageError,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+    }
+
+    // 文件已经被删除, 遍历后从索引中移除, 之后不再访问storage
+    {
+        std::vector<std::string> fileNames;
+        EXPECT_CALL(*storage_, GetFile(ROOTINODEID, "file5", _))
+            .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*storage_, ListFile(_, _, _))
+            .WillOnce(DoAll(SetArgPointee<2>(std::vector<FileInfo>{file2}),
+                            Return(StoreStatus::OK)));
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_TRUE(fileNames.empty());
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _)).Times(0);
+        EXPECT_CALL(*storage_, ListFile(_, _, _)).Times(0);
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->ListVolumesOnCopyset(copysetVec, &fileNames));
+        ASSERT_TRUE(fileNames.empty());
+    }
+}
+
 TEST_F(CurveFSTest, TestUpdateFileThrottleParams) {
     // GetFileInfo failed
     {
@@ -77,6 +77,10 @@ class MockNameServerStorage : public NameServerStorage {
                                          const PageFileSegment *,
                                          int64_t *));
 
+    MOCK_METHOD3(PutSegments, StoreStatus(InodeID,
+                                    const std::vector<PageFileSegment> &,
+                                    int64_t *));
+
     MOCK_METHOD3(DeleteSegment, StoreStatus(InodeID, uint64_t, int64_t*));
 
     MOCK_METHOD2(SnapShotFile, StoreStatus(const FileInfo *,
@@ -24,6 +24,8 @@
 #include <glog/logging.h>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "src/mds/nameserver2/namespace_storage_cache.h"
 #include "src/mds/nameserver2/namespace_storage.h"
 #include "src/mds/nameserver2/helper/namespace_helper.h"
@@ -157,6 +159,98 @@ TEST(CaCheTest, TestCacheHitAndMissMetric) {
     ASSERT_EQ(10, cache->GetCacheMetrics()->cacheMiss.get_value());
 }
 
+TEST(CaCheTest, TestCacheWithBytesLimit) {
+    auto metrics = std::make_shared<NameserverCacheMetrics>();
+    // 每个元素key和value共4字节, 最多缓存3个元素
+    std::shared_ptr<LRUCache> cache =
+        std::make_shared<LRUCache>(0, 12, metrics);
+
+    std::string out;
+    for (int i = 1; i <= 3; i++) {
+        cache->Put("k" + std::to_string(i), "v" + std::to_string(i));
+    }
+    ASSERT_EQ(3, metrics->cacheCount.get_value());
+    ASSERT_EQ(12, metrics->cacheBytes.get_value());
+
+    // 访问k1后, 淘汰最久未访问的k2
+    ASSERT_TRUE(cache->Get("k1", &out));
+    cache->Put("k4", "v4");
+    ASSERT_FALSE(cache->Get("k2", &out));
+    ASSERT_TRUE(cache->Get("k1", &out));
+    ASSERT_EQ("v1", out);
+    ASSERT_EQ(12, metrics->cacheBytes.get_value());
+
+    // 大的value淘汰多个元素
+    cache->Put("k5", "value5");
+    ASSERT_EQ(2, metrics->cacheCount.get_value());
+    ASSERT_EQ(12, metrics->cacheBytes.get_value());
+    ASSERT_TRUE(cache->Get("k1", &out));
+    ASSERT_TRUE(cache->Get("k5", &out));
+    ASSERT_EQ("value5", out);
+
+    // 超过上限的元素不缓存
+    cache->Put("k6", "value-too-large");
+    ASSERT_FALSE(cache->Get("k6", &out));
+    ASSERT_EQ(0, metrics->cacheCount.get_value());
+    ASSERT_EQ(0, metrics->cacheBytes.get_value());
+}
+
+TEST(CaCheTest, TestShardedCache) {
+    // 每个分片最多缓存2个元素
+    std::shared_ptr<ShardedLRUCache> cache =
+        std::make_shared<ShardedLRUCache>(4, 8, 0);
+    auto metrics = cache->GetCacheMetrics();
+
+    std::string out;
+    for (int i = 1; i <= 100; i++) {
+        cache->Put(std::to_string(i), std::to_string(i));
+        ASSERT_TRUE(cache->Get(std::to_string(i), &out));
+        ASSERT_EQ(std::to_string(i), out);
+    }
+    ASSERT_EQ(8, metrics->cacheCount.get_value());
+    ASSERT_EQ(100, metrics->cacheHit.get_value());
+
+    int hit = 0;
+    for (int i = 1; i <= 100; i++) {
+        if (cache->Get(std::to_string(i), &out)) {
+            ++hit;
+        }
+    }
+    ASSERT_EQ(8, hit);
+    ASSERT_EQ(92, metrics->cacheMiss.get_value());
+
+    // 最后写入的元素一定在缓存中
+    ASSERT_TRUE(cache->Get("100", &out));
+    cache->Remove("100");
+    ASSERT_FALSE(cache->Get("100", &out));
+    ASSERT_EQ(7, metrics->cacheCount.get_value());
+}
+
+TEST(CaCheTest, TestShardedCacheConcurrentAccess) {
+    std::shared_ptr<ShardedLRUCache> cache =
+        std::make_shared<ShardedLRUCache>(8, 0, 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([cache, t]() {
+            std::string out;
+            for (int i = 0; i < 1000; i++) {
+                std::string key = std::to_string(t) + "-" + std::to_string(i);
+                cache->Put(key, key);
+                ASSERT_TRUE(cache->Get(key, &out));
+                ASSERT_EQ(key, out);
+                if (i % 2 == 0) {
+                    cache->Remove(key);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(8 * 500, cache->GetCacheMetrics()->cacheCount.get_value());
+}
+
 
 }  // namespace mds
 }  // namespace curve
@@ -35,6 +35,7 @@ using ::testing::AtLeast;
 using ::testing::SetArgPointee;
 using ::testing::DoAll;
 using ::testing::Matcher;
+using ::testing::Invoke;
 
 namespace curve {
 namespace mds {
@@ -366,6 +367,54 @@ TEST_F(TestNameServerStorageImp, test_putsegment) {
         storage_->PutSegment(0, 0, &segment, &revision));
 }
 
+TEST_F(TestNameServerStorageImp, test_putsegments) {
+    std::vector<PageFileSegment> segments(3);
+    for (int i = 0; i < 3; i++) {
+        segments[i].set_segmentsize(1024*1024*1024);
+        segments[i].set_chunksize(16*1024*1024);
+        segments[i].set_startoffset(i * segments[i].segmentsize());
+        segments[i].set_logicalpoolid(1);
+    }
+    int64_t revision = 0;
+
+    // 1. 空的segment列表不访问etcd
+    ASSERT_EQ(StoreStatus::OK, storage_->PutSegments(0, {}, &revision));
+
+    // 2. 单个segment走PutRewithRevision
+    EXPECT_CALL(*client_, PutRewithRevision(_, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(10), Return(EtcdErrCode::EtcdOK)));
+    EXPECT_CALL(*cache_, Put(_, _)).Times(1);
+    ASSERT_EQ(StoreStatus::OK, storage_->PutSegments(
+        0, std::vector<PageFileSegment>{segments[0]}, &revision));
+    ASSERT_EQ(10, revision);
+
+    // 3. 多个segment在一个事务中写入, 成功后全部放入cache
+    std::vector<std::string> keys;
+    EXPECT_CALL(*client_, TxnNRewithRevision(_, _))
+        .WillOnce(Invoke([&](const std::vector<Operation> &ops,
+                             int64_t *rev) {
+            for (auto &op : ops) {
+                EXPECT_EQ(OpType::OpPut, op.opType);
+                keys.emplace_back(op.key, op.keyLen);
+            }
+            *rev = 11;
+            return EtcdErrCode::EtcdOK;
+        }))
+        .WillOnce(Return(EtcdErrCode::EtcdCanceled));
+    EXPECT_CALL(*cache_, Put(_, _)).Times(3);
+    ASSERT_EQ(StoreStatus::OK, storage_->PutSegments(0, segments, &revision));
+    ASSERT_EQ(11, revision);
+    ASSERT_EQ(3, keys.size());
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(NameSpaceStorageCodec::EncodeSegmentStoreKey(
+                      0, segments[i].startoffset()), keys[i]);
+    }
+
+    // 4. 事务失败
+    ASSERT_EQ(StoreStatus::InternalError,
+        storage_->PutSegments(0, segments, &revision));
+}
+
 TEST_F(TestNameServerStorageImp, test_getSegment) {
     // 1. get err
     PageFileSegment segment;
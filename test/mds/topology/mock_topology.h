@@ -147,6 +147,10 @@ class MockStorage : public TopologyStorage {
                      const ChunkServer &data));
     MOCK_METHOD1(UpdateCopySet, bool(
                      const CopySetInfo &data));
+    MOCK_METHOD1(UpdateChunkServers, bool(
+                     const std::vector<ChunkServer> &data));
+    MOCK_METHOD1(UpdateCopySets, bool(
+                     const std::vector<CopySetInfo> &data));
 
     MOCK_METHOD1(LoadClusterInfo,
                  bool(std::vector<ClusterInformation> *info));
@@ -338,6 +342,8 @@ class MockKVStorageClient : public KVStorageClient {
                            std::vector<std::pair<std::string, std::string>>*));
     MOCK_METHOD1(Delete, int(const std::string&));
     MOCK_METHOD1(TxnN, int(const std::vector<Operation>&));
+    MOCK_METHOD2(TxnNRewithRevision,
+        int(const std::vector<Operation>&, int64_t*));
     MOCK_METHOD3(CompareAndSwap, int(const std::string&, const std::string&,
         const std::string&));
     MOCK_METHOD5(CampaignLeader, int(const std::string&, const std::string&,
@@ -35,6 +35,7 @@ using ::testing::Return;
 using ::testing::_;
 using ::testing::Contains;
 using ::testing::SetArgPointee;
+using ::testing::Invoke;
 using ::curve::common::Configuration;
 
 class TestTopology : public ::testing::Test {
@@ -1578,7 +1579,7 @@ TEST_F(TestTopology, UpdateChunkServerDiskStatus_success) {
     ASSERT_EQ(100, pool.GetDiskCapacity());
 
     // 只刷一次
-    EXPECT_CALL(*storage_, UpdateChunkServer(_))
+    EXPECT_CALL(*storage_, UpdateChunkServers(_))
         .WillOnce(Return(true));
     topology_->Run();
     // sleep 等待刷数据库
@@ -1617,7 +1618,7 @@ TEST_F(TestTopology, UpdateChunkServerRwStateToStorage_success) {
     ASSERT_EQ(kTopoErrCodeSuccess, ret);
 
     // 只刷一次
-    EXPECT_CALL(*storage_, UpdateChunkServer(_))
+    EXPECT_CALL(*storage_, UpdateChunkServers(_))
         .WillOnce(Return(true));
     topology_->Run();
     // sleep 等待刷数据库
@@ -2584,7 +2585,7 @@ TEST_F(TestTopology, UpdateCopySetTopo_success) {
     ASSERT_EQ(kTopoErrCodeSuccess, ret);
 
     // 只刷一次
-    EXPECT_CALL(*storage_, UpdateCopySet(_))
+    EXPECT_CALL(*storage_, UpdateCopySets(_))
         .WillOnce(Return(true));
     topology_->Run();
     // sleep 等待刷数据库
@@ -2631,6 +2632,144 @@ TEST_F(TestTopology, UpdateCopySetTopo_CopySetNotFound) {
     ASSERT_EQ(kTopoErrCodeCopySetNotFound, ret);
 }
 
+TEST_F(TestTopology, FlushCopySetToStorage_retryAfterFail) {
+    PoolIdType logicalPoolId = 0x01;
+    PoolIdType physicalPoolId = 0x11;
+
+    PrepareAddPhysicalPool(physicalPoolId);
+    PrepareAddZone(0x21, "zone1", physicalPoolId);
+    PrepareAddZone(0x22, "zone2", physicalPoolId);
+    PrepareAddZone(0x23, "zone3", physicalPoolId);
+    PrepareAddServer(
+        0x31, "server1", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x21, 0x11);
+    PrepareAddServer(
+        0x32, "server2", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x22, 0x11);
+    PrepareAddServer(
+        0x33, "server3", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x23, 0x11);
+    PrepareAddChunkServer(0x41, "token1", "nvme", 0x31, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x42, "token2", "nvme", 0x32, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x43, "token3", "nvme", 0x33, "127.0.0.1", 8200);
+    PrepareAddLogicalPool(logicalPoolId, "logicalPool1", physicalPoolId);
+    std::set<ChunkServerIdType> replicas;
+    replicas.insert(0x41);
+    replicas.insert(0x42);
+    replicas.insert(0x43);
+    for (CopySetIdType id = 0x51; id < 0x55; id++) {
+        PrepareAddCopySet(id, logicalPoolId, replicas);
+    }
+
+    // 只有更新过的copyset需要刷入数据库
+    for (CopySetIdType id = 0x51; id < 0x54; id++) {
+        CopySetInfo csInfo(logicalPoolId, id);
+        csInfo.SetCopySetMembers(replicas);
+        csInfo.SetEpoch(2);
+        ASSERT_EQ(kTopoErrCodeSuccess, topology_->UpdateCopySetTopo(csInfo));
+    }
+
+    // 第一次刷失败，下一次重新刷入，之后不再刷
+    EXPECT_CALL(*storage_, UpdateCopySets(_))
+        .WillOnce(Return(false))
+        .WillOnce(Invoke([](const std::vector<CopySetInfo> &data) {
+            EXPECT_EQ(3, data.size());
+            for (auto &cs : data) {
+                EXPECT_EQ(2, cs.GetEpoch());
+            }
+            return true;
+        }));
+    topology_->Run();
+    // sleep 等待刷数据库
+    sleep(5);
+    topology_->Stop();
+
+    for (CopySetIdType id = 0x51; id < 0x55; id++) {
+        CopySetInfo csInfo;
+        ASSERT_TRUE(topology_->GetCopySet(
+            CopySetKey(logicalPoolId, id), &csInfo));
+        ASSERT_FALSE(csInfo.GetDirtyFlag());
+    }
+}
+
+TEST_F(TestTopology, FlushCopySetToStorage_batchSizeLargerThanTxn) {
+    EXPECT_CALL(*storage_, LoadClusterInfo(_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, StorageClusterInfo(_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadLogicalPool(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadPhysicalPool(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadZone(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadServer(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadChunkServer(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*storage_, LoadCopySet(_, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*idGenerator_, initLogicalPoolIdGenerator(_));
+    EXPECT_CALL(*idGenerator_, initPhysicalPoolIdGenerator(_));
+    EXPECT_CALL(*idGenerator_, initZoneIdGenerator(_));
+    EXPECT_CALL(*idGenerator_, initServerIdGenerator(_));
+    EXPECT_CALL(*idGenerator_, initChunkServerIdGenerator(_));
+    EXPECT_CALL(*idGenerator_, initCopySetIdGenerator(_));
+
+    // 超过一个etcd事务能包含的数量
+    TopologyOption option;
+    option.FlushBatchSize = kMaxUpdateBatchSize + 72;
+    ASSERT_EQ(kTopoErrCodeSuccess, topology_->Init(option));
+
+    PoolIdType logicalPoolId = 0x01;
+    PoolIdType physicalPoolId = 0x11;
+    PrepareAddPhysicalPool(physicalPoolId);
+    PrepareAddZone(0x21, "zone1", physicalPoolId);
+    PrepareAddZone(0x22, "zone2", physicalPoolId);
+    PrepareAddZone(0x23, "zone3", physicalPoolId);
+    PrepareAddServer(
+        0x31, "server1", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x21, 0x11);
+    PrepareAddServer(
+        0x32, "server2", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x22, 0x11);
+    PrepareAddServer(
+        0x33, "server3", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x23, 0x11);
+    PrepareAddChunkServer(0x41, "token1", "nvme", 0x31, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x42, "token2", "nvme", 0x32, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x43, "token3", "nvme", 0x33, "127.0.0.1", 8200);
+    PrepareAddLogicalPool(logicalPoolId, "logicalPool1", physicalPoolId);
+    std::set<ChunkServerIdType> replicas;
+    replicas.insert(0x41);
+    replicas.insert(0x42);
+    replicas.insert(0x43);
+    const CopySetIdType copysetNum = kMaxUpdateBatchSize + 2;
+    for (CopySetIdType id = 1; id <= copysetNum; id++) {
+        PrepareAddCopySet(id, logicalPoolId, replicas);
+        CopySetInfo csInfo(logicalPoolId, id);
+        csInfo.SetCopySetMembers(replicas);
+        csInfo.SetEpoch(2);
+        ASSERT_EQ(kTopoErrCodeSuccess, topology_->UpdateCopySetTopo(csInfo));
+    }
+
+    // 按事务的上限分批刷入
+    std::vector<size_t> batchSizes;
+    EXPECT_CALL(*storage_, UpdateCopySets(_))
+        .Times(2)
+        .WillRepeatedly(Invoke(
+            [&batchSizes](const std::vector<CopySetInfo> &data) {
+                batchSizes.push_back(data.size());
+                return true;
+            }));
+    topology_->Run();
+    // sleep 等待刷数据库
+    sleep(5);
+    topology_->Stop();
+
+    ASSERT_EQ(std::vector<size_t>({kMaxUpdateBatchSize, 2}), batchSizes);
+    for (CopySetIdType id = 1; id <= copysetNum; id++) {
+        CopySetInfo csInfo;
+        ASSERT_TRUE(topology_->GetCopySet(
+            CopySetKey(logicalPoolId, id), &csInfo));
+        ASSERT_FALSE(csInfo.GetDirtyFlag());
+    }
+}
+
 TEST_F(TestTopology, GetCopySet_success) {
     PoolIdType logicalPoolId = 0x01;
     PoolIdType physicalPoolId = 0x11;
@@ -2787,6 +2926,62 @@ TEST_F(TestTopology, GetCopySetsInChunkServer_success) {
     ASSERT_EQ(1, csList.size());
 }
 
+TEST_F(TestTopology, GetCopySetsInChunkServer_afterUpdateAndRemove) {
+    PoolIdType physicalPoolId = 0x11;
+    CopySetIdType copysetId = 0x51;
+
+    PrepareAddPhysicalPool(physicalPoolId);
+    PrepareAddZone(0x21, "zone1", physicalPoolId);
+    PrepareAddZone(0x22, "zone2", physicalPoolId);
+    PrepareAddZone(0x23, "zone3", physicalPoolId);
+    PrepareAddServer(
+        0x31, "server1", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x21, 0x11);
+    PrepareAddServer(
+        0x32, "server2", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x22, 0x11);
+    PrepareAddServer(
+        0x33, "server3", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x23, 0x11);
+    PrepareAddChunkServer(0x41, "token1", "nvme", 0x31, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x42, "token2", "nvme", 0x32, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x43, "token3", "nvme", 0x33, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x44, "token4", "nvme", 0x33, "127.0.0.1", 8201);
+    PrepareAddLogicalPool(0x01, "logicalPool1", physicalPoolId);
+    PrepareAddLogicalPool(0x02, "logicalPool2", physicalPoolId);
+    PrepareAddCopySet(copysetId, 0x01, {0x41, 0x42, 0x43});
+    PrepareAddCopySet(copysetId, 0x02, {0x41, 0x42, 0x44});
+
+    ASSERT_EQ(2, topology_->GetCopySetsInChunkServer(0x41).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x43).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x44).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInLogicalPool(0x01).size());
+    ASSERT_EQ(1, topology_->GetCopySetInfosInLogicalPool(0x02).size());
+    ASSERT_EQ(0, topology_->GetCopySetsInLogicalPool(0x03).size());
+
+    // 0x43被替换为0x44
+    CopySetInfo csInfo(0x01, copysetId);
+    csInfo.SetCopySetMembers({0x41, 0x42, 0x44});
+    ASSERT_EQ(kTopoErrCodeSuccess, topology_->UpdateCopySetTopo(csInfo));
+    ASSERT_EQ(0, topology_->GetCopySetsInChunkServer(0x43).size());
+    std::vector<CopySetKey> csList = topology_->GetCopySetsInChunkServer(0x44);
+    ASSERT_EQ(2, csList.size());
+    ASSERT_EQ(CopySetKey(0x01, copysetId), csList[0]);
+    ASSERT_EQ(CopySetKey(0x02, copysetId), csList[1]);
+
+    csList = topology_->GetCopySetsInChunkServer(0x44,
+        [](const CopySetInfo &info) {
+            return info.GetLogicalPoolId() == 0x02;
+        });
+    ASSERT_EQ(1, csList.size());
+    ASSERT_EQ(CopySetKey(0x02, copysetId), csList[0]);
+
+    EXPECT_CALL(*storage_, DeleteCopySet(_))
+        .WillOnce(Return(true));
+    ASSERT_EQ(kTopoErrCodeSuccess,
+        topology_->RemoveCopySet(CopySetKey(0x02, copysetId)));
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x41).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x44).size());
+    ASSERT_EQ(0, topology_->GetCopySetsInLogicalPool(0x02).size());
+}
+
 
 
 
@@ -723,6 +723,65 @@ TEST_F(TestTopologyStorageEtcd, test_StotageCopyset_putInfoEtcdFail) {
     ASSERT_FALSE(ret);
 }
 
+TEST_F(TestTopologyStorageEtcd, test_UpdateCopySets_success) {
+    std::vector<CopySetInfo> data;
+    for (CopySetIdType id = 0x61; id < 0x64; id++) {
+        CopySetInfo cs(0x11, id);
+        cs.SetEpoch(100);
+        cs.SetCopySetMembers({0x51, 0x52, 0x53});
+        data.push_back(cs);
+    }
+
+    // 多个copyset在一个事务中写入
+    EXPECT_CALL(*kvStorageClient_, TxnN(_))
+        .WillOnce(Invoke([](const std::vector<Operation> &ops) {
+            EXPECT_EQ(3, ops.size());
+            for (auto &op : ops) {
+                EXPECT_EQ(OpType::OpPut, op.opType);
+            }
+            return EtcdErrCode::EtcdOK;
+        }));
+    ASSERT_TRUE(storage_->UpdateCopySets(data));
+
+    // 单个copyset不需要事务
+    data.resize(1);
+    EXPECT_CALL(*kvStorageClient_, Put(_, _))
+        .WillOnce(Return(EtcdErrCode::EtcdOK));
+    ASSERT_TRUE(storage_->UpdateCopySets(data));
+
+    data.clear();
+    ASSERT_TRUE(storage_->UpdateCopySets(data));
+}
+
+TEST_F(TestTopologyStorageEtcd, test_UpdateCopySets_txnFail) {
+    std::vector<CopySetInfo> data;
+    data.emplace_back(0x11, 0x61);
+    data.emplace_back(0x11, 0x62);
+
+    EXPECT_CALL(*kvStorageClient_, TxnN(_))
+        .WillOnce(Return(EtcdErrCode::EtcdUnknown));
+    ASSERT_FALSE(storage_->UpdateCopySets(data));
+}
+
+TEST_F(TestTopologyStorageEtcd, test_UpdateChunkServers_success) {
+    std::vector<ChunkServer> data;
+    for (ChunkServerIdType id = 0x51; id < 0x54; id++) {
+        data.emplace_back(id, "token", "ssd", 0x41, "127.0.0.1", 8080,
+            "/root", ChunkServerStatus::READWRITE, OnlineState::OFFLINE);
+    }
+
+    EXPECT_CALL(*kvStorageClient_, TxnN(_))
+        .WillOnce(Invoke([](const std::vector<Operation> &ops) {
+            EXPECT_EQ(3, ops.size());
+            return EtcdErrCode::EtcdOK;
+        }));
+    ASSERT_TRUE(storage_->UpdateChunkServers(data));
+
+    EXPECT_CALL(*kvStorageClient_, TxnN(_))
+        .WillOnce(Return(EtcdErrCode::EtcdUnknown));
+    ASSERT_FALSE(storage_->UpdateChunkServers(data));
+}
+
 TEST_F(TestTopologyStorageEtcd, test_DeleteLogicalPool_success) {
     EXPECT_CALL(*kvStorageClient_, Delete(_))
         .WillOnce(Return(EtcdErrCode::EtcdOK));
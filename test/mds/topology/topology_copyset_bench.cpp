@@ -0,0 +1,234 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2021-01-06
+ * Author: wuhanqing
+ */
+
+// Benchmark of copyset lookups in TopologyImpl, compares the chunkserver
+// and logical pool indexes with a full scan of all copysets (the previous
+// implementation). A scheduler round queries the copysets of every
+// chunkserver and every logical pool, while heartbeat threads keep
+// updating copysets.
+//
+// usage: topology-copyset-bench -copyset_num=100000 -chunkserver_num=1000
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <butil/fast_rand.h>
+#include <butil/time.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "src/mds/topology/topology.h"
+
+DEFINE_uint32(copyset_num, 100000, "number of copysets");
+DEFINE_uint32(chunkserver_num, 1000, "number of chunkservers");
+DEFINE_uint32(logical_pool_num, 4, "number of logical pools");
+DEFINE_uint32(rounds, 1, "scheduler rounds of each mode");
+DEFINE_uint32(heartbeat_threads, 4,
+              "threads updating copysets during scheduler rounds");
+
+namespace curve {
+namespace mds {
+namespace topology {
+
+// all data stays in memory
+class FakeTopologyStorage : public TopologyStorage {
+ public:
+    bool LoadLogicalPool(
+        std::unordered_map<PoolIdType, LogicalPool> *logicalPoolMap,
+        PoolIdType *maxLogicalPoolId) override { return true; }
+    bool LoadPhysicalPool(
+        std::unordered_map<PoolIdType, PhysicalPool> *physicalPoolMap,
+        PoolIdType *maxPhysicalPoolId) override { return true; }
+    bool LoadZone(
+        std::unordered_map<ZoneIdType, Zone> *zoneMap,
+        ZoneIdType *maxZoneId) override { return true; }
+    bool LoadServer(
+        std::unordered_map<ServerIdType, Server> *serverMap,
+        ServerIdType *maxServerId) override { return true; }
+    bool LoadChunkServer(
+        std::unordered_map<ChunkServerIdType, ChunkServer> *chunkServerMap,
+        ChunkServerIdType *maxChunkServerId) override { return true; }
+    bool LoadCopySet(
+        std::map<CopySetKey, CopySetInfo> *copySetMap,
+        std::map<PoolIdType, CopySetIdType> *copySetIdMaxMap) override {
+        return true;
+    }
+
+    bool StorageLogicalPool(const LogicalPool &data) override { return true; }
+    bool StoragePhysicalPool(const PhysicalPool &data) override {
+        return true;
+    }
+    bool StorageZone(const Zone &data) override { return true; }
+    bool StorageServer(const Server &data) override { return true; }
+    bool StorageChunkServer(const ChunkServer &data) override { return true; }
+    bool StorageCopySet(const CopySetInfo &data) override { return true; }
+
+    bool DeleteLogicalPool(PoolIdType id) override { return true; }
+    bool DeletePhysicalPool(PoolIdType id) override { return true; }
+    bool DeleteZone(ZoneIdType id) override { return true; }
+    bool DeleteServer(ServerIdType id) override { return true; }
+    bool DeleteChunkServer(ChunkServerIdType id) override { return true; }
+    bool DeleteCopySet(CopySetKey key) override { return true; }
+
+    bool UpdateLogicalPool(const LogicalPool &data) override { return true; }
+    bool UpdatePhysicalPool(const PhysicalPool &data) override {
+        return true;
+    }
+    bool UpdateZone(const Zone &data) override { return true; }
+    bool UpdateServer(const Server &data) override { return true; }
+    bool UpdateChunkServer(const ChunkServer &data) override { return true; }
+    bool UpdateCopySet(const CopySetInfo &data) override { return true; }
+    bool UpdateChunkServers(const std::vector<ChunkServer> &data) override {
+        return true;
+    }
+    bool UpdateCopySets(const std::vector<CopySetInfo> &data) override {
+        return true;
+    }
+
+    bool LoadClusterInfo(std::vector<ClusterInformation> *info) override {
+        return true;
+    }
+    bool StorageClusterInfo(const ClusterInformation &info) override {
+        return true;
+    }
+};
+
+std::set<ChunkServerIdType> RandomMembers() {
+    std::set<ChunkServerIdType> members;
+    while (members.size() < 3) {
+        members.insert(butil::fast_rand_less_than(FLAGS_chunkserver_num) + 1);
+    }
+    return members;
+}
+
+void PrepareTopology(TopologyImpl *topology) {
+    CHECK_EQ(kTopoErrCodeSuccess,
+        topology->AddPhysicalPool(PhysicalPool(1, "pool", "")));
+    for (PoolIdType pid = 1; pid <= FLAGS_logical_pool_num; ++pid) {
+        LogicalPool pool(pid, "lpool" + std::to_string(pid), 1, PAGEFILE,
+            LogicalPool::RedundanceAndPlaceMentPolicy(),
+            LogicalPool::UserPolicy(), 0, true, true);
+        CHECK_EQ(kTopoErrCodeSuccess, topology->AddLogicalPool(pool));
+    }
+    for (uint32_t i = 0; i < FLAGS_copyset_num; ++i) {
+        CopySetInfo info(i % FLAGS_logical_pool_num + 1,
+                         i / FLAGS_logical_pool_num + 1);
+        info.SetCopySetMembers(RandomMembers());
+        CHECK_EQ(kTopoErrCodeSuccess, topology->AddCopySet(info));
+    }
+}
+
+// what a scheduler round asks for: copysets of every chunkserver
+// and every logical pool
+uint64_t RunRound(TopologyImpl *topology, bool fullScan) {
+    uint64_t found = 0;
+    for (ChunkServerIdType csId = 1; csId <= FLAGS_chunkserver_num; ++csId) {
+        if (fullScan) {
+            found += topology->GetCopySetsInCluster(
+                [csId](const CopySetInfo &info) {
+                    return info.GetCopySetMembers().count(csId) > 0;
+                }).size();
+        } else {
+            found += topology->GetCopySetsInChunkServer(csId).size();
+        }
+    }
+    for (PoolIdType pid = 1; pid <= FLAGS_logical_pool_num; ++pid) {
+        if (fullScan) {
+            found += topology->GetCopySetsInCluster(
+                [pid](const CopySetInfo &info) {
+                    return info.GetLogicalPoolId() == pid;
+                }).size();
+        } else {
+            found += topology->GetCopySetsInLogicalPool(pid).size();
+        }
+    }
+    return found;
+}
+
+void Bench(TopologyImpl *topology, bool fullScan) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> updates(0);
+    std::vector<std::thread> heartbeats;
+    for (uint32_t i = 0; i < FLAGS_heartbeat_threads; ++i) {
+        heartbeats.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t n = butil::fast_rand_less_than(FLAGS_copyset_num);
+                CopySetInfo info(n % FLAGS_logical_pool_num + 1,
+                                 n / FLAGS_logical_pool_num + 1);
+                info.SetCopySetMembers(RandomMembers());
+                topology->UpdateCopySetTopo(info);
+                updates.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    butil::Timer timer;
+    timer.start();
+    uint64_t found = 0;
+    for (uint32_t i = 0; i < FLAGS_rounds; ++i) {
+        found += RunRound(topology, fullScan);
+    }
+    timer.stop();
+    stop.store(true);
+    for (auto &t : heartbeats) {
+        t.join();
+    }
+
+    printf("%-10s round: %8.2f ms, heartbeat updates: %10.0f/s, found: %lu\n",
+           fullScan ? "full scan" : "index",
+           timer.m_elapsed(0.0) / FLAGS_rounds,
+           updates.load() * 1000.0 / timer.m_elapsed(1.0),
+           found / FLAGS_rounds);
+}
+
+}  // namespace topology
+}  // namespace mds
+}  // namespace curve
+
+int main(int argc, char *argv[]) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    using curve::mds::topology::DefaultIdGenerator;
+    using curve::mds::topology::DefaultTokenGenerator;
+    using curve::mds::topology::FakeTopologyStorage;
+    using curve::mds::topology::TopologyImpl;
+
+    TopologyImpl topology(std::make_shared<DefaultIdGenerator>(),
+                          std::make_shared<DefaultTokenGenerator>(),
+                          std::make_shared<FakeTopologyStorage>());
+    curve::mds::topology::PrepareTopology(&topology);
+
+    printf("copyset_num: %u, chunkserver_num: %u, logical_pool_num: %u, "
+           "heartbeat_threads: %u\n", FLAGS_copyset_num,
+           FLAGS_chunkserver_num, FLAGS_logical_pool_num,
+           FLAGS_heartbeat_threads);
+    curve::mds::topology::Bench(&topology, true);
+    curve::mds::topology::Bench(&topology, false);
+    return 0;
+}
@@ -30,6 +30,7 @@ namespace curve {
 namespace tool {
 
 using curve::common::Bitmap;
+using curve::common::CompactBitmap;
 using curve::fs::MockLocalFileSystem;
 using ::testing::_;
 using ::testing::Return;
@@ -105,7 +106,7 @@ TEST_F(CurveMetaToolTest, PrintChunkMeta) {
     auto bitmap = std::make_shared<Bitmap>(size);
     bitmap->Set(0, 2);
     bitmap->Set(size - 1);
-    metaPage.bitmap = bitmap;
+    metaPage.bitmap = std::make_shared<CompactBitmap>(*bitmap);
     metaPage.encode(buf);
     EXPECT_CALL(*localFs_, Read(_, _, 0, PAGE_SIZE))
         .Times(1)
@@ -93,6 +93,7 @@ import (
 	"strings"
 	"sync"
 	"time"
+	"unsafe"
 )
 
 const (
@@ -103,6 +104,7 @@ const (
 	EtcdDelete     = "Delete"
 	EtcdTxn2       = "Txn2"
 	EtcdTxn3       = "Txn3"
+	EtcdTxnN       = "TxnN"
 	EtcdCmpAndSwp  = "CmpAndSwp"
 	EtcdNewMutex   = "NewMutex"
 	EtcdNewSession = "NewSession"
@@ -394,6 +396,27 @@ func EtcdClientTxn3(
 	return GetErrCode(EtcdTxn3, err)
 }
 
+//export EtcdClientTxnN
+func EtcdClientTxnN(timeout C.int, cops *C.struct_Operation,
+	n C.int) (C.enum_EtcdErrCode, int64) {
+	ops := (*[1 << 20]C.struct_Operation)(unsafe.Pointer(cops))[:n:n]
+	etcdOps, err := GenOpList(ops)
+	if err != nil {
+		log.Printf("unknown op types, err: %v", err)
+		return C.EtcdTxnUnkownOp, 0
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(),
+		time.Duration(int(timeout))*time.Millisecond)
+	defer cancel()
+
+	resp, err := globalClient.Txn(ctx).Then(etcdOps...).Commit()
+	if err == nil {
+		return GetErrCode(EtcdTxnN, err), resp.Header.Revision
+	}
+	return GetErrCode(EtcdTxnN, err), 0
+}
+
 //export EtcdClientCompareAndSwap
 func EtcdClientCompareAndSwap(timeout C.int, key, prev, target *C.char,
 	keyLen, preLen, targetLen C.int) C.enum_EtcdErrCode {